@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+/*
+ * Crash consistency check of the KV record log of Linux HAL: a log is written,
+ * then cut at every offset as a crash could leave it, and each cut is opened
+ * again. Every record wholly before the cut shall be replayed, the torn one
+ * and all after it dropped, and the file truncated to the last good record.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "kv.h"
+
+#define KV_TEST_FILE            "./kv_log_test.db"
+#define KV_TEST_CUT_FILE        "./kv_log_test_cut.db"
+
+/* must match the log format in kv.c */
+#define KV_TEST_MAGIC_LEN       (8)
+#define KV_TEST_REC_HDR_LEN     (12)
+
+#define KV_TEST_KEY_NUM         (4)
+#define KV_TEST_VAL_MAXLEN      (32)
+
+typedef struct {
+    int key;                    /* index of key */
+    const char *value;          /* NULL to delete */
+} kv_test_op_t;
+
+static const kv_test_op_t kv_test_ops[] = {
+    {0, "v0"},
+    {1, "value1"},
+    {2, "a longer value of key 2"},
+    {0, "v0-again"},
+    {1, NULL},
+    {3, ""},
+    {2, "v2"},
+    {1, "back"},
+};
+
+#define KV_TEST_OP_NUM          (sizeof(kv_test_ops) / sizeof(kv_test_ops[0]))
+
+static void kv_test_key(int index, char *key)
+{
+    sprintf(key, "key_%d", index);
+}
+
+static long kv_test_rec_len(const kv_test_op_t *op)
+{
+    char key[16];
+
+    kv_test_key(op->key, key);
+    return KV_TEST_REC_HDR_LEN + strlen(key) + (op->value ? strlen(op->value) : 0);
+}
+
+static int kv_test_write_log(void)
+{
+    kv_file_t *file = NULL;
+    char key[16];
+    int i;
+
+    unlink(KV_TEST_FILE);
+    file = kv_open(KV_TEST_FILE);
+    if (!file) {
+        return -1;
+    }
+
+    for (i = 0; i < KV_TEST_OP_NUM; i++) {
+        kv_test_key(kv_test_ops[i].key, key);
+        if (kv_test_ops[i].value) {
+            if (kv_set(file, key, (char *)kv_test_ops[i].value, 1) != 0) {
+                break;
+            }
+        } else if (kv_del(file, key) != 0) {
+            break;
+        }
+    }
+    kv_close(file);
+
+    return (i == KV_TEST_OP_NUM) ? 0 : -1;
+}
+
+static char *kv_test_read(long *size)
+{
+    FILE *fp = fopen(KV_TEST_FILE, "rb");
+    char *buf = NULL;
+
+    if (!fp) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    buf = malloc(*size);
+    if (buf && fread(buf, 1, *size, fp) != *size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+
+    return buf;
+}
+
+/* open log cut at @cut and compare with ops wholly before it */
+static int kv_test_check_cut(const char *log, long cut)
+{
+    const char *expected[KV_TEST_KEY_NUM] = {NULL};
+    char key[16];
+    char value[KV_TEST_VAL_MAXLEN + 1];
+    kv_file_t *file = NULL;
+    struct stat st;
+    long good = KV_TEST_MAGIC_LEN;
+    FILE *fp = NULL;
+    int ret = 0;
+    int i;
+
+    for (i = 0; i < KV_TEST_OP_NUM && good + kv_test_rec_len(&kv_test_ops[i]) <= cut; i++) {
+        expected[kv_test_ops[i].key] = kv_test_ops[i].value;
+        good += kv_test_rec_len(&kv_test_ops[i]);
+    }
+
+    fp = fopen(KV_TEST_CUT_FILE, "wb");
+    if (!fp || fwrite(log, 1, cut, fp) != cut) {
+        if (fp) {
+            fclose(fp);
+        }
+        printf("cut %ld: write failed\n", cut);
+        return -1;
+    }
+    fclose(fp);
+
+    file = kv_open(KV_TEST_CUT_FILE);
+    if (!file) {
+        printf("cut %ld: open failed\n", cut);
+        return -1;
+    }
+
+    for (i = 0; i < KV_TEST_KEY_NUM; i++) {
+        kv_test_key(i, key);
+        if (kv_get(file, key, value, sizeof(value)) != 0) {
+            if (expected[i]) {
+                printf("cut %ld: %s missing, expect '%s'\n", cut, key, expected[i]);
+                ret = -1;
+            }
+        } else if (!expected[i] || strcmp(value, expected[i])) {
+            printf("cut %ld: %s is '%s', expect '%s'\n", cut, key, value, expected[i] ? expected[i] : "(none)");
+            ret = -1;
+        }
+    }
+    kv_close(file);
+
+    if (stat(KV_TEST_CUT_FILE, &st) != 0 || st.st_size != good) {
+        printf("cut %ld: file is %ld bytes, expect %ld\n", cut, (long)st.st_size, good);
+        ret = -1;
+    }
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    char *log = NULL;
+    long size = 0;
+    long cut;
+    int failed = 0;
+
+    if (kv_test_write_log() != 0 || (log = kv_test_read(&size)) == NULL) {
+        printf("failed to write log\n");
+        return -1;
+    }
+
+    for (cut = 0; cut <= size; cut++) {
+        if (kv_test_check_cut(log, cut) != 0) {
+            failed++;
+        }
+    }
+    printf("%ld cuts of %ld bytes log checked, %d failed\n", size + 1, size, failed);
+
+    free(log);
+    unlink(KV_TEST_FILE);
+    unlink(KV_TEST_CUT_FILE);
+
+    return failed ? -1 : 0;
+}
@@ -32,6 +32,13 @@ SRCS_linkkit-example-sched      := app_entry.c cJSON.c linkkit/linkkit_example_s
 SRCS_linkkit-example-solo       := app_entry.c cJSON.c linkkit/linkkit_example_solo.c
 SRCS_linkkit-example-countdown  := app_entry.c cJSON.c linkkit/linkkit_example_cntdown.c
 SRCS_linkkit-example-gw         := app_entry.c cJSON.c linkkit/linkkit_example_gateway.c
+SRCS_kv-log-test                := hal/kv_log_test.c
+SRCS_slab-bench                 := utils/slab_bench.c
+SRCS_slab-soak                  := utils/slab_soak.c
+SRCS_dm-lookup-bench            := utils/dm_lookup_bench.c
+SRCS_cjson-iter-bench           := utils/cjson_iter_bench.c
+SRCS_mqtt-rpc-bench             := mqtt/mqtt_rpc_bench.c
+SRCS_dm-ipc-bench               := linkkit/dm_ipc_bench.c
 
 # Syntax of Append_Conditional
 # ---
@@ -82,6 +89,15 @@ ifneq (Darwin,$(shell uname))
 $(call Append_Conditional, TARGET, linkkit-example-sched,       DEVICE_MODEL_ENABLED, DEVICE_MODEL_GATEWAY)
 endif
 
+ifneq (,$(filter -D_PLATFORM_IS_LINUX_,$(CFLAGS)))
+TARGET              += kv-log-test
+TARGET              += slab-bench slab-soak cjson-iter-bench
+$(call Append_Conditional, TARGET, mqtt-rpc-bench,              MQTT_COMM_ENABLED)
+$(call Append_Conditional, TARGET, dm-ipc-bench,                DEVICE_MODEL_ENABLED)
+$(call Append_Conditional, TARGET, dm-lookup-bench,             DEVICE_MODEL_ENABLED)
+HDR_REFS            += src/ref-impl/hal/os/ubuntu
+endif
+
 # Clear All Above when Build for Windows
 #
 ifneq (,$(filter -D_PLATFORM_IS_WINDOWS_,$(CFLAGS)))
@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+/*
+ * Event throughput of dm_ipc, the queue between dm producers (MQTT and ALCS
+ * callbacks) and IOT_Linkkit_Yield() dispatch. 1 to 4 producer threads insert
+ * formatted JSON events while main thread takes and releases them, as dispatch
+ * does, until all of them are consumed. A producer retries when queue is full.
+ *
+ * Two queues are compared:
+ * - ring: dm_ipc slot ring, events formatted right into slot payload
+ * - list: the queue before it, rebuilt here: a mutex protected list and a
+ *   malloc'd node, message and string per event
+ * Each is run with small events only, and with every DM_IPC_BENCH_SPILL_EVERY
+ * event longer than DM_IPC_MSG_INLINE_SIZE. Events/sec are printed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "iotx_dm_internal.h"
+
+#define DM_IPC_BENCH_EVENTS         (200000)    /* per producer */
+#define DM_IPC_BENCH_PRODUCERS_MAX  (4)
+#define DM_IPC_BENCH_QUEUE_LEN      (64)
+#define DM_IPC_BENCH_SPILL_EVERY    (8)
+#define DM_IPC_BENCH_SMALL_LEN      (64)
+#define DM_IPC_BENCH_LARGE_LEN      (256)
+
+#define DM_IPC_BENCH_SMALL_FMT      "{\"id\":\"%d\",\"params\":{\"LightSwitch\":%d}}"
+#define DM_IPC_BENCH_LARGE_FMT      "{\"id\":\"%d\",\"params\":{\"Data\":\"%0200d\"}}"
+
+typedef struct {
+    const char *name;
+    int (*init)(int max_size);
+    void (*deinit)(void);
+    int (*insert)(int data_len, const char *fmt, ...);
+    int (*next)(dm_ipc_msg_t **msg);
+    void (*release)(dm_ipc_msg_t *msg);
+} dm_ipc_bench_queue_t;
+
+typedef struct dm_ipc_bench_node_s {
+    struct dm_ipc_bench_node_s *next;
+    dm_ipc_msg_t *msg;
+} dm_ipc_bench_node_t;
+
+static struct {
+    void *mutex;
+    dm_ipc_bench_node_t *head;
+    dm_ipc_bench_node_t *tail;
+    int size;
+    int max_size;
+} dm_ipc_bench_list;
+
+static const dm_ipc_bench_queue_t *dm_ipc_bench_queue;
+static int dm_ipc_bench_spill;
+static volatile unsigned long dm_ipc_bench_bytes;    /* read by consumer, keeps the read from being dropped */
+
+static int dm_ipc_bench_ring_insert(int data_len, const char *fmt, ...)
+{
+    va_list args;
+    int res;
+
+    va_start(args, fmt);
+    res = dm_ipc_msg_insert_vfmt(IOTX_DM_EVENT_PROPERTY_SET, data_len, fmt, args);
+    va_end(args);
+
+    return res;
+}
+
+static int dm_ipc_bench_list_init(int max_size)
+{
+    memset(&dm_ipc_bench_list, 0, sizeof(dm_ipc_bench_list));
+    dm_ipc_bench_list.mutex = HAL_MutexCreate();
+    dm_ipc_bench_list.max_size = max_size;
+
+    return (dm_ipc_bench_list.mutex == NULL) ? FAIL_RETURN : SUCCESS_RETURN;
+}
+
+static void dm_ipc_bench_list_release(dm_ipc_msg_t *msg)
+{
+    free(msg->data);
+    free(msg);
+}
+
+static int dm_ipc_bench_list_next(dm_ipc_msg_t **msg)
+{
+    dm_ipc_bench_node_t *node = NULL;
+
+    HAL_MutexLock(dm_ipc_bench_list.mutex);
+    node = dm_ipc_bench_list.head;
+    if (node == NULL) {
+        HAL_MutexUnlock(dm_ipc_bench_list.mutex);
+        return FAIL_RETURN;
+    }
+    dm_ipc_bench_list.head = node->next;
+    if (dm_ipc_bench_list.head == NULL) {
+        dm_ipc_bench_list.tail = NULL;
+    }
+    dm_ipc_bench_list.size--;
+    *msg = node->msg;
+    free(node);
+    HAL_MutexUnlock(dm_ipc_bench_list.mutex);
+
+    return SUCCESS_RETURN;
+}
+
+static void dm_ipc_bench_list_deinit(void)
+{
+    dm_ipc_msg_t *msg = NULL;
+
+    while (dm_ipc_bench_list_next(&msg) == SUCCESS_RETURN) {
+        dm_ipc_bench_list_release(msg);
+        msg = NULL;
+    }
+    HAL_MutexDestroy(dm_ipc_bench_list.mutex);
+}
+
+/* allocations as the old producers made them: message and string, then node under mutex */
+static int dm_ipc_bench_list_insert(int data_len, const char *fmt, ...)
+{
+    dm_ipc_bench_node_t *node = NULL;
+    dm_ipc_msg_t *msg = NULL;
+    va_list args;
+
+    msg = malloc(sizeof(dm_ipc_msg_t));
+    if (msg == NULL) {
+        return FAIL_RETURN;
+    }
+    msg->type = IOTX_DM_EVENT_PROPERTY_SET;
+    msg->data = malloc(data_len);
+    if (msg->data == NULL) {
+        free(msg);
+        return FAIL_RETURN;
+    }
+    va_start(args, fmt);
+    HAL_Vsnprintf(msg->data, data_len, fmt, args);
+    va_end(args);
+
+    HAL_MutexLock(dm_ipc_bench_list.mutex);
+    if (dm_ipc_bench_list.size >= dm_ipc_bench_list.max_size
+        || (node = malloc(sizeof(dm_ipc_bench_node_t))) == NULL) {
+        HAL_MutexUnlock(dm_ipc_bench_list.mutex);
+        dm_ipc_bench_list_release(msg);
+        return FAIL_RETURN;
+    }
+    node->next = NULL;
+    node->msg = msg;
+    if (dm_ipc_bench_list.tail) {
+        dm_ipc_bench_list.tail->next = node;
+    } else {
+        dm_ipc_bench_list.head = node;
+    }
+    dm_ipc_bench_list.tail = node;
+    dm_ipc_bench_list.size++;
+    HAL_MutexUnlock(dm_ipc_bench_list.mutex);
+
+    return SUCCESS_RETURN;
+}
+
+static const dm_ipc_bench_queue_t dm_ipc_bench_queues[] = {
+    {"ring", dm_ipc_init, dm_ipc_deinit, dm_ipc_bench_ring_insert, dm_ipc_msg_next, dm_ipc_msg_release},
+    {"list", dm_ipc_bench_list_init, dm_ipc_bench_list_deinit, dm_ipc_bench_list_insert, dm_ipc_bench_list_next, dm_ipc_bench_list_release},
+};
+
+static long long dm_ipc_bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void *dm_ipc_bench_producer(void *arg)
+{
+    const dm_ipc_bench_queue_t *queue = dm_ipc_bench_queue;
+    int id = (int)(long)arg;
+    int i, res;
+
+    for (i = 0; i < DM_IPC_BENCH_EVENTS; i++) {
+        do {
+            if (dm_ipc_bench_spill && i % DM_IPC_BENCH_SPILL_EVERY == 0) {
+                res = queue->insert(DM_IPC_BENCH_LARGE_LEN, DM_IPC_BENCH_LARGE_FMT, id, i);
+            } else {
+                res = queue->insert(DM_IPC_BENCH_SMALL_LEN, DM_IPC_BENCH_SMALL_FMT, id, i & 1);
+            }
+            if (res != SUCCESS_RETURN) {
+                sched_yield();
+            }
+        } while (res != SUCCESS_RETURN);
+    }
+
+    return NULL;
+}
+
+/* return events/sec, or -1 if queue cannot be set up */
+static double dm_ipc_bench_run(const dm_ipc_bench_queue_t *queue, int producers, int spill)
+{
+    pthread_t threads[DM_IPC_BENCH_PRODUCERS_MAX];
+    dm_ipc_msg_t *msg = NULL;
+    long long begin, cost;
+    long total = (long)producers * DM_IPC_BENCH_EVENTS;
+    long consumed = 0;
+    int i;
+
+    if (queue->init(DM_IPC_BENCH_QUEUE_LEN) != SUCCESS_RETURN) {
+        return -1;
+    }
+    dm_ipc_bench_queue = queue;
+    dm_ipc_bench_spill = spill;
+
+    begin = dm_ipc_bench_now_ns();
+    for (i = 0; i < producers; i++) {
+        if (pthread_create(&threads[i], NULL, dm_ipc_bench_producer, (void *)(long)i) != 0) {
+            printf("create producer %d failed\n", i);
+            exit(1);
+        }
+    }
+
+    while (consumed < total) {
+        msg = NULL;
+        if (queue->next(&msg) != SUCCESS_RETURN) {
+            sched_yield();
+            continue;
+        }
+        /* read the event as a user callback would */
+        dm_ipc_bench_bytes += strlen(msg->data);
+        queue->release(msg);
+        consumed++;
+    }
+    cost = dm_ipc_bench_now_ns() - begin;
+
+    for (i = 0; i < producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    queue->deinit();
+
+    return (double)total * 1000000000.0 / cost;
+}
+
+int main(int argc, char **argv)
+{
+    double small, spilled;
+    int i, producers;
+
+    IOT_SetLogLevel(IOT_LOG_NONE);
+
+    printf("%d events per producer, queue of %d, 1/%d events %d bytes in spill column\n",
+           DM_IPC_BENCH_EVENTS, DM_IPC_BENCH_QUEUE_LEN, DM_IPC_BENCH_SPILL_EVERY, DM_IPC_BENCH_LARGE_LEN);
+    printf("%-6s %10s %14s %14s\n", "queue", "producers", "small ev/s", "spill ev/s");
+
+    for (producers = 1; producers <= DM_IPC_BENCH_PRODUCERS_MAX; producers++) {
+        for (i = 0; i < sizeof(dm_ipc_bench_queues) / sizeof(dm_ipc_bench_queues[0]); i++) {
+            small = dm_ipc_bench_run(&dm_ipc_bench_queues[i], producers, 0);
+            spilled = dm_ipc_bench_run(&dm_ipc_bench_queues[i], producers, 1);
+            if (small < 0 || spilled < 0) {
+                printf("%-6s %10d %14s\n", dm_ipc_bench_queues[i].name, producers, "setup failed");
+                continue;
+            }
+            printf("%-6s %10d %14.0f %14.0f\n", dm_ipc_bench_queues[i].name, producers, small, spilled);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+/*
+ * RPC latency of the MQTT yield loop against a local broker stand-in. The
+ * stand-in, a thread on loopback, acks each QoS1 request at once and answers
+ * it with a QoS0 reply after RPC_BENCH_SERVICE_US, as a cloud handler would.
+ * A yield thread drives the client while main thread times request to reply.
+ *
+ * Two loops are compared:
+ * - deadline: IOT_MQTT_Yield() called back to back, which blocks until data
+ *   arrives or something is due
+ * - old: the loop before it, which blocked until a packet was handled and
+ *   then slept a fixed 10ms, rebuilt here from short yields and that sleep
+ * p50/p99 of each are printed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "iot_import.h"
+#include "iot_export.h"
+
+#define RPC_BENCH_COUNT         (1000)
+#define RPC_BENCH_SERVICE_US    (1000)
+#define RPC_BENCH_THINK_MS      (5)         /* at most, between two requests */
+#define RPC_BENCH_OLD_SLEEP_MS  (10)
+
+#define RPC_BENCH_TOPIC         "/bench/rpc"
+#define RPC_BENCH_TOPIC_REPLY   "/bench/rpc_reply"
+#define RPC_BENCH_MSGLEN        (1024)
+
+typedef struct {
+    int             listen_fd;
+    uint16_t        port;
+} rpc_bench_broker_t;
+
+static void *rpc_bench_client;
+static volatile int rpc_bench_running;
+static volatile int rpc_bench_old_loop;
+static int rpc_bench_packets;               /* handled by client, bumped in yield thread */
+static int rpc_bench_expect;
+static sem_t rpc_bench_reply;
+
+static long long rpc_bench_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/*** broker stand-in ***/
+
+static int rpc_bench_read_full(int fd, unsigned char *buf, int len)
+{
+    int got = 0;
+    int rc;
+
+    while (got < len) {
+        rc = read(fd, buf + got, len - got);
+        if (rc <= 0) {
+            return -1;
+        }
+        got += rc;
+    }
+
+    return 0;
+}
+
+static int rpc_bench_write_full(int fd, const unsigned char *buf, int len)
+{
+    return (write(fd, buf, len) == len) ? 0 : -1;
+}
+
+/* read one packet into @buf, return its remaining length and fill @type with first byte */
+static int rpc_bench_read_packet(int fd, unsigned char *type, unsigned char *buf, int size)
+{
+    unsigned char byte;
+    int len = 0;
+    int shift = 0;
+
+    if (rpc_bench_read_full(fd, type, 1) != 0) {
+        return -1;
+    }
+    do {
+        if (rpc_bench_read_full(fd, &byte, 1) != 0 || shift > 21) {
+            return -1;
+        }
+        len |= (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    if (len > size || rpc_bench_read_full(fd, buf, len) != 0) {
+        return -1;
+    }
+
+    return len;
+}
+
+/* answer request in @buf with a QoS0 PUBLISH of its payload on reply topic */
+static int rpc_bench_reply_publish(int fd, unsigned char type, const unsigned char *buf, int len)
+{
+    unsigned char out[RPC_BENCH_MSGLEN];
+    int topic_len = (buf[0] << 8) | buf[1];
+    int offset = 2 + topic_len + (((type >> 1) & 0x03) ? 2 : 0);
+    int payload_len = len - offset;
+    int reply_len = 2 + strlen(RPC_BENCH_TOPIC_REPLY) + payload_len;
+    int pos = 0;
+
+    if (payload_len < 0 || reply_len > 127) {
+        return -1;
+    }
+
+    out[pos++] = 0x30;
+    out[pos++] = reply_len;
+    out[pos++] = 0;
+    out[pos++] = strlen(RPC_BENCH_TOPIC_REPLY);
+    memcpy(out + pos, RPC_BENCH_TOPIC_REPLY, strlen(RPC_BENCH_TOPIC_REPLY));
+    pos += strlen(RPC_BENCH_TOPIC_REPLY);
+    memcpy(out + pos, buf + offset, payload_len);
+    pos += payload_len;
+
+    return rpc_bench_write_full(fd, out, pos);
+}
+
+static void *rpc_bench_broker_routine(void *arg)
+{
+    rpc_bench_broker_t *broker = arg;
+    unsigned char buf[RPC_BENCH_MSGLEN];
+    unsigned char ack[8];
+    unsigned char type;
+    int one = 1;
+    int fd, len, pos, topics;
+
+    fd = accept(broker->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return NULL;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    while ((len = rpc_bench_read_packet(fd, &type, buf, sizeof(buf))) >= 0) {
+        switch (type >> 4) {
+            case 1:     /* CONNECT */
+                memcpy(ack, "\x20\x02\x00\x00", 4);
+                rpc_bench_write_full(fd, ack, 4);
+                break;
+            case 3:     /* PUBLISH */
+                if ((type >> 1) & 0x03) {
+                    pos = 2 + ((buf[0] << 8) | buf[1]);
+                    ack[0] = 0x40;
+                    ack[1] = 0x02;
+                    ack[2] = buf[pos];
+                    ack[3] = buf[pos + 1];
+                    rpc_bench_write_full(fd, ack, 4);
+                }
+                usleep(RPC_BENCH_SERVICE_US);
+                rpc_bench_reply_publish(fd, type, buf, len);
+                break;
+            case 8:     /* SUBSCRIBE, grant QoS0 to every topic */
+                for (pos = 2, topics = 0; pos + 2 < len; topics++) {
+                    pos += 2 + ((buf[pos] << 8) | buf[pos + 1]) + 1;
+                }
+                ack[0] = 0x90;
+                ack[1] = 2 + topics;
+                ack[2] = buf[0];
+                ack[3] = buf[1];
+                memset(ack + 4, 0, topics);
+                rpc_bench_write_full(fd, ack, 4 + topics);
+                break;
+            case 10:    /* UNSUBSCRIBE */
+                ack[0] = 0xB0;
+                ack[1] = 0x02;
+                ack[2] = buf[0];
+                ack[3] = buf[1];
+                rpc_bench_write_full(fd, ack, 4);
+                break;
+            case 12:    /* PINGREQ */
+                memcpy(ack, "\xD0\x00", 2);
+                rpc_bench_write_full(fd, ack, 2);
+                break;
+            default:    /* DISCONNECT */
+                len = -1;
+                break;
+        }
+        if (len < 0) {
+            break;
+        }
+    }
+    close(fd);
+
+    return NULL;
+}
+
+static int rpc_bench_broker_start(rpc_bench_broker_t *broker, pthread_t *tid)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+
+    broker->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (broker->listen_fd < 0) {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(broker->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(broker->listen_fd, 1) != 0
+        || getsockname(broker->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        close(broker->listen_fd);
+        return -1;
+    }
+    broker->port = ntohs(addr.sin_port);
+
+    return pthread_create(tid, NULL, rpc_bench_broker_routine, broker);
+}
+
+/*** client ***/
+
+static void rpc_bench_event(void *pcontext, void *pclient, iotx_mqtt_event_msg_pt msg)
+{
+    if (msg->event_type == IOTX_MQTT_EVENT_PUBLISH_SUCCESS) {
+        __sync_add_and_fetch(&rpc_bench_packets, 1);
+    }
+}
+
+static void rpc_bench_on_reply(void *pcontext, void *pclient, iotx_mqtt_event_msg_pt msg)
+{
+    iotx_mqtt_topic_info_pt topic_info = (iotx_mqtt_topic_info_pt)msg->msg;
+
+    __sync_add_and_fetch(&rpc_bench_packets, 1);
+    if (msg->event_type == IOTX_MQTT_EVENT_PUBLISH_RECEIVED && topic_info->payload_len == sizeof(int)
+        && !memcmp(topic_info->payload, &rpc_bench_expect, sizeof(int))) {
+        sem_post(&rpc_bench_reply);
+    }
+}
+
+static void *rpc_bench_yield_routine(void *arg)
+{
+    int packets;
+
+    while (rpc_bench_running) {
+        if (rpc_bench_old_loop) {
+            packets = __sync_add_and_fetch(&rpc_bench_packets, 0);
+            IOT_MQTT_Yield(rpc_bench_client, 1);
+            if (packets != __sync_add_and_fetch(&rpc_bench_packets, 0)) {
+                HAL_SleepMs(RPC_BENCH_OLD_SLEEP_MS);
+            }
+        } else {
+            IOT_MQTT_Yield(rpc_bench_client, 200);
+        }
+    }
+
+    return NULL;
+}
+
+static int rpc_bench_cmp(const void *a, const void *b)
+{
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+
+    return (x > y) - (x < y);
+}
+
+static int rpc_bench_run(const char *name, int old_loop)
+{
+    static long long latency[RPC_BENCH_COUNT];
+    iotx_mqtt_topic_info_t topic_msg;
+    struct timespec deadline;
+    long long begin;
+    int i;
+
+    rpc_bench_old_loop = old_loop;
+    memset(&topic_msg, 0, sizeof(topic_msg));
+    topic_msg.qos = IOTX_MQTT_QOS1;
+    topic_msg.payload = (void *)&rpc_bench_expect;
+    topic_msg.payload_len = sizeof(int);
+
+    for (i = 0; i < RPC_BENCH_COUNT; i++) {
+        HAL_SleepMs(rand() % (RPC_BENCH_THINK_MS + 1));
+
+        rpc_bench_expect++;
+        begin = rpc_bench_now_us();
+        if (IOT_MQTT_Publish(rpc_bench_client, RPC_BENCH_TOPIC, &topic_msg) < 0) {
+            printf("%s: publish failed\n", name);
+            return -1;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 2;
+        if (sem_timedwait(&rpc_bench_reply, &deadline) != 0) {
+            printf("%s: no reply of request %d\n", name, i);
+            return -1;
+        }
+        latency[i] = rpc_bench_now_us() - begin;
+    }
+
+    qsort(latency, RPC_BENCH_COUNT, sizeof(long long), rpc_bench_cmp);
+    printf("%10s %10lld %10lld %10lld\n", name, latency[RPC_BENCH_COUNT / 2],
+           latency[RPC_BENCH_COUNT * 99 / 100], latency[RPC_BENCH_COUNT - 1]);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    rpc_bench_broker_t broker;
+    iotx_mqtt_param_t mqtt_params;
+    iotx_conn_info_pt pconn_info;
+    pthread_t broker_tid, yield_tid;
+    int ret = -1;
+
+    IOT_SetLogLevel(IOT_LOG_NONE);
+    sem_init(&rpc_bench_reply, 0, 0);
+
+    if (rpc_bench_broker_start(&broker, &broker_tid) != 0) {
+        printf("failed to start broker stand-in\n");
+        return -1;
+    }
+
+    /* only to mark connection info as set up, so that construct keeps the stand-in address */
+    if (0 != IOT_SetupConnInfo("a1RpcBench", "rpc-bench", "rpc-bench-secret", (void **)&pconn_info)) {
+        printf("failed to set up connection info\n");
+        close(broker.listen_fd);
+        return -1;
+    }
+
+    memset(&mqtt_params, 0, sizeof(mqtt_params));
+    mqtt_params.port = broker.port;
+    mqtt_params.host = "127.0.0.1";
+    mqtt_params.client_id = "rpc-bench";
+    mqtt_params.username = "rpc-bench";
+    mqtt_params.password = "rpc-bench";
+    mqtt_params.pub_key = NULL;
+    mqtt_params.request_timeout_ms = 2000;
+    mqtt_params.keepalive_interval_ms = 60000;
+    mqtt_params.read_buf_size = RPC_BENCH_MSGLEN;
+    mqtt_params.write_buf_size = RPC_BENCH_MSGLEN;
+    mqtt_params.handle_event.h_fp = rpc_bench_event;
+
+    rpc_bench_client = IOT_MQTT_Construct(&mqtt_params);
+    if (rpc_bench_client == NULL) {
+        printf("failed to connect broker stand-in\n");
+        close(broker.listen_fd);
+        return -1;
+    }
+    if (IOT_MQTT_Subscribe_Sync(rpc_bench_client, RPC_BENCH_TOPIC_REPLY, IOTX_MQTT_QOS0,
+                                rpc_bench_on_reply, NULL, 2000) < 0) {
+        printf("failed to subscribe\n");
+        goto do_exit;
+    }
+
+    rpc_bench_running = 1;
+    pthread_create(&yield_tid, NULL, rpc_bench_yield_routine, NULL);
+
+    printf("%d requests, %d us service time, latency in us\n", RPC_BENCH_COUNT, RPC_BENCH_SERVICE_US);
+    printf("%10s %10s %10s %10s\n", "loop", "p50", "p99", "max");
+    ret = rpc_bench_run("old", 1);
+    if (ret == 0) {
+        ret = rpc_bench_run("deadline", 0);
+    }
+
+    rpc_bench_running = 0;
+    pthread_join(yield_tid, NULL);
+
+do_exit:
+    IOT_MQTT_Destroy(&rpc_bench_client);
+    pthread_join(broker_tid, NULL);
+    close(broker.listen_fd);
+    sem_destroy(&rpc_bench_reply);
+
+    return ret;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+/*
+ * Cost of walking all elements of a lite_cjson array, as dm property set
+ * and TSL parsers do, for arrays of 1k, 2k and 4k integers:
+ * - array_item: lite_cjson_array_item() for index 0 to n-1, which parses
+ *   from the start of array on every call and so grows quadratically
+ * - iterator: lite_cjson_iter_next() till the end, which parses each element
+ *   once and so grows linearly
+ * Average time of one whole walk is printed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "iotx_utils.h"
+#include "lite-cjson.h"
+
+#define CJSON_ITER_BENCH_INDEX_ROUNDS   (2)     /* quadratic walk takes about a second at 4k */
+#define CJSON_ITER_BENCH_ITER_ROUNDS    (100)
+
+static long long cjson_iter_bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* "[0,1,2,...]" of @count integers, NULL if out of memory */
+static char *cjson_iter_bench_array(int count, int *len)
+{
+    char *json = NULL;
+    int offset = 0;
+    int i;
+
+    json = malloc(count * 12 + 3);
+    if (json == NULL) {
+        return NULL;
+    }
+
+    json[offset++] = '[';
+    for (i = 0; i < count; i++) {
+        offset += sprintf(json + offset, (i == 0) ? "%d" : ",%d", i);
+    }
+    json[offset++] = ']';
+    json[offset] = '\0';
+
+    *len = offset;
+    return json;
+}
+
+/* return sum of elements, as a check that both walks see the same */
+static long cjson_iter_bench_walk_index(lite_cjson_t *array)
+{
+    lite_cjson_t item;
+    long sum = 0;
+    int i;
+
+    for (i = 0; i < array->size; i++) {
+        if (lite_cjson_array_item(array, i, &item) != 0) {
+            return -1;
+        }
+        sum += item.value_int;
+    }
+
+    return sum;
+}
+
+static long cjson_iter_bench_walk_iter(lite_cjson_t *array)
+{
+    lite_cjson_iter_t iter;
+    lite_cjson_t item;
+    long sum = 0;
+
+    if (lite_cjson_iter_init(array, &iter) != 0) {
+        return -1;
+    }
+    while (lite_cjson_iter_next(&iter, NULL, &item) == 0) {
+        sum += item.value_int;
+    }
+
+    return sum;
+}
+
+/* return average ns of one walk, or -1 if walk does not add up */
+static long long cjson_iter_bench_run(lite_cjson_t *array, long (*walk)(lite_cjson_t *array), int rounds)
+{
+    long expect = (long)array->size * (array->size - 1) / 2;
+    long long begin;
+    int round;
+
+    begin = cjson_iter_bench_now_ns();
+    for (round = 0; round < rounds; round++) {
+        if (walk(array) != expect) {
+            return -1;
+        }
+    }
+
+    return (cjson_iter_bench_now_ns() - begin) / rounds;
+}
+
+int main(int argc, char **argv)
+{
+    const int counts[] = {1024, 2048, 4096};
+    lite_cjson_t array;
+    long long by_index, by_iter;
+    char *json = NULL;
+    int len = 0;
+    int i;
+
+    printf("%8s %16s %16s\n", "size", "array_item us", "iterator us");
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        json = cjson_iter_bench_array(counts[i], &len);
+        if (json == NULL) {
+            printf("%8d out of memory\n", counts[i]);
+            return -1;
+        }
+
+        memset(&array, 0, sizeof(lite_cjson_t));
+        if (lite_cjson_parse(json, len, &array) != 0 || array.size != counts[i]) {
+            printf("%8d parse failed\n", counts[i]);
+            free(json);
+            return -1;
+        }
+
+        by_index = cjson_iter_bench_run(&array, cjson_iter_bench_walk_index, CJSON_ITER_BENCH_INDEX_ROUNDS);
+        by_iter = cjson_iter_bench_run(&array, cjson_iter_bench_walk_iter, CJSON_ITER_BENCH_ITER_ROUNDS);
+        free(json);
+        if (by_index < 0 || by_iter < 0) {
+            printf("%8d walk mismatch\n", counts[i]);
+            return -1;
+        }
+        printf("%8d %16.1f %16.1f\n", counts[i], by_index / 1000.0, by_iter / 1000.0);
+    }
+
+    return 0;
+}
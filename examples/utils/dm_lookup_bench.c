@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+/*
+ * Device lookup cost of dm_manager, which resolves pk/dn of nearly every
+ * inbound message and devid of every outbound report. For 10, 100, 1000 and
+ * 5000 sub-devices, the same random lookups by pk/dn and by devid are timed,
+ * once through the dm_manager hashes and once by walking a list of the same
+ * devices as dm_manager did before, strlen() per compare included. Average
+ * cost of one lookup is printed, -1 if a device is not found.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "iotx_dm_internal.h"
+
+#define DM_LOOKUP_BENCH_LOOKUPS     (200000)
+#define DM_LOOKUP_BENCH_PRODUCTS    (4)
+
+typedef struct {
+    char product_key[PRODUCT_KEY_MAXLEN];
+    char device_name[DEVICE_NAME_MAXLEN];
+    int devid;
+} dm_lookup_bench_key_t;
+
+static LIST_HEAD(dm_lookup_bench_list);
+
+/* copy of the scan before indexing */
+static dm_mgr_dev_node_t *dm_lookup_bench_scan_devid(int devid)
+{
+    dm_mgr_dev_node_t *search_node = NULL;
+
+    list_for_each_entry(search_node, &dm_lookup_bench_list, linked_list, dm_mgr_dev_node_t) {
+        if (search_node->devid == devid) {
+            return search_node;
+        }
+    }
+
+    return NULL;
+}
+
+/* pk/dn compare as it was, four strlen() per node */
+static dm_mgr_dev_node_t *dm_lookup_bench_scan_pkdn(char *product_key, char *device_name)
+{
+    dm_mgr_dev_node_t *search_node = NULL;
+
+    list_for_each_entry(search_node, &dm_lookup_bench_list, linked_list, dm_mgr_dev_node_t) {
+        if ((strlen(search_node->product_key) == strlen(product_key)) &&
+            (memcmp(search_node->product_key, product_key, strlen(product_key)) == 0) &&
+            (strlen(search_node->device_name) == strlen(device_name)) &&
+            (memcmp(search_node->device_name, device_name, strlen(device_name)) == 0)) {
+            return search_node;
+        }
+    }
+
+    return NULL;
+}
+
+static void dm_lookup_bench_clear_list(void)
+{
+    dm_mgr_dev_node_t *node = NULL;
+    dm_mgr_dev_node_t *next = NULL;
+
+    list_for_each_entry_safe(node, next, &dm_lookup_bench_list, linked_list, dm_mgr_dev_node_t) {
+        list_del(&node->linked_list);
+        free(node);
+    }
+}
+
+static long long dm_lookup_bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* create @count sub-devices in dm_manager and in scan list, return -1 on failure */
+static int dm_lookup_bench_setup(int count, dm_lookup_bench_key_t *keys)
+{
+    dm_mgr_dev_node_t *copy = NULL;
+    void *node = NULL;
+    int i;
+
+    if (dm_mgr_init() != SUCCESS_RETURN) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        memset(&keys[i], 0, sizeof(dm_lookup_bench_key_t));
+        HAL_Snprintf(keys[i].product_key, PRODUCT_KEY_MAXLEN, "a1BenchPk%03d", i % DM_LOOKUP_BENCH_PRODUCTS);
+        HAL_Snprintf(keys[i].device_name, DEVICE_NAME_MAXLEN, "bench_dev_%05d", i);
+        if (dm_mgr_device_create(IOTX_DM_DEVICE_SUBDEV, keys[i].product_key, keys[i].device_name, NULL,
+                                 &keys[i].devid) != SUCCESS_RETURN ||
+            dm_mgr_search_device_node_by_devid(keys[i].devid, &node) != SUCCESS_RETURN) {
+            return -1;
+        }
+
+        copy = malloc(sizeof(dm_mgr_dev_node_t));
+        if (copy == NULL) {
+            return -1;
+        }
+        memcpy(copy, node, sizeof(dm_mgr_dev_node_t));
+        list_add_tail(&copy->linked_list, &dm_lookup_bench_list);
+    }
+
+    return 0;
+}
+
+/* return average ns of one lookup, or -1 if a device is not found */
+static long long dm_lookup_bench_run(dm_lookup_bench_key_t *keys, const int *picks, int by_pkdn, int indexed)
+{
+    dm_lookup_bench_key_t *key = NULL;
+    long long begin;
+    void *node = NULL;
+    int devid = 0;
+    int found = 0;
+    int i;
+
+    begin = dm_lookup_bench_now_ns();
+    for (i = 0; i < DM_LOOKUP_BENCH_LOOKUPS; i++) {
+        key = &keys[picks[i]];
+        if (by_pkdn && indexed) {
+            found += (dm_mgr_search_device_by_pkdn(key->product_key, key->device_name, &devid) == SUCCESS_RETURN);
+        } else if (by_pkdn) {
+            found += (dm_lookup_bench_scan_pkdn(key->product_key, key->device_name) != NULL);
+        } else if (indexed) {
+            found += (dm_mgr_search_device_node_by_devid(key->devid, &node) == SUCCESS_RETURN);
+        } else {
+            found += (dm_lookup_bench_scan_devid(key->devid) != NULL);
+        }
+    }
+
+    if (found != DM_LOOKUP_BENCH_LOOKUPS) {
+        return -1;
+    }
+    return (dm_lookup_bench_now_ns() - begin) / DM_LOOKUP_BENCH_LOOKUPS;
+}
+
+int main(int argc, char **argv)
+{
+    const int counts[] = {10, 100, 1000, 5000};
+    long long cost[4];
+    dm_lookup_bench_key_t *keys = NULL;
+    int *picks = NULL;
+    int i, j;
+
+    IOT_SetLogLevel(IOT_LOG_NONE);
+
+    keys = malloc(counts[sizeof(counts) / sizeof(counts[0]) - 1] * sizeof(dm_lookup_bench_key_t));
+    picks = malloc(DM_LOOKUP_BENCH_LOOKUPS * sizeof(int));
+    if (keys == NULL || picks == NULL) {
+        printf("out of memory\n");
+        return -1;
+    }
+
+    printf("%8s %14s %14s %14s %14s\n", "devices", "pkdn scan ns", "pkdn hash ns", "devid scan ns", "devid hash ns");
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        srand(counts[i]);
+        for (j = 0; j < DM_LOOKUP_BENCH_LOOKUPS; j++) {
+            picks[j] = rand() % counts[i];
+        }
+
+        if (dm_lookup_bench_setup(counts[i], keys) != 0) {
+            printf("%8d setup failed\n", counts[i]);
+            return -1;
+        }
+        for (j = 0; j < 4; j++) {
+            cost[j] = dm_lookup_bench_run(keys, picks, j < 2, j % 2);
+        }
+        printf("%8d %14lld %14lld %14lld %14lld\n", counts[i], cost[0], cost[1], cost[2], cost[3]);
+
+        dm_lookup_bench_clear_list();
+        dm_mgr_deinit();
+    }
+
+    free(keys);
+    free(picks);
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+/*
+ * Allocation cost of slab pools against heap: for each object size, batches
+ * of objects are allocated and then freed in an interleaved order, as list
+ * nodes of the SDK are, once through utils_slab_alloc() and once through
+ * malloc(), which is what HAL_Malloc() of Linux HAL comes to. Average and
+ * worst cost of one alloc and free pair are printed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "utils_slab.h"
+
+#define SLAB_BENCH_BATCH        (256)
+#define SLAB_BENCH_ROUNDS       (2000)
+
+static const utils_slab_config_t slab_bench_config = {
+    "slab-bench", 4096, 64, 4, { 32, 64, 128, 256 }
+};
+
+static utils_slab_pool_t slab_bench_pool = UTILS_SLAB_POOL_INIT(&slab_bench_config);
+
+typedef struct {
+    const char *name;
+    void *(*alloc)(int size);
+    void (*free)(void *ptr);
+} slab_bench_allocator_t;
+
+static void *slab_bench_slab_alloc(int size)
+{
+    return utils_slab_alloc(&slab_bench_pool, size);
+}
+
+static void *slab_bench_heap_alloc(int size)
+{
+    return calloc(1, size);
+}
+
+static const slab_bench_allocator_t slab_bench_allocators[] = {
+    {"slab", slab_bench_slab_alloc, utils_slab_free},
+    {"heap", slab_bench_heap_alloc, free},
+};
+
+static long long slab_bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* return -1 if out of memory */
+static int slab_bench_run(const slab_bench_allocator_t *allocator, int size, long long *avg, long long *worst)
+{
+    void *objs[SLAB_BENCH_BATCH];
+    long long total = 0;
+    long long begin, cost;
+    int round, start, i;
+
+    *worst = 0;
+    for (round = 0; round < SLAB_BENCH_ROUNDS; round++) {
+        for (i = 0; i < SLAB_BENCH_BATCH; i++) {
+            begin = slab_bench_now_ns();
+            objs[i] = allocator->alloc(size);
+            cost = slab_bench_now_ns() - begin;
+            if (objs[i] == NULL) {
+                return -1;
+            }
+            memset(objs[i], i, size);
+            total += cost;
+            *worst = (cost > *worst) ? cost : *worst;
+        }
+
+        /* odd ones first, so that pages are left partly used for a while */
+        for (start = 1; start >= 0; start--) {
+            for (i = start; i < SLAB_BENCH_BATCH; i += 2) {
+                begin = slab_bench_now_ns();
+                allocator->free(objs[i]);
+                cost = slab_bench_now_ns() - begin;
+                total += cost;
+                *worst = (cost > *worst) ? cost : *worst;
+            }
+        }
+    }
+    *avg = total / ((long long)SLAB_BENCH_ROUNDS * SLAB_BENCH_BATCH);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const int sizes[] = {24, 64, 120, 256};
+    long long avg, worst;
+    int i, j;
+
+    printf("%8s %6s %14s %14s\n", "size", "from", "avg ns/pair", "worst ns/op");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (j = 0; j < sizeof(slab_bench_allocators) / sizeof(slab_bench_allocators[0]); j++) {
+            if (slab_bench_run(&slab_bench_allocators[j], sizes[i], &avg, &worst) != 0) {
+                printf("%8d %6s out of memory\n", sizes[i], slab_bench_allocators[j].name);
+                return -1;
+            }
+            printf("%8d %6s %14lld %14lld\n", sizes[i], slab_bench_allocators[j].name, avg, worst);
+        }
+    }
+
+    utils_slab_shrink(&slab_bench_pool);
+    utils_slab_dump();
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+/*
+ * Fragmentation soak of slab pools: threads sharing one pool keep a set of
+ * live objects each and replace them at random for a long while, with sizes
+ * of every class and beyond, so that slab and heap fallback are both taken.
+ * Every object is filled with a pattern of its owner and checked on free.
+ * After all is freed no object shall be in use, at most one page per class
+ * be kept, and none after shrink. Slot usage of pages is sampled on the way
+ * to show how well freed slots are reused.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "utils_slab.h"
+
+#define SLAB_SOAK_THREADS       (4)
+#define SLAB_SOAK_LIVE          (512)
+#define SLAB_SOAK_STEPS         (1000000)
+#define SLAB_SOAK_SAMPLE        (10000)
+#define SLAB_SOAK_SIZE_MAX      (320)
+
+static const utils_slab_config_t slab_soak_config = {
+    "slab-soak", 2048, 32, 3, { 200, 32, 96 }
+};
+
+static utils_slab_pool_t slab_soak_pool = UTILS_SLAB_POOL_INIT(&slab_soak_config);
+
+/* seen by sampler, per class */
+static int slab_soak_low_usage[UTILS_SLAB_CLASS_MAX];
+static int slab_soak_max_pages[UTILS_SLAB_CLASS_MAX];
+
+typedef struct {
+    int id;
+    unsigned int seed;
+    int errors;
+    unsigned char *objs[SLAB_SOAK_LIVE];
+    int sizes[SLAB_SOAK_LIVE];
+} slab_soak_thread_t;
+
+static unsigned char slab_soak_pattern(slab_soak_thread_t *thread, int slot, int offset)
+{
+    return (unsigned char)(thread->id * 131 + slot * 7 + offset);
+}
+
+static void slab_soak_release(slab_soak_thread_t *thread, int slot)
+{
+    int i;
+
+    for (i = 0; i < thread->sizes[slot]; i++) {
+        if (thread->objs[slot][i] != slab_soak_pattern(thread, slot, i)) {
+            printf("thread %d: object of %d bytes corrupted at %d\n", thread->id, thread->sizes[slot], i);
+            thread->errors++;
+            break;
+        }
+    }
+    utils_slab_free(thread->objs[slot]);
+    thread->objs[slot] = NULL;
+}
+
+static void *slab_soak_routine(void *arg)
+{
+    slab_soak_thread_t *thread = arg;
+    int step, slot, i;
+
+    for (step = 0; step < SLAB_SOAK_STEPS && thread->errors == 0; step++) {
+        slot = rand_r(&thread->seed) % SLAB_SOAK_LIVE;
+        if (thread->objs[slot] != NULL) {
+            slab_soak_release(thread, slot);
+            continue;
+        }
+
+        thread->sizes[slot] = 1 + rand_r(&thread->seed) % SLAB_SOAK_SIZE_MAX;
+        thread->objs[slot] = utils_slab_alloc(&slab_soak_pool, thread->sizes[slot]);
+        if (thread->objs[slot] == NULL) {
+            printf("thread %d: out of memory\n", thread->id);
+            thread->errors++;
+            break;
+        }
+        for (i = 0; i < thread->sizes[slot]; i++) {
+            thread->objs[slot][i] = slab_soak_pattern(thread, slot, i);
+        }
+    }
+
+    for (slot = 0; slot < SLAB_SOAK_LIVE; slot++) {
+        if (thread->objs[slot] != NULL) {
+            slab_soak_release(thread, slot);
+        }
+    }
+
+    return NULL;
+}
+
+/* lowest share of carved slots in use and most pages, read without pool mutex as a rough sample */
+static void *slab_soak_sampler(void *arg)
+{
+    int *done = arg;
+    utils_slab_class_t *cls = NULL;
+    int usage, i;
+
+    for (i = 0; i < slab_soak_config.class_num; i++) {
+        slab_soak_low_usage[i] = 100;
+    }
+
+    while (!__sync_fetch_and_add(done, 0)) {
+        for (i = 0; i < slab_soak_config.class_num; i++) {
+            cls = &slab_soak_pool.classes[i];
+            if (cls->pages > slab_soak_max_pages[i]) {
+                slab_soak_max_pages[i] = cls->pages;
+            }
+            if (cls->pages > 1 && cls->page_objs > 0) {
+                usage = cls->inuse * 100 / (cls->pages * cls->page_objs);
+                if (usage < slab_soak_low_usage[i]) {
+                    slab_soak_low_usage[i] = usage;
+                }
+            }
+        }
+        usleep(SLAB_SOAK_SAMPLE);
+    }
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    static slab_soak_thread_t threads[SLAB_SOAK_THREADS];
+    pthread_t tids[SLAB_SOAK_THREADS];
+    pthread_t sampler;
+    utils_slab_class_t *cls = NULL;
+    int done = 0;
+    int errors = 0;
+    int i;
+
+    pthread_create(&sampler, NULL, slab_soak_sampler, &done);
+    for (i = 0; i < SLAB_SOAK_THREADS; i++) {
+        threads[i].id = i;
+        threads[i].seed = 2018 + i;
+        pthread_create(&tids[i], NULL, slab_soak_routine, &threads[i]);
+    }
+    for (i = 0; i < SLAB_SOAK_THREADS; i++) {
+        pthread_join(tids[i], NULL);
+        errors += threads[i].errors;
+    }
+    __sync_fetch_and_add(&done, 1);
+    pthread_join(sampler, NULL);
+
+    for (i = 0; i < slab_soak_config.class_num; i++) {
+        cls = &slab_soak_pool.classes[i];
+        printf("%4d bytes: %4d max in use, %6d from heap, %2d pages at most, slots in use low at %d%%\n",
+               slab_soak_config.class_size[i], cls->max_inuse, cls->fallbacks,
+               slab_soak_max_pages[i], slab_soak_low_usage[i]);
+        if (slab_soak_max_pages[i] > slab_soak_config.max_pages) {
+            printf("%d bytes: more than %d pages\n", slab_soak_config.class_size[i], slab_soak_config.max_pages);
+            errors++;
+        }
+        if (cls->inuse != 0 || cls->pages > 1) {
+            printf("%d bytes: %d in use, %d pages kept after all freed\n",
+                   slab_soak_config.class_size[i], cls->inuse, cls->pages);
+            errors++;
+        }
+    }
+
+    utils_slab_shrink(&slab_soak_pool);
+    for (i = 0; i < slab_soak_config.class_num; i++) {
+        cls = &slab_soak_pool.classes[i];
+        if (cls->pages != 0) {
+            printf("%d bytes: %d pages kept after shrink\n", slab_soak_config.class_size[i], cls->pages);
+            errors++;
+        }
+    }
+    printf("%d threads of %d steps soaked, %d errors\n", SLAB_SOAK_THREADS, SLAB_SOAK_STEPS, errors);
+
+    return errors ? -1 : 0;
+}
@@ -128,6 +128,16 @@ typedef struct {
 } iotx_mqtt_event_handle_t, *iotx_mqtt_event_handle_pt;
 
 
+/* The structure of one topic filter in multi-topic subscribe */
+typedef struct {
+    const char                         *topic_filter;           /* Specify the topic filter */
+    iotx_mqtt_qos_t                     qos;                    /* Specify the MQTT Requested QoS */
+    iotx_mqtt_event_handle_func_fpt     topic_handle_func;      /* Specify the topic handle callback-function */
+    void                               *pcontext;               /* Specify context passed back to callback */
+    int                                 result;                 /* Output of IOT_MQTT_Subscribe_Multi_Sync, 0 once subscribed */
+} iotx_mqtt_multi_sub_t, *iotx_mqtt_multi_sub_pt;
+
+
 /* The structure of MQTT initial parameter */
 typedef struct {
 
@@ -299,6 +309,39 @@ DLL_IOT_API int IOT_MQTT_Subscribe_Sync(void *handle,
                                         void *pcontext,
                                         int timeout_ms);
 
+/**
+ * @brief Subscribe several MQTT topics in one SUBSCRIBE packet.
+ *
+ * @param [in] handle: specify the MQTT client.
+ * @param [in] topics: specify the topic filters and related callback-functions.
+ * @param [in] count: number of topic filters, no more than MUTLI_SUBSCIRBE_MAX.
+ *
+ * @retval -1  : Subscribe failed.
+ * @retval >=0 : Subscribe successful.
+          The value is a unique ID of this request.
+          The ID will be passed back when callback 'iotx_mqtt_param_t:handle_event'.
+ * @see None.
+ */
+DLL_IOT_API int IOT_MQTT_Subscribe_Multi(void *handle, iotx_mqtt_multi_sub_t *topics, int count);
+
+/**
+ * @brief Subscribe any number of MQTT topics and wait all subacks.
+ *        Topics are sent in SUBSCRIBE packets of MUTLI_SUBSCIRBE_MAX topics without waiting
+ *        for each other, then topics rejected or timeout are sent again till 'timeout_ms' expires.
+ *        'result' of each topic tells whether it is subscribed, so that caller retries failed ones only.
+ *
+ * @param [in] handle: specify the MQTT client.
+ * @param [in] topics: specify the topic filters and related callback-functions.
+ * @param [in] count: number of topic filters.
+ * @param [in] timeout_ms: time in ms to wait.
+ *
+ * @retval -1 : Some of topics failed.
+ * @retval  0 : All topics subscribed.
+ * @see None.
+ */
+DLL_IOT_API int IOT_MQTT_Subscribe_Multi_Sync(void *handle, iotx_mqtt_multi_sub_t *topics, int count,
+        int timeout_ms);
+
 
 /**
  * @brief Unsubscribe MQTT topic.
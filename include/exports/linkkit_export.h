@@ -133,6 +133,16 @@ DLL_IOT_API int being_deprecated linkkit_end(void);
  */
 DLL_IOT_API void *linkkit_set_tsl(const char *tsl, int tsl_len);
 
+/**
+ * @brief install user tsl precompiled by linkkit_tsl_convert -c, no tsl string parsed.
+ *        use IOT_Ioctl(IOTX_IOCTL_SET_TSL_TABLE) instead, which also covers subdevices.
+ *
+ * @param tsl_table, the dm_shw_table_t generated by linkkit_tsl_convert.
+ *
+ * @return pointer to thing object, NULL when fails.
+ */
+DLL_IOT_API being_deprecated void *linkkit_set_tsl_table(const void *tsl_table);
+
 /* patterns: */
 /* method:
  * set_property_/event_output_/service_output_value:
@@ -47,6 +47,7 @@
     #define CONFIG_BLDTIME_MUTE_DBGLOG      (0)
 #endif
 
+/* maximum messages pending for user callback, dm allocates their ring at init, see DM_IPC_MSG_INLINE_SIZE */
 #ifndef CONFIG_DISPATCH_QUEUE_MAXLEN
     #define CONFIG_DISPATCH_QUEUE_MAXLEN    (50)
 #endif
@@ -62,7 +62,9 @@ DLL_HAL_API int HAL_Aes128_Destroy(_IN_ p_HAL_Aes128_t aes);
      = -1: failed
    @endverbatim
  * @see None.
- * @note None.
+ * @note 同一句柄的多次调用须保持CBC链接状态: 首次调用从`HAL_Aes128_Init()`时的iv开始,
+ *       之后每次调用从上一次调用的最后一个密文块继续, 即分多次加密与一次加密的结果相同.
+ *       ALCS会话缓存的句柄依赖这一行为.
  */
 DLL_HAL_API int HAL_Aes128_Cbc_Encrypt(
             _IN_ p_HAL_Aes128_t aes,
@@ -83,7 +85,9 @@ DLL_HAL_API int HAL_Aes128_Cbc_Encrypt(
      = -1: failed
    @endverbatim
  * @see None.
- * @note None.
+ * @note 同一句柄的多次调用须保持CBC链接状态: 首次调用从`HAL_Aes128_Init()`时的iv开始,
+ *       之后每次调用从上一次调用的最后一个密文块继续, 即分多次解密与一次解密的结果相同.
+ *       ALCS会话缓存的句柄依赖这一行为.
  */
 DLL_HAL_API int HAL_Aes128_Cbc_Decrypt(
             _IN_ p_HAL_Aes128_t aes,
@@ -77,6 +77,9 @@ DLL_HAL_API int32_t HAL_SSL_Write(_IN_ uintptr_t handle, _IN_ const char *buf, _
  * @param [out] buf @n A pointer to a buffer to receive incoming data.
  * @param [out] len @n The length, in bytes, of the data pointed to by the 'buf' parameter.
  * @param [in] timeout_ms @n Specify the timeout value in millisecond. In other words, the API block 'timeout_ms' millisecond maximumly.
+ *                           Zero 'timeout_ms' means only taking data already arrived, without blocking.
+ *                           The MQTT client relies on this to drain its read buffer, a port which
+ *                           blocks on zero shall build with IOTX_MC_READ_AVAIL_TIMEOUT_MS set to 1.
  *
  * @retval       -2 : SSL connection error occur.
  * @retval       -1 : SSL connection be closed by remote server.
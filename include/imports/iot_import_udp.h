@@ -168,6 +168,32 @@ DLL_HAL_API int HAL_UDP_recvfrom(_IN_ intptr_t sockfd,
                                  _IN_ unsigned int datalen,
                                  _IN_ unsigned int timeout_ms);
 
+/**
+ * @brief   从指定的UDP句柄批量接收数据报, 阻塞时间不超过指定时长, 有数据报到达后一次读取当前已到达的最多'count'个
+ *
+ * @param   sockfd : UDP socket的句柄
+ * @param   p_remote : 存放源网络地址的结构体数组, 元素个数为'count'
+ * @param   p_data : 存放被接收数据的缓冲区指针数组, 元素个数为'count'
+ * @param   datalen : 每个缓冲区中存放数据的最大长度, 单位是字节(Byte)
+ * @param   p_len : 存放每个数据报实际长度的数组, 元素个数为'count'
+ * @param   count : 最多接收的数据报个数
+ * @param   timeout_ms : 可能阻塞的最大时间长度, 单位是毫秒
+ *
+ * @retval  < 0 : 接收过程中出现错误或异常
+ * @retval  0 : 在指定的'timeout_ms'时间间隔内, 没有任何数据报被成功接收
+ * @retval  (0, count] : 被成功接收的数据报个数
+ *
+ * @note    不支持批量接收的平台可以每次只接收一个数据报, 与HAL_UDP_recvfrom行为一致
+ * @note    仅当板级配置定义COAP_RECV_BATCH_COUNT大于1时才会被调用, 其它平台无需实现
+ */
+DLL_HAL_API int HAL_UDP_recvfrom_batch(_IN_ intptr_t sockfd,
+                                       _OU_ NetworkAddr *p_remote,
+                                       _OU_ unsigned char *p_data[],
+                                       _IN_ unsigned int datalen,
+                                       _OU_ unsigned int *p_len,
+                                       _IN_ unsigned int count,
+                                       _IN_ unsigned int timeout_ms);
+
 /**
 * @brief   从指定的UDP句柄接收指定长度数据到缓冲区, 阻塞时间不超过指定时长, 且指定长度若接收完需提前返回, 源地址保存在出参中
 *          调用该接口之前需要调用HAL_UDP_connect设置好目的地址和端口。
@@ -109,6 +109,20 @@ typedef struct {
     int         status;
 } iotx_ioctl_get_subdev_info_t;
 
+/* data struct define for IOTX_IOCTL_GET_PROP_POST_STATS */
+typedef struct {
+    unsigned int reports;       /* property reports taken by coalescing */
+    unsigned int posts;         /* property post or pack post messages sent for them */
+    unsigned int saved;         /* messages saved, reports sent minus posts */
+    unsigned int overwritten;   /* properties replaced by a later report of the same window */
+} iotx_ioctl_prop_post_stats_t;
+
+/* data struct define for IOTX_IOCTL_SET_TSL_TABLE */
+typedef struct {
+    const char *product_key;
+    const void *tsl_table;      /* dm_shw_table_t generated by linkkit_tsl_convert -c, NULL to unregister */
+} iotx_ioctl_set_tsl_table_t;
+
 typedef enum {
     IOTX_IOCTL_SET_REGION,              /* value(int*): iotx_cloud_region_types_t */
     IOTX_IOCTL_GET_REGION,              /* value(int*) */
@@ -120,7 +134,10 @@ typedef enum {
     IOTX_IOCTL_RECV_EVENT_REPLY,        /* value(int*): 0 - Disable event post reply by cloud; 1 - Enable event post reply by cloud */
     IOTX_IOCTL_SEND_PROP_SET_REPLY,     /* value(int*): 0 - Disable send post set reply by devid; 1 - Enable property set reply by devid */
     IOTX_IOCTL_SET_SUBDEV_SIGN,         /* value(const char*): only for slave device, set signature of subdevice */
-    IOTX_IOCTL_GET_SUBDEV_LOGIN         /* value(int*): 0 - SubDev is logout; 1 - SubDev is login */
+    IOTX_IOCTL_GET_SUBDEV_LOGIN,        /* value(int*): 0 - SubDev is logout; 1 - SubDev is login */
+    IOTX_IOCTL_SET_PROP_POST_COALESCE,  /* value(int*): 0 - Disable; >0 - merge property reports of this many ms into one post */
+    IOTX_IOCTL_GET_PROP_POST_STATS,     /* value(iotx_ioctl_prop_post_stats_t*) */
+    IOTX_IOCTL_SET_TSL_TABLE            /* value(iotx_ioctl_set_tsl_table_t*): shadows of devices of product are created from table, no TSL parsed */
 } iotx_ioctl_option_t;
 
 typedef enum {
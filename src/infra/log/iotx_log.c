@@ -3,6 +3,9 @@
  */
 
 #include "iotx_log_internal.h"
+#ifdef LOG_ASYNC_ENABLED
+#include "utils_atomic.h"
+#endif
 
 static log_client logcb = {
     .name       = "linkkit",
@@ -19,46 +22,401 @@ char *lvl_color[] = {
     "[0m", "[1;31m", "[1;31m", "[1;35m", "[1;33m", "[1;36m", "[1;37m"
 };
 
-void LITE_syslog_routine(char *m, const char *f, const int l, const int level, const char *fmt, va_list *params)
+#ifdef LOG_ASYNC_ENABLED
+static log_async_ring logring = {0};
+#endif
+
+/* format into buf of LOG_MSG_MAXLEN + 1 bytes, return length of text */
+static int _log_format(char *buf, const char *fmt, va_list *params, int *truncated)
 {
-    char       *tmpbuf = logcb.text_buf;
-    char       *o = tmpbuf;
-    int         truncated = 0;
+    int         ret;
+    int         len;
 
-    if (LITE_get_loglevel() < level || level < LOG_NONE_LEVEL) {
-        return;
-    }
+    buf[0] = '\0';
+    ret = LITE_vsnprintf(buf, LOG_MSG_MAXLEN + 1, fmt, *params);
+    len = strlen(buf);
 
+    *truncated = (ret > LOG_MSG_MAXLEN || len == LOG_MSG_MAXLEN);
+    return len;
+}
+
+static void _log_output(const int level, const char *f, const int l, const char *text, int len, int truncated)
+{
 #if !defined(_WIN32)
     LITE_printf("%s%s", "\033", lvl_color[level]);
     LITE_printf(LOG_PREFIX_FMT, lvl_names[level], f, l);
 #endif  /* #if !defined(_WIN32) */
 
-    memset(tmpbuf, 0, sizeof(logcb.text_buf));
-
-    o = tmpbuf;
-    o += LITE_vsnprintf(o, LOG_MSG_MAXLEN + 1, fmt, *params);
-
-    if (o - tmpbuf > LOG_MSG_MAXLEN) {
-        o = tmpbuf + strlen(tmpbuf);
-        truncated = 1;
-    }
-    if (strlen(tmpbuf) == LOG_MSG_MAXLEN) {
-        truncated = 1;
-    }
-
-    LITE_printf("%s", tmpbuf);
+    LITE_printf("%s", text);
     if (truncated) {
         LITE_printf(" ...");
     }
 
-    if (tmpbuf[strlen(tmpbuf) - 1] != '\n') {
+    if (len == 0 || text[len - 1] != '\n') {
         LITE_printf("\r\n");
     }
 
 #if !defined(_WIN32)
     LITE_printf("%s", "\033[0m");
 #endif  /* #if !defined(_WIN32) */
+}
+
+#ifdef LOG_ASYNC_ENABLED
+#if UTILS_ATOMIC_LOCK_FREE
+#define _log_async_cas(ptr, oldval, newval) UTILS_ATOMIC_CAS(ptr, oldval, newval)
+#define _log_async_load(ptr)                UTILS_ATOMIC_LOAD(ptr)
+#define _log_async_add(ptr, val)            UTILS_ATOMIC_ADD(ptr, val)
+#else
+static int _log_async_cas(volatile unsigned int *ptr, unsigned int oldval, unsigned int newval)
+{
+    int res = 0;
+
+    HAL_MutexLock(logring.atomic_mutex);
+    if (*ptr == oldval) {
+        *ptr = newval;
+        res = 1;
+    }
+    HAL_MutexUnlock(logring.atomic_mutex);
+
+    return res;
+}
+
+static unsigned int _log_async_load(volatile unsigned int *ptr)
+{
+    unsigned int value = 0;
+
+    HAL_MutexLock(logring.atomic_mutex);
+    value = *ptr;
+    HAL_MutexUnlock(logring.atomic_mutex);
+
+    return value;
+}
+
+static unsigned int _log_async_add(volatile unsigned int *ptr, int val)
+{
+    unsigned int value = 0;
+
+    HAL_MutexLock(logring.atomic_mutex);
+    *ptr += val;
+    value = *ptr;
+    HAL_MutexUnlock(logring.atomic_mutex);
+
+    return value;
+}
+#endif
+
+/* wake sink if it announced sleep and nobody else took the flag yet */
+static void _log_async_wakeup(void)
+{
+    if (_log_async_load(&logring.sleeping) && _log_async_cas(&logring.sleeping, 1, 0)) {
+        HAL_SemaphorePost(logring.sem_wakeup);
+    }
+}
+
+/* claim record at head for producer, NULL if ring is full */
+static log_record *_log_async_claim(unsigned int *pos)
+{
+    log_record     *record;
+    unsigned int    cur;
+    int             diff;
+
+    cur = _log_async_load(&logring.head);
+    for (;;) {
+        record = &logring.records[cur % LOG_ASYNC_RECORD_NUM];
+        diff = (int)(_log_async_load(&record->seq) - cur);
+        if (diff == 0) {
+            if (_log_async_cas(&logring.head, cur, cur + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return NULL;
+        }
+        cur = _log_async_load(&logring.head);
+    }
+
+    *pos = cur;
+    return record;
+}
+
+static void *_log_async_sink(void *arg)
+{
+    log_record     *record;
+    unsigned int    dropped = 0;
+    unsigned int    lost;
+    unsigned int    tail;
+    unsigned int    flushing;
+
+    while (1) {
+        lost = _log_async_load(&logring.dropped) - dropped;
+        dropped += lost;
+        if (lost) {
+            LITE_printf("[%s] %u log records dropped\r\n", lvl_names[LOG_WARNING_LEVEL], lost);
+        }
+
+        /* sink is the only one moving tail */
+        tail = logring.tail;
+        record = &logring.records[tail % LOG_ASYNC_RECORD_NUM];
+        if (_log_async_load(&record->seq) != tail + 1) {
+            /* stop waits for producers to publish before it is set, so ring is drained */
+            if (_log_async_load(&logring.stopping)) {
+                break;
+            }
+
+            /* announce sleep then look again, a record published in between is not missed */
+            _log_async_cas(&logring.sleeping, 0, 1);
+            if (_log_async_load(&record->seq) != tail + 1 && !_log_async_load(&logring.stopping)) {
+                HAL_SemaphoreWait(logring.sem_wakeup, PLATFORM_WAIT_INFINITE);
+            } else if (!_log_async_cas(&logring.sleeping, 1, 0)) {
+                /* someone cleared the flag and posts, take it so next wait is not woken early */
+                HAL_SemaphoreWait(logring.sem_wakeup, PLATFORM_WAIT_INFINITE);
+            }
+            continue;
+        }
+
+        _log_output(record->level, record->func, record->line, record->text, record->len, record->truncated);
+
+        /* record becomes free for producer of next round */
+        _log_async_cas(&record->seq, tail + 1, tail + LOG_ASYNC_RECORD_NUM);
+        _log_async_cas(&logring.tail, tail, tail + 1);
+
+        /* generation in CAS keeps a target read for one flusher from waking the next */
+        flushing = _log_async_load(&logring.flushing);
+        if ((flushing & 1) && (int)(tail + 1 - logring.flush_target) >= 0
+            && _log_async_cas(&logring.flushing, flushing, flushing + 1)) {
+            HAL_SemaphorePost(logring.sem_flush);
+        }
+    }
+
+    HAL_SemaphorePost(logring.sem_exit);
+    return NULL;
+}
+
+static void _log_async_stop(void);
+
+/* kept till exit so that callers racing with stop can still lock it */
+static void *_log_async_mutex(void)
+{
+    void *mutex = NULL;
+
+#if UTILS_ATOMIC_LOCK_FREE
+    mutex = UTILS_ATOMIC_LOAD(&logring.mutex);
+    if (mutex != NULL) {
+        return mutex;
+    }
+    mutex = HAL_MutexCreate();
+    if (mutex != NULL && !UTILS_ATOMIC_CAS(&logring.mutex, NULL, mutex)) {
+        HAL_MutexDestroy(mutex);
+    }
+#else
+    if (logring.atomic_mutex == NULL) {
+        logring.atomic_mutex = HAL_MutexCreate();
+        if (logring.atomic_mutex == NULL) {
+            return NULL;
+        }
+    }
+    if (logring.mutex == NULL) {
+        logring.mutex = HAL_MutexCreate();
+    }
+#endif
+
+    return logring.mutex;
+}
+
+/* whole setup runs in mutex, so racing starts create one sink only */
+static void _log_async_start(void)
+{
+    hal_os_thread_param_t task_parms = {0};
+    static int exit_hooked = 0;
+    int stack_used = 0;
+    unsigned int index;
+
+    if (_log_async_mutex() == NULL) {
+        return;
+    }
+
+    HAL_MutexLock(logring.mutex);
+    if (_log_async_load(&logring.running) || _log_async_load(&logring.stopping)) {
+        HAL_MutexUnlock(logring.mutex);
+        return;
+    }
+
+    logring.records = HAL_Malloc(LOG_ASYNC_RECORD_NUM * sizeof(log_record));
+    logring.sem_wakeup = HAL_SemaphoreCreate();
+    logring.sem_exit = HAL_SemaphoreCreate();
+    logring.sem_flush = HAL_SemaphoreCreate();
+    if (logring.records == NULL || logring.sem_wakeup == NULL || logring.sem_exit == NULL || logring.sem_flush == NULL) {
+        goto fail;
+    }
+    for (index = 0; index < LOG_ASYNC_RECORD_NUM; index++) {
+        logring.records[index].seq = index;
+    }
+    logring.head = logring.tail = logring.dropped = 0;
+    logring.sleeping = logring.flushing = 0;
+
+    task_parms.stack_size = 4096;
+    task_parms.name = "log_sink";
+    if (HAL_ThreadCreate(&logring.thread, _log_async_sink, NULL, &task_parms, &stack_used) != 0) {
+        goto fail;
+    }
+    HAL_ThreadDetach(logring.thread);
+
+    /* print what is left in ring when process exits */
+    if (!exit_hooked) {
+        exit_hooked = (atexit(_log_async_stop) == 0);
+    }
+
+    /* set last, with barrier, so producers seeing it also see the ring */
+    _log_async_cas(&logring.running, 0, 1);
+    HAL_MutexUnlock(logring.mutex);
+    return;
+
+fail:
+    if (logring.records) {
+        HAL_Free(logring.records);
+        logring.records = NULL;
+    }
+    if (logring.sem_wakeup) {
+        HAL_SemaphoreDestroy(logring.sem_wakeup);
+        logring.sem_wakeup = NULL;
+    }
+    if (logring.sem_exit) {
+        HAL_SemaphoreDestroy(logring.sem_exit);
+        logring.sem_exit = NULL;
+    }
+    if (logring.sem_flush) {
+        HAL_SemaphoreDestroy(logring.sem_flush);
+        logring.sem_flush = NULL;
+    }
+    HAL_MutexUnlock(logring.mutex);
+}
+
+/* print pending records and stop sink, later logs go synchronous */
+static void _log_async_stop(void)
+{
+    if (logring.mutex == NULL) {
+        return;
+    }
+
+    HAL_MutexLock(logring.mutex);
+    if (!_log_async_cas(&logring.running, 1, 0)) {
+        HAL_MutexUnlock(logring.mutex);
+        return;
+    }
+    HAL_MutexUnlock(logring.mutex);
+
+    /* producers which saw running publish their record before leaving, only once per stop */
+    while (_log_async_load(&logring.writers) != 0) {
+        HAL_SleepMs(1);
+    }
+
+    _log_async_cas(&logring.stopping, 0, 1);
+    _log_async_wakeup();
+    HAL_SemaphoreWait(logring.sem_exit, PLATFORM_WAIT_INFINITE);
+
+    /* start is refused till stopping is cleared, so these are not replaced meanwhile */
+    HAL_MutexLock(logring.mutex);
+    HAL_Free(logring.records);
+    logring.records = NULL;
+    HAL_SemaphoreDestroy(logring.sem_wakeup);
+    logring.sem_wakeup = NULL;
+    HAL_SemaphoreDestroy(logring.sem_exit);
+    logring.sem_exit = NULL;
+    HAL_SemaphoreDestroy(logring.sem_flush);
+    logring.sem_flush = NULL;
+    _log_async_cas(&logring.stopping, 1, 0);
+    HAL_MutexUnlock(logring.mutex);
+}
+
+/*
+ * return 0 if record is handled, -1 if sink is not running and nothing is done,
+ * lock free: producers claim a record by CAS on head and format right into it
+ */
+static int _log_async_post(const int level, const char *f, const int l, const char *fmt, va_list *params)
+{
+    log_record     *record;
+    unsigned int    pos = 0;
+    int             truncated = 0;
+
+    if (logring.mutex == NULL || !logring.running) {
+        return -1;
+    }
+
+    /* stop waits for writers, so the ring stays alive till we leave */
+    _log_async_add(&logring.writers, 1);
+    if (!_log_async_load(&logring.running)) {
+        _log_async_add(&logring.writers, -1);
+        return -1;
+    }
+
+    record = _log_async_claim(&pos);
+    if (record == NULL) {
+        _log_async_add(&logring.dropped, 1);
+        _log_async_add(&logring.writers, -1);
+        return 0;
+    }
+
+    record->func = f;
+    record->line = l;
+    record->level = level;
+    record->len = _log_format(record->text, fmt, params, &truncated);
+    record->truncated = truncated;
+
+    /* CAS also acts as release barrier for record content */
+    _log_async_cas(&record->seq, pos, pos + 1);
+    _log_async_wakeup();
+
+    _log_async_add(&logring.writers, -1);
+    return 0;
+}
+#endif  /* #ifdef LOG_ASYNC_ENABLED */
+
+/* wait till sink printed what is queued now, stop is held off meanwhile by mutex */
+void LITE_syslog_flush(void)
+{
+#ifdef LOG_ASYNC_ENABLED
+    unsigned int    flushing;
+
+    if (logring.mutex == NULL) {
+        return;
+    }
+
+    HAL_MutexLock(logring.mutex);
+    if (_log_async_load(&logring.running)) {
+        /* flushers are serialized by mutex, so generation is even and stable here */
+        flushing = _log_async_load(&logring.flushing);
+        logring.flush_target = _log_async_load(&logring.head);
+        _log_async_cas(&logring.flushing, flushing, flushing + 1);
+
+        /* sink posts once tail passes target, unless we find it passed and move generation on first */
+        if ((int)(_log_async_load(&logring.tail) - logring.flush_target) < 0
+            || !_log_async_cas(&logring.flushing, flushing + 1, flushing + 2)) {
+            HAL_SemaphoreWait(logring.sem_flush, PLATFORM_WAIT_INFINITE);
+        }
+    }
+    HAL_MutexUnlock(logring.mutex);
+#endif
+}
+
+void LITE_syslog_routine(char *m, const char *f, const int l, const int level, const char *fmt, va_list *params)
+{
+    char       *tmpbuf = logcb.text_buf;
+    int         truncated = 0;
+    int         len;
+
+    if (LITE_get_loglevel() < level || level < LOG_NONE_LEVEL) {
+        return;
+    }
+
+#ifdef LOG_ASYNC_ENABLED
+    /* fatal logs are printed right away in case of no chance later */
+    if (level > LOG_CRIT_LEVEL && _log_async_post(level, f, l, fmt, params) == 0) {
+        return;
+    }
+#endif
+
+    LITE_syslog_flush();
+    len = _log_format(tmpbuf, fmt, params, &truncated);
+    _log_output(level, f, l, tmpbuf, len, truncated);
     return;
 }
 
@@ -80,6 +438,14 @@ void LITE_set_loglevel(int pri)
 {
     logcb.priority = pri;
 
+#ifdef LOG_ASYNC_ENABLED
+    if (pri != LOG_NONE_LEVEL) {
+        _log_async_start();
+    } else {
+        _log_async_stop();
+    }
+#endif
+
 #if WITH_MEM_STATS
     void **mutex = LITE_get_mem_mutex();
     if (pri != LOG_NONE_LEVEL) {
@@ -107,6 +473,7 @@ void LITE_rich_hexdump(const char *f, const int l,
         return;
     }
 
+    LITE_syslog_flush();
     LITE_printf("%s%s", "\033", lvl_color[level]);
     LITE_printf(LOG_PREFIX_FMT, lvl_names[level], f, l);
     LITE_printf("HEXDUMP %s @ %p[%d]\r\n", buf_str, buf_ptr, buf_len);
@@ -127,6 +494,7 @@ int log_multi_line_internal(const char *f, const int l,
         return 1;
     }
 
+    LITE_syslog_flush();
     LITE_printf("[%s] %s(%d): %s (Length: %d Bytes)\r\n",
                 lvl_names[LITE_get_loglevel()], f, l, title, (int)strlen(payload));
 
@@ -177,6 +545,7 @@ int LITE_hexdump(const char *title, const void *buff, const int len)
     char                    header[64] = {0};
     unsigned char          *buf = (unsigned char *)buff;
 
+    LITE_syslog_flush();
     LITE_snprintf(header, sizeof(header), "| %s: (len=%d) |\r\n", title, (int)len);
 
     LITE_HEXDUMP_DRAWLINE("+", strlen(header) - 4, "+");
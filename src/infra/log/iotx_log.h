@@ -22,6 +22,8 @@ int     LITE_hexdump(const char *title, const void *buf, const int len);
 
 void    LITE_syslog_routine(char *m, const char *f, const int l, const int level, const char *fmt, va_list *params);
 void    LITE_syslog(char *m, const char *f, const int l, const int level, const char *fmt, ...);
+/* wait for logs queued so far to be printed, call before printing with LITE_printf() directly */
+void    LITE_syslog_flush(void);
 
 #define LOG_NONE_LEVEL                  (0)     /* no log printed at all */
 #define LOG_CRIT_LEVEL                  (1)     /* current application aborting */
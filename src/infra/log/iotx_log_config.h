@@ -27,4 +27,18 @@
     #define LOG_MSG_MAXLEN              (512)
 #endif
 
+/*
+ * LOG_ASYNC_ENABLED, set by board config, prints from a sink thread of 4KB stack and callers
+ * only format into a ring of LOG_ASYNC_RECORD_NUM records, each of LOG_MSG_MAXLEN bytes text
+ */
+
+#ifndef LOG_ASYNC_RECORD_NUM
+    #define LOG_ASYNC_RECORD_NUM        (64)
+#endif
+
+/* ring positions wrap at 2^32, which only maps onto the same record if the count divides it */
+#if (LOG_ASYNC_RECORD_NUM & (LOG_ASYNC_RECORD_NUM - 1)) != 0
+    #error "LOG_ASYNC_RECORD_NUM must be power of 2"
+#endif
+
 #endif  /* __LITE_LOG_CONFIG_H__ */
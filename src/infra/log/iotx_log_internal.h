@@ -23,4 +23,40 @@ typedef struct {
     char            text_buf[LOG_MSG_MAXLEN + 1];
 } log_client;
 
+#ifdef LOG_ASYNC_ENABLED
+/*
+ * One record of the ring, @seq tells its owner like dm_ipc slots:
+ * seq == pos: free for producer of position pos, seq == pos + 1: ready for sink.
+ */
+typedef struct {
+    volatile unsigned int seq;
+    const char     *func;
+    int             line;
+    short           level;
+    short           truncated;
+    int             len;
+    char            text[LOG_MSG_MAXLEN + 1];
+} log_record;
+
+/* records in [tail, head) are claimed or pending, head and tail only grow */
+typedef struct {
+    void           *mutex;          /* start, stop and flush only, never taken by producers or sink */
+    void           *atomic_mutex;   /* emulates atomics when UTILS_ATOMIC_LOCK_FREE is 0 */
+    void           *sem_wakeup;
+    void           *sem_exit;
+    void           *sem_flush;
+    void           *thread;
+    log_record     *records;
+    volatile unsigned int head;
+    volatile unsigned int tail;
+    volatile unsigned int dropped;
+    volatile unsigned int writers;  /* producers between checking running and publishing */
+    volatile unsigned int flush_target;
+    volatile unsigned int running;
+    volatile unsigned int stopping;
+    volatile unsigned int sleeping; /* sink waits on sem_wakeup, whoever clears it posts */
+    volatile unsigned int flushing; /* generation, odd while a flusher waits on sem_flush */
+} log_async_ring;
+#endif
+
 #endif  /* __LITE_LOG_INTERNAL_H__ */
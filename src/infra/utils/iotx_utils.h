@@ -23,6 +23,7 @@
 #include "utils_httpc.h"
 #include "lite-cjson.h"
 #include "lite-list.h"
+#include "utils_slab.h"
 #include "string_utils.h"
 #include "json_parser.h"
 #include "utils_md5.h"
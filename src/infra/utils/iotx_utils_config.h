@@ -21,6 +21,16 @@
     #define WITH_MEM_STATS_PER_MODULE       0
 #endif
 
+/* backtrace one of every N allocations when WITH_MEM_STATS, 0 for none */
+#ifndef WITH_MEM_STATS_BT_SAMPLE
+    #define WITH_MEM_STATS_BT_SAMPLE        16
+#endif
+
+/* carve small hot objects of SDK modules from slab pages, 0 to allocate each from heap */
+#ifndef WITH_SLAB_POOL
+    #define WITH_SLAB_POOL                  1
+#endif
+
 #ifndef WITH_JSON_KEYS_OF
     #define WITH_JSON_KEYS_OF               0
 #endif
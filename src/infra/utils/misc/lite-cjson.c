@@ -562,10 +562,28 @@ int lite_cjson_is_object(_IN_ lite_cjson_t *lite)
     return (lite->type & 0xFF) == cJSON_Object;
 }
 
-int lite_cjson_array_item(_IN_ lite_cjson_t *lite, _IN_ int index, _OU_ lite_cjson_t *lite_item)
+int lite_cjson_iter_init(_IN_ lite_cjson_t *lite, _OU_ lite_cjson_iter_t *iter)
 {
-    if (!lite || lite->type != cJSON_Array || !lite->value ||
-        index < 0 || index >= lite->size || !lite_item) {
+    if (iter) {
+        memset(iter, 0, sizeof(lite_cjson_iter_t));
+    }
+
+    if (!lite || !iter || !lite->value || lite->value_length < 2 ||
+        (lite->type != cJSON_Array && lite->type != cJSON_Object)) {
+        return -1;
+    }
+
+    iter->lite = lite;
+    iter->offset = 1; /* right behind '[' or '{' */
+    iter->index = 0;
+
+    return 0;
+}
+
+int lite_cjson_iter_next(_IN_ lite_cjson_iter_t *iter, _OU_ lite_cjson_t *lite_item_key,
+                         _OU_ lite_cjson_t *lite_item_value)
+{
+    if (!iter || !iter->lite || !lite_item_value || iter->index >= iter->lite->size) {
         return -1;
     }
 
@@ -573,56 +591,73 @@ int lite_cjson_array_item(_IN_ lite_cjson_t *lite, _IN_ int index, _OU_ lite_cjs
     parse_buffer *p_buffer = &buffer;
 
     memset(&buffer, 0, sizeof(parse_buffer));
-    buffer.content = (const unsigned char *)lite->value;
-    buffer.length = lite->value_length;
-    buffer.offset = 0;
+    buffer.content = (const unsigned char *)iter->lite->value;
+    buffer.length = iter->lite->value_length;
+    buffer.offset = iter->offset;
 
-    lite_cjson_t current_item;
-    //int start_pos = p_buffer->offset;
-    int iter_index = 0;
+    lite_cjson_t current_item_key;
+    lite_cjson_t current_item_value;
 
-    if (buffer_at_offset(p_buffer)[0] != '[') {
-        /* not an array */
-        return -1;
+    memset(&current_item_key, 0, sizeof(lite_cjson_t));
+    memset(&current_item_value, 0, sizeof(lite_cjson_t));
+
+    buffer_skip_whitespace(p_buffer);
+    if (iter->lite->type == cJSON_Object) {
+        /* parse the name of the child */
+        if (parse_string(&current_item_key, p_buffer) != 0) {
+            return -1; /* faile to parse name */
+        }
+        buffer_skip_whitespace(p_buffer);
+
+        if (cannot_access_at_index(p_buffer, 0) || (buffer_at_offset(p_buffer)[0] != ':')) {
+            return -1; /* invalid object */
+        }
+        p_buffer->offset++;
+        buffer_skip_whitespace(p_buffer);
     }
 
-    p_buffer->offset++;
+    /* parse the value */
+    if (parse_value(&current_item_value, p_buffer) != 0) {
+        return -1; /* failed to parse value */
+    }
     buffer_skip_whitespace(p_buffer);
-    if (can_access_at_index(p_buffer, 0) && (buffer_at_offset(p_buffer)[0] == ']')) {
-        /* empty array */
-        return -1;
+
+    /* step over the comma in front of next child */
+    if (can_access_at_index(p_buffer, 0) && (buffer_at_offset(p_buffer)[0] == ',')) {
+        p_buffer->offset++;
     }
 
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(p_buffer, 0)) {
-        p_buffer->offset--;
-        return -1;
+    iter->offset = p_buffer->offset;
+    iter->index++;
+
+    if (lite_item_key && iter->lite->type == cJSON_Object) {
+        memcpy(lite_item_key, &current_item_key, sizeof(lite_cjson_t));
     }
+    memcpy(lite_item_value, &current_item_value, sizeof(lite_cjson_t));
 
-    /* step back to character in front of the first element */
-    p_buffer->offset--;
-    /* loop through the comma separated array elements */
-    do {
-        memset(&current_item, 0, sizeof(lite_cjson_t));
+    return 0;
+}
 
-        /* parse next value */
-        p_buffer->offset++;
-        buffer_skip_whitespace(p_buffer);
-        if (parse_value(&current_item, p_buffer) != 0) {
-            return -1; /* failed to parse value */
-        }
-        buffer_skip_whitespace(p_buffer);
+int lite_cjson_array_item(_IN_ lite_cjson_t *lite, _IN_ int index, _OU_ lite_cjson_t *lite_item)
+{
+    if (!lite || lite->type != cJSON_Array || !lite->value ||
+        index < 0 || index >= lite->size || !lite_item) {
+        return -1;
+    }
 
-        //printf("current item index: %d, type: %d, length: %d, value: %.*s\n",
-        //  iter_index+1, current_item.type, current_item.value_length, current_item.value_length, current_item.value);
+    lite_cjson_iter_t iter;
+    lite_cjson_t current_item;
+
+    if (lite_cjson_iter_init(lite, &iter) != 0) {
+        return -1;
+    }
 
-        if (iter_index == index) {
+    while (lite_cjson_iter_next(&iter, NULL, &current_item) == 0) {
+        if (iter.index - 1 == index) {
             memcpy(lite_item, &current_item, sizeof(lite_cjson_t));
             return 0;
         }
-
-        iter_index++;
-    } while (can_access_at_index(p_buffer, 0) && (buffer_at_offset(p_buffer)[0] == ','));
+    }
 
     return -1;
 }
@@ -634,74 +669,21 @@ static int _lite_cjson_object_item(_IN_ lite_cjson_t *lite, _IN_ const char *key
         return -1;
     };
 
-    parse_buffer buffer;
-    parse_buffer *p_buffer = &buffer;
-
-    memset(&buffer, 0, sizeof(parse_buffer));
-    buffer.content = (const unsigned char *)lite->value;
-    buffer.length = lite->value_length;
-    buffer.offset = 0;
-
+    lite_cjson_iter_t iter;
     lite_cjson_t current_item_key;
     lite_cjson_t current_item_value;
-    //int start_pos = p_buffer->offset;
-    int index = 0;
-
-    if (cannot_access_at_index(p_buffer, 0) || (buffer_at_offset(p_buffer)[0] != '{')) {
-        return -1; /* not an object */
-    }
-
-    p_buffer->offset++;
-    buffer_skip_whitespace(p_buffer);
-    if (can_access_at_index(p_buffer, 0) && (buffer_at_offset(p_buffer)[0] == '}')) {
-        return -1; /* empty object */
-    }
 
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(p_buffer, 0)) {
-        p_buffer->offset--;
+    if (lite_cjson_iter_init(lite, &iter) != 0) {
         return -1;
     }
 
-    /* step back to character in front of the first element */
-    p_buffer->offset--;
-    /* loop through the comma separated array elements */
-    do {
-        memset(&current_item_key, 0, sizeof(lite_cjson_t));
-        memset(&current_item_value, 0, sizeof(lite_cjson_t));
-
-        /* parse the name of the child */
-        p_buffer->offset++;
-        buffer_skip_whitespace(p_buffer);
-        if (parse_string(&current_item_key, p_buffer) != 0) {
-            return -1; /* faile to parse name */
-        }
-        buffer_skip_whitespace(p_buffer);
-
-        if (cannot_access_at_index(p_buffer, 0) || (buffer_at_offset(p_buffer)[0] != ':')) {
-            return -1; /* invalid object */
-        }
-
-        /* parse the value */
-        p_buffer->offset++;
-        buffer_skip_whitespace(p_buffer);
-        if (parse_value(&current_item_value, p_buffer) != 0) {
-            return -1; /* failed to parse value */
-        }
-        buffer_skip_whitespace(p_buffer);
-
-        //printf("Current Object [Index: %d], [Key Length: %d, Key Value: %.*s], [Value Length: %d, Value: %.*s]\n",
-        //  index + 1, current_item_key.value_length,current_item_key.value_length,current_item_key.value,
-        //  current_item_value.value_length,current_item_value.value_length,current_item_value.value);
-        index++;
-
-        //printf("key: %s, ken_len: %d\n",key,key_len);
+    while (lite_cjson_iter_next(&iter, &current_item_key, &current_item_value) == 0) {
         if ((current_item_key.value_length == key_len) &&
             memcmp(current_item_key.value, key, key_len) == 0) {
             memcpy(lite_item, &current_item_value, sizeof(lite_cjson_t));
             return 0;
         }
-    } while (can_access_at_index(p_buffer, 0) && (buffer_at_offset(p_buffer)[0] == ','));
+    }
 
     return -1;
 }
@@ -842,71 +824,16 @@ int lite_cjson_object_item_by_index(_IN_ lite_cjson_t *lite, _IN_ int index, _OU
         return -1;
     };
 
-    parse_buffer buffer;
-    parse_buffer *p_buffer = &buffer;
-
-    memset(&buffer, 0, sizeof(parse_buffer));
-    buffer.content = (const unsigned char *)lite->value;
-    buffer.length = lite->value_length;
-    buffer.offset = 0;
-
+    lite_cjson_iter_t iter;
     lite_cjson_t current_item_key;
     lite_cjson_t current_item_value;
-    //int start_pos = p_buffer->offset;
-    int item_index = 0;
-
-    if (cannot_access_at_index(p_buffer, 0) || (buffer_at_offset(p_buffer)[0] != '{')) {
-        return -1; /* not an object */
-    }
-
-    p_buffer->offset++;
-    buffer_skip_whitespace(p_buffer);
-    if (can_access_at_index(p_buffer, 0) && (buffer_at_offset(p_buffer)[0] == '}')) {
-        return -1; /* empty object */
-    }
 
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(p_buffer, 0)) {
-        p_buffer->offset--;
+    if (lite_cjson_iter_init(lite, &iter) != 0) {
         return -1;
     }
 
-    /* step back to character in front of the first element */
-    p_buffer->offset--;
-    /* loop through the comma separated array elements */
-    do {
-        memset(&current_item_key, 0, sizeof(lite_cjson_t));
-        memset(&current_item_value, 0, sizeof(lite_cjson_t));
-
-        /* parse the name of the child */
-        p_buffer->offset++;
-        buffer_skip_whitespace(p_buffer);
-        if (parse_string(&current_item_key, p_buffer) != 0) {
-            return -1; /* faile to parse name */
-        }
-        buffer_skip_whitespace(p_buffer);
-
-        if (cannot_access_at_index(p_buffer, 0) || (buffer_at_offset(p_buffer)[0] != ':')) {
-            return -1; /* invalid object */
-        }
-
-        /* parse the value */
-        p_buffer->offset++;
-        buffer_skip_whitespace(p_buffer);
-        if (parse_value(&current_item_value, p_buffer) != 0) {
-            return -1; /* failed to parse value */
-        }
-        buffer_skip_whitespace(p_buffer);
-
-        //printf("Current Object [Index: %d], [Key Length: %d, Key Value: %.*s], [Value Length: %d, Value: %.*s]\n",
-        //  index + 1, current_item_key.value_length,current_item_key.value_length,current_item_key.value,
-        //  current_item_value.value_length,current_item_value.value_length,current_item_value.value);
-
-        //printf("index:%d, key: %.*s, value: %.*s\n",index,
-        //  current_item_key.value_length,current_item_key.value,
-        //  current_item_value.value_length,current_item_value.value);
-
-        if (item_index == index) {
+    while (lite_cjson_iter_next(&iter, &current_item_key, &current_item_value) == 0) {
+        if (iter.index - 1 == index) {
             if (lite_item_key) {
                 memcpy(lite_item_key, &current_item_key, sizeof(lite_cjson_t));
             }
@@ -915,9 +842,7 @@ int lite_cjson_object_item_by_index(_IN_ lite_cjson_t *lite, _IN_ int index, _OU
             }
             return 0;
         }
-
-        item_index++;
-    } while (can_access_at_index(p_buffer, 0) && (buffer_at_offset(p_buffer)[0] == ','));
+    }
 
     return -1;
 }
@@ -956,6 +881,23 @@ static void internal_free(void *ptr)
 }
 
 static internal_hooks global_hooks = { internal_malloc, internal_free, NULL };
+
+/* items are all of one size and short lived, so they come from slab while default hooks are in use */
+#ifndef LITE_CJSON_SLAB_PAGE_SIZE
+    #define LITE_CJSON_SLAB_PAGE_SIZE       (1024)
+#endif
+#ifndef LITE_CJSON_SLAB_MAX_PAGES
+    #define LITE_CJSON_SLAB_MAX_PAGES       (8)
+#endif
+
+static const utils_slab_config_t lite_cjson_slab_config = {
+    "cjson", LITE_CJSON_SLAB_PAGE_SIZE, LITE_CJSON_SLAB_MAX_PAGES, 1, { sizeof(lite_cjson_item_t) }
+};
+
+static utils_slab_pool_t lite_cjson_slab = UTILS_SLAB_POOL_INIT(&lite_cjson_slab_config);
+
+static int lite_cjson_item_slab = 1;
+
 static cJSON_bool print_value(const lite_cjson_item_t *const item, printbuffer *const output_buffer);
 
 void lite_cjson_init_hooks(lite_cjson_hooks *hooks)
@@ -966,6 +908,7 @@ void lite_cjson_init_hooks(lite_cjson_hooks *hooks)
 
     global_hooks.allocate = hooks->malloc_fn;
     global_hooks.deallocate = hooks->free_fn;
+    lite_cjson_item_slab = (hooks->malloc_fn == internal_malloc && hooks->free_fn == internal_free);
 }
 
 static unsigned char *ensure(printbuffer *const p, size_t needed)
@@ -1528,7 +1471,11 @@ void lite_cjson_delete(lite_cjson_item_t *item)
         if (!(item->type & cJSON_StringIsConst) && (item->string != NULL)) {
             global_hooks.deallocate(item->string);
         }
-        global_hooks.deallocate(item);
+        if (lite_cjson_item_slab) {
+            utils_slab_free(item);
+        } else {
+            global_hooks.deallocate(item);
+        }
         item = next;
     }
 }
@@ -1631,7 +1578,13 @@ void lite_cjson_add_item_to_object(lite_cjson_item_t *object, const char *string
 
 static lite_cjson_item_t *cJSON_New_Item(const internal_hooks *const hooks)
 {
-    lite_cjson_item_t *node = (lite_cjson_item_t *)hooks->allocate(sizeof(lite_cjson_item_t));
+    lite_cjson_item_t *node = NULL;
+
+    if (lite_cjson_item_slab) {
+        return (lite_cjson_item_t *)utils_slab_alloc(&lite_cjson_slab, sizeof(lite_cjson_item_t));
+    }
+
+    node = (lite_cjson_item_t *)hooks->allocate(sizeof(lite_cjson_item_t));
     if (node) {
         memset(node, '\0', sizeof(lite_cjson_item_t));
     }
@@ -66,6 +66,21 @@ int lite_cjson_object_item_by_index(
             _OU_ lite_cjson_t *lite_item_key,
             _OU_ lite_cjson_t *lite_item_value);
 
+/* Cursor over children of array or object, each step parses only the next child */
+typedef struct {
+    lite_cjson_t *lite;     /* array or object walked through */
+    int offset;             /* offset of next child in lite->value */
+    int index;              /* index of next child */
+} lite_cjson_iter_t;
+
+int lite_cjson_iter_init(_IN_ lite_cjson_t *lite, _OU_ lite_cjson_iter_t *iter);
+
+/* fetch next child, @lite_item_key is only filled for object and may be NULL, return -1 at end */
+int lite_cjson_iter_next(
+            _IN_ lite_cjson_iter_t *iter,
+            _OU_ lite_cjson_t *lite_item_key,
+            _OU_ lite_cjson_t *lite_item_value);
+
 
 /*** lite_cjson create, add and print ***/
 #if defined(ALCS_ENABLED) || defined(DEPRECATED_LINKKIT)
@@ -95,6 +110,10 @@ typedef struct {
     void(*free_fn)(void *ptr);
 } lite_cjson_hooks;
 
+/*
+ * Items are taken from a slab pool while default hooks are in use, and from @hooks once others are set.
+ * Shall be called before any item is created, since items are released the way of hooks in use then.
+ */
 void lite_cjson_init_hooks(lite_cjson_hooks *hooks);
 
 /* Render a lite_cjson_item_t entity to text for transfer/storage. Free the char* when finished. */
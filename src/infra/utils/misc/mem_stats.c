@@ -3,13 +3,126 @@
  */
 
 #include "iotx_utils_internal.h"
+#include "utils_atomic.h"
 #include "mem_stats.h"
 
-LIST_HEAD(mem_recs);
+#if WITH_MEM_STATS
 
-#if WITH_MEM_STATS_PER_MODULE
-LIST_HEAD(mem_module_statis);
+/*
+ * Each buffer is preceded by its OS_malloc_record. Records are linked in
+ * buckets hashed by address for reports. Free reaches the record right in
+ * front of the buffer, and only trusts it when its check word matches its own
+ * address and it points back to the bucket of that address, so pointers not
+ * from LITE_malloc and buffers freed twice are caught without a search.
+ * Counters are updated with atomics and buckets have their own spin lock,
+ * mutex_mem_stats is only taken by reports. Compilers without atomic builtins
+ * fall back to serialize everything with mutex_mem_stats.
+ */
+#define MEM_STATS_HDR_LEN           ((sizeof(OS_malloc_record) + 15) & ~15)
+#define MEM_STATS_BUCKET_NUM        (256)
+#define MEM_STATS_MODULE_MAX        (64)
+#define MEM_STATS_SPIN_MAX          (64)    /* spins before yielding cpu to lock holder */
+#define MEM_STATS_DUMP_HEAD_LEN     (32)    /* leading bytes of buffer printed in report */
+#define MEM_STATS_REC_CHECK(rec)    ((unsigned long)(rec) ^ 0x4D454D53UL)   /* check word of live record */
+
+#if UTILS_ATOMIC_LOCK_FREE
+    #define MEM_STATS_ADD(p, v)         UTILS_ATOMIC_ADD((p), (v))
+    #define MEM_STATS_LOAD(p)           UTILS_ATOMIC_LOAD(p)
+    #define MEM_STATS_CAS(p, o, n)      UTILS_ATOMIC_CAS((p), (o), (n))
+    #define MEM_STATS_SPIN_LOCK(l)      _mem_stats_spin_lock(l)
+    #define MEM_STATS_SPIN_UNLOCK(l)    UTILS_ATOMIC_CAS((l), 1, 0)
+    #define MEM_STATS_ENTER()
+    #define MEM_STATS_LEAVE()
+#else
+    #define MEM_STATS_ADD(p, v)         (*(p) += (v))
+    #define MEM_STATS_LOAD(p)           (*(p))
+    #define MEM_STATS_CAS(p, o, n)      (*(p) = (n), 1)
+    #define MEM_STATS_SPIN_LOCK(l)
+    #define MEM_STATS_SPIN_UNLOCK(l)
+    #define MEM_STATS_ENTER()           do { if (mutex_mem_stats) HAL_MutexLock(mutex_mem_stats); } while (0)
+    #define MEM_STATS_LEAVE()           do { if (mutex_mem_stats) HAL_MutexUnlock(mutex_mem_stats); } while (0)
+#endif
+
+typedef int mem_stats_lock_t;
 
+typedef struct {
+    mem_stats_lock_t    lock;
+    list_head_t         recs;           /* zeroed until first record */
+} mem_stats_bucket_t;
+
+static mem_stats_bucket_t mem_recs[MEM_STATS_BUCKET_NUM];
+
+static void *mutex_mem_stats = NULL;
+static int bytes_total_allocated;
+static int bytes_total_freed;
+static int bytes_total_in_use;
+static int bytes_max_allocated;
+static int bytes_max_in_use;
+static int iterations_allocated;
+static int iterations_freed;
+static int iterations_in_use;
+static int iterations_max_in_use;
+
+#if UTILS_ATOMIC_LOCK_FREE
+/* holders never block, but may be preempted, so give up the rest of slice rather than burn it */
+static void _mem_stats_spin_lock(mem_stats_lock_t *lock)
+{
+    int spins = 0;
+
+    while (!UTILS_ATOMIC_CAS(lock, 0, 1)) {
+        if (++spins >= MEM_STATS_SPIN_MAX) {
+#if defined(_PLATFORM_IS_LINUX_)
+            sched_yield();
+#else
+            HAL_SleepMs(0);
+#endif
+            spins = 0;
+        }
+    }
+}
+#endif
+
+static void _mem_stats_max(int *max, int value)
+{
+    int old;
+
+    do {
+        old = MEM_STATS_LOAD(max);
+        if (old >= value) {
+            return;
+        }
+    } while (!MEM_STATS_CAS(max, old, value));
+}
+
+static mem_stats_bucket_t *_mem_bucket(OS_malloc_record *rec)
+{
+    unsigned long addr = (unsigned long)rec >> 4;
+
+    return &mem_recs[(addr ^ (addr >> 7)) & (MEM_STATS_BUCKET_NUM - 1)];
+}
+
+/* record of @ptr if it is from LITE_malloc and not freed yet, unlinked if @unlink, otherwise NULL */
+static OS_malloc_record *_mem_record(void *ptr, int unlink)
+{
+    OS_malloc_record *rec = (OS_malloc_record *)((char *)ptr - MEM_STATS_HDR_LEN);
+    mem_stats_bucket_t *bucket = _mem_bucket(rec);
+    OS_malloc_record *found = NULL;
+
+    /* checked in bucket lock, so that only one of racing frees gets the record */
+    MEM_STATS_SPIN_LOCK(&bucket->lock);
+    if (rec->check == MEM_STATS_REC_CHECK(rec) && rec->bucket == (void *)bucket) {
+        found = rec;
+        if (unlink) {
+            list_del(&rec->list);
+            rec->check = 0;
+        }
+    }
+    MEM_STATS_SPIN_UNLOCK(&bucket->lock);
+
+    return found;
+}
+
+#if WITH_MEM_STATS_PER_MODULE
 typedef struct {
     char *func_name;
     int line;
@@ -31,101 +144,249 @@ typedef struct {
 } mem_statis_t;
 
 typedef struct {
+    const char     *name_ref;           /* name pointer it was created with, checked before strcmp */
     mem_statis_t    mem_statis;
-    list_head_t     list;
 } module_mem_t;
 
-#if WITH_MEM_STATS
-/* sort module used */
-static int _mem_cmp_max_used(list_head_t *a, list_head_t *b)
+/* append only, entries below mem_module_num are complete */
+static module_mem_t *mem_modules[MEM_STATS_MODULE_MAX];
+static int mem_module_num;
+static mem_stats_lock_t mem_module_lock;
+
+static module_mem_t *_find_mem_table(const char *module_name, int from, int to)
 {
-    if (a == NULL || b == NULL) {
-        return 0;
-    }
+    int i;
 
-    module_mem_t *temp_a = list_entry(a, module_mem_t, list);
-    module_mem_t *temp_b = list_entry(b, module_mem_t, list);
+    for (i = from; i < to; i++) {
+        if (mem_modules[i]->name_ref == module_name || !strcmp(module_name, mem_modules[i]->mem_statis.module_name)) {
+            return mem_modules[i];
+        }
+    }
 
-    /* return true to swap if a < b */
-    return (temp_a->mem_statis.bytes_max_in_use < temp_b->mem_statis.bytes_max_in_use);
+    return NULL;
 }
 
-static void _mem_swap_module_pos(list_head_t *a, list_head_t *b)
+static module_mem_t *_get_mem_table(const char *module_name)
 {
-    list_head_t temp = {NULL, NULL};
+    module_mem_t *pos = NULL;
+    int num = MEM_STATS_LOAD(&mem_module_num);
+    int len = 0;
 
-    if (a == NULL || a == NULL) {
-        return;
+    pos = _find_mem_table(module_name, 0, num);
+    if (pos) {
+        return pos;
+    }
+
+    MEM_STATS_SPIN_LOCK(&mem_module_lock);
+    pos = _find_mem_table(module_name, num, mem_module_num);
+    if (!pos && mem_module_num < MEM_STATS_MODULE_MAX) {
+        pos = UTILS_malloc(sizeof(module_mem_t));
+        if (pos) {
+            memset(pos, 0, sizeof(module_mem_t));
+            pos->name_ref = module_name;
+            len = strlen(module_name);
+            memcpy(pos->mem_statis.module_name, module_name,
+                   (len >= sizeof(pos->mem_statis.module_name)) ? (sizeof(pos->mem_statis.module_name) - 1) : len);
+            INIT_LIST_HEAD(&pos->mem_statis.calling_stack.func_head);
+
+            mem_modules[mem_module_num] = pos;
+            MEM_STATS_ADD(&mem_module_num, 1);
+        }
     }
+    MEM_STATS_SPIN_UNLOCK(&mem_module_lock);
 
-    list_add(&temp, b);
-    list_del(b);
-    list_add(b, a);
-    list_del(a);
-    list_add(a, &temp);
-    list_del(&temp);
+    return pos;
 }
 
-static void _mem_sort_module_pos(list_head_t *head)
+static void _count_malloc_internal(const char *f, const int l, OS_malloc_record *os_malloc_pos, va_list ap)
 {
-    list_head_t *start = NULL;
-    list_head_t *end = NULL;
+    int magic = 0;
+    char is_repeat = 0;
+    char *module_name = NULL;
+    module_mem_t *pos = NULL;
+    mem_statis_t *statis = NULL;
+    calling_stack_t    *call_pos;
+    calling_stack_t    *entry = NULL;
 
-    if (head == NULL) {
+    magic = va_arg(ap, int);
+    if (MEM_MAGIC == magic) {
+        module_name = va_arg(ap, char *);
+    } else {
+        module_name = "unknown";
+    }
+
+    pos = _get_mem_table(module_name);
+    if (!pos) {
+        utils_err("create_mem_table:[%s] failed!", module_name);
         return;
     }
+    os_malloc_pos->mem_table = (void *)pos;
+    statis = &pos->mem_statis;
 
-    for (end = head->prev; end != head; end = end->prev) {  /* list_for_each_prev */
-        list_for_each(start, head) {
-            if (start == end) {
+    if (!strcmp(statis->module_name, "unknown")) {
+        MEM_STATS_SPIN_LOCK(&mem_module_lock);
+        list_for_each_entry(call_pos, &statis->calling_stack.func_head, func_head, calling_stack_t) {
+            if (call_pos->line == l && !strcmp(call_pos->func_name, f)) {
+                is_repeat = 1;
                 break;
             }
-
-            if (_mem_cmp_max_used(start, start->next)) {
-                _mem_swap_module_pos(start, start->next);
-
-                start = start->prev;
-                if (start == end) {
-                    end = end->next;
+        }
+        if (!is_repeat) {
+            entry = UTILS_malloc(sizeof(calling_stack_t));
+            if (entry) {
+                memset(entry, 0, sizeof(calling_stack_t));
+                entry->func_name = UTILS_malloc(strlen(f) + 1);
+                if (entry->func_name) {
+                    strcpy(entry->func_name, f);
+                    entry->line = l;
+                    list_add(&entry->func_head, &statis->calling_stack.func_head);
+                } else {
+                    UTILS_free(entry);
                 }
             }
         }
+        MEM_STATS_SPIN_UNLOCK(&mem_module_lock);
     }
+
+    MEM_STATS_ADD(&statis->iterations_allocated, 1);
+    MEM_STATS_ADD(&statis->bytes_total_allocated, os_malloc_pos->buflen);
+    _mem_stats_max(&statis->bytes_max_in_use, MEM_STATS_ADD(&statis->bytes_total_in_use, os_malloc_pos->buflen));
+    _mem_stats_max(&statis->bytes_max_allocated, os_malloc_pos->buflen);
+    _mem_stats_max(&statis->iterations_max_in_use, MEM_STATS_ADD(&statis->iterations_in_use, 1));
 }
-#endif /* WITH_MEM_STATS */
-#endif /* WITH_MEM_STATS_PER_MODULE */
 
-#if WITH_MEM_STATS
-    static void *mutex_mem_stats = NULL;
-    static int bytes_total_allocated;
-    static int bytes_total_freed;
-    static int bytes_total_in_use;
-    static int bytes_max_allocated;
-    static int bytes_max_in_use;
-    static int iterations_allocated;
-    static int iterations_freed;
-    static int iterations_in_use;
-    static int iterations_max_in_use;
-#endif
+static void _count_free_internal(OS_malloc_record *os_malloc_pos)
+{
+    module_mem_t *pos = NULL;
+
+    pos = (module_mem_t *)(os_malloc_pos->mem_table);
+    if (!pos) {
+        return;
+    }
+
+    MEM_STATS_ADD(&pos->mem_statis.iterations_freed, 1);
+    MEM_STATS_ADD(&pos->mem_statis.iterations_in_use, -1);
+
+    MEM_STATS_ADD(&pos->mem_statis.bytes_total_freed, os_malloc_pos->buflen);
+    MEM_STATS_ADD(&pos->mem_statis.bytes_total_in_use, -os_malloc_pos->buflen);
+}
+
+static void _dump_mem_tables(void)
+{
+    module_mem_t *sorted[MEM_STATS_MODULE_MAX];
+    module_mem_t *module_pos;
+    module_mem_t *unknown_mod = NULL;
+    int num = MEM_STATS_LOAD(&mem_module_num);
+    int i, j;
+
+    /* sort by max in use, descending */
+    for (i = 0; i < num; i++) {
+        module_pos = mem_modules[i];
+        for (j = i; j > 0 && sorted[j - 1]->mem_statis.bytes_max_in_use < module_pos->mem_statis.bytes_max_in_use; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = module_pos;
+    }
+
+    LITE_printf("\r\n");
+    LITE_printf("|               |  max_in_use          |  max_allocated   |  total_allocated      |  total_free\r\n");
+    LITE_printf("|---------------|----------------------|------------------|-----------------------|----------------------\r\n");
+    for (i = 0; i < num; i++) {
+        module_pos = sorted[i];
+        LITE_printf("| %-13s | %6d bytes / %-5d |    %6d bytes  | %6d bytes / %-5d  | %6d bytes / %-5d     \r\n",
+                    module_pos->mem_statis.module_name,
+                    module_pos->mem_statis.bytes_max_in_use,
+                    module_pos->mem_statis.iterations_max_in_use,
+                    module_pos->mem_statis.bytes_max_allocated,
+                    module_pos->mem_statis.bytes_total_allocated,
+                    module_pos->mem_statis.iterations_allocated,
+                    module_pos->mem_statis.bytes_total_freed,
+                    module_pos->mem_statis.iterations_freed
+                   );
+        if (!strcmp(module_pos->mem_statis.module_name, "unknown")) {
+            unknown_mod = module_pos;
+        }
+    }
+
+    if (unknown_mod) {
+        list_head_t *head = &unknown_mod->mem_statis.calling_stack.func_head;
+        list_head_t *first;
+        list_head_t *node;
+
+        LITE_printf("\r\n");
+        LITE_printf("\x1B[1;33mMissing module-name references:\x1B[0m\r\n");
+        LITE_printf("---------------------------------------------------\r\n");
+
+        /* entries are only added at head and never freed, so the rest of list is stable without lock */
+        MEM_STATS_SPIN_LOCK(&mem_module_lock);
+        first = head->next;
+        MEM_STATS_SPIN_UNLOCK(&mem_module_lock);
+        for (node = first; node != head; node = node->next) {
+            calling_stack_t *call_pos = list_entry(node, calling_stack_t, func_head);
+            LITE_printf(". \x1B[1;31m%s \x1B[0m Ln:%d\r\n", call_pos->func_name, call_pos->line);
+        }
+        LITE_printf("\r\n");
+    }
+
+    LITE_printf("\r\n");
+}
+#endif  /* #if WITH_MEM_STATS_PER_MODULE */
+#endif  /* #if WITH_MEM_STATS */
 
 #if defined(_PLATFORM_IS_LINUX_) && (WITH_MEM_STATS)
 
 static int tracking_malloc_callstack = 1;
+static int bt_sample_count = 0;
 
-static int record_backtrace(int *level, char *** trace)
-{
 #define MAX_BT_LEVEL    8
 
+/* only raw frames are kept, symbols are resolved when printed */
+static void record_backtrace(OS_malloc_record *rec)
+{
     void       *buffer[MAX_BT_LEVEL];
+    int         level;
+
+    if (!tracking_malloc_callstack || WITH_MEM_STATS_BT_SAMPLE <= 0
+        || MEM_STATS_ADD(&bt_sample_count, 1) % WITH_MEM_STATS_BT_SAMPLE != 0) {
+        return;
+    }
+
+    level = backtrace(buffer, MAX_BT_LEVEL);
+    rec->bt_frames = UTILS_malloc(level * sizeof(void *));
+    if (rec->bt_frames == NULL) {
+        return;
+    }
+    memcpy(rec->bt_frames, buffer, level * sizeof(void *));
+    rec->bt_level = level;
+}
+
+static void print_backtrace(void **frames, int level, const char *indent)
+{
+    char      **symbols;
+    int         k;
 
-    *level = backtrace(buffer, MAX_BT_LEVEL);
-    *trace = backtrace_symbols(buffer, *level);
-    if (*trace == NULL) {
+    symbols = backtrace_symbols(frames, level);
+    if (symbols == NULL) {
         utils_err("backtrace_symbols returns NULL!");
-        return -1;
+        return;
+    }
+
+    for (k = 0; k < level; ++k) {
+        int             m;
+        const char     *p = strchr(symbols[k], '(');
+
+        if (p == NULL || p[1] == ')') {
+            continue;
+        }
+        LITE_printf("%s", indent);
+        for (m = 0; m < k; ++m) {
+            LITE_printf("  ");
+        }
+
+        LITE_printf("%s\r\n", p);
     }
 
-    return 0;
+    free(symbols);
 }
 
 void LITE_track_malloc_callstack(int state)
@@ -148,6 +409,7 @@ void *LITE_realloc_internal(const char *f, const int l, void *ptr, int size, ...
     void               *temp = NULL;
     int                 magic = 0;
     char               *module_name = NULL;
+    int                 len = size;
 
     if (size <= 0) {
         return NULL;
@@ -172,7 +434,12 @@ void *LITE_realloc_internal(const char *f, const int l, void *ptr, int size, ...
     }
 
     if (ptr) {
-        memcpy(temp, ptr, size);
+        OS_malloc_record *pos = _mem_record(ptr, 0);
+
+        if (pos != NULL && pos->buflen < size) {
+            len = pos->buflen;
+        }
+        memcpy(temp, ptr, len);
 
         LITE_free(ptr);
 
@@ -185,215 +452,40 @@ void *LITE_realloc_internal(const char *f, const int l, void *ptr, int size, ...
 #endif
 }
 
-#if WITH_MEM_STATS_PER_MODULE
-void *_create_mem_table(char *module_name, struct list_head *list_head)
-{
-    module_mem_t *pos = NULL;
-    int len = 0;
-
-    if (!module_name || !list_head) {
-        return NULL;
-    }
-
-    pos = UTILS_malloc(sizeof(module_mem_t));
-    if (!pos) {
-        return NULL;
-    }
-    memset(pos, 0, sizeof(module_mem_t));
-    len = strlen(module_name);
-    memcpy(pos->mem_statis.module_name, module_name,
-           (len >= sizeof(pos->mem_statis.module_name)) ? (sizeof(pos->mem_statis.module_name) - 1) : len);
-
-    INIT_LIST_HEAD(&pos->mem_statis.calling_stack.func_head);
-
-    list_add_tail(&pos->list, list_head);
-    return (void *)pos;
-}
-
-void *_find_mem_table(char *module_name, struct list_head *list_head)
-{
-
-    module_mem_t *pos = NULL, *tmp = NULL;
-
-    if (!module_name || !list_head) {
-        return NULL;
-    }
-
-    list_for_each_entry_safe(pos, tmp, list_head, list, module_mem_t) {
-        if (!strcmp(module_name, pos->mem_statis.module_name)) {
-            return (void *)pos;
-        }
-    }
-
-    return NULL;
-}
-
-int _del_mem_table(char *module_name, struct list_head *list_head)
-{
-    int ret = -1;
-
-    calling_stack_t *calling_stack_pos = NULL, *tmp = NULL;
-    module_mem_t *table_pos = (module_mem_t *)_find_mem_table(module_name, list_head);
-    if (table_pos) {
-        list_for_each_entry_safe(calling_stack_pos, tmp, \
-                                 &table_pos->mem_statis.calling_stack.func_head, func_head, calling_stack_t) {
-            if (calling_stack_pos) {
-                list_del(&calling_stack_pos->func_head);
-                if (calling_stack_pos->func_name) {
-                    UTILS_free(calling_stack_pos->func_name);
-                    calling_stack_pos->func_name = NULL;
-                }
-                UTILS_free(calling_stack_pos);
-                calling_stack_pos = NULL;
-            }
-        }
-
-        list_del(&table_pos->list);
-        UTILS_free(table_pos);
-        table_pos = NULL;
-        ret = 0;
-    }
-    return ret;
-}
-
-int _count_malloc_internal(const char *f, const int l, OS_malloc_record *os_malloc_pos, va_list ap)
-{
-    int ret = -1;
-
-    int magic = 0;
-    char is_repeat = 0;
-    char *module_name = NULL;
-    module_mem_t *pos = NULL;
-    calling_stack_t    *call_pos, *call_tmp;
-    calling_stack_t    *entry = NULL;
-
-    magic = va_arg(ap, int);
-    if (MEM_MAGIC == magic) {
-        module_name = va_arg(ap, char *);
-    } else {
-        module_name = "unknown";
-    }
-
-    pos = (module_mem_t *)_find_mem_table(module_name, &mem_module_statis);
-    if (!pos) {
-        if (NULL == (pos = (module_mem_t *)_create_mem_table(module_name, &mem_module_statis))) {
-            utils_err("create_mem_table:[%s] failed!", module_name);
-            return ret;
-        }
-    }
-    os_malloc_pos->mem_table = (void *)pos;
-
-    if (!strcmp(pos->mem_statis.module_name, "unknown")) {
-        list_for_each_entry_safe(call_pos, call_tmp, &pos->mem_statis.calling_stack.func_head, func_head, calling_stack_t) {
-            if (!strcmp(call_pos->func_name, f) && (call_pos->line == l)) {
-                is_repeat = 1;
-                break;
-            }
-        }
-        if (!is_repeat) {
-            entry = UTILS_malloc(sizeof(calling_stack_t));
-            if (!entry) {
-                return ret;
-            }
-
-            memset(entry, 0, sizeof(calling_stack_t));
-            entry->func_name = UTILS_malloc(strlen(f) + 1);
-            memset(entry->func_name, 0, strlen(f) + 1);
-            strncpy(entry->func_name, f, strlen(f));
-            entry->line = l;
-            list_add(&entry->func_head, &pos->mem_statis.calling_stack.func_head);
-        }
-    }
-
-    pos->mem_statis.iterations_allocated += 1;
-    pos->mem_statis.bytes_total_allocated += os_malloc_pos->buflen;
-    pos->mem_statis.bytes_total_in_use += os_malloc_pos->buflen;
-    pos->mem_statis.bytes_max_in_use = (pos->mem_statis.bytes_max_in_use > pos->mem_statis.bytes_total_in_use) ?
-                                       pos->mem_statis.bytes_max_in_use : pos->mem_statis.bytes_total_in_use;
-    pos->mem_statis.bytes_max_allocated = (pos->mem_statis.bytes_max_allocated >= os_malloc_pos->buflen) ?
-                                          pos->mem_statis.bytes_max_allocated : os_malloc_pos->buflen;
-
-    pos->mem_statis.iterations_in_use += 1;
-    pos->mem_statis.iterations_max_in_use = (pos->mem_statis.iterations_in_use > pos->mem_statis.iterations_max_in_use) ?
-                                            pos->mem_statis.iterations_in_use : pos->mem_statis.iterations_max_in_use;
-    ret = 0;
-
-    return ret;
-}
-
-void _count_free_internal(void *ptr, OS_malloc_record *os_malloc_pos)
-{
-
-    module_mem_t *pos = NULL;
-
-    pos = (module_mem_t *)(os_malloc_pos->mem_table);
-    if (!pos) {
-        utils_err("find mem_table faild");
-        return;
-    }
-
-    pos->mem_statis.iterations_freed += 1;
-    pos->mem_statis.iterations_in_use -= 1;
-
-    pos->mem_statis.bytes_total_freed += os_malloc_pos->buflen;
-    pos->mem_statis.bytes_total_in_use -= os_malloc_pos->buflen;
-}
-
-#endif
-
 void *LITE_malloc_internal(const char *f, const int l, int size, ...)
 {
     void                   *ptr = NULL;
 #if WITH_MEM_STATS
     OS_malloc_record       *pos;
+    mem_stats_bucket_t     *bucket;
+    int                     in_use;
 
     if (size <= 0) {
         return NULL;
     }
 
-    ptr = UTILS_malloc(size);
-    if (!ptr) {
-        return NULL;
-    }
-
-    HAL_MutexLock(mutex_mem_stats);
-
-    iterations_allocated += 1;
-    bytes_total_allocated += size;
-    bytes_total_in_use += size;
-    bytes_max_in_use = (bytes_max_in_use > bytes_total_in_use) ? bytes_max_in_use : bytes_total_in_use;
-    bytes_max_allocated = (bytes_max_allocated >= size) ? bytes_max_allocated : size;
-
-#if defined(WITH_TOTAL_COST_WARNING)
-    if (bytes_total_in_use > WITH_TOTAL_COST_WARNING) {
-        utils_debug(" ");
-        utils_debug("==== PRETTY HIGH TOTAL IN USE: %d BYTES ====", bytes_total_in_use);
-        LITE_dump_malloc_free_stats(LOG_DEBUG_LEVEL);
-    }
-#endif
-
-    iterations_in_use += 1;
-    iterations_max_in_use = (iterations_in_use > iterations_max_in_use) ? iterations_in_use : iterations_max_in_use;
-
-    pos = UTILS_malloc(sizeof(OS_malloc_record));
-    if (NULL == pos) {
-        UTILS_free(ptr);
-        HAL_MutexUnlock(mutex_mem_stats);
+    pos = UTILS_malloc(MEM_STATS_HDR_LEN + size);
+    if (!pos) {
         return NULL;
     }
     memset(pos, 0, sizeof(OS_malloc_record));
+    ptr = (char *)pos + MEM_STATS_HDR_LEN;
 
-    pos->buf = ptr;
     pos->buflen = size;
     pos->func = (char *)f;
     pos->line = (int)l;
 #if defined(_PLATFORM_IS_LINUX_)
-    if (tracking_malloc_callstack) {
-        record_backtrace(&pos->bt_level, &pos->bt_symbols);
-    }
+    record_backtrace(pos);
 #endif
 
-    list_add_tail(&pos->list, &mem_recs);
+    MEM_STATS_ENTER();
+
+    MEM_STATS_ADD(&iterations_allocated, 1);
+    MEM_STATS_ADD(&bytes_total_allocated, size);
+    in_use = MEM_STATS_ADD(&bytes_total_in_use, size);
+    _mem_stats_max(&bytes_max_in_use, in_use);
+    _mem_stats_max(&bytes_max_allocated, size);
+    _mem_stats_max(&iterations_max_in_use, MEM_STATS_ADD(&iterations_in_use, 1));
 
 #if WITH_MEM_STATS_PER_MODULE
     va_list                 ap;
@@ -402,32 +494,40 @@ void *LITE_malloc_internal(const char *f, const int l, int size, ...)
     va_end(ap);
 #endif
 
+    bucket = _mem_bucket(pos);
+    MEM_STATS_SPIN_LOCK(&bucket->lock);
+    if (bucket->recs.next == NULL) {
+        INIT_LIST_HEAD(&bucket->recs);
+    }
+    list_add_tail(&pos->list, &bucket->recs);
+    pos->bucket = (void *)bucket;
+    pos->check = MEM_STATS_REC_CHECK(pos);
+    MEM_STATS_SPIN_UNLOCK(&bucket->lock);
+
+    MEM_STATS_LEAVE();
+
+#if defined(WITH_TOTAL_COST_WARNING)
+    if (in_use > WITH_TOTAL_COST_WARNING) {
+        utils_debug(" ");
+        utils_debug("==== PRETTY HIGH TOTAL IN USE: %d BYTES ====", in_use);
+        LITE_dump_malloc_free_stats(LOG_DEBUG_LEVEL);
+    }
+#endif
+
 #if defined(WITH_ALLOC_WARNING_THRESHOLD)
     if (size > WITH_ALLOC_WARNING_THRESHOLD) {
-        int             k;
-
         log_warning("utils", "large allocating @ %s(%d) for %04d bytes!", f, l, size);
         LITE_printf("\r\n");
 #if defined(_PLATFORM_IS_LINUX_)
-        for (k = 0; k < pos->bt_level; ++k) {
-            int             m;
-            const char     *p = strchr(pos->bt_symbols[k], '(');
-
-            if (p[1] == ')') {
-                continue;
-            }
-            for (m = 0; m < k; ++m) {
-                LITE_printf("  ");
-            }
-
-            LITE_printf("%s\r\n", p);
+        {
+            void   *frames[MAX_BT_LEVEL];
+            print_backtrace(frames, backtrace(frames, MAX_BT_LEVEL), "");
         }
 #endif
         LITE_printf("\r\n");
     }
 #endif
     memset(ptr, 0, size);
-    HAL_MutexUnlock(mutex_mem_stats);
     return ptr;
 #else
     ptr = UTILS_malloc(size);
@@ -443,62 +543,43 @@ void LITE_free_internal(void *ptr)
 {
 #if WITH_MEM_STATS
     OS_malloc_record       *pos;
-    OS_malloc_record       *next;
-    int                     found = 0;
 
     if (!ptr) {
         return;
     }
 
-    HAL_MutexLock(mutex_mem_stats);
-
-    pos = NULL;
-    list_for_each_entry_safe(pos, next, &mem_recs, list, OS_malloc_record) {
-        if (pos->buf == ptr) {
-            found = 1;
-            break;
-        }
-    }
-
-    if (!found) {
-        pos = NULL;
-    }
+    MEM_STATS_ENTER();
 
-    if (NULL == pos) {
+    pos = _mem_record(ptr, 1);
+    if (pos == NULL) {
+        /* not from LITE_malloc or freed already, neither is safe to hand to UTILS_free */
+        MEM_STATS_LEAVE();
         log_warning("utils", "Cannot find %p allocated! Skip stat ...", ptr);
-
-        HAL_MutexUnlock(mutex_mem_stats);
         return;
-    } else {
-        iterations_freed += 1;
-        iterations_in_use -= 1;
+    }
+
+    MEM_STATS_ADD(&iterations_freed, 1);
+    MEM_STATS_ADD(&iterations_in_use, -1);
 
-        bytes_total_freed += pos->buflen;
-        bytes_total_in_use -= pos->buflen;
+    MEM_STATS_ADD(&bytes_total_freed, pos->buflen);
+    MEM_STATS_ADD(&bytes_total_in_use, -pos->buflen);
 
 #if WITH_MEM_STATS_PER_MODULE
-        _count_free_internal(ptr, pos);
+    _count_free_internal(pos);
 #endif
 
-        if (pos->buf && pos->buflen > 0) {
-            memset(pos->buf, 0xEE, pos->buflen);
-        }
-        pos->buf = 0;
-        pos->buflen = 0;
-        pos->func = "";
-        pos->line = 0;
-#if defined(_PLATFORM_IS_LINUX_)
-        pos->bt_level = 0;
-        UTILS_free(pos->bt_symbols);
-        pos->bt_symbols = 0;
-#endif
+    MEM_STATS_LEAVE();
 
-        list_del(&pos->list);
-        UTILS_free(pos);
+    memset(ptr, 0xEE, pos->buflen);
+#if defined(_PLATFORM_IS_LINUX_)
+    if (pos->bt_frames) {
+        UTILS_free(pos->bt_frames);
     }
-    HAL_MutexUnlock(mutex_mem_stats);
 #endif
+    UTILS_free(pos);
+#else
     UTILS_free(ptr);
+#endif
 }
 
 void *LITE_malloc_routine(int size, ...)
@@ -544,15 +625,125 @@ void LITE_free_routine(void *ptr)
     LITE_free(ptr);
 }
 
+#if WITH_MEM_STATS
+/* what report prints of a record, copied so that record may be freed meanwhile */
+typedef struct {
+    const char         *func;
+    int                 line;
+    void               *buf;
+    int                 buflen;
+    char                head[MEM_STATS_DUMP_HEAD_LEN];
+#if defined(_PLATFORM_IS_LINUX_)
+    void               *bt_frames[MAX_BT_LEVEL];
+    int                 bt_level;
+#endif
+} mem_stats_snap_t;
+
+/* copy up to @max records of @bucket, return number of records it holds */
+static int _snap_mem_bucket(mem_stats_bucket_t *bucket, mem_stats_snap_t *snaps, int max)
+{
+    OS_malloc_record   *pos;
+    mem_stats_snap_t   *snap;
+    int                 num = 0;
+
+    MEM_STATS_SPIN_LOCK(&bucket->lock);
+    if (bucket->recs.next != NULL) {
+        list_for_each_entry(pos, &bucket->recs, list, OS_malloc_record) {
+            if (num < max) {
+                snap = &snaps[num];
+                snap->func = pos->func;
+                snap->line = pos->line;
+                snap->buf = (char *)pos + MEM_STATS_HDR_LEN;
+                snap->buflen = pos->buflen;
+                memcpy(snap->head, snap->buf,
+                       (pos->buflen < MEM_STATS_DUMP_HEAD_LEN) ? pos->buflen : MEM_STATS_DUMP_HEAD_LEN);
+#if defined(_PLATFORM_IS_LINUX_)
+                snap->bt_level = (pos->bt_frames != NULL) ? pos->bt_level : 0;
+                if (snap->bt_level) {
+                    memcpy(snap->bt_frames, pos->bt_frames, snap->bt_level * sizeof(void *));
+                }
+#endif
+            }
+            num++;
+        }
+    }
+    MEM_STATS_SPIN_UNLOCK(&bucket->lock);
+
+    return num;
+}
+
+/* print records of @bucket numbered from @cnt + 1, return the last number, nothing is printed in bucket lock */
+static int _dump_mem_bucket(mem_stats_bucket_t *bucket, int cnt)
+{
+    mem_stats_snap_t   *snaps = NULL;
+    mem_stats_snap_t   *snap;
+    int                 max = 0;
+    int                 num;
+    int                 i, j;
+
+    /* bucket may grow between counting and copying, retry with room for that */
+    while ((num = _snap_mem_bucket(bucket, snaps, max)) > max) {
+        if (snaps) {
+            UTILS_free(snaps);
+        }
+        max = num + 8;
+        snaps = UTILS_malloc(max * sizeof(mem_stats_snap_t));
+        if (snaps == NULL) {
+            return cnt;
+        }
+    }
+
+    for (i = 0; i < num; i++) {
+        snap = &snaps[i];
+        LITE_printf("%4d. %-24s Ln:%-5d @ %p: %4d bytes [",
+                    ++cnt,
+                    snap->func,
+                    snap->line,
+                    snap->buf,
+                    snap->buflen);
+        for (j = 0; j < MEM_STATS_DUMP_HEAD_LEN && j < snap->buflen; ++j) {
+            char        c;
+
+            c = snap->head[j];
+            if (c < ' ' || c > '~') {
+                c = '.';
+            }
+            LITE_printf("%c", c);
+        }
+        LITE_printf("]\r\n");
+
+#if defined(_PLATFORM_IS_LINUX_)
+        if (snap->bt_level) {
+            LITE_printf("\r\n");
+            print_backtrace(snap->bt_frames, snap->bt_level, "    ");
+        }
+#endif
+        LITE_printf("\r\n");
+    }
+
+    if (snaps) {
+        UTILS_free(snaps);
+    }
+    return cnt;
+}
+#endif  /* #if WITH_MEM_STATS */
+
 void LITE_dump_malloc_free_stats(int level)
 {
 #if WITH_MEM_STATS
-    OS_malloc_record       *pos;
+    int                     i;
 
     if (level > LITE_get_loglevel()) {
         return;
     }
 
+    /* tables below are printed directly, let queued logs go first */
+    LITE_syslog_flush();
+
+    if (mutex_mem_stats) {
+        HAL_MutexLock(mutex_mem_stats);
+    }
+
     utils_debug("");
     utils_debug("---------------------------------------------------");
     utils_debug(". bytes_total_allocated:    %d", bytes_total_allocated);
@@ -568,122 +759,20 @@ void LITE_dump_malloc_free_stats(int level)
     utils_debug("");
 
 #if WITH_MEM_STATS_PER_MODULE
-    _mem_sort_module_pos(&mem_module_statis);
-
-    module_mem_t *module_pos, *tmp;
-    module_mem_t *unknown_mod = NULL;
-
-    LITE_printf("\r\n");
-    LITE_printf("|               |  max_in_use          |  max_allocated   |  total_allocated      |  total_free\r\n");
-    LITE_printf("|---------------|----------------------|------------------|-----------------------|----------------------\r\n");
-    list_for_each_entry_safe(module_pos, tmp, &mem_module_statis, list, module_mem_t) {
-        if (module_pos) {
-
-            LITE_printf("| %-13s | %6d bytes / %-5d |    %6d bytes  | %6d bytes / %-5d  | %6d bytes / %-5d     \r\n",
-                        module_pos->mem_statis.module_name,
-                        module_pos->mem_statis.bytes_max_in_use,
-                        module_pos->mem_statis.iterations_max_in_use,
-                        module_pos->mem_statis.bytes_max_allocated,
-                        module_pos->mem_statis.bytes_total_allocated,
-                        module_pos->mem_statis.iterations_allocated,
-                        module_pos->mem_statis.bytes_total_freed,
-                        module_pos->mem_statis.iterations_freed
-                       );
-            /*
-                        LITE_printf("\x1B[1;32mMODULE_NAME: [%s]\x1B[0m\r\n", module_pos->mem_statis.module_name);
-                        LITE_printf("---------------------------------------------------\r\n");
-                        LITE_printf(". bytes_total_allocated:    %d\r\n", module_pos->mem_statis.bytes_total_allocated);
-                        LITE_printf(". bytes_total_freed:        %d\r\n", module_pos->mem_statis.bytes_total_freed);
-                        LITE_printf(". bytes_total_in_use:       %d\r\n", module_pos->mem_statis.bytes_total_in_use);
-                        LITE_printf(". bytes_max_allocated:      %d\r\n", module_pos->mem_statis.bytes_max_allocated);
-                        LITE_printf(". bytes_max_in_use:         %d\r\n", module_pos->mem_statis.bytes_max_in_use);
-                        LITE_printf(". iterations_allocated:     %d\r\n", module_pos->mem_statis.iterations_allocated);
-                        LITE_printf(". iterations_freed:         %d\r\n", module_pos->mem_statis.iterations_freed);
-                        LITE_printf(". iterations_in_use:        %d\r\n", module_pos->mem_statis.iterations_in_use);
-                        LITE_printf(". iterations_max_in_use:    %d\r\n", module_pos->mem_statis.iterations_max_in_use);
-                        LITE_printf("---------------------------------------------------\r\n");
-            */
-            if (!strcmp(module_pos->mem_statis.module_name, "unknown")) {
-                unknown_mod = module_pos;
-            } else {
-                UTILS_free(module_pos->mem_statis.calling_stack.func_name);
-            }
-        }
-    }
-
-    if (unknown_mod) {
-        calling_stack_t *call_pos, *tmp;
-        LITE_printf("\r\n");
-        LITE_printf("\x1B[1;33mMissing module-name references:\x1B[0m\r\n");
-        LITE_printf("---------------------------------------------------\r\n");
-
-        list_for_each_entry_safe(call_pos, tmp, &unknown_mod->mem_statis.calling_stack.func_head, func_head, calling_stack_t) {
-            if (call_pos->func_name) {
-                LITE_printf(". \x1B[1;31m%s \x1B[0m Ln:%d\r\n", call_pos->func_name, call_pos->line);
-
-                // free memery of func_name and calling_stack
-                UTILS_free(call_pos->func_name);
-                list_del(&call_pos->func_head);
-                UTILS_free(call_pos);
-            }
-        }
-        LITE_printf("\r\n");
-    }
-
-    list_for_each_entry_safe(module_pos, tmp, &mem_module_statis, list, module_mem_t) {
-        list_del(&module_pos->list);
-        UTILS_free(module_pos);
-    }
-
-    LITE_printf("\r\n");
-
+    _dump_mem_tables();
 #endif
+    utils_slab_dump();
     if (LITE_get_loglevel() == level) {
-        int         j;
         int         cnt = 0;
 
-        list_for_each_entry(pos, &mem_recs, list, OS_malloc_record) {
-            if (pos->buf) {
-                LITE_printf("%4d. %-24s Ln:%-5d @ %p: %4d bytes [",
-                            ++cnt,
-                            pos->func,
-                            pos->line,
-                            pos->buf,
-                            pos->buflen);
-                for (j = 0; j < 32 && j < pos->buflen; ++j) {
-                    char        c;
-
-                    c = *(char *)(pos->buf + j);
-                    if (c < ' ' || c > '~') {
-                        c = '.';
-                    }
-                    LITE_printf("%c", c);
-                }
-                LITE_printf("]\r\n");
-
-#if defined(_PLATFORM_IS_LINUX_)
-                int             k;
-
-                LITE_printf("\r\n");
-                for (k = 0; k < pos->bt_level; ++k) {
-                    int             m;
-                    const char     *p = strchr(pos->bt_symbols[k], '(');
-
-                    if (p[1] == ')') {
-                        continue;
-                    }
-                    LITE_printf("    ");
-                    for (m = 0; m < k; ++m) {
-                        LITE_printf("  ");
-                    }
-
-                    LITE_printf("%s\r\n", p);
-                }
-#endif
-                LITE_printf("\r\n");
-            }
+        for (i = 0; i < MEM_STATS_BUCKET_NUM; i++) {
+            cnt = _dump_mem_bucket(&mem_recs[i], cnt);
         }
     }
+
+    if (mutex_mem_stats) {
+        HAL_MutexUnlock(mutex_mem_stats);
+    }
 #else
     utils_info("WITH_MEM_STATS = %d", WITH_MEM_STATS);
 #endif  /* #if WITH_MEM_STATS */
@@ -696,5 +785,3 @@ void **LITE_get_mem_mutex(void)
     return &mutex_mem_stats;
 }
 #endif
-
-
@@ -12,18 +12,21 @@
 
 #if defined(_PLATFORM_IS_LINUX_) && WITH_MEM_STATS
     #include <execinfo.h>
+    #include <sched.h>
 #endif
 
+/* placed right before each buffer returned by LITE_malloc */
 typedef struct {
-    void               *buf;
     int                 buflen;
     char               *func;
     int                 line;
 #if defined(_PLATFORM_IS_LINUX_)
-    char              **bt_symbols;
+    void              **bt_frames;      /* raw frames of sampled allocations, NULL otherwise */
     int                 bt_level;
 #endif
-    list_head_t         list;
+    list_head_t         list;           /* in the bucket of its address */
+    void               *bucket;         /* bucket of its address, checked with @check before record is trusted */
+    unsigned long       check;          /* MEM_STATS_REC_CHECK() of its address while allocated, 0 once freed */
 
 #if WITH_MEM_STATS_PER_MODULE
     void               *mem_table;
@@ -128,6 +128,23 @@ int LITE_get_randstr(_OU_ char *random, _IN_ int length)
     return SUCCESS_RETURN;
 }
 
+uint32_t LITE_hash_string(_IN_ const char *str, _IN_ int len)
+{
+    uint32_t        hash = 2166136261u;
+    int             i = 0;
+
+    if (str == NULL) {
+        return 0;
+    }
+
+    for (i = 0; (len < 0) ? (str[i] != '\0') : (i < len); i++) {
+        hash ^= (uint8_t)str[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
 #if WITH_STRING_UTILS_EXT
 char *LITE_format_string(const char *fmt, ...)
 {
@@ -13,6 +13,9 @@
 
 int LITE_get_randstr(_OU_ char *random, _IN_ int length);
 
+/* FNV-1a over @len bytes of @str, @len < 0 means NUL-terminated */
+uint32_t LITE_hash_string(_IN_ const char *str, _IN_ int len);
+
 
 #endif  /* __COMMON_UTILS_H__ */
 
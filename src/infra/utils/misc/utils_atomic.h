@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+
+
+
+#ifndef _IOTX_COMMON_ATOMIC_H_
+#define _IOTX_COMMON_ATOMIC_H_
+
+/*
+ * Minimal atomic operations on pointer-sized or int words, all of them act as full memory barrier.
+ * UTILS_ATOMIC_LOCK_FREE is 0 on toolchains without GCC style builtins, then callers shall fall back to mutex.
+ */
+#if defined(__GNUC__)
+    #define UTILS_ATOMIC_LOCK_FREE                  (1)
+
+    /* if *@ptr equals @oldval, set it to @newval and return non-zero, otherwise return 0 */
+    #define UTILS_ATOMIC_CAS(ptr, oldval, newval)   __sync_bool_compare_and_swap((ptr), (oldval), (newval))
+
+    /* read *@ptr with memory barrier */
+    #define UTILS_ATOMIC_LOAD(ptr)                  __sync_fetch_and_add((ptr), 0)
+
+    /* add @val to *@ptr, return the new value */
+    #define UTILS_ATOMIC_ADD(ptr, val)              __sync_add_and_fetch((ptr), (val))
+#else
+    #define UTILS_ATOMIC_LOCK_FREE                  (0)
+#endif
+
+#endif /* _IOTX_COMMON_ATOMIC_H_ */
@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+#include "iotx_utils_internal.h"
+#include "utils_atomic.h"
+#include "utils_slab.h"
+
+/*
+ * A pool has one class per configured object size. Pages of a class are carved into slots,
+ * each slot starts with the page it belongs to, so free needs no pool or size. Pages with
+ * free slots are on the partial list of their class and keep their own free list, a page
+ * whose slots are all freed goes back to heap unless it is the one kept as empty.
+ * Everything of a pool is guarded by its mutex, which is created on first allocation.
+ */
+#define UTILS_SLAB_ENABLED          (WITH_SLAB_POOL && UTILS_ATOMIC_LOCK_FREE)
+
+#if UTILS_SLAB_ENABLED
+
+#define UTILS_SLAB_POOL_MAX         (16)
+#define SLAB_ALIGN(n)               (((n) + 7) & ~7)
+
+typedef struct {
+    void                   *mutex;          /* of pool, copied here so that free never reads pool */
+    utils_slab_class_t     *cls;
+    list_head_t             list;           /* in partial list of cls, unlinked when full or empty */
+    void                   *free;           /* free slots, linked through their first word */
+    int                     inuse;
+} utils_slab_page_t;
+
+typedef union {
+    utils_slab_page_t      *page;           /* NULL when allocated from heap */
+    long long               align;
+} utils_slab_hdr_t;
+
+#define SLAB_PAGE_HDR_LEN           SLAB_ALIGN(sizeof(utils_slab_page_t))
+
+/* append only, for reports */
+static utils_slab_pool_t *slab_pools[UTILS_SLAB_POOL_MAX];
+static int slab_pool_num;
+
+static void _slab_register(utils_slab_pool_t *pool)
+{
+    int num;
+
+    do {
+        num = UTILS_ATOMIC_LOAD(&slab_pool_num);
+        if (num >= UTILS_SLAB_POOL_MAX) {
+            utils_warning("too many slab pools, %s not reported", pool->config->module);
+            return;
+        }
+    } while (!UTILS_ATOMIC_CAS(&slab_pool_num, num, num + 1));
+
+    slab_pools[num] = pool;
+}
+
+static void *_slab_mutex(utils_slab_pool_t *pool)
+{
+    void *mutex = UTILS_ATOMIC_LOAD(&pool->mutex);
+
+    if (mutex != NULL) {
+        return mutex;
+    }
+
+    mutex = HAL_MutexCreate();
+    if (mutex == NULL) {
+        return NULL;
+    }
+    if (!UTILS_ATOMIC_CAS(&pool->mutex, NULL, mutex)) {
+        HAL_MutexDestroy(mutex);
+        return UTILS_ATOMIC_LOAD(&pool->mutex);
+    }
+
+    _slab_register(pool);
+    return mutex;
+}
+
+/* best fit, so that class_size may be given in any order */
+static int _slab_class_index(utils_slab_pool_t *pool, int size)
+{
+    const utils_slab_config_t *config = pool->config;
+    int index = -1;
+    int i;
+
+    for (i = 0; i < config->class_num && i < UTILS_SLAB_CLASS_MAX; i++) {
+        if (config->class_size[i] >= size
+            && (index < 0 || config->class_size[i] < config->class_size[index])) {
+            index = i;
+        }
+    }
+
+    return index;
+}
+
+/* Required to run in pool mutex */
+static void _slab_class_init(utils_slab_pool_t *pool, int index)
+{
+    utils_slab_class_t *cls = &pool->classes[index];
+
+    cls->slot_size = SLAB_ALIGN(sizeof(utils_slab_hdr_t) + pool->config->class_size[index]);
+    cls->page_objs = (pool->config->page_size - (int)SLAB_PAGE_HDR_LEN) / cls->slot_size;
+    if (cls->page_objs < 1) {
+        cls->page_objs = 1;
+    }
+    INIT_LIST_HEAD(&cls->partial);
+}
+
+/* Required to run in pool mutex */
+static void *_slab_class_take(utils_slab_class_t *cls)
+{
+    utils_slab_page_t *page = NULL;
+    utils_slab_hdr_t *slot = NULL;
+
+    if (!list_empty(&cls->partial)) {
+        page = list_first_entry(&cls->partial, utils_slab_page_t, list);
+    } else if (cls->empty != NULL) {
+        page = cls->empty;
+        cls->empty = NULL;
+        list_add(&page->list, &cls->partial);
+    } else {
+        return NULL;
+    }
+
+    slot = page->free;
+    page->free = *(void **)slot;
+    if (page->free == NULL) {
+        list_del(&page->list);
+    }
+    page->inuse++;
+
+    cls->inuse++;
+    if (cls->inuse > cls->max_inuse) {
+        cls->max_inuse = cls->inuse;
+    }
+
+    slot->page = page;
+    return slot + 1;
+}
+
+static utils_slab_page_t *_slab_page_new(utils_slab_pool_t *pool, utils_slab_class_t *cls, void *mutex)
+{
+    utils_slab_page_t *page = NULL;
+    char *slot = NULL;
+    int i;
+
+    page = LITE_malloc(SLAB_PAGE_HDR_LEN + cls->page_objs * cls->slot_size, MEM_MAGIC, pool->config->module);
+    if (page == NULL) {
+        return NULL;
+    }
+
+    page->mutex = mutex;
+    page->cls = cls;
+    page->inuse = 0;
+    page->free = NULL;
+    slot = (char *)page + SLAB_PAGE_HDR_LEN + (cls->page_objs - 1) * cls->slot_size;
+    for (i = 0; i < cls->page_objs; i++, slot -= cls->slot_size) {
+        *(void **)slot = page->free;
+        page->free = slot;
+    }
+
+    return page;
+}
+
+static void *_slab_heap_alloc(utils_slab_pool_t *pool, int size)
+{
+    utils_slab_hdr_t *hdr = LITE_malloc(sizeof(utils_slab_hdr_t) + size, MEM_MAGIC, pool->config->module);
+
+    if (hdr == NULL) {
+        return NULL;
+    }
+    hdr->page = NULL;
+
+    return hdr + 1;
+}
+
+void *utils_slab_alloc(utils_slab_pool_t *pool, int size)
+{
+    utils_slab_class_t *cls = NULL;
+    utils_slab_page_t *page = NULL;
+    void *mutex = NULL;
+    void *ptr = NULL;
+    int index;
+
+    index = _slab_class_index(pool, size);
+    if (index < 0 || (mutex = _slab_mutex(pool)) == NULL) {
+        return _slab_heap_alloc(pool, size);
+    }
+    cls = &pool->classes[index];
+
+    HAL_MutexLock(mutex);
+    if (cls->slot_size == 0) {
+        _slab_class_init(pool, index);
+    }
+    ptr = _slab_class_take(cls);
+    if (ptr == NULL && cls->pages < pool->config->max_pages) {
+        /* reserve the page before leaving mutex, so racing threads don't exceed max_pages */
+        cls->pages++;
+        HAL_MutexUnlock(mutex);
+        page = _slab_page_new(pool, cls, mutex);
+        HAL_MutexLock(mutex);
+        if (page == NULL) {
+            cls->pages--;
+        } else {
+            list_add(&page->list, &cls->partial);
+            ptr = _slab_class_take(cls);
+        }
+    }
+    if (ptr == NULL) {
+        cls->fallbacks++;
+    }
+    HAL_MutexUnlock(mutex);
+
+    if (ptr == NULL) {
+        return _slab_heap_alloc(pool, size);
+    }
+
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+void utils_slab_free(void *ptr)
+{
+    utils_slab_hdr_t *hdr = NULL;
+    utils_slab_page_t *page = NULL;
+    utils_slab_page_t *release = NULL;
+    utils_slab_class_t *cls = NULL;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    hdr = (utils_slab_hdr_t *)ptr - 1;
+    page = hdr->page;
+    if (page == NULL) {
+        LITE_free(hdr);
+        return;
+    }
+    cls = page->cls;
+
+    HAL_MutexLock(page->mutex);
+    if (page->free == NULL) {
+        list_add(&page->list, &cls->partial);
+    }
+    *(void **)hdr = page->free;
+    page->free = hdr;
+    page->inuse--;
+    cls->inuse--;
+
+    if (page->inuse == 0) {
+        list_del(&page->list);
+        if (cls->empty == NULL) {
+            cls->empty = page;
+        } else {
+            cls->pages--;
+            release = page;
+        }
+    }
+    HAL_MutexUnlock(page->mutex);
+
+    if (release != NULL) {
+        LITE_free(release);
+    }
+}
+
+void utils_slab_shrink(utils_slab_pool_t *pool)
+{
+    utils_slab_page_t *release[UTILS_SLAB_CLASS_MAX];
+    void *mutex = UTILS_ATOMIC_LOAD(&pool->mutex);
+    int i;
+
+    if (mutex == NULL) {
+        return;
+    }
+
+    HAL_MutexLock(mutex);
+    for (i = 0; i < UTILS_SLAB_CLASS_MAX; i++) {
+        release[i] = pool->classes[i].empty;
+        if (release[i] != NULL) {
+            pool->classes[i].empty = NULL;
+            pool->classes[i].pages--;
+        }
+    }
+    HAL_MutexUnlock(mutex);
+
+    for (i = 0; i < UTILS_SLAB_CLASS_MAX; i++) {
+        if (release[i] != NULL) {
+            LITE_free(release[i]);
+        }
+    }
+}
+
+void utils_slab_dump(void)
+{
+    utils_slab_pool_t *pool = NULL;
+    utils_slab_class_t cls;
+    void *mutex = NULL;
+    int num = UTILS_ATOMIC_LOAD(&slab_pool_num);
+    int i, j;
+
+    for (i = 0; i < num; i++) {
+        pool = slab_pools[i];
+        if (pool == NULL) {
+            continue;
+        }
+        mutex = UTILS_ATOMIC_LOAD(&pool->mutex);
+
+        utils_info("slab pool [%s]", pool->config->module);
+        for (j = 0; j < pool->config->class_num && j < UTILS_SLAB_CLASS_MAX; j++) {
+            HAL_MutexLock(mutex);
+            memcpy(&cls, &pool->classes[j], sizeof(utils_slab_class_t));
+            HAL_MutexUnlock(mutex);
+
+            utils_info(". %4d bytes: %2d pages, %4d in use, %4d max in use, %4d from heap",
+                       pool->config->class_size[j], cls.pages, cls.inuse, cls.max_inuse, cls.fallbacks);
+        }
+    }
+}
+
+#else
+
+void *utils_slab_alloc(utils_slab_pool_t *pool, int size)
+{
+    return LITE_malloc(size, MEM_MAGIC, pool->config->module);
+}
+
+void utils_slab_free(void *ptr)
+{
+    if (ptr != NULL) {
+        LITE_free(ptr);
+    }
+}
+
+void utils_slab_shrink(utils_slab_pool_t *pool)
+{
+    (void)pool;
+}
+
+void utils_slab_dump(void)
+{
+}
+
+#endif  /* #if UTILS_SLAB_ENABLED */
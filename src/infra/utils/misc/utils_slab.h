@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+
+
+
+#ifndef _IOTX_COMMON_SLAB_H_
+#define _IOTX_COMMON_SLAB_H_
+
+#include "lite-list.h"
+
+#define UTILS_SLAB_CLASS_MAX        (8)
+
+/* tuning of one module's pool, normally a static const next to its users */
+typedef struct {
+    const char     *module;                             /* name in reports, pages are charged to it in mem_stats */
+    int             page_size;                          /* bytes of one page, carved into objects of a class */
+    int             max_pages;                          /* pages per class, requests beyond go to heap */
+    int             class_num;
+    int             class_size[UTILS_SLAB_CLASS_MAX];   /* object sizes, in any order */
+} utils_slab_config_t;
+
+typedef struct {
+    int             slot_size;                          /* 0 until first used */
+    int             page_objs;
+    list_head_t     partial;                            /* pages with free objects */
+    void           *empty;                              /* one wholly free page kept against thrashing */
+    int             pages;
+    int             inuse;
+    int             max_inuse;
+    int             fallbacks;
+} utils_slab_class_t;
+
+typedef struct {
+    const utils_slab_config_t  *config;
+    void                       *mutex;                  /* created on first allocation */
+    utils_slab_class_t          classes[UTILS_SLAB_CLASS_MAX];
+} utils_slab_pool_t;
+
+#define UTILS_SLAB_POOL_INIT(config)    { (config), NULL }
+
+/*
+ * Allocate @size zeroed bytes from the smallest class of @pool which fits, from heap if none fits
+ * or the class is at max_pages. Either way the result shall be released by utils_slab_free().
+ */
+void *utils_slab_alloc(utils_slab_pool_t *pool, int size);
+
+void utils_slab_free(void *ptr);
+
+/* give cached empty pages of @pool back to heap, for module deinit */
+void utils_slab_shrink(utils_slab_pool_t *pool);
+
+/* print usage of every pool used so far, part of LITE_dump_malloc_free_stats() */
+void utils_slab_dump(void);
+
+#endif /* _IOTX_COMMON_SLAB_H_ */
@@ -16,6 +16,37 @@
 LIST_HEAD(secure_resource_cb_head);
 
 static bool is_inited = 0;
+static void *session_mutex = NULL;      //guards session lists and hash, refs and cipher state of sessions and pk_dn checksum cache
+
+/* sessions of all lists indexed by (addr, pk_dn checksum), must be power of 2 */
+#define SESSION_HASH_SIZE   (32)
+static struct list_head session_hash[SESSION_HASH_SIZE];
+
+#define PK_DN_CACHE_SIZE    (8)
+typedef struct
+{
+    char pk[PRODUCT_KEY_MAXLEN];
+    char dn[DEVICE_NAME_MAXLEN];
+    char ck[PK_DN_CHECKSUM_LEN];
+} pk_dn_cache_item;
+static pk_dn_cache_item pk_dn_cache[PK_DN_CACHE_SIZE];
+
+void session_lock (void)
+{
+    if (session_mutex) {
+        HAL_MutexLock(session_mutex);
+    }
+}
+
+void session_unlock (void)
+{
+    if (session_mutex) {
+        HAL_MutexUnlock(session_mutex);
+    }
+}
+
+static void session_cipher_free (session_item* session);
+
 #ifdef SUPPORT_MULTI_DEVICES
 LIST_HEAD(device_list);
 
@@ -58,32 +89,149 @@ struct list_head* get_svr_session_list (CoAPContext *context)
 device_auth_list _device;
 #endif
 
+static struct list_head* session_bucket (NetworkAddr* addr, const char ck[PK_DN_CHECKSUM_LEN])
+{
+    unsigned int hash = addr->port;
+    const unsigned char* p = addr->addr;
+    int i;
+
+    while (*p) {
+        hash = hash * 33 + *p++;
+    }
+    for (i = 0; i < PK_DN_CHECKSUM_LEN; i++) {
+        hash = hash * 33 + (unsigned char)ck[i];
+    }
+    return &session_hash[hash & (SESSION_HASH_SIZE - 1)];
+}
+
+/* addr and pk_dn of session must be set, they are the key of index; the list takes its own reference */
+void add_session (struct list_head* sessions, session_item* session)
+{
+    session_lock ();
+    session->owner = sessions;
+    session->refs++;
+    list_add_tail(&session->lst, sessions);
+    list_add_tail(&session->hash_lst, session_bucket(&session->addr, session->pk_dn));
+    session_unlock ();
+}
+
+/* drop a reference of @session, free it with the last one */
+void put_session (session_item* session)
+{
+    int last;
+
+    if (!session) {
+        return;
+    }
+    session_lock ();
+    last = --session->refs == 0;
+    if (last) {
+        session_cipher_free (session);
+    }
+    session_unlock ();
+    if (last) {
+        coap_free (session);
+    }
+}
+
+/* move @session from its lists to @removed, unless another thread took it out already */
+/* Required to run in session lock protection setup by caller */
+void unlink_session (session_item* session, struct list_head* removed)
+{
+    if (session->owner) {
+        list_del (&session->lst);
+        list_del (&session->hash_lst);
+        session->owner = NULL;
+        list_add_tail (&session->lst, removed);
+    }
+}
+
+/* stop observers of sessions unlinked to @removed, and drop references their lists held */
+void release_sessions (CoAPContext *ctx, struct list_head* removed)
+{
+    session_item *node = NULL, *next = NULL;
+
+    list_for_each_entry_safe(node, next, removed, lst, session_item) {
+        list_del (&node->lst);
+        CoapObsServerAll_delete (ctx, &node->addr);
+        put_session (node);
+    }
+}
+
 void remove_session (CoAPContext *ctx, session_item* session)
 {
+    LIST_HEAD(removed);
+
     COAP_INFO("remove_session");
     if (session) {
-        CoapObsServerAll_delete (ctx, &session->addr);
-        list_del (&session->lst);
-        coap_free (session);
+        session_lock ();
+        unlink_session (session, &removed);
+        session_unlock ();
+        release_sessions (ctx, &removed);
     }
 }
 
+/* returns a reference, which caller drops by put_session */
 session_item* get_session_by_checksum (struct list_head* sessions, NetworkAddr* addr, char ck[PK_DN_CHECKSUM_LEN])
 {
-    if (!sessions || !ck) {
+    if (!is_inited || !sessions || !addr || !ck) {
         return NULL;
     }
 
-    session_item* node = NULL, *next = NULL;
-    list_for_each_entry_safe(node, next, sessions, lst, session_item) {
-        if (is_networkadd_same(addr, &node->addr)
+    session_item* node = NULL;
+    session_item* found = NULL;
+    session_lock ();
+    list_for_each_entry(node, session_bucket(addr, ck), hash_lst, session_item) {
+        if (node->owner == sessions && is_networkadd_same(addr, &node->addr)
                 && strncmp(node->pk_dn, ck, PK_DN_CHECKSUM_LEN) == 0)
         {
             COAP_DEBUG("find node, sessionid:%d", node->sessionId);
-            return node;
+            node->refs++;
+            found = node;
+            break;
         }
     }
-    return NULL;
+    session_unlock ();
+    return found;
+}
+
+/* checksum of pk+dn, recently used ones are cached to skip md5 */
+static void get_pk_dn_checksum (const char* pk, const char* dn, char ck[PK_DN_CHECKSUM_LEN])
+{
+    unsigned int hash = 5381;
+    const char* p;
+    pk_dn_cache_item* item;
+    char path[100] = {0};
+    int cacheable = strlen(pk) < PRODUCT_KEY_MAXLEN && strlen(dn) < DEVICE_NAME_MAXLEN;
+
+    for (p = pk; *p; p++) {
+        hash = hash * 33 + (unsigned char)*p;
+    }
+    for (p = dn; *p; p++) {
+        hash = hash * 33 + (unsigned char)*p;
+    }
+    item = &pk_dn_cache[hash % PK_DN_CACHE_SIZE];
+
+    if (cacheable) {
+        session_lock ();
+        if (item->pk[0] && !strcmp(item->pk, pk) && !strcmp(item->dn, dn)) {
+            memcpy (ck, item->ck, PK_DN_CHECKSUM_LEN);
+            session_unlock ();
+            return;
+        }
+        session_unlock ();
+    }
+
+    snprintf (path, sizeof(path), "%s%s", pk, dn);
+    CoAPPathMD5_sum (path, strlen(path), ck, PK_DN_CHECKSUM_LEN);
+
+    if (cacheable) {
+        session_lock ();
+        strcpy (item->pk, pk);
+        strcpy (item->dn, dn);
+        memcpy (item->ck, ck, PK_DN_CHECKSUM_LEN);
+        session_unlock ();
+    }
 }
 
 static session_item* get_session (struct list_head* sessions, AlcsDeviceKey* devKey)
@@ -93,9 +241,7 @@ static session_item* get_session (struct list_head* sessions, AlcsDeviceKey* dev
     }
 
     char ck[PK_DN_CHECKSUM_LEN] = {0};
-    char path[100] = {0};
-    snprintf (path, sizeof(path), "%s%s", devKey->pk, devKey->dn);
-    CoAPPathMD5_sum (path, strlen(path), ck, PK_DN_CHECKSUM_LEN);
+    get_pk_dn_checksum (devKey->pk, devKey->dn, ck);
 
     return get_session_by_checksum (sessions, &devKey->addr, ck);
 }
@@ -125,12 +271,14 @@ static session_item* get_auth_session (CoAPContext *ctx, AlcsDeviceKey* devKey)
     if (node && node->sessionId) {
         return node;
     }
+    put_session (node);
 #endif
 #ifdef ALCS_SERVER_ENABLED
     session_item* node1 = get_svr_session (ctx, devKey);
     if (node1 && node1->sessionId) {
         return node1;
     }
+    put_session (node1);
 #endif
 
     return NULL;
@@ -144,6 +292,7 @@ static session_item* get_auth_session_by_checksum (CoAPContext *ctx, NetworkAddr
     if (node && node->sessionId) {
         return node;
     }
+    put_session (node);
 #endif
 #ifdef ALCS_SERVER_ENABLED
     struct list_head* sessions1 = get_svr_session_list(ctx);
@@ -151,6 +300,7 @@ static session_item* get_auth_session_by_checksum (CoAPContext *ctx, NetworkAddr
     if (node1 && node1->sessionId) {
         return node1;
     }
+    put_session (node1);
 #endif
 
     return NULL;
@@ -193,6 +343,12 @@ int alcs_auth_init(CoAPContext *ctx, const char* productKey, const char* deviceN
         return 0;
     }
     is_inited = 1;
+    session_mutex = HAL_MutexCreate();
+    int i;
+    for (i = 0; i < SESSION_HASH_SIZE; i++) {
+        INIT_LIST_HEAD(&session_hash[i]);
+    }
+    memset (pk_dn_cache, 0, sizeof(pk_dn_cache));
 
     device_auth_list* dev;
     //auth_list* lst_auth;
@@ -214,6 +370,9 @@ int alcs_auth_init(CoAPContext *ctx, const char* productKey, const char* deviceN
 
     INIT_LIST_HEAD(&dev->lst);
     INIT_LIST_HEAD(&secure_resource_cb_head);
+#ifdef ALCS_SERVER_ENABLED
+    alcs_resource_cb_init();
+#endif
 
     if (role & ROLE_SERVER) {
 #ifdef ALCS_SERVER_ENABLED
@@ -272,6 +431,11 @@ void alcs_auth_deinit(void)
         HAL_MutexDestroy(_device.lst_auth.list_mutex);
     }   
 #endif
+
+    if (session_mutex) {
+        HAL_MutexDestroy(session_mutex);
+        session_mutex = NULL;
+    }
 }
 
 bool is_networkadd_same (NetworkAddr* addr1, NetworkAddr* addr2)
@@ -283,64 +447,160 @@ bool is_networkadd_same (NetworkAddr* addr1, NetworkAddr* addr2)
     return addr1->port == addr2->port && !strcmp((const char *)addr1->addr, (const char *)addr2->addr);
 }
 
-int alcs_encrypt (const char* src, int len, const char* key, void* out)
+static const char* alcs_iv = "a1b1c1d1e1f1g1h1";
+
+/*
+ * Body blocks are chained from iv and the padding block is encrypted with iv again.
+ * The handle keeps chaining from its last block across calls, as HAL_Aes128_Cbc_Encrypt()
+ * requires, and that block is kept in chain, so the difference to iv is folded into the
+ * blocks which start from iv. src and out may be the same.
+ * Return length of output, or -1 if the handle failed and chain is no longer known.
+ */
+static int alcs_cbc_encrypt (p_HAL_Aes128_t aes, char chain[16], const char* src, int len, unsigned char* out)
 {
-    char* iv = "a1b1c1d1e1f1g1h1";
+    int blocks = len >> 4;
+    int pad = 16 - (len & 0xf);
+    int i, j;
+    char block[16];
 
-    int len1 = len & 0xfffffff0;
-    int len2 = len1 + 16;
-    int pad = len2 - len;
-    int ret = 0;
+    for (i = 0; i <= blocks; i++) {
+        if (i < blocks) {
+            memcpy (block, src + (i << 4), 16);
+        } else {
+            memcpy (block, src + (i << 4), 16 - pad);
+            memset (block + 16 - pad, pad, pad);
+        }
+        if (i == 0 || i == blocks) {
+            for (j = 0; j < 16; j++) {
+                block[j] ^= alcs_iv[j] ^ chain[j];
+            }
+        }
+        if (HAL_Aes128_Cbc_Encrypt(aes, block, 1, out + (i << 4)) != 0) {
+            return -1;
+        }
+        memcpy (chain, out + (i << 4), 16);
+    }
+
+    COAP_DEBUG ("to encrypt len:%d", (blocks + 1) << 4);
+    return (blocks + 1) << 4;
+}
+
+static int alcs_cbc_decrypt (p_HAL_Aes128_t aes, char chain[16], const char* src, int len, unsigned char* out)
+{
+    int blocks = len >> 4;
+    int i, j, pad;
+    char block[16];
+
+    COAP_DEBUG ("to decrypt len:%d", len);
+    if (blocks == 0) {
+        return 0;
+    }
+
+    for (i = 0; i < blocks; i++) {
+        memcpy (block, src + (i << 4), 16);
+        if (HAL_Aes128_Cbc_Decrypt(aes, block, 1, out + (i << 4)) != 0) {
+            return -1;
+        }
+        if (i == 0 || i == blocks - 1) {
+            for (j = 0; j < 16; j++) {
+                out[(i << 4) + j] ^= chain[j] ^ alcs_iv[j];
+            }
+        }
+        memcpy (chain, block, 16);
+    }
+
+    pad = out[(blocks << 4) - 1];
+    if (pad < 1 || pad > 16) {
+        return 0;
+    }
+    for (j = 1; j < pad; j++) {
+        if (out[(blocks << 4) - 1 - j] != pad) {
+            return 0;
+        }
+    }
+    out[(blocks << 4) - pad] = 0;
+    COAP_DEBUG ("decrypt data:%s, len:%d", out, (blocks << 4) - pad);
+    return (blocks << 4) - pad;
+}
 
-    if (len1) {
-        p_HAL_Aes128_t aes_e_h = HAL_Aes128_Init ((uint8_t*)key, (uint8_t*)iv, HAL_AES_ENCRYPTION);
-        ret = HAL_Aes128_Cbc_Encrypt(aes_e_h, src, len1 >> 4, out);
-        HAL_Aes128_Destroy (aes_e_h);
+static void session_cipher_free (session_item* session)
+{
+    if (session->aes_enc) {
+        HAL_Aes128_Destroy (session->aes_enc);
+        session->aes_enc = NULL;
     }
-    if (!ret && pad) {
-        char buf[16];
-        memcpy (buf, src + len1, len - len1);
-        memset (buf + len - len1, pad, pad);
-        p_HAL_Aes128_t aes_e_h = HAL_Aes128_Init ((uint8_t*)key, (uint8_t*)iv, HAL_AES_ENCRYPTION);
-        ret = HAL_Aes128_Cbc_Encrypt(aes_e_h, buf, 1, (uint8_t *)out + len1);
-        HAL_Aes128_Destroy (aes_e_h);
+    if (session->aes_dec) {
+        HAL_Aes128_Destroy (session->aes_dec);
+        session->aes_dec = NULL;
     }
+}
+
+static int session_cipher_create (session_item* session)
+{
+    session_cipher_free (session);
 
-    COAP_DEBUG ("to encrypt src:%s, len:%d", src, len2);
-    return ret == 0? len2 : 0;
+    session->aes_enc = HAL_Aes128_Init ((uint8_t*)session->sessionKey, (uint8_t*)alcs_iv, HAL_AES_ENCRYPTION);
+    session->aes_dec = HAL_Aes128_Init ((uint8_t*)session->sessionKey, (uint8_t*)alcs_iv, HAL_AES_DECRYPTION);
+    if (!session->aes_enc || !session->aes_dec) {
+        session_cipher_free (session);
+        return COAP_ERROR_MALLOC;
+    }
+    memcpy (session->enc_chain, alcs_iv, 16);
+    memcpy (session->dec_chain, alcs_iv, 16);
+    return COAP_SUCCESS;
 }
 
-int alcs_decrypt (const char* src, int len, const char* key, void* out)
+/* call when sessionKey is negotiated */
+int alcs_session_cipher_init (session_item* session)
 {
-    COAP_DEBUG ("to decrypt len:%d", len);
-    char* iv = "a1b1c1d1e1f1g1h1";
+    int ret;
 
-    p_HAL_Aes128_t aes_d_h;
-    int n = len >> 4;
-    if (n > 0) {
-        aes_d_h  = HAL_Aes128_Init ((uint8_t*)key, (uint8_t*)iv, HAL_AES_DECRYPTION);
-        HAL_Aes128_Cbc_Decrypt(aes_d_h, src, n - 1, out);
-        HAL_Aes128_Destroy(aes_d_h);
+    if (!session) {
+        return COAP_ERROR_NULL;
     }
+    session_lock ();
+    ret = session_cipher_create (session);
+    session_unlock ();
+    return ret;
+}
 
+int alcs_session_encrypt (session_item* session, const char* src, int len, void* out)
+{
+    int ret = 0;
 
-    char* out_c = (char*)out;
-    int offset = n > 0? ((n - 1) << 4) : 0;
-    out_c[offset] = 0;
+    session_lock ();
+    if (session->aes_enc || session_cipher_create (session) == COAP_SUCCESS) {
+        ret = alcs_cbc_encrypt (session->aes_enc, session->enc_chain, src, len, out);
+        if (ret < 0) {
+            session_cipher_free (session);
+            ret = 0;
+        }
+    }
+    session_unlock ();
+    return ret;
+}
 
-    aes_d_h  = HAL_Aes128_Init ((uint8_t*)key, (uint8_t*)iv, HAL_AES_DECRYPTION);
-    int ret = HAL_Aes128_Cbc_Decrypt(aes_d_h, src + offset, 1, out_c + offset);
-    HAL_Aes128_Destroy(aes_d_h);
+int alcs_session_decrypt (session_item* session, const char* src, int len, void* out)
+{
+    int ret = 0;
 
-    char pad = out_c[len - 1];
-    out_c[len - pad] = 0;
-    COAP_DEBUG ("decrypt data:%s, len:%d", out_c, len - pad);
-    return ret == 0? len - pad : 0;
+    session_lock ();
+    if (session->aes_dec || session_cipher_create (session) == COAP_SUCCESS) {
+        ret = alcs_cbc_decrypt (session->aes_dec, session->dec_chain, src, len, out);
+        if (ret < 0) {
+            session_cipher_free (session);
+            ret = 0;
+        }
+    }
+    session_unlock ();
+    return ret;
 }
 
 bool alcs_is_auth (CoAPContext *ctx, AlcsDeviceKey* devKey)
 {
-    return get_auth_session(ctx, devKey) != NULL;
+    session_item* session = get_auth_session(ctx, devKey);
+    put_session (session);
+    return session != NULL;
 }
 
 /*---------------------------------------------------------*/
@@ -351,7 +611,7 @@ typedef struct
     CoAPSendMsgHandler orig_handler;
 } secure_send_item;
 
-static int do_secure_send (CoAPContext *ctx, NetworkAddr* addr, CoAPMessage *message, const char* key, char* buf)
+static int do_secure_send (CoAPContext *ctx, NetworkAddr* addr, CoAPMessage *message, session_item* session, char* buf)
 {
     int ret = COAP_SUCCESS;
     COAP_DEBUG("do_secure_send");
@@ -360,7 +620,7 @@ static int do_secure_send (CoAPContext *ctx, NetworkAddr* addr, CoAPMessage *mes
     int len_old = message->payloadlen;
 
     message->payload = (unsigned char *)buf;
-    message->payloadlen = alcs_encrypt ((const char *)payload_old, len_old, key, message->payload);
+    message->payloadlen = alcs_session_encrypt (session, (const char *)payload_old, len_old, message->payload);
     ret = CoAPMessage_send (ctx, addr, message);
 
     message->payload = payload_old;
@@ -398,22 +658,22 @@ int internal_secure_send (CoAPContext *ctx, session_item* session, NetworkAddr *
     int encryptlen = (message->payloadlen & 0xfffffff0) + 16;
     if (encryptlen > 64) {
         char* buf = (char*)coap_malloc(encryptlen);
-        int rt = do_secure_send (ctx, addr, message, session->sessionKey, buf);
+        int rt = do_secure_send (ctx, addr, message, session, buf);
         coap_free (buf);
         return rt;
     } else {
         char buf[64];
-        return do_secure_send (ctx, addr, message, session->sessionKey, buf);
+        return do_secure_send (ctx, addr, message, session, buf);
     }
 }
 
-static void call_cb (CoAPContext *context, NetworkAddr *remote, CoAPMessage* message, const char* key, char* buf, secure_send_item* send_item)
+static void call_cb (CoAPContext *context, NetworkAddr *remote, CoAPMessage* message, session_item* session, secure_send_item* send_item)
 {
     if (send_item->orig_handler) {
-        int len = alcs_decrypt ((const char *)message->payload, message->payloadlen, key, buf);
+        /* decrypt in place, payload is in receive buffer of message */
+        int len = alcs_session_decrypt (session, (const char *)message->payload, message->payloadlen, message->payload);
         CoAPMessage tmpMsg;
         memcpy (&tmpMsg, message, sizeof(CoAPMessage));
-        tmpMsg.payload = (unsigned char *)buf;
         tmpMsg.payloadlen = len;
         send_item->orig_handler (context, COAP_REQUEST_SUCCESS, send_item->orig_user_data, remote, &tmpMsg);
     }
@@ -443,17 +703,9 @@ void secure_sendmsg_handler(CoAPContext *context, CoAPReqResult result, void *us
             //todo
         } else {
             session->heart_time = HAL_UptimeMs();
-            if (message->payloadlen < 128) {
-                char buf[128];
-                call_cb (context, remote, message, session->sessionKey, buf, send_item);
-            } else {
-                char* buf = (char*)coap_malloc(message->payloadlen);
-                if (buf) {
-                    call_cb (context, remote, message, session->sessionKey, buf, send_item);
-                    coap_free (buf);
-                }
-            }
+            call_cb (context, remote, message, session, send_item);
         }
+        put_session (session);
     }
 
     unsigned int obsVal;
@@ -474,7 +726,9 @@ int alcs_sendmsg_secure(CoAPContext *ctx, AlcsDeviceKey* devKey, CoAPMessage *me
         return ALCS_ERR_AUTH_UNAUTH;
     }
 
-    return internal_secure_send (ctx, session, &devKey->addr, message, observe, handler);
+    int ret = internal_secure_send (ctx, session, &devKey->addr, message, observe, handler);
+    put_session (session);
+    return ret;
 }
 
 int alcs_sendrsp_secure(CoAPContext *ctx, AlcsDeviceKey* devKey, CoAPMessage *message, char observe, unsigned short msgid, CoAPLenString* token)
@@ -501,7 +755,9 @@ int alcs_sendrsp_secure(CoAPContext *ctx, AlcsDeviceKey* devKey, CoAPMessage *me
         return ALCS_ERR_AUTH_UNAUTH;
     }
 
-    return internal_secure_send (ctx, session, &devKey->addr, message, observe, NULL);
+    int ret = internal_secure_send (ctx, session, &devKey->addr, message, observe, NULL);
+    put_session (session);
+    return ret;
 }
 
 bool req_payload_parser (const char* payload, int len, char** seq, int* seqlen, char** data, int* datalen)
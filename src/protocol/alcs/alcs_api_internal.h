@@ -85,7 +85,14 @@ typedef struct
     int interval;
     NetworkAddr addr;
     char pk_dn[PK_DN_CHECKSUM_LEN];
+    p_HAL_Aes128_t aes_enc;             //key schedules of sessionKey, kept until key changes
+    p_HAL_Aes128_t aes_dec;
+    char enc_chain[16];                 //chaining value held by aes_enc, last block it output
+    char dec_chain[16];                 //chaining value held by aes_dec, last block it input
+    struct list_head* owner;            //session list holding the session, NULL once removed
+    int refs;                           //held by owner list and by users of a looked up session
     struct list_head  lst;
+    struct list_head  hash_lst;         //index of all sessions by addr and pk_dn
 } session_item;
 
 #define ROLE_SERVER 2
@@ -135,6 +142,12 @@ extern device_auth_list _device;
 #define get_list(v) (&_device.lst_auth)
 #endif
 
+void session_lock (void);
+void session_unlock (void);
+void add_session (struct list_head* sessions, session_item* session);
+void put_session (session_item* session);
+void unlink_session (session_item* session, struct list_head* removed);
+void release_sessions (CoAPContext *ctx, struct list_head* removed);
 void remove_session (CoAPContext *ctx, session_item* session);
 
 #ifdef ALCS_CLIENT_ENABLED
@@ -152,13 +165,15 @@ typedef struct
     char              pk_dn[PK_DN_CHECKSUM_LEN];
     CoAPRecvMsgHandler cb;
     struct list_head   lst;
+    struct list_head   hash_lst;
 } secure_resource_cb_item;
 
 extern struct list_head secure_resource_cb_head;
 #endif
 
-int alcs_encrypt (const char* src, int len, const char* key, void* out);
-int alcs_decrypt (const char* src, int len, const char* key, void* out);
+int alcs_session_cipher_init (session_item* session);
+int alcs_session_encrypt (session_item* session, const char* src, int len, void* out);
+int alcs_session_decrypt (session_item* session, const char* src, int len, void* out);
 int observe_data_encrypt(CoAPContext *ctx, const char* paths, NetworkAddr* addr,
 CoAPMessage* message, CoAPLenString *src, CoAPLenString *dest);
 
@@ -170,6 +185,7 @@ int internal_secure_send (CoAPContext *ctx, session_item* session, NetworkAddr *
 
 int alcs_resource_register_secure (CoAPContext *context, const char* pk, const char* dn, const char *path, unsigned short permission,
             unsigned int ctype, unsigned int maxage, CoAPRecvMsgHandler callback);
+void alcs_resource_cb_init(void);
 void alcs_resource_cb_deinit(void);
 void alcs_auth_list_deinit(void);
 
@@ -289,6 +289,7 @@ void  auth_cb(CoAPContext *ctx, CoAPReqResult result, void *userdata, NetworkAdd
                 char buf[32];
                 snprintf (buf, sizeof(buf), "%s%.*s", session->randomKey, tmplen, tmp);
                 utils_hmac_sha1_raw (buf,strlen(buf), session->sessionKey, auth_param->accessToken, strlen(auth_param->accessToken));
+                alcs_session_cipher_init (session);
                 session->authed_time = HAL_UptimeMs ();
                 session->heart_time = session->authed_time;
                 session->interval = default_heart_interval;
@@ -300,6 +301,7 @@ void  auth_cb(CoAPContext *ctx, CoAPReqResult result, void *userdata, NetworkAdd
         }
         auth_param->handler (ctx, remote, auth_param->user_data, &msg);
     }
+    put_session (session);
 
     coap_free (auth_param->productKey);
     coap_free (auth_param->deviceName);
@@ -325,7 +327,9 @@ int do_auth (CoAPContext *ctx, NetworkAddr* addr, ctl_key_item* ctl_item, void *
 
     session_item* session = get_ctl_session (ctx, &devKey);
     if (session) {
-        if (session->sessionId) {
+        int authed = session->sessionId != 0;
+        put_session (session);
+        if (authed) {
             COAP_INFO ("no need to reauth!");
             ResponseMsg res = {COAP_SUCCESS, NULL};
             handler (ctx, addr, user_data, &res);
@@ -340,6 +344,7 @@ int do_auth (CoAPContext *ctx, NetworkAddr* addr, ctl_key_item* ctl_item, void *
     {
         session = (session_item*)coap_malloc(sizeof(session_item));
         memset (session, 0, sizeof(session_item));
+        session->refs = 1;
 
         char path[100] = {0};
         strncpy(path, ctl_item->productKey, sizeof(path) - 1);
@@ -350,7 +355,7 @@ int do_auth (CoAPContext *ctx, NetworkAddr* addr, ctl_key_item* ctl_item, void *
         gen_random_key((unsigned char *)session->randomKey, RANDOMKEY_LEN);
 
         struct list_head* ctl_head = get_ctl_session_list (ctx);
-        list_add_tail(&session->lst, ctl_head);
+        add_session (ctl_head, session);
     }
 
     char sign[64]={0};
@@ -362,6 +367,7 @@ int do_auth (CoAPContext *ctx, NetworkAddr* addr, ctl_key_item* ctl_item, void *
     char payloadbuf[512];
     sprintf (payloadbuf, auth_payload_format, ++dev->seq, ctl_item->productKey, ctl_item->deviceName, session->randomKey, sign, ctl_item->accessKey);
     COAP_INFO("payload:%s", payloadbuf);
+    put_session (session);
 
     CoAPLenString payload;
     payload.data = (unsigned char *)payloadbuf;
@@ -508,7 +514,9 @@ int alcs_remove_client_key (CoAPContext *ctx, const char* key, char isfullkey)
 bool alcs_device_online (CoAPContext *ctx, AlcsDeviceKey* devKey)
 {
     session_item* session = get_ctl_session (ctx, devKey);
-    return session && session->sessionId? 1 : 0;
+    bool online = session && session->sessionId? 1 : 0;
+    put_session (session);
+    return online;
 }
 
 void heart_beat_cb(CoAPContext *ctx, CoAPReqResult result, void *userdata, NetworkAddr *remote, CoAPMessage *message)
@@ -520,16 +528,17 @@ void heart_beat_cb(CoAPContext *ctx, CoAPReqResult result, void *userdata, Netwo
         return;
     }
 
+    LIST_HEAD(removed);
+    session_item *node = NULL, *next = NULL;
+    session_lock ();
     if (result == COAP_RECV_RESP_TIMEOUT) {
         COAP_ERR ("heart beat timeout");
-        session_item *node = NULL, *next = NULL;
         list_for_each_entry_safe(node, next, ctl_head, lst, session_item) {
             if (node->sessionId && is_networkadd_same(&node->addr, remote)) {
-                remove_session (ctx, node);
+                unlink_session (node, &removed);
             }
         }
     } else {
-        session_item *node = NULL, *next = NULL;
         list_for_each_entry_safe(node, next, ctl_head, lst, session_item) {
 
             if(node->sessionId && is_networkadd_same(&node->addr, remote)) {
@@ -538,13 +547,16 @@ void heart_beat_cb(CoAPContext *ctx, CoAPReqResult result, void *userdata, Netwo
 
                 if (node->sessionId != sessionId) {
                     COAP_INFO ("receive stale heart beat response");
-                    remove_session (ctx, node);
+                    unlink_session (node, &removed);
                 } else {
                     node->heart_time = HAL_UptimeMs();
                 }
             }
         }
     }
+    session_unlock ();
+    /* observers are stopped out of session lock, observe notify takes it to encrypt */
+    release_sessions (ctx, &removed);
 }
 
 void on_client_auth_timer (CoAPContext* ctx)
@@ -565,6 +577,7 @@ void on_client_auth_timer (CoAPContext* ctx)
     int tick = HAL_UptimeMs();
 
     session_item *node = NULL, *next = NULL;
+    session_lock ();
     list_for_each_entry_safe(node, next, ctl_head, lst, session_item) {
         if (!node->sessionId) {
             continue;
@@ -580,6 +593,7 @@ void on_client_auth_timer (CoAPContext* ctx)
             CoAPMessage_destory(&message);
         }
     }
+    session_unlock ();
 }
 
 #endif
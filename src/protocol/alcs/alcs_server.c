@@ -225,6 +225,8 @@ void alcs_rec_auth (CoAPContext *ctx, const char *paths, NetworkAddr* from, CoAP
 
         if (!session) {
             session = (session_item*)coap_malloc(sizeof(session_item));
+            memset (session, 0, sizeof(session_item));
+            session->refs = 1;
             gen_random_key((unsigned char *)session->randomKey, RANDOMKEY_LEN);
             session->sessionId = ++sessionid_seed;
             char path[100] = {0};
@@ -235,7 +237,7 @@ void alcs_rec_auth (CoAPContext *ctx, const char *paths, NetworkAddr* from, CoAP
             memcpy (&session->addr, from, sizeof(NetworkAddr));
             COAP_INFO ("new session, addr:%s, port:%d", session->addr.addr, session->addr.port);
             struct list_head* svr_head = get_svr_session_list (ctx);
-            list_add_tail(&session->lst, svr_head);
+            add_session (svr_head, session);
         }
 
         pk[pklen] = tmp1;
@@ -243,6 +245,7 @@ void alcs_rec_auth (CoAPContext *ctx, const char *paths, NetworkAddr* from, CoAP
 
         snprintf (buf, sizeof(buf), "%.*s%s", randomkeylen, randomkey, session->randomKey);
         utils_hmac_sha1_raw (buf,strlen(buf), session->sessionKey, accessToken, tokenlen);
+        alcs_session_cipher_init (session);
 
         /*calc sign, save in buf*/
         calc_sign_len = sizeof(buf);
@@ -252,6 +255,7 @@ void alcs_rec_auth (CoAPContext *ctx, const char *paths, NetworkAddr* from, CoAP
 
         session->authed_time = HAL_UptimeMs ();
         session->heart_time = session->authed_time;
+        put_session (session);
         // ???
         //result = 1;
 
@@ -399,14 +403,14 @@ void send_err_rsp (CoAPContext* ctx, NetworkAddr*addr, int code, CoAPMessage* re
     alcs_sendrsp (ctx, addr, &sendMsg, 1, request->header.msgid, &token);
 }
 
-void call_cb (CoAPContext *context, const char *path, NetworkAddr *remote, CoAPMessage* message, const char* key, char* buf, CoAPRecvMsgHandler cb)
+void call_cb (CoAPContext *context, const char *path, NetworkAddr *remote, CoAPMessage* message, session_item* session, CoAPRecvMsgHandler cb)
 {
     CoAPMessage tmpMsg;
     memcpy (&tmpMsg, message, sizeof(CoAPMessage));
 
-    if (key && buf) {
-        int len = alcs_decrypt ((const char *)message->payload, message->payloadlen, key, buf);
-        tmpMsg.payload = (unsigned char *)buf;
+    if (session) {
+        /* decrypt in place, payload is in receive buffer of request */
+        int len = alcs_session_decrypt (session, (const char *)message->payload, message->payloadlen, message->payload);
         tmpMsg.payloadlen = len;
     } else {
         tmpMsg.payload = NULL;
@@ -416,17 +420,81 @@ void call_cb (CoAPContext *context, const char *path, NetworkAddr *remote, CoAPM
     cb (context, path, remote, &tmpMsg);
 }
 
+/* secure resources indexed by path checksum, must be power of 2 */
+#define RESOURCE_HASH_SIZE          (64)
+#define RESOURCE_PATH_CACHE_SIZE    (4)
+
+typedef struct
+{
+    unsigned int            hash;
+    secure_resource_cb_item* item;
+    char                    path[COAP_MSG_MAX_PATH_LEN];
+} resource_path_cache_item;
+
+static void *resource_mutex = NULL;
+static struct list_head secure_resource_hash[RESOURCE_HASH_SIZE];
+static resource_path_cache_item resource_path_cache[RESOURCE_PATH_CACHE_SIZE];
+
+static struct list_head* resource_bucket (const char path_calc[MAX_PATH_CHECKSUM_LEN])
+{
+    unsigned int hash = (unsigned char)path_calc[0] | ((unsigned char)path_calc[1] << 8);
+    return &secure_resource_hash[hash & (RESOURCE_HASH_SIZE - 1)];
+}
+
+void alcs_resource_cb_init(void)
+{
+    int i;
+
+    if (!resource_mutex) {
+        resource_mutex = HAL_MutexCreate();
+    }
+    for (i = 0; i < RESOURCE_HASH_SIZE; i++) {
+        INIT_LIST_HEAD(&secure_resource_hash[i]);
+    }
+    memset (resource_path_cache, 0, sizeof(resource_path_cache));
+}
+
 static secure_resource_cb_item* get_resource_by_path (const char *path)
 {
-    secure_resource_cb_item*node, *next;
+    secure_resource_cb_item* node;
+    resource_path_cache_item* cache;
+    unsigned int hash = 5381;
+    const char* p;
     char path_calc[MAX_PATH_CHECKSUM_LEN] = {0};
+
+    if (!resource_mutex) {
+        return NULL;
+    }
+
+    /* items are only released at deinit, so cached item stays valid */
+    for (p = path; *p; p++) {
+        hash = hash * 33 + (unsigned char)*p;
+    }
+    cache = &resource_path_cache[hash % RESOURCE_PATH_CACHE_SIZE];
+
+    HAL_MutexLock(resource_mutex);
+    if (cache->item && cache->hash == hash && strcmp(cache->path, path) == 0) {
+        node = cache->item;
+        HAL_MutexUnlock(resource_mutex);
+        return node;
+    }
+    HAL_MutexUnlock(resource_mutex);
+
     CoAPPathMD5_sum (path, strlen(path), path_calc, MAX_PATH_CHECKSUM_LEN);
 
-    list_for_each_entry_safe(node, next, &secure_resource_cb_head, lst, secure_resource_cb_item) {
+    HAL_MutexLock(resource_mutex);
+    list_for_each_entry(node, resource_bucket(path_calc), hash_lst, secure_resource_cb_item) {
         if (memcmp(node->path, path_calc, MAX_PATH_CHECKSUM_LEN) == 0){
+            if (strlen(path) < COAP_MSG_MAX_PATH_LEN) {
+                cache->hash = hash;
+                cache->item = node;
+                strcpy (cache->path, path);
+            }
+            HAL_MutexUnlock(resource_mutex);
             return node;
         }
     }
+    HAL_MutexUnlock(resource_mutex);
 
     COAP_ERR ("receive unknown request, path:%s", path);
     return NULL;
@@ -446,6 +514,7 @@ void recv_msg_handler (CoAPContext *context, const char *path, NetworkAddr *remo
     struct list_head* sessions = get_svr_session_list(context);
     session_item* session = get_session_by_checksum(sessions, remote, node->pk_dn);
     if (!session || session->sessionId != sessionId) {
+        put_session (session);
         send_err_rsp (context, remote, COAP_MSG_CODE_401_UNAUTHORIZED, message);
         COAP_ERR ("need auth, path:%s, from:%s", path, remote->addr);
         return;
@@ -458,16 +527,8 @@ void recv_msg_handler (CoAPContext *context, const char *path, NetworkAddr *remo
         }
     }
 
-    if (message->payloadlen < 256) {
-        char buf[256];
-        call_cb (context, path, remote, message, session->sessionKey, buf, node->cb);
-    } else {
-        char* buf = (char*)coap_malloc(message->payloadlen);
-        if (buf) {
-            call_cb (context, path, remote, message, session->sessionKey, buf, node->cb);
-            coap_free (buf);
-        }
-    }
+    call_cb (context, path, remote, message, session, node->cb);
+    put_session (session);
 }
 
 int alcs_resource_register_secure (CoAPContext *context, const char* pk, const char* dn, const char *path, unsigned short permission,
@@ -484,7 +545,13 @@ int alcs_resource_register_secure (CoAPContext *context, const char* pk, const c
     strncat(pk_dn, dn, sizeof(pk_dn)-strlen(pk_dn)-1);
     CoAPPathMD5_sum (pk_dn, strlen(pk_dn), item->pk_dn, PK_DN_CHECKSUM_LEN);
 
+    if (!resource_mutex) {
+        alcs_resource_cb_init();
+    }
+    HAL_MutexLock(resource_mutex);
     list_add_tail(&item->lst, &secure_resource_cb_head);
+    list_add_tail(&item->hash_lst, resource_bucket(item->path));
+    HAL_MutexUnlock(resource_mutex);
 
     return CoAPResource_register (context, path, permission, ctype, maxage, &recv_msg_handler);
 }
@@ -493,12 +560,22 @@ void alcs_resource_cb_deinit(void)
 {
     secure_resource_cb_item* del_item = NULL;
 
+    if (!resource_mutex) {
+        return;
+    }
+    HAL_MutexLock(resource_mutex);
     list_for_each_entry(del_item,&secure_resource_cb_head,lst,secure_resource_cb_item)
     {
         list_del(&del_item->lst);
+        list_del(&del_item->hash_lst);
         coap_free(del_item);
         del_item = list_entry(&secure_resource_cb_head,secure_resource_cb_item,lst);
     }
+    memset (resource_path_cache, 0, sizeof(resource_path_cache));
+    HAL_MutexUnlock(resource_mutex);
+
+    HAL_MutexDestroy(resource_mutex);
+    resource_mutex = NULL;
 }
 
 void alcs_auth_list_deinit(void)
@@ -523,12 +600,17 @@ void alcs_rec_heart_beat(CoAPContext *ctx, const char *path, NetworkAddr *remote
 
     session_item* session = NULL;
     session_item *node = NULL, *next = NULL;
+    session_lock ();
     list_for_each_entry_safe(node, next, ctl_head, lst, session_item) {
         if(node->sessionId && is_networkadd_same(&node->addr, remote)) {
             node->heart_time = HAL_UptimeMs();
             session = node;
         }
     }
+    if (session) {
+        session->refs++;
+    }
+    session_unlock ();
 
     if (!session) {
         COAP_INFO ("receive stale heart beat");
@@ -558,6 +640,7 @@ void alcs_rec_heart_beat(CoAPContext *ctx, const char *path, NetworkAddr *remote
         msg.header.tokenlen = request->header.tokenlen;
         memcpy (&msg.token, request->token, request->header.tokenlen);
         internal_secure_send (ctx, session, remote, &msg, 1, NULL);
+        put_session (session);
     } else {
         CoAPLenString token = {request->header.tokenlen, request->token};
         alcs_sendrsp (ctx, remote, &msg, 1, request->header.msgid, &token);
@@ -580,8 +663,9 @@ int observe_data_encrypt(CoAPContext *ctx, const char* path, NetworkAddr* from,
     if (session) {
         dest->len = (src->len & 0xfffffff0) + 16;
         dest->data  = (unsigned char*)coap_malloc(dest->len);
-        alcs_encrypt ((const char*)src->data, src->len, session->sessionKey, dest->data);
+        alcs_session_encrypt (session, (const char*)src->data, src->len, dest->data);
         CoAPUintOption_add (message, COAP_OPTION_SESSIONID, session->sessionId);
+        put_session (session);
         return COAP_SUCCESS;
     }
 
@@ -599,12 +683,16 @@ void on_svr_auth_timer (CoAPContext* ctx)
     //device_auth_list* dev = get_device (ctx);
     int tick = HAL_UptimeMs();
 
+    LIST_HEAD(removed);
     session_item *node = NULL, *next = NULL;
+    session_lock ();
     list_for_each_entry_safe(node, next, head, lst, session_item) {
         if(node->sessionId && node->heart_time + default_heart_expire < tick) {
             COAP_ERR ("heart beat timeout");
-            remove_session (ctx, node);
+            unlink_session (node, &removed);
         }
     }
+    session_unlock ();
+    release_sessions (ctx, &removed);
 }
 #endif
@@ -29,6 +29,7 @@
 
 CoAPContext *CoAPContext_create(CoAPInitParam *param)
 {
+    int i = 0;
     CoAPIntContext    *p_ctx = NULL;
     NetworkInit    network_param;
 
@@ -59,12 +60,15 @@ CoAPContext *CoAPContext_create(CoAPInitParam *param)
     memset(p_ctx->sendbuf, 0x00, COAP_MSG_MAX_PDU_LEN);
 #endif
 
-    p_ctx->recvbuf = coap_malloc(COAP_MSG_MAX_PDU_LEN);
+    p_ctx->recvbuf = coap_malloc(COAP_RECV_BATCH_COUNT * (COAP_MSG_MAX_PDU_LEN + 1));
     if (NULL == p_ctx->recvbuf) {
         COAP_ERR("not enough memory");
         goto err;
     }
-    memset(p_ctx->recvbuf, 0x00, COAP_MSG_MAX_PDU_LEN);
+    memset(p_ctx->recvbuf, 0x00, COAP_RECV_BATCH_COUNT * (COAP_MSG_MAX_PDU_LEN + 1));
+    for (i = 0; i < COAP_RECV_BATCH_COUNT; i++) {
+        p_ctx->recvbufs[i] = p_ctx->recvbuf + i * (COAP_MSG_MAX_PDU_LEN + 1);
+    }
 
     if (0 == param->waittime) {
         p_ctx->waittime = COAP_DEFAULT_WAIT_TIME_MS;
@@ -81,6 +85,10 @@ CoAPContext *CoAPContext_create(CoAPInitParam *param)
     p_ctx->sendlist.list_mutex = HAL_MutexCreate();
     /*CoAP message send list*/
     INIT_LIST_HEAD(&p_ctx->sendlist.list);
+    for (i = 0; i < COAP_SENDLIST_HASH_SIZE; i++) {
+        INIT_LIST_HEAD(&p_ctx->sendmsgid[i]);
+        INIT_LIST_HEAD(&p_ctx->sendtoken[i]);
+    }
 
     HAL_MutexLock(p_ctx->sendlist.list_mutex);
     p_ctx->sendlist.count = 0;
@@ -91,6 +99,12 @@ CoAPContext *CoAPContext_create(CoAPInitParam *param)
     } else {
         p_ctx->sendlist.maxcount = COAP_DEFAULT_SENDLIST_MAXCOUNT;
     }
+    p_ctx->sendheap = coap_malloc(p_ctx->sendlist.maxcount * sizeof(CoAPSendNode *));
+    if (NULL == p_ctx->sendheap) {
+        COAP_ERR("not enough memory");
+        goto err;
+    }
+    p_ctx->heapcount = 0;
 
     if (0 == param->res_maxcount) {
         param->res_maxcount = COAP_DEFAULT_RES_MAXCOUNT;
@@ -157,6 +171,11 @@ err:
 
     CoAPResource_deinit(p_ctx);
 
+    if (NULL != p_ctx->sendheap) {
+        coap_free(p_ctx->sendheap);
+        p_ctx->sendheap = NULL;
+    }
+
     if (NULL != p_ctx->sendlist.list_mutex) {
         HAL_MutexDestroy(p_ctx->sendlist.list_mutex);
         p_ctx->sendlist.list_mutex = NULL;
@@ -205,14 +224,18 @@ void CoAPContext_free(CoAPContext *context)
                 coap_free(cur->message);
                 cur->message = NULL;
             }
-            coap_free(cur);
+            coap_node_free(cur);
             cur = NULL;
         }
     }
     INIT_LIST_HEAD(&p_ctx->sendlist.list);
+    p_ctx->heapcount = 0;
+    coap_free(p_ctx->sendheap);
+    p_ctx->sendheap = NULL;
     HAL_MutexUnlock(p_ctx->sendlist.list_mutex);
     HAL_MutexDestroy(p_ctx->sendlist.list_mutex);
     p_ctx->sendlist.list_mutex = NULL;
+    utils_slab_shrink(&g_coap_slab_pool);
     HAL_MutexDestroy(p_ctx->mutex);
     p_ctx->mutex = NULL;
     COAP_DEBUG("Release Send List and Memory");
@@ -8,13 +8,41 @@
 #define __COAP_INTERNAL_H__
 #include "CoAPNetwork.h"
 #include "CoAPExport.h"
+#include "CoAPMessage.h"
+#include "CoAPResource.h"
 #include "lite-list.h"
+#include "utils_slab.h"
 
 
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
+/* bucket counts must be power of 2 */
+#define COAP_SENDLIST_HASH_SIZE         (16)
+#define COAP_RESOURCE_HASH_SIZE         (64)
+#ifndef COAP_RESOURCE_PATH_CACHE_SIZE
+#define COAP_RESOURCE_PATH_CACHE_SIZE   (4)
+#endif
+/* send nodes are carved from slab pages, beyond max pages from heap */
+#ifndef COAP_SLAB_PAGE_SIZE
+#define COAP_SLAB_PAGE_SIZE             (1024)
+#endif
+#ifndef COAP_SLAB_MAX_PAGES
+#define COAP_SLAB_MAX_PAGES             (8)
+#endif
+
+extern utils_slab_pool_t g_coap_slab_pool;
+#define coap_node_malloc(size)          utils_slab_alloc(&g_coap_slab_pool, size)
+#define coap_node_free(ptr)             utils_slab_free(ptr)
+
+typedef struct
+{
+    unsigned int             hash;
+    CoAPResource            *resource;
+    char                     path[COAP_MSG_MAX_PATH_LEN];
+}CoAPResourcePathCache;
+
 
 typedef struct
 {
@@ -31,11 +59,18 @@ typedef struct
     NetworkContext           *p_network;
     CoAPEventNotifier        notifier;
     unsigned char            *sendbuf;
-    unsigned char            *recvbuf;
+    unsigned char            *recvbuf;      /* pool of COAP_RECV_BATCH_COUNT pdu buffers, one spare byte each */
+    unsigned char            *recvbufs[COAP_RECV_BATCH_COUNT];
     CoAPList                 sendlist;
+    CoAPSendNode           **sendheap;      /* min-heap of sendlist nodes by deadline, guarded by sendlist.list_mutex */
+    unsigned char            heapcount;
+    struct list_head         sendmsgid[COAP_SENDLIST_HASH_SIZE];   /* sendlist nodes by msgid, guarded by sendlist.list_mutex */
+    struct list_head         sendtoken[COAP_SENDLIST_HASH_SIZE];   /* sendlist nodes with token by token */
     CoAPList                 obsserver;
     CoAPList                 obsclient;
     CoAPList                 resource;
+    struct list_head         reshash[COAP_RESOURCE_HASH_SIZE];     /* resources by path checksum, guarded by resource.list_mutex */
+    CoAPResourcePathCache    rescache[COAP_RESOURCE_PATH_CACHE_SIZE];
     unsigned int             waittime;
     void                     *appdata;
     void                     *mutex;
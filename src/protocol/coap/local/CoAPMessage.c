@@ -38,14 +38,21 @@
 #define CoAPReqMsg(header)\
     ((1 <= header.code) && (32 > header.code))
 
+static const utils_slab_config_t g_coap_slab_config = {
+    "coap.local", COAP_SLAB_PAGE_SIZE, COAP_SLAB_MAX_PAGES, 1, { sizeof(CoAPSendNode) }
+};
+
+utils_slab_pool_t g_coap_slab_pool = UTILS_SLAB_POOL_INIT(&g_coap_slab_config);
+
 
 #define COAP_CUR_VERSION        1
 #define COAP_WAIT_TIME_MS       2000
 #define COAP_MAX_MESSAGE_ID     65535
+/* RFC 7252 4.8 transmission parameters, timing scaled down for local network */
 #define COAP_MAX_RETRY_COUNT    4
-#define COAP_ACK_TIMEOUT        2
-#define COAP_ACK_RANDOM_FACTOR  1
-#define COAP_MAX_TRANSMISSION_SPAN   10
+#define COAP_ACK_TIMEOUT_MS     400
+#define COAP_ACK_RANDOM_FACTOR  150     /* percent */
+#define COAP_MAX_TRANSMISSION_SPAN_MS   2000    /* lifetime of NON message waiting for response */
 
 int CoAPStrOption_add(CoAPMessage *message, unsigned short optnum, unsigned char *data, unsigned short datalen)
 {
@@ -339,22 +346,114 @@ int CoAPMessage_destory(CoAPMessage *message)
     return COAP_SUCCESS;
 }
 
+/* Send heap keeps nodes of sendlist ordered by deadline, caller holds sendlist.list_mutex */
+static void CoAPSendHeap_set(CoAPIntContext *ctx, int index, CoAPSendNode *node)
+{
+    ctx->sendheap[index] = node;
+    node->heap_index = index;
+}
+
+static void CoAPSendHeap_up(CoAPIntContext *ctx, int index)
+{
+    CoAPSendNode *node = ctx->sendheap[index];
+    int parent = 0;
+
+    while (index > 0) {
+        parent = (index - 1) / 2;
+        if (ctx->sendheap[parent]->deadline <= node->deadline) {
+            break;
+        }
+        CoAPSendHeap_set(ctx, index, ctx->sendheap[parent]);
+        index = parent;
+    }
+    CoAPSendHeap_set(ctx, index, node);
+}
+
+static void CoAPSendHeap_down(CoAPIntContext *ctx, int index)
+{
+    CoAPSendNode *node = ctx->sendheap[index];
+    int child = 0;
+
+    while ((child = index * 2 + 1) < ctx->heapcount) {
+        if (child + 1 < ctx->heapcount && ctx->sendheap[child + 1]->deadline < ctx->sendheap[child]->deadline) {
+            child++;
+        }
+        if (node->deadline <= ctx->sendheap[child]->deadline) {
+            break;
+        }
+        CoAPSendHeap_set(ctx, index, ctx->sendheap[child]);
+        index = child;
+    }
+    CoAPSendHeap_set(ctx, index, node);
+}
+
+static void CoAPSendHeap_push(CoAPIntContext *ctx, CoAPSendNode *node)
+{
+    CoAPSendHeap_set(ctx, ctx->heapcount++, node);
+    CoAPSendHeap_up(ctx, node->heap_index);
+}
+
+static void CoAPSendHeap_remove(CoAPIntContext *ctx, CoAPSendNode *node)
+{
+    int index = node->heap_index;
+
+    if (index < 0) {
+        return;
+    }
+    node->heap_index = -1;
+
+    if (index == --ctx->heapcount) {
+        return;
+    }
+    CoAPSendHeap_set(ctx, index, ctx->sendheap[ctx->heapcount]);
+    CoAPSendHeap_up(ctx, index);
+    CoAPSendHeap_down(ctx, ctx->sendheap[index]->heap_index);
+}
+
+static struct list_head *CoAPMessageList_msgid_bucket(CoAPIntContext *ctx, unsigned short msgid)
+{
+    return &ctx->sendmsgid[msgid & (COAP_SENDLIST_HASH_SIZE - 1)];
+}
+
+static struct list_head *CoAPMessageList_token_bucket(CoAPIntContext *ctx, unsigned char *token,
+        unsigned char tokenlen)
+{
+    unsigned int hash = 0;
+    unsigned char i = 0;
+
+    for (i = 0; i < tokenlen; i++) {
+        hash = hash * 31 + token[i];
+    }
+    return &ctx->sendtoken[hash & (COAP_SENDLIST_HASH_SIZE - 1)];
+}
+
+/* caller holds sendlist.list_mutex */
+static void CoAPMessageList_remove(CoAPIntContext *ctx, CoAPSendNode *node)
+{
+    list_del_init(&node->sendlist);
+    list_del_init(&node->msgidlist);
+    list_del_init(&node->tokenlist);
+    CoAPSendHeap_remove(ctx, node);
+    ctx->sendlist.count--;
+}
+
 static int CoAPMessageList_add(CoAPContext *context, NetworkAddr *remote,
                                CoAPMessage *message, unsigned char *buffer, int len)
 {
     CoAPIntContext *ctx = (CoAPIntContext *)context;
     CoAPSendNode *node = NULL;
-    node = coap_malloc(sizeof(CoAPSendNode));
+    node = coap_node_malloc(sizeof(CoAPSendNode));
 
     if (NULL != node) {
-        memset(node, 0x00, sizeof(CoAPSendNode));
         node->acked        = 0;
         node->user         = message->user;
         node->header       = message->header;
         node->handler      = message->handler;
         node->msglen       = len;
         node->message      = buffer;
-        node->timeout_val   = COAP_ACK_TIMEOUT * COAP_ACK_RANDOM_FACTOR;
+        node->heap_index   = -1;
+        INIT_LIST_HEAD(&node->msgidlist);
+        INIT_LIST_HEAD(&node->tokenlist);
         memcpy(&node->remote, remote, sizeof(NetworkAddr));
         if (platform_is_multicast((const char *)remote->addr) || 1 == message->keep) {
             COAP_FLOW("The message %d need keep", message->header.msgid);
@@ -364,23 +463,35 @@ static int CoAPMessageList_add(CoAPContext *context, NetworkAddr *remote,
         }
 
         if (COAP_MESSAGE_TYPE_CON == message->header.type) {
-            node->timeout       = node->timeout_val;
+            /* initial timeout is random between ACK_TIMEOUT and ACK_TIMEOUT * ACK_RANDOM_FACTOR */
+            node->timeout_val   = COAP_ACK_TIMEOUT_MS +
+                                  HAL_Random(COAP_ACK_TIMEOUT_MS * (COAP_ACK_RANDOM_FACTOR - 100) / 100 + 1);
             node->retrans_count = 0;
         } else {
-            node->timeout       = COAP_MAX_TRANSMISSION_SPAN;
+            node->timeout_val   = COAP_MAX_TRANSMISSION_SPAN_MS;
             node->retrans_count = COAP_MAX_RETRY_COUNT;
         }
+        node->deadline = HAL_UptimeMs() + node->timeout_val;
         memcpy(node->token, message->token, message->header.tokenlen);
 
         HAL_MutexLock(ctx->sendlist.list_mutex);
         if (ctx->sendlist.count >= ctx->sendlist.maxcount) {
             HAL_MutexUnlock(ctx->sendlist.list_mutex);
-            coap_free(node);
+            coap_node_free(node);
             COAP_INFO("The send list is full");
             return COAP_ERROR_DATA_SIZE;
         } else {
             list_add_tail(&node->sendlist, &ctx->sendlist.list);
+            list_add_tail(&node->msgidlist, CoAPMessageList_msgid_bucket(ctx, node->header.msgid));
+            if (0 != node->header.tokenlen) {
+                list_add_tail(&node->tokenlist,
+                              CoAPMessageList_token_bucket(ctx, node->token, node->header.tokenlen));
+            }
             ctx->sendlist.count ++;
+            /* NON message which needs keep waits for responses until canceled */
+            if (COAP_MESSAGE_TYPE_CON == node->header.type || !node->keep) {
+                CoAPSendHeap_push(ctx, node);
+            }
             HAL_MutexUnlock(ctx->sendlist.list_mutex);
             return COAP_SUCCESS;
         }
@@ -507,14 +618,14 @@ int CoAPMessage_cancel(CoAPContext *context, CoAPMessage *message)
 
 
     HAL_MutexLock(ctx->sendlist.list_mutex);
-    list_for_each_entry_safe(node, next, &ctx->sendlist.list, sendlist, CoAPSendNode) {
+    list_for_each_entry_safe(node, next, CoAPMessageList_msgid_bucket(ctx, message->header.msgid), msgidlist,
+                             CoAPSendNode) {
         if (node->header.msgid == message->header.msgid) {
-            list_del_init(&node->sendlist);
-            ctx->sendlist.count--;
+            CoAPMessageList_remove(ctx, node);
             COAP_INFO("Cancel message %d from list, cur count %d",
                       node->header.msgid, ctx->sendlist.count);
             coap_free(node->message);
-            coap_free(node);
+            coap_node_free(node);
         }
     }
     HAL_MutexUnlock(ctx->sendlist.list_mutex);
@@ -531,15 +642,14 @@ int CoAPMessageId_cancel(CoAPContext *context, unsigned short msgid)
     }
 
     HAL_MutexLock(ctx->sendlist.list_mutex);
-    list_for_each_entry_safe(node, next, &ctx->sendlist.list, sendlist, CoAPSendNode) {
+    list_for_each_entry_safe(node, next, CoAPMessageList_msgid_bucket(ctx, msgid), msgidlist, CoAPSendNode) {
         if (NULL != node) {
             if (node->header.msgid == msgid) {
-                list_del_init(&node->sendlist);
-                ctx->sendlist.count--;
+                CoAPMessageList_remove(ctx, node);
                 COAP_FLOW("Cancel message %d from list, cur count %d",
                           node->header.msgid, ctx->sendlist.count);
                 coap_free(node->message);
-                coap_free(node);
+                coap_node_free(node);
 
             }
         }
@@ -556,14 +666,14 @@ static int CoAPAckMessage_handle(CoAPContext *context, CoAPMessage *message)
     CoAPIntContext *ctx = (CoAPIntContext *)context;
 
     HAL_MutexLock(ctx->sendlist.list_mutex);
-    list_for_each_entry_safe(node, next, &ctx->sendlist.list, sendlist, CoAPSendNode) {
+    list_for_each_entry_safe(node, next, CoAPMessageList_msgid_bucket(ctx, message->header.msgid), msgidlist,
+                             CoAPSendNode) {
         if (node->header.msgid == message->header.msgid) {
             node->acked = 1;
             if (CoAPRespMsg(node->header)) { //CON response message
-                list_del_init(&node->sendlist);
+                CoAPMessageList_remove(ctx, node);
                 coap_free(node->message);
-                coap_free(node);
-                ctx->sendlist.count --;
+                coap_node_free(node);
                 COAP_DEBUG("The CON response message %d receive ACK, remove it", message->header.msgid);
             }
             HAL_MutexUnlock(ctx->sendlist.list_mutex);
@@ -637,12 +747,12 @@ static int CoAPRespMessage_handle(CoAPContext *context, NetworkAddr *remote, CoA
     }
 
     HAL_MutexLock(ctx->sendlist.list_mutex);
-    list_for_each_entry_safe(node, next, &ctx->sendlist.list, sendlist, CoAPSendNode) {
+    list_for_each_entry_safe(node, next, CoAPMessageList_token_bucket(ctx, message->token, message->header.tokenlen),
+                             tokenlist, CoAPSendNode) {
         if (0 != node->header.tokenlen && node->header.tokenlen == message->header.tokenlen
             && 0 == memcmp(node->token, message->token, message->header.tokenlen)) {
             if (!node->keep) {
-                list_del_init(&node->sendlist);
-                ctx->sendlist.count--;
+                CoAPMessageList_remove(ctx, node);
                 COAP_FLOW("Remove the message id %d from list", node->header.msgid);
             } else {
                 COAP_FLOW("Find the message id %d, It need keep", node->header.msgid);
@@ -676,7 +786,7 @@ static int CoAPRespMessage_handle(CoAPContext *context, NetworkAddr *remote, CoA
             if (NULL != node->message) {
                 coap_free(node->message);
             }
-            coap_free(node);
+            coap_node_free(node);
             node = NULL;
             COAP_DEBUG("The message needless keep, free it");
         }
@@ -822,10 +932,28 @@ static void CoAPMessage_handle(CoAPContext *context,
 
 }
 
+/* time to wait for incoming message, no later than the first deadline of send heap */
+static unsigned int CoAPMessage_waittime(CoAPIntContext *ctx, unsigned int timeout)
+{
+    uint64_t now = HAL_UptimeMs();
+    uint64_t deadline = now + timeout;
+
+    HAL_MutexLock(ctx->sendlist.list_mutex);
+    if (0 != ctx->heapcount && ctx->sendheap[0]->deadline < deadline) {
+        deadline = ctx->sendheap[0]->deadline;
+    }
+    HAL_MutexUnlock(ctx->sendlist.list_mutex);
+
+    return (deadline > now) ? (unsigned int)(deadline - now) : 0;
+}
+
 int CoAPMessage_process(CoAPContext *context, unsigned int timeout)
 {
-    int len = 0;
-    NetworkAddr remote;
+    int count = 0;
+    int i = 0;
+    unsigned int waittime = 0;
+    unsigned int len[COAP_RECV_BATCH_COUNT];
+    NetworkAddr remote[COAP_RECV_BATCH_COUNT];
     CoAPIntContext *ctx = (CoAPIntContext *)context;
 
     if (NULL == context) {
@@ -833,82 +961,95 @@ int CoAPMessage_process(CoAPContext *context, unsigned int timeout)
     }
 
     while (1) {
-        memset(&remote, 0x00, sizeof(NetworkAddr));
-        memset(ctx->recvbuf, 0x00, COAP_MSG_MAX_PDU_LEN);
-        len = CoAPNetwork_read(ctx->p_network,
-                               &remote,
-                               ctx->recvbuf,
-                               COAP_MSG_MAX_PDU_LEN, timeout);
-        if (len > 0) {
-            CoAPMessage_handle(ctx, &remote, ctx->recvbuf, len);
-        } else {
-            return len;
+        /* return when a retransmission is due, so that it is not delayed by incoming messages */
+        waittime = CoAPMessage_waittime(ctx, timeout);
+        if (0 == waittime) {
+            return 0;
+        }
+
+        memset(remote, 0x00, sizeof(remote));
+        count = CoAPNetwork_read_batch(ctx->p_network, remote, ctx->recvbufs,
+                                       COAP_MSG_MAX_PDU_LEN, len, COAP_RECV_BATCH_COUNT, waittime);
+        if (count <= 0) {
+            return count;
+        }
+
+        for (i = 0; i < count; i++) {
+            /* terminate instead of clearing the whole buffer, payload may be used as string */
+            ctx->recvbufs[i][len[i]] = '\0';
+            CoAPMessage_handle(ctx, &remote[i], ctx->recvbufs[i], len[i]);
         }
     }
 }
 
 int CoAPMessage_retransmit(CoAPContext *context)
 {
-    unsigned int ret = 0;
     CoAPIntContext *ctx = (CoAPIntContext *)context;
-    CoAPSendNode *node = NULL, *next = NULL;
+    CoAPSendNode *node = NULL;
+    NetworkAddr remote;
+    unsigned char *message = NULL;
+    unsigned int msglen = 0;
+    unsigned short msgid = 0;
+    uint64_t now = 0;
 
     if (NULL == context) {
         return COAP_ERROR_INVALID_PARAM;
     }
-    HAL_MutexLock(ctx->sendlist.list_mutex);
-    list_for_each_entry_safe(node, next, &ctx->sendlist.list, sendlist, CoAPSendNode) {
-        if (NULL != node) {
-            if (node->timeout == 0) {
-                if (node->retrans_count < COAP_MAX_RETRY_COUNT) {
-                    node->timeout     = node->timeout_val * 2;
-                    node->timeout_val = node->timeout;
-                    node->retrans_count++;
-
-                    /*If has received ack message, don't resend the message*/
-                    if (0 == node->acked) {
-                        COAP_DEBUG("Retansmit the message id %d len %d", node->header.msgid, node->msglen);
-                        ret = CoAPNetwork_write(ctx->p_network, &node->remote, node->message, node->msglen, ctx->waittime);
-                        if (ret != COAP_SUCCESS) {
-                            if (NULL != ctx->notifier) {
-                                /* TODO: */
-                                /* context->notifier(context, event); */
-                            }
-                        }
-                    }
+
+    /* only nodes whose deadline has passed are visited, earliest first */
+    now = HAL_UptimeMs();
+    while (1) {
+        HAL_MutexLock(ctx->sendlist.list_mutex);
+        if (0 == ctx->heapcount || ctx->sendheap[0]->deadline > now) {
+            HAL_MutexUnlock(ctx->sendlist.list_mutex);
+            break;
+        }
+        node = ctx->sendheap[0];
+
+        if (node->retrans_count < COAP_MAX_RETRY_COUNT) {
+            node->retrans_count++;
+            node->timeout_val *= 2;
+            node->deadline = now + node->timeout_val;
+            CoAPSendHeap_down(ctx, 0);
+
+            /*If has received ack message, don't resend the message*/
+            message = NULL;
+            if (0 == node->acked) {
+                message = coap_malloc(node->msglen);
+                if (NULL != message) {
+                    memcpy(message, node->message, node->msglen);
+                    memcpy(&remote, &node->remote, sizeof(NetworkAddr));
+                    msglen = node->msglen;
+                    msgid = node->header.msgid;
                 }
+            }
+            HAL_MutexUnlock(ctx->sendlist.list_mutex);
+
+            /* node may be acked or canceled while writing, so write a copy without holding list */
+            if (NULL != message) {
+                COAP_DEBUG("Retansmit the message id %d len %d", msgid, msglen);
+                CoAPNetwork_write(ctx->p_network, &remote, message, msglen, ctx->waittime);
+                coap_free(message);
+            }
+            continue;
+        }
+
+        /*Remove the node from the list*/
+        CoAPMessageList_remove(ctx, node);
+        COAP_INFO("Retransmit timeout,remove the message id %d count %d",
+                  node->header.msgid, ctx->sendlist.count);
+        HAL_MutexUnlock(ctx->sendlist.list_mutex);
 
-                if ((node->timeout > COAP_MAX_TRANSMISSION_SPAN)
-                    || (node->retrans_count >= COAP_MAX_RETRY_COUNT
-                        && !node->keep)) {
-                    if (NULL != ctx->notifier) {
-                        /* TODO: */
-                        /* context->notifier(context, event); */
-                    }
-                    /*Remove the node from the list*/
-                    list_del_init(&node->sendlist);
-                    ctx->sendlist.count--;
-                    COAP_INFO("Retransmit timeout,remove the message id %d count %d",
-                              node->header.msgid, ctx->sendlist.count);
 #ifndef COAP_OBSERVE_SERVER_DISABLE
-                    CoapObsServerAll_delete(ctx, &node->remote);
+        CoapObsServerAll_delete(ctx, &node->remote);
 #endif
-                    HAL_MutexUnlock(ctx->sendlist.list_mutex);
-                    if (NULL != node->handler) {
-                        node->handler(ctx, COAP_RECV_RESP_TIMEOUT, node->user, &node->remote, NULL);
-                    }
-                    coap_free(node->message);
-                    coap_free(node);
-
-                    HAL_MutexLock(ctx->sendlist.list_mutex);
-                }
-            } else {
-                node->timeout--;
-            }
+        if (NULL != node->handler) {
+            node->handler(ctx, COAP_RECV_RESP_TIMEOUT, node->user, &node->remote, NULL);
         }
+        coap_free(node->message);
+        coap_node_free(node);
     }
 
-    HAL_MutexUnlock(ctx->sendlist.list_mutex);
     return COAP_SUCCESS;
 }
 
@@ -6,6 +6,7 @@
 
 #ifndef __COAP_MESSAGE_H__
 #define __COAP_MESSAGE_H__
+#include "lite-list.h"
 #include "CoAPExport.h"
 
 #ifdef __cplusplus
@@ -18,12 +19,15 @@ typedef struct
     CoAPMsgHeader            header;
     unsigned char            retrans_count;
     unsigned char            token[COAP_MSG_MAX_TOKEN_LEN];
-    unsigned short           timeout;
-    unsigned short           timeout_val;
+    unsigned int             timeout_val;   /* ms, doubled on each retransmission */
+    uint64_t                 deadline;      /* HAL_UptimeMs() of next retransmission or expiry */
+    int                      heap_index;    /* position in send heap of context, -1 if never expires */
     unsigned int             msglen;
     CoAPSendMsgHandler       handler;
     NetworkAddr              remote;
     struct list_head         sendlist;
+    struct list_head         msgidlist;
+    struct list_head         tokenlist;
     void                    *user;
     unsigned char           *message;
     int                      acked;
@@ -46,6 +46,44 @@ int CoAPNetwork_read(NetworkContext         *p_context,
     return len;
 }
 
+int CoAPNetwork_read_batch(NetworkContext *p_context,
+                           NetworkAddr    *p_remote,
+                           unsigned char  *p_data[],
+                           unsigned int    datalen,
+                           unsigned int   *p_len,
+                           unsigned int    count,
+                           unsigned int    timeout_ms)
+{
+    int          ret      = 0;
+    NetworkConf  *network = NULL;
+
+    if (NULL == p_context || NULL == p_remote || NULL == p_data || NULL == p_len || 0 == count) {
+        return -1;
+    }
+
+    network = (NetworkConf *)p_context;
+#ifdef COAP_DTLS_SUPPORT
+    if (COAP_NETWORK_DTLS == network->type) {
+    } else {
+#endif
+#if COAP_RECV_BATCH_COUNT > 1
+        if (1 < count) {
+            ret = HAL_UDP_recvfrom_batch(network->fd, p_remote, p_data, datalen, p_len, count, timeout_ms);
+        } else
+#endif
+        {
+            ret = HAL_UDP_recvfrom(network->fd, p_remote, p_data[0], datalen, timeout_ms);
+            if (ret > 0) {
+                p_len[0] = ret;
+                ret = 1;
+            }
+        }
+#ifdef COAP_DTLS_SUPPORT
+    }
+#endif
+    return ret;
+}
+
 int CoAPNetwork_write(NetworkContext          *p_context,
                                 NetworkAddr   *p_remote,
                          const unsigned char  *p_data,
@@ -13,6 +13,10 @@
 extern "C" {
 #endif /* __cplusplus */
 
+/* datagrams read from network at once, opt in by board config only where HAL_UDP_recvfrom_batch is provided */
+#ifndef COAP_RECV_BATCH_COUNT
+#define COAP_RECV_BATCH_COUNT           (1)
+#endif
 
 typedef enum
 {
@@ -55,6 +59,14 @@ int CoAPNetwork_read(NetworkContext *p_context,
                             unsigned int datalen,
                             unsigned int timeout);
 
+int CoAPNetwork_read_batch(NetworkContext *p_context,
+                           NetworkAddr    *p_remote,
+                           unsigned char  *p_data[],
+                           unsigned int    datalen,
+                           unsigned int   *p_len,
+                           unsigned int    count,
+                           unsigned int    timeout);
+
 void CoAPNetwork_deinit(NetworkContext *p_context);
 
 #ifdef __cplusplus
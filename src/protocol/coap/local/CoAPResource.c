@@ -27,15 +27,38 @@ int CoAPPathMD5_sum(const char *path, int len, char outbuf[], int outlen)
     return 0;
 }
 
+/* checksum is part of md5, so its leading bytes are evenly distributed */
+static struct list_head *CoAPResource_bucket(CoAPIntContext *ctx, const char *path_calc)
+{
+    unsigned int hash = (unsigned char)path_calc[0] | ((unsigned char)path_calc[1] << 8);
+
+    return &ctx->reshash[hash & (COAP_RESOURCE_HASH_SIZE - 1)];
+}
+
+static unsigned int CoAPResource_path_hash(const char *path)
+{
+    unsigned int hash = 5381;
+
+    while (*path) {
+        hash = hash * 33 + (unsigned char)(*path++);
+    }
+    return hash;
+}
+
 
 int CoAPResource_init(CoAPContext *context, int res_maxcount)
 {
+    int i = 0;
     CoAPIntContext *ctx = (CoAPIntContext *)context;
 
     ctx->resource.list_mutex = HAL_MutexCreate();
 
     HAL_MutexLock(ctx->resource.list_mutex);
     INIT_LIST_HEAD(&ctx->resource.list);
+    for (i = 0; i < COAP_RESOURCE_HASH_SIZE; i++) {
+        INIT_LIST_HEAD(&ctx->reshash[i]);
+    }
+    memset(ctx->rescache, 0x00, sizeof(ctx->rescache));
     ctx->resource.count = 0;
     ctx->resource.maxcount = res_maxcount;
     HAL_MutexUnlock(ctx->resource.list_mutex);
@@ -52,6 +75,7 @@ int CoAPResource_deinit(CoAPContext *context)
     HAL_MutexLock(ctx->resource.list_mutex);
     list_for_each_entry_safe(node, next, &ctx->resource.list, reslist, CoAPResource) {
         list_del_init(&node->reslist);
+        list_del_init(&node->hashlist);
         LITE_hexbuf_convert((unsigned char *)node->path, tmpbuf, COAP_MAX_PATH_CHECKSUM_LEN, 0);
         COAP_DEBUG("Release the resource %s", tmpbuf);
         coap_free(node);
@@ -59,6 +83,7 @@ int CoAPResource_deinit(CoAPContext *context)
     }
     ctx->resource.count = 0;
     ctx->resource.maxcount = 0;
+    memset(ctx->rescache, 0x00, sizeof(ctx->rescache));
     HAL_MutexUnlock(ctx->resource.list_mutex);
 
     HAL_MutexDestroy(ctx->resource.list_mutex);
@@ -117,7 +142,7 @@ int CoAPResource_register(CoAPContext *context, const char *path,
 
 
     CoAPPathMD5_sum(path, strlen(path), path_calc, COAP_PATH_DEFAULT_SUM_LEN);
-    list_for_each_entry(node, &ctx->resource.list, reslist, CoAPResource) {
+    list_for_each_entry(node, CoAPResource_bucket(ctx, path_calc), hashlist, CoAPResource) {
         if (0 == memcmp(path_calc, node->path, COAP_PATH_DEFAULT_SUM_LEN)) {
             /*Alread exist, re-write it*/
             COAP_INFO("CoAPResource_register:Alread exist");
@@ -136,6 +161,7 @@ int CoAPResource_register(CoAPContext *context, const char *path,
         if (NULL != newnode) {
             COAP_DEBUG("CoAPResource_register, context:%p, new node", ctx);
             list_add_tail(&newnode->reslist, &ctx->resource.list);
+            list_add_tail(&newnode->hashlist, CoAPResource_bucket(ctx, newnode->path));
             ctx->resource.count++;
             COAP_DEBUG("Register new resource %s success, count: %d", path, ctx->resource.count);
         } else {
@@ -157,6 +183,8 @@ int CoAPResource_unregister(CoAPContext *context, const char *path)
 CoAPResource *CoAPResourceByPath_get(CoAPContext *context, const char *path)
 {
     char path_calc[COAP_PATH_DEFAULT_SUM_LEN] = {0};
+    unsigned int hash = 0;
+    CoAPResourcePathCache *cache = NULL;
     CoAPResource *node = NULL;
     CoAPIntContext *ctx = (CoAPIntContext *)context;
 
@@ -166,11 +194,28 @@ CoAPResource *CoAPResourceByPath_get(CoAPContext *context, const char *path)
     }
     COAP_FLOW("CoAPResourceByPath_get, context:%p\n", ctx);
 
+    /* resources are only released at deinit, so cached node stays valid */
+    hash = CoAPResource_path_hash(path);
+    cache = &ctx->rescache[hash % COAP_RESOURCE_PATH_CACHE_SIZE];
+
+    HAL_MutexLock(ctx->resource.list_mutex);
+    if (NULL != cache->resource && cache->hash == hash && 0 == strcmp(cache->path, path)) {
+        node = cache->resource;
+        HAL_MutexUnlock(ctx->resource.list_mutex);
+        return node;
+    }
+    HAL_MutexUnlock(ctx->resource.list_mutex);
+
     CoAPPathMD5_sum(path, strlen(path), path_calc, COAP_PATH_DEFAULT_SUM_LEN);
 
     HAL_MutexLock(ctx->resource.list_mutex);
-    list_for_each_entry(node, &ctx->resource.list, reslist, CoAPResource) {
+    list_for_each_entry(node, CoAPResource_bucket(ctx, path_calc), hashlist, CoAPResource) {
         if (0 == memcmp(path_calc, node->path, COAP_PATH_DEFAULT_SUM_LEN)) {
+            if (strlen(path) < COAP_MSG_MAX_PATH_LEN) {
+                cache->hash = hash;
+                cache->resource = node;
+                strcpy(cache->path, path);
+            }
             HAL_MutexUnlock(ctx->resource.list_mutex);
             if (strcmp("/sys/device/info/notify", path)) {
                 COAP_DEBUG("Found the resource: %s", path);
@@ -25,6 +25,7 @@ typedef struct
     unsigned int             ctype;
     unsigned int             maxage;
     struct list_head         reslist;
+    struct list_head         hashlist;
     char                     path[COAP_MAX_PATH_CHECKSUM_LEN];
 }CoAPResource;
 
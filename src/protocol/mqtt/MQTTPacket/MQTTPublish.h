@@ -12,6 +12,7 @@
     #define DLLExport
 #endif
 
+DLLExport int MQTTSerialize_publishLength(int qos, MQTTString topicName, int payloadlen);
 DLLExport int MQTTSerialize_publish(unsigned char *buf, int buflen, unsigned char dup, int qos, unsigned char retained,
                                     unsigned short packetid,
                                     MQTTString topicName, unsigned char *payload, int payloadlen);
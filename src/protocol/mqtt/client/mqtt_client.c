@@ -10,39 +10,67 @@
 #include "iotx_utils.h"
 #include "utils_hmac.h"
 #include "string_utils.h"
+#include "utils_atomic.h"
 
 #include "MQTTPacket/MQTTPacket.h"
 #include "iotx_mqtt_internal.h"
+#include "mqtt_topic_trie.h"
 #include "utils_md5.h"
 #include "report.h"
 
 #define MQTT_DEFAULT_MSG_LEN 1280
 
+/* packet being handled in read buffer */
+#define MQTT_READ_FRAME(c)              ((unsigned char *)(c)->buf_read + (c)->buf_read_offset)
+
+/* handles matched by one PUBLISH kept on stack, more than that will be allocated */
+#define MQTT_DELIVER_HANDLE_NUM_LOCAL   (8)
+
+#if !WITH_MQTT_ONLY_QOS0
+static const utils_slab_config_t g_mqtt_slab_config = {
+    "mqtt", IOTX_MC_SLAB_PAGE_SIZE, IOTX_MC_SLAB_MAX_PAGES, 3,
+    {
+        sizeof(iotx_mc_topic_handle_t),
+        sizeof(iotx_mc_pub_info_t) + 128,
+        sizeof(iotx_mc_pub_info_t) + 256
+    }
+};
+#else
+/* no pub info kept for QoS0 only */
+static const utils_slab_config_t g_mqtt_slab_config = {
+    "mqtt", IOTX_MC_SLAB_PAGE_SIZE, IOTX_MC_SLAB_MAX_PAGES, 1,
+    {
+        sizeof(iotx_mc_topic_handle_t)
+    }
+};
+#endif
+
+utils_slab_pool_t g_mqtt_slab_pool = UTILS_SLAB_POOL_INIT(&g_mqtt_slab_config);
+
 static int iotx_mc_send_packet(iotx_mc_client_t *c, char *buf, int length, iotx_time_t *time);
 static int iotx_mc_read_packet(iotx_mc_client_t *c, iotx_time_t *timer, unsigned int *packet_type);
 static int iotx_mc_keepalive_sub(iotx_mc_client_t *pClient);
+static int iotx_mc_get_next_packetid(iotx_mc_client_t *c);
 static void iotx_mc_disconnect_callback(iotx_mc_client_t *pClient) ;
 static int iotx_mc_check_state_normal(iotx_mc_client_t *c);
 static void iotx_mc_reconnect_callback(iotx_mc_client_t *pClient);
 #if !WITH_MQTT_ONLY_QOS0
-    static int iotx_mc_push_pubInfo_to(iotx_mc_client_t *c, int len, unsigned short msgId, iotx_mc_pub_info_t **node);
+    static int iotx_mc_push_pubInfo_to(iotx_mc_client_t *c, int len, iotx_mc_pub_info_t **node);
+    static void iotx_mc_remove_pubInfo(iotx_mc_client_t *c, iotx_mc_pub_info_t *node, uint16_t msgId);
+    #if WITH_MQTT_SEND_QUEUE
+    static void _pub_info_put(iotx_mc_client_t *c, iotx_mc_pub_info_t *node);
+    #endif
 #endif
 static int iotx_mc_push_subInfo_to(iotx_mc_client_t *c, int len, unsigned short msgId, enum msgTypes type,
-                                   iotx_mc_topic_handle_t *handler,
+                                   iotx_mc_topic_handle_t *handler, int handler_num,
                                    iotx_mc_subsribe_info_t **node);
-#if !(WITH_MQTT_SUB_SHORTCUT)
-static int iotx_mc_check_handle_is_identical(iotx_mc_topic_handle_t *messageHandlers1,
-        iotx_mc_topic_handle_t *messageHandler2);
-#endif
-static int iotx_mc_check_handle_is_identical_ex(iotx_mc_topic_handle_t *messageHandlers1,
-        iotx_mc_topic_handle_t *messageHandler2);
 
 static iotx_mc_state_t iotx_mc_get_client_state(iotx_mc_client_t *pClient);
 static void iotx_mc_set_client_state(iotx_mc_client_t *pClient, iotx_mc_state_t newState);
 
 static int _dump_wait_list(iotx_mc_client_t *c, const char *type);
 
-static void _iotx_mqtt_event_handle_sub(void *pcontext, void *pclient, iotx_mqtt_event_msg_pt msg);
+static void _iotx_mqtt_event_handle_sub(void *pcontext, void *pclient, iotx_mqtt_event_msg_pt msg, uint32_t fail_mask);
 
 static void *g_mqtt_client = NULL;
 
@@ -142,8 +170,6 @@ static int _alloc_recv_buffer(iotx_mc_client_t *c, int len)
 
 
 #if WITH_MQTT_ZIP_TOPIC
-#define MQTT_MD5_PATH_DEFAULT_LEN (16)
-
 static int iotx_mc_get_md5_topic(const char *path, int len, char outbuf[], int outlen)
 {
     unsigned char md5[16] = {0};
@@ -262,40 +288,6 @@ static int iotx_mc_check_rule(char *iterm, iotx_mc_topic_type_t type)
     return SUCCESS_RETURN;
 }
 
-/* check whether the topic is matched or not */
-static char iotx_mc_is_topic_matched(char *topicFilter, MQTTString *topicName)
-{
-    if (!topicFilter || !topicName) {
-        return 0;
-    }
-    char *curf = topicFilter;
-    char *curn = topicName->lenstring.data;
-    char *curn_end = curn + topicName->lenstring.len;
-
-    while (*curf && curn < curn_end) {
-        if (*curn == '/' && *curf != '/') {
-            break;
-        }
-
-        if (*curf != '+' && *curf != '#' && *curf != *curn) {
-            break;
-        }
-
-        if (*curf == '+') {
-            /* skip until we meet the next separator, or end of string */
-            char *nextpos = curn + 1;
-            while (nextpos < curn_end && *nextpos != '/') {
-                nextpos = ++curn + 1;
-            }
-        } else if (*curf == '#') {
-            curn = curn_end - 1;    /* skip until end of string */
-        }
-        curf++;
-        curn++;
-    }
-
-    return (curn == curn_end) && (*curf == '\0');
-}
 /* Check topic name */
 /* 0, topic name is valid; NOT 0, topic name is invalid */
 static int iotx_mc_check_topic(const char *topicName, iotx_mc_topic_type_t type)
@@ -436,27 +428,371 @@ int MQTTConnect(iotx_mc_client_t *pClient)
     return SUCCESS_RETURN;
 }
 
-int MQTTPublish(iotx_mc_client_t *c, const char *topicName, iotx_mqtt_topic_info_pt topic_msg)
+#if WITH_MQTT_SEND_QUEUE
+#if UTILS_ATOMIC_LOCK_FREE
+    #define MQTT_SEND_CAS_PTR(c, ptr, oldval, newval)   UTILS_ATOMIC_CAS(ptr, oldval, newval)
+    #define MQTT_SEND_CAS_INT(c, ptr, oldval, newval)   UTILS_ATOMIC_CAS(ptr, oldval, newval)
+#else
+/* compare-and-swap emulated by lock_generic on toolchains without atomic builtins */
+static int _send_cas_ptr(iotx_mc_client_t *c, iotx_mc_send_info_t **ptr, iotx_mc_send_info_t *oldval,
+                         iotx_mc_send_info_t *newval)
+{
+    int rc = 0;
 
+    HAL_MutexLock(c->lock_generic);
+    if (*ptr == oldval) {
+        *ptr = newval;
+        rc = 1;
+    }
+    HAL_MutexUnlock(c->lock_generic);
+
+    return rc;
+}
+
+static int _send_cas_int(iotx_mc_client_t *c, int *ptr, int oldval, int newval)
 {
-    iotx_time_t         timer;
-    MQTTString          topic = MQTTString_initializer;
-    int                 len = 0;
+    int rc = 0;
 
-    if (!c || !topicName || !topic_msg) {
-        return FAIL_RETURN;
+    HAL_MutexLock(c->lock_generic);
+    if (*ptr == oldval) {
+        *ptr = newval;
+        rc = 1;
+    }
+    HAL_MutexUnlock(c->lock_generic);
+
+    return rc;
+}
+
+    #define MQTT_SEND_CAS_PTR(c, ptr, oldval, newval)   _send_cas_ptr(c, ptr, oldval, newval)
+    #define MQTT_SEND_CAS_INT(c, ptr, oldval, newval)   _send_cas_int(c, ptr, oldval, newval)
+#endif
+
+/* allocate node with buffer of @len bytes, small ones are taken from pool */
+static iotx_mc_send_info_t *_send_info_alloc(iotx_mc_client_t *c, uint32_t len)
+{
+    iotx_mc_send_info_t *node = NULL;
+    uint32_t size = (len > IOTX_MC_SEND_POOL_BUF_LEN) ? len : IOTX_MC_SEND_POOL_BUF_LEN;
+
+    if (size == IOTX_MC_SEND_POOL_BUF_LEN) {
+        HAL_MutexLock(c->lock_generic);
+        node = c->send_pool;
+        if (node != NULL) {
+            c->send_pool = node->next;
+            c->send_pool_num--;
+        }
+        HAL_MutexUnlock(c->lock_generic);
+    }
+
+    if (node == NULL) {
+        node = mqtt_malloc(sizeof(iotx_mc_send_info_t) + size);
+        if (node == NULL) {
+            return NULL;
+        }
+    }
+
+    memset(node, 0, sizeof(iotx_mc_send_info_t));
+    node->size = size;
+    node->buf = (unsigned char *)node + sizeof(iotx_mc_send_info_t);
+
+    return node;
+}
+
+static void _send_info_free(iotx_mc_client_t *c, iotx_mc_send_info_t *node)
+{
+    if (node->size == IOTX_MC_SEND_POOL_BUF_LEN) {
+        HAL_MutexLock(c->lock_generic);
+        if (c->send_pool_num < IOTX_MC_SEND_POOL_NUM) {
+            node->next = c->send_pool;
+            c->send_pool = node;
+            c->send_pool_num++;
+            node = NULL;
+        }
+        HAL_MutexUnlock(c->lock_generic);
+    }
+
+    if (node != NULL) {
+        mqtt_free(node);
+    }
+}
+
+/* release nodes from @node to the end of list once written or dropped */
+static void _send_info_list_done(iotx_mc_client_t *c, iotx_mc_send_info_t *node)
+{
+    iotx_mc_send_info_t *next = NULL;
+
+    for (; node != NULL; node = next) {
+        next = node->next;
+#if !WITH_MQTT_ONLY_QOS0
+        if (node->pub != NULL) {
+            _pub_info_put(c, node->pub);
+            continue;
+        }
+#endif
+        _send_info_free(c, node);
+    }
+}
+
+/* push @node into send queue, never blocks */
+static void iotx_mc_send_queue_push(iotx_mc_client_t *c, iotx_mc_send_info_t *node)
+{
+    iotx_mc_send_info_t *head = NULL;
+
+    do {
+        head = c->send_queue;
+        node->next = head;
+    } while (!MQTT_SEND_CAS_PTR(c, &c->send_queue, head, node));
+}
+
+/* detach all nodes of send queue, return them in order of push */
+static iotx_mc_send_info_t *iotx_mc_send_queue_take(iotx_mc_client_t *c)
+{
+    iotx_mc_send_info_t *head = NULL;
+    iotx_mc_send_info_t *list = NULL;
+    iotx_mc_send_info_t *next = NULL;
+
+    do {
+        head = c->send_queue;
+    } while (head != NULL && !MQTT_SEND_CAS_PTR(c, &c->send_queue, head, NULL));
+
+    for (; head != NULL; head = next) {
+        next = head->next;
+        head->next = list;
+        list = head;
+    }
+
+    return list;
+}
+
+/* write out @list, packets are copied together into send buffer as many as it holds, to share one write */
+/* On failure the rest is dropped and client marked disconnected, QoS1 packets stay in window and are republished */
+/* Required to run in lock_write_buf protection setup by caller */
+static int _send_queue_write(iotx_mc_client_t *c, iotx_mc_send_info_t *list)
+{
+    int rc = SUCCESS_RETURN;
+    iotx_time_t timer;
+    iotx_mc_send_info_t *node = NULL;
+    iotx_mc_send_info_t *batch = NULL;
+    iotx_mc_send_info_t *last = NULL;
+    uint32_t total = 0;
+    uint32_t len = 0;
+    int coalesce = 0;
+
+    for (node = list; node != NULL; node = node->next) {
+        total += node->len;
+    }
+    if (list->next != NULL && _alloc_send_buffer(c, total) == SUCCESS_RETURN && c->buf_send != NULL) {
+        coalesce = 1;
     }
 
-    topic.cstring = (char *)topicName;
     iotx_time_init(&timer);
     utils_time_countdown_ms(&timer, c->request_timeout_ms);
 
+    node = list;
+    while (node != NULL && rc == SUCCESS_RETURN) {
+        len = 0;
+        batch = node;
+        if (coalesce) {
+            while (node != NULL && len + node->len <= c->buf_size_send) {
+                memcpy(c->buf_send + len, node->buf, node->len);
+                len += node->len;
+                last = node;
+                node = node->next;
+            }
+        }
+
+        if (len > 0) {
+            rc = iotx_mc_send_packet(c, c->buf_send, len, &timer);
+        } else {
+            /* single packet, or one larger than send buffer, goes out by itself */
+            rc = iotx_mc_send_packet(c, (char *)node->buf, node->len, &timer);
+            last = node;
+            node = node->next;
+        }
+        last->next = NULL;
+        _send_info_list_done(c, batch);
+    }
+
+    if (rc != SUCCESS_RETURN) {
+        mqtt_err("send queue write failed, drop packets not sent");
+        _send_info_list_done(c, node);
+        iotx_mc_set_client_state(c, IOTX_MC_STATE_DISCONNECTED);
+    }
+    if (coalesce) {
+        _reset_send_buffer(c);
+    }
+
+    return rc;
+}
+
+/* drain send queue if no other sender is doing that, otherwise leave packets to it */
+static void iotx_mc_send_queue_flush(iotx_mc_client_t *c)
+{
+    iotx_mc_send_info_t *list = NULL;
+
+    while (c->send_queue != NULL && MQTT_SEND_CAS_INT(c, &c->send_draining, 0, 1)) {
+        list = iotx_mc_send_queue_take(c);
+        if (list != NULL) {
+            HAL_MutexLock(c->lock_write_buf);
+            _send_queue_write(c, list);
+            HAL_MutexUnlock(c->lock_write_buf);
+        }
+        /* packets pushed while draining are taken by next round, or by sender who wins after reset */
+        MQTT_SEND_CAS_INT(c, &c->send_draining, 1, 0);
+    }
+}
+
+/* queue @node, which is released by whichever sender writes it, return without waiting for that */
+static int iotx_mc_send_queue_send(iotx_mc_client_t *c, iotx_mc_send_info_t *node)
+{
+    iotx_mc_send_queue_push(c, node);
+    /* the drainer may have left before @node was pushed, so try to drain it here as well */
+    iotx_mc_send_queue_flush(c);
+
+    return SUCCESS_RETURN;
+}
+
+/* release pool and packets never written, run after locks are destroyed */
+static void iotx_mc_send_queue_destroy(iotx_mc_client_t *c)
+{
+    iotx_mc_send_info_t *node = NULL;
+
+    while (c->send_queue != NULL) {
+        node = c->send_queue;
+        c->send_queue = node->next;
+#if !WITH_MQTT_ONLY_QOS0
+        if (node->pub != NULL) {
+            /* window node, freed here if PUBACK took it out of window already */
+            if (--node->pub->refs == 0) {
+                mqtt_obj_free(node->pub);
+            }
+            continue;
+        }
+#endif
+        mqtt_free(node);
+    }
+    while (c->send_pool != NULL) {
+        node = c->send_pool;
+        c->send_pool = node->next;
+        mqtt_free(node);
+    }
+    c->send_pool_num = 0;
+}
+#endif
+
+#if !WITH_MQTT_ONLY_QOS0
+/* QoS1 publish is serialized once into its own node of in-flight window, and sent or queued from there */
+static int MQTTPublishAcked(iotx_mc_client_t *c, MQTTString *topic, iotx_mqtt_topic_info_pt topic_msg,
+                            iotx_time_t *timer)
+{
+    int                 len = 0;
+    int                 rc = 0;
+    iotx_mc_pub_info_t *node = NULL;
+
+    len = MQTTPacket_len(MQTTSerialize_publishLength(topic_msg->qos, *topic, topic_msg->payload_len));
+
+    /* push into window, packet id is allocated there */
+    if (SUCCESS_RETURN != iotx_mc_push_pubInfo_to(c, len, &node)) {
+        mqtt_err("push publish into to pubInfolist failed!");
+        return MQTT_PUSH_TO_LIST_ERROR;
+    }
+    topic_msg->packet_id = node->msg_id;
+
+    len = MQTTSerialize_publish(node->buf,
+                                node->len,
+                                0,
+                                topic_msg->qos,
+                                topic_msg->retain,
+                                topic_msg->packet_id,
+                                *topic,
+                                (unsigned char *)topic_msg->payload,
+                                topic_msg->payload_len);
+    if (len <= 0) {
+        mqtt_err("MQTTSerialize_publish is error, len=%d, payloadlen=%u", len, topic_msg->payload_len);
+        iotx_mc_remove_pubInfo(c, node, topic_msg->packet_id);
+        return MQTT_PUBLISH_PACKET_ERROR;
+    }
+
+#if WITH_MQTT_SEND_QUEUE
+    /* queued by reference, the reference keeps node alive if PUBACK comes before sender is done with it */
+    memset(&node->send, 0, sizeof(iotx_mc_send_info_t));
+    node->send.buf = node->buf;
+    node->send.len = len;
+    node->send.size = node->len;
+    node->send.pub = node;
     HAL_MutexLock(c->lock_list_pub);
+    node->refs++;
+    HAL_MutexUnlock(c->lock_list_pub);
+    rc = iotx_mc_send_queue_send(c, &node->send);
+#else
+    HAL_MutexLock(c->lock_write_buf);
+    rc = iotx_mc_send_packet(c, (char *)node->buf, len, timer);
+    HAL_MutexUnlock(c->lock_write_buf);
+#endif
+
+    if (rc != SUCCESS_RETURN) {
+        /* If not even successfully sent to IP stack, meaningless to wait QOS1 ack, give up waiting */
+        iotx_mc_remove_pubInfo(c, node, topic_msg->packet_id);
+        return MQTT_NETWORK_ERROR;
+    }
+
+    return SUCCESS_RETURN;
+}
+#endif
+
+#if WITH_MQTT_SEND_QUEUE
+/* QoS0 publish is serialized into a buffer of its own, and sent through send queue */
+static int MQTTPublishUnacked(iotx_mc_client_t *c, MQTTString *topic, iotx_mqtt_topic_info_pt topic_msg,
+                              iotx_time_t *timer)
+{
+    int                 len = 0;
+    iotx_mc_send_info_t *node = NULL;
+
+    (void)timer;
+    len = MQTTPacket_len(MQTTSerialize_publishLength(topic_msg->qos, *topic, topic_msg->payload_len));
+#if WITH_MQTT_DYN_BUF
+    if (len > c->buf_size_send_max) {
+#else
+    if (len > c->buf_size_send) {
+#endif
+        mqtt_err("publish packet too long, len=%d", len);
+        return MQTT_PUBLISH_PACKET_ERROR;
+    }
+
+    node = _send_info_alloc(c, len);
+    if (node == NULL) {
+        mqtt_err("allocate send buffer failed, len=%d", len);
+        return FAIL_RETURN;
+    }
+
+    len = MQTTSerialize_publish(node->buf,
+                                node->size,
+                                0,
+                                topic_msg->qos,
+                                topic_msg->retain,
+                                topic_msg->packet_id,
+                                *topic,
+                                (unsigned char *)topic_msg->payload,
+                                topic_msg->payload_len);
+    if (len <= 0) {
+        mqtt_err("MQTTSerialize_publish is error, len=%d, payloadlen=%u", len, topic_msg->payload_len);
+        _send_info_free(c, node);
+        return MQTT_PUBLISH_PACKET_ERROR;
+    }
+    node->len = len;
+
+    return iotx_mc_send_queue_send(c, node);
+}
+#else
+/* QoS0 publish is serialized into send buffer */
+static int MQTTPublishUnacked(iotx_mc_client_t *c, MQTTString *topic, iotx_mqtt_topic_info_pt topic_msg,
+                              iotx_time_t *timer)
+{
+    int                 len = 0;
+
     HAL_MutexLock(c->lock_write_buf);
 
-    if (_alloc_send_buffer(c, strlen(topicName) + topic_msg->payload_len) < 0) {
+    if (_alloc_send_buffer(c, strlen(topic->cstring) + topic_msg->payload_len) < 0) {
         HAL_MutexUnlock(c->lock_write_buf);
-        HAL_MutexUnlock(c->lock_list_pub);
         return FAIL_RETURN;
     }
 
@@ -466,7 +802,7 @@ int MQTTPublish(iotx_mc_client_t *c, const char *topicName, iotx_mqtt_topic_info
                                 topic_msg->qos,
                                 topic_msg->retain,
                                 topic_msg->packet_id,
-                                topic,
+                                *topic,
                                 (unsigned char *)topic_msg->payload,
                                 topic_msg->payload_len);
     if (len <= 0) {
@@ -476,82 +812,145 @@ int MQTTPublish(iotx_mc_client_t *c, const char *topicName, iotx_mqtt_topic_info
                  topic_msg->payload_len);
         _reset_send_buffer(c);
         HAL_MutexUnlock(c->lock_write_buf);
-        HAL_MutexUnlock(c->lock_list_pub);
         return MQTT_PUBLISH_PACKET_ERROR;
     }
 
-#if !WITH_MQTT_ONLY_QOS0
-    iotx_mc_pub_info_t  *node = NULL;
-    /* If the QOS >1, push the information into list of wait publish ACK */
-    if (topic_msg->qos > IOTX_MQTT_QOS0) {
-        /* push into list */
-        if (SUCCESS_RETURN != iotx_mc_push_pubInfo_to(c, len, topic_msg->packet_id, &node)) {
-            mqtt_err("push publish into to pubInfolist failed!");
-            _reset_send_buffer(c);
-            HAL_MutexUnlock(c->lock_write_buf);
-            HAL_MutexUnlock(c->lock_list_pub);
-            return MQTT_PUSH_TO_LIST_ERROR;
-        }
-    }
-#endif
     /* send the publish packet */
-    if (iotx_mc_send_packet(c, c->buf_send, len, &timer) != SUCCESS_RETURN) {
-#if !WITH_MQTT_ONLY_QOS0
-        if (topic_msg->qos > IOTX_MQTT_QOS0) {
-            /* If not even successfully sent to IP stack, meaningless to wait QOS1 ack, give up waiting */
-            list_del(&node->linked_list);
-            mqtt_free(node);
-        }
-#endif
+    if (iotx_mc_send_packet(c, c->buf_send, len, timer) != SUCCESS_RETURN) {
         _reset_send_buffer(c);
         HAL_MutexUnlock(c->lock_write_buf);
-        HAL_MutexUnlock(c->lock_list_pub);
         return MQTT_NETWORK_ERROR;
     }
-
-#if WITH_MQTT_JSON_FLOW
-    const char     *json_payload = (const char *)topic_msg->payload;
-
-    mqtt_info("Upstream Topic: '%s'", topicName);
-    mqtt_info("Upstream Payload:");
-    iotx_facility_json_print(json_payload, LOG_INFO_LEVEL, '>');
-
-#endif  /* #if WITH_MQTT_JSON_FLOW */
-    _reset_send_buffer(c);
-    HAL_MutexUnlock(c->lock_write_buf);
-    HAL_MutexUnlock(c->lock_list_pub);
+
+    _reset_send_buffer(c);
+    HAL_MutexUnlock(c->lock_write_buf);
+
+    return SUCCESS_RETURN;
+}
+#endif
+
+int MQTTPublish(iotx_mc_client_t *c, const char *topicName, iotx_mqtt_topic_info_pt topic_msg)
+
+{
+    iotx_time_t         timer;
+    MQTTString          topic = MQTTString_initializer;
+    int                 rc = 0;
+
+    if (!c || !topicName || !topic_msg) {
+        return FAIL_RETURN;
+    }
+
+    topic.cstring = (char *)topicName;
+    iotx_time_init(&timer);
+    utils_time_countdown_ms(&timer, c->request_timeout_ms);
+
+#if !WITH_MQTT_ONLY_QOS0
+    if (topic_msg->qos > IOTX_MQTT_QOS0) {
+        rc = MQTTPublishAcked(c, &topic, topic_msg, &timer);
+    } else
+#endif
+    {
+        rc = MQTTPublishUnacked(c, &topic, topic_msg, &timer);
+    }
+    if (rc != SUCCESS_RETURN) {
+        return rc;
+    }
+
+#if WITH_MQTT_JSON_FLOW
+    const char     *json_payload = (const char *)topic_msg->payload;
+
+    mqtt_info("Upstream Topic: '%s'", topicName);
+    mqtt_info("Upstream Payload:");
+    iotx_facility_json_print(json_payload, LOG_INFO_LEVEL, '>');
+
+#endif  /* #if WITH_MQTT_JSON_FLOW */
+
+    return SUCCESS_RETURN;
+}
+
+/* remove and free all handles which have the same topic filter with @key */
+static void iotx_mc_remove_topic_handles(iotx_mc_client_t *c, iotx_mc_topic_handle_t *key)
+{
+    iotx_mc_topic_handle_t *h = NULL;
+
+    while ((h = iotx_mc_topic_trie_lookup(&c->sub_handles, key, 0)) != NULL) {
+        iotx_mc_topic_trie_remove(&c->sub_handles, h);
+        mqtt_free(h->topic_filter);
+        mqtt_obj_free(h);
+    }
+}
+
+/* fill @handler with copy of @topicFilter, which is saved as MD5 digest if WITH_MQTT_ZIP_TOPIC and no wildcard */
+static int iotx_mc_topic_handle_init(iotx_mc_topic_handle_t *handler, const char *topicFilter,
+                                     iotx_mqtt_event_handle_func_fpt messageHandler, void *pcontext)
+{
+    memset(handler, 0, sizeof(iotx_mc_topic_handle_t));
+#if !(WITH_MQTT_ZIP_TOPIC)
+    handler->topic_filter = mqtt_malloc(strlen(topicFilter) + 1);
+    if (NULL == handler->topic_filter) {
+        return FAIL_RETURN;
+    }
+    handler->topic_type = (strchr(topicFilter, '+') != NULL || strchr(topicFilter, '#') != NULL) ?
+                          TOPIC_FILTER_TYPE : TOPIC_NAME_TYPE;
+    memcpy((char *)handler->topic_filter, topicFilter, strlen(topicFilter) + 1);
+#else
+    if (strstr(topicFilter, "/+") != NULL || strstr(topicFilter, "/#") != NULL) {
+        handler->topic_filter = mqtt_malloc(strlen(topicFilter) + 1);
+        if (NULL == handler->topic_filter) {
+            return FAIL_RETURN;
+        }
+        handler->topic_type = TOPIC_FILTER_TYPE;
+        memcpy((char *)handler->topic_filter, topicFilter, strlen(topicFilter) + 1);
+    } else {
+        handler->topic_filter = mqtt_malloc(MQTT_MD5_PATH_DEFAULT_LEN);
+        if (NULL == handler->topic_filter) {
+            return FAIL_RETURN;
+        }
+        handler->topic_type = TOPIC_NAME_TYPE;
+        if (iotx_mc_get_md5_topic(topicFilter, strlen(topicFilter), (char *)handler->topic_filter,
+                                  MQTT_MD5_PATH_DEFAULT_LEN) != 0) {
+            mqtt_free(handler->topic_filter);
+            handler->topic_filter = NULL;
+            return FAIL_RETURN;
+        }
+    }
+#endif
+    iotx_mc_topic_handle_hash(handler);
+    handler->handle.h_fp = messageHandler;
+    handler->handle.pcontext = pcontext;
 
     return SUCCESS_RETURN;
 }
 
-static int remove_handle_from_list(iotx_mc_client_t *c, iotx_mc_topic_handle_t *h)
+/* free array of @count handles allocated for one SUBSCRIBE or UNSUBSCRIBE request */
+static void iotx_mc_topic_handles_free(iotx_mc_topic_handle_t *handlers, int count)
 {
-    iotx_mc_topic_handle_t **hp, *h1;
+    int i = 0;
 
-    hp = &c->first_sub_handle;
-    while ((*hp) != NULL) {
-        h1 = *hp;
-        if (h1 == h) {
-            *hp = h->next;
-        } else {
-            hp = &h1->next;
-        }
+    if (handlers == NULL) {
+        return;
     }
 
-    return 0;
+    for (i = 0; i < count; i++) {
+        if (handlers[i].topic_filter != NULL) {
+            mqtt_free(handlers[i].topic_filter);
+        }
+    }
+    mqtt_free(handlers);
 }
 
-/* MQTT send subscribe packet */
-static int MQTTSubscribe(iotx_mc_client_t *c, const char *topicFilter, iotx_mqtt_qos_t qos, unsigned int msgId,
-                         iotx_mqtt_event_handle_func_fpt messageHandler, void *pcontext)
+/* MQTT send subscribe packet carrying @count topic filters */
+static int MQTTSubscribe(iotx_mc_client_t *c, iotx_mqtt_multi_sub_t *topics, int count, unsigned int msgId)
 {
     int                         len = 0;
+    int                         i = 0;
+    int                         topics_len = 0;
     iotx_time_t                 timer;
-    MQTTString                  topic = MQTTString_initializer;
-    /*iotx_mc_topic_handle_t handler = {topicFilter, {messageHandler, pcontext}};*/
+    MQTTString                  topic[MUTLI_SUBSCIRBE_MAX];
+    int                         qos[MUTLI_SUBSCIRBE_MAX];
     iotx_mc_topic_handle_t     *handler = NULL;
 
-    if (!c || !topicFilter || !messageHandler) {
+    if (!c || !topics || count <= 0 || count > MUTLI_SUBSCIRBE_MAX) {
         return FAIL_RETURN;
     }
 #if !( WITH_MQTT_DYN_BUF)
@@ -560,63 +959,41 @@ static int MQTTSubscribe(iotx_mc_client_t *c, const char *topicFilter, iotx_mqtt
     }
 #endif
 
-    topic.cstring = (char *)topicFilter;
     iotx_time_init(&timer);
     utils_time_countdown_ms(&timer, c->request_timeout_ms);
 
-    handler = mqtt_malloc(sizeof(iotx_mc_topic_handle_t));
+    /* handles of all topic filters are kept in one array, till SUBACK arrives */
+    handler = mqtt_malloc(count * sizeof(iotx_mc_topic_handle_t));
     if (NULL == handler) {
         return FAIL_RETURN;
     }
+    memset(handler, 0, count * sizeof(iotx_mc_topic_handle_t));
 
-#if !(WITH_MQTT_ZIP_TOPIC)
-    handler->topic_filter = mqtt_malloc(strlen(topicFilter) + 1);
-    if (NULL == handler->topic_filter) {
-        mqtt_free(handler);
-        return FAIL_RETURN;
-    }
-    memcpy((char *)handler->topic_filter, topicFilter, strlen(topicFilter) + 1);
-#else
-    if (strstr(topicFilter, "/+") != NULL || strstr(topicFilter, "/#") != NULL) {
-        handler->topic_filter = mqtt_malloc(strlen(topicFilter) + 1);
-        if (NULL == handler->topic_filter) {
-            mqtt_free(handler);
-            return FAIL_RETURN;
-        }
-        handler->topic_type = TOPIC_FILTER_TYPE;
-        memcpy((char *)handler->topic_filter, topicFilter, strlen(topicFilter) + 1);
-    } else {
-        handler->topic_filter = mqtt_malloc(MQTT_MD5_PATH_DEFAULT_LEN);
-        if (NULL == handler->topic_filter) {
-            mqtt_free(handler);
-            return FAIL_RETURN;
-        }
-        handler->topic_type = TOPIC_NAME_TYPE;
-        if (iotx_mc_get_md5_topic(topicFilter, strlen(topicFilter), (char *)handler->topic_filter,
-                                  MQTT_MD5_PATH_DEFAULT_LEN) != 0) {
-            mqtt_free(handler->topic_filter);
-            mqtt_free(handler);
+    for (i = 0; i < count; i++) {
+        if (!topics[i].topic_filter || !topics[i].topic_handle_func ||
+            SUCCESS_RETURN != iotx_mc_topic_handle_init(&handler[i], topics[i].topic_filter,
+                    topics[i].topic_handle_func, topics[i].pcontext)) {
+            iotx_mc_topic_handles_free(handler, count);
             return FAIL_RETURN;
         }
+        memset(&topic[i], 0, sizeof(MQTTString));
+        topic[i].cstring = (char *)topics[i].topic_filter;
+        qos[i] = (int)topics[i].qos;
+        topics_len += strlen(topics[i].topic_filter) + 3;
     }
-#endif
-    handler->handle.h_fp = messageHandler;
-    handler->handle.pcontext = pcontext;
 
     HAL_MutexLock(c->lock_write_buf);
 
-    if (_alloc_send_buffer(c, strlen(topicFilter)) < 0) {
+    if (_alloc_send_buffer(c, topics_len) < 0) {
         HAL_MutexUnlock(c->lock_write_buf);
-        mqtt_free(handler->topic_filter);
-        mqtt_free(handler);
+        iotx_mc_topic_handles_free(handler, count);
         return FAIL_RETURN;
     }
 
-    len = MQTTSerialize_subscribe((unsigned char *)c->buf_send, c->buf_size_send, 0, (unsigned short)msgId, 1, &topic,
-                                  (int *)&qos);
+    len = MQTTSerialize_subscribe((unsigned char *)c->buf_send, c->buf_size_send, 0, (unsigned short)msgId, count, topic,
+                                  qos);
     if (len <= 0) {
-        mqtt_free(handler->topic_filter);
-        mqtt_free(handler);
+        iotx_mc_topic_handles_free(handler, count);
         _reset_send_buffer(c);
         HAL_MutexUnlock(c->lock_write_buf);
         return MQTT_SUBSCRIBE_PACKET_ERROR;
@@ -629,10 +1006,9 @@ static int MQTTSubscribe(iotx_mc_client_t *c, const char *topicFilter, iotx_mqtt
 #if !(WITH_MQTT_SUB_SHORTCUT)
     /* push the element to list of wait subscribe ACK */
     iotx_mc_subsribe_info_t    *node = NULL;
-    if (SUCCESS_RETURN != iotx_mc_push_subInfo_to(c, len, msgId, SUBSCRIBE, handler, &node)) {
+    if (SUCCESS_RETURN != iotx_mc_push_subInfo_to(c, len, msgId, SUBSCRIBE, handler, count, &node)) {
         mqtt_err("push publish into to pubInfolist failed!");
-        mqtt_free(handler->topic_filter);
-        mqtt_free(handler);
+        iotx_mc_topic_handles_free(handler, count);
         _reset_send_buffer(c);
         HAL_MutexUnlock(c->lock_write_buf);
         return MQTT_PUSH_TO_LIST_ERROR;
@@ -640,8 +1016,10 @@ static int MQTTSubscribe(iotx_mc_client_t *c, const char *topicFilter, iotx_mqtt
 #endif
 
     mqtt_debug("%20s : %08d", "Packet Ident", msgId);
-    mqtt_debug("%20s : %s", "Topic", topicFilter);
-    mqtt_debug("%20s : %d", "QoS", (int)qos);
+    for (i = 0; i < count; i++) {
+        mqtt_debug("%20s : %s", "Topic", topics[i].topic_filter);
+        mqtt_debug("%20s : %d", "QoS", qos[i]);
+    }
     mqtt_debug("%20s : %d", "Packet Length", len);
 #if defined(INSPECT_MQTT_FLOW)
     HEXDUMP_DEBUG(c->buf_send, len);
@@ -656,8 +1034,7 @@ static int MQTTSubscribe(iotx_mc_client_t *c, const char *topicFilter, iotx_mqtt
         HAL_MutexUnlock(c->lock_list_sub);
 #endif
         mqtt_err("run sendPacket error!");
-        mqtt_free(handler->topic_filter);
-        mqtt_free(handler);
+        iotx_mc_topic_handles_free(handler, count);
         _reset_send_buffer(c);
         HAL_MutexUnlock(c->lock_write_buf);
         return MQTT_NETWORK_ERROR;
@@ -667,9 +1044,20 @@ static int MQTTSubscribe(iotx_mc_client_t *c, const char *topicFilter, iotx_mqtt
 
 #if (WITH_MQTT_SUB_SHORTCUT)
     HAL_MutexLock(c->lock_generic);
-    handler->next = c->first_sub_handle;
-    c->first_sub_handle = handler;
+    for (i = 0; i < count; i++) {
+        iotx_mc_topic_handle_t *h = mqtt_obj_malloc(sizeof(iotx_mc_topic_handle_t));
+        if (h == NULL) {
+            mqtt_free(handler[i].topic_filter);
+            continue;
+        }
+        memcpy(h, &handler[i], sizeof(iotx_mc_topic_handle_t));
+        if (SUCCESS_RETURN != iotx_mc_topic_trie_insert(&c->sub_handles, h)) {
+            mqtt_free(h->topic_filter);
+            mqtt_obj_free(h);
+        }
+    }
     HAL_MutexUnlock(c->lock_generic);
+    mqtt_free(handler);
 #endif
     _dump_wait_list(c, "sub");
 
@@ -701,61 +1089,30 @@ static int MQTTUnsubscribe(iotx_mc_client_t *c, const char *topicFilter, unsigne
     if (NULL == handler) {
         return FAIL_RETURN;
     }
-
-#if !(WITH_MQTT_ZIP_TOPIC)
-    handler->topic_filter = mqtt_malloc(strlen(topicFilter) + 1);
-    if (NULL == handler->topic_filter) {
+    if (SUCCESS_RETURN != iotx_mc_topic_handle_init(handler, topicFilter, NULL, NULL)) {
         mqtt_free(handler);
         return FAIL_RETURN;
     }
-    memcpy((char *)handler->topic_filter, topicFilter, strlen(topicFilter) + 1);
-#else
-    if (strstr(topicFilter, "/+") != NULL || strstr(topicFilter, "/#") != NULL) {
-        handler->topic_filter = mqtt_malloc(strlen(topicFilter) + 1);
-        if (NULL == handler->topic_filter) {
-            mqtt_free(handler);
-            return FAIL_RETURN;
-        }
-        handler->topic_type = TOPIC_FILTER_TYPE;
-        memcpy((char *)handler->topic_filter, topicFilter, strlen(topicFilter) + 1);
-    } else {
-        handler->topic_filter = mqtt_malloc(MQTT_MD5_PATH_DEFAULT_LEN);
-        if (NULL == handler->topic_filter) {
-            mqtt_free(handler);
-            return FAIL_RETURN;
-        }
-        handler->topic_type = TOPIC_NAME_TYPE;
-        if (iotx_mc_get_md5_topic(topicFilter, strlen(topicFilter), (char *)handler->topic_filter,
-                                  MQTT_MD5_PATH_DEFAULT_LEN) != 0) {
-            mqtt_free(handler->topic_filter);
-            mqtt_free(handler);
-            return FAIL_RETURN;
-        }
-    }
-#endif
 
     HAL_MutexLock(c->lock_write_buf);
 
     if (_alloc_send_buffer(c, strlen(topicFilter)) < 0) {
         HAL_MutexUnlock(c->lock_write_buf);
-        mqtt_free(handler->topic_filter);
-        mqtt_free(handler);
+        iotx_mc_topic_handles_free(handler, 1);
         return FAIL_RETURN;
     }
 
     if ((len = MQTTSerialize_unsubscribe((unsigned char *)c->buf_send, c->buf_size_send, 0, (unsigned short)msgId, 1,
                                          &topic)) <= 0) {
-        mqtt_free(handler->topic_filter);
-        mqtt_free(handler);
+        iotx_mc_topic_handles_free(handler, 1);
         _reset_send_buffer(c);
         HAL_MutexUnlock(c->lock_write_buf);
         return MQTT_UNSUBSCRIBE_PACKET_ERROR;
     }
 
-    if (SUCCESS_RETURN != iotx_mc_push_subInfo_to(c, len, msgId, UNSUBSCRIBE, handler, &node)) {
+    if (SUCCESS_RETURN != iotx_mc_push_subInfo_to(c, len, msgId, UNSUBSCRIBE, handler, 1, &node)) {
         mqtt_err("push publish into to pubInfolist failed!");
-        mqtt_free(handler->topic_filter);
-        mqtt_free(handler);
+        iotx_mc_topic_handles_free(handler, 1);
         _reset_send_buffer(c);
         HAL_MutexUnlock(c->lock_write_buf);
         return MQTT_PUSH_TO_LIST_ERROR;
@@ -767,42 +1124,15 @@ static int MQTTUnsubscribe(iotx_mc_client_t *c, const char *topicFilter, unsigne
         list_del(&node->linked_list);
         mqtt_free(node);
         HAL_MutexUnlock(c->lock_list_sub);
-        mqtt_free(handler->topic_filter);
-        mqtt_free(handler);
+        iotx_mc_topic_handles_free(handler, 1);
         _reset_send_buffer(c);
         HAL_MutexUnlock(c->lock_write_buf);
         return MQTT_NETWORK_ERROR;
     }
 
-    MQTTString cur_topic;
-    cur_topic.cstring = NULL;
-    cur_topic.lenstring.data = (char *)handler->topic_filter;
-
-#if !(WITH_MQTT_ZIP_TOPIC)
-    cur_topic.lenstring.len = strlen(handler->topic_filter) + 1;
-#else
-    if (handler->topic_type == TOPIC_FILTER_TYPE) {
-        cur_topic.lenstring.len = strlen(handler->topic_filter) + 1;
-    } else {
-        cur_topic.lenstring.len = MQTT_MD5_PATH_DEFAULT_LEN;
-    }
-#endif
-
-
     /* we have to find the right message handler - indexed by topic */
     HAL_MutexLock(c->lock_generic);
-    iotx_mc_topic_handle_t *h, *h2;
-    for (h = c->first_sub_handle; h != NULL; h = h2) {
-        h2 = h->next;
-        if (MQTTPacket_equals(&cur_topic, (char *)h->topic_filter)
-            || iotx_mc_is_topic_matched((char *)h->topic_filter, &cur_topic)) {
-            mqtt_debug("topic be matched");
-            remove_handle_from_list(c, h);
-            mqtt_free(h->topic_filter);
-            mqtt_free(h);
-        }
-
-    }
+    iotx_mc_remove_topic_handles(c, handler);
     HAL_MutexUnlock(c->lock_generic);
     _reset_send_buffer(c);
     HAL_MutexUnlock(c->lock_write_buf);
@@ -902,7 +1232,47 @@ static int MQTTPuback(iotx_mc_client_t *c, unsigned int msgId, enum msgTypes typ
 }
 
 #if !WITH_MQTT_ONLY_QOS0
-/* remove the list element specified by @msgId from list of wait publish ACK */
+#define MQTT_PUB_WINDOW_SLOT(msgId)    ((msgId) % IOTX_MC_REPUB_NUM_MAX)
+
+/* drop a reference to @node, free it with the last one */
+/* Required to run in lock_list_pub protection setup by caller */
+static void _pub_info_unref(iotx_mc_pub_info_t *node)
+{
+    if (--node->refs == 0) {
+        mqtt_obj_free(node);
+    }
+}
+
+#if WITH_MQTT_SEND_QUEUE
+/* drop reference of send queue to @node */
+static void _pub_info_put(iotx_mc_client_t *c, iotx_mc_pub_info_t *node)
+{
+    HAL_MutexLock(c->lock_list_pub);
+    _pub_info_unref(node);
+    HAL_MutexUnlock(c->lock_list_pub);
+}
+#endif
+
+/* remove @node from window and list of wait publish ACK, and drop reference of window */
+/* Required to run in lock_list_pub protection setup by caller */
+static void _pub_window_del(iotx_mc_client_t *c, iotx_mc_pub_info_t *node)
+{
+    c->pub_window[MQTT_PUB_WINDOW_SLOT(node->msg_id)] = NULL;
+    list_del(&node->linked_list);
+    _pub_info_unref(node);
+}
+
+/* remove @node pushed with @msgId, unless PUBACK or destroy took it already and the memory went to another */
+static void iotx_mc_remove_pubInfo(iotx_mc_client_t *c, iotx_mc_pub_info_t *node, uint16_t msgId)
+{
+    HAL_MutexLock(c->lock_list_pub);
+    if (c->pub_window[MQTT_PUB_WINDOW_SLOT(msgId)] == node && node->msg_id == msgId) {
+        _pub_window_del(c, node);
+    }
+    HAL_MutexUnlock(c->lock_list_pub);
+}
+
+/* remove the element specified by @msgId from window of wait publish ACK */
 /* return: 0, success; NOT 0, fail; */
 static int iotx_mc_mask_pubInfo_from(iotx_mc_client_t *c, uint16_t msgId)
 {
@@ -913,66 +1283,79 @@ static int iotx_mc_mask_pubInfo_from(iotx_mc_client_t *c, uint16_t msgId)
     }
 
     HAL_MutexLock(c->lock_list_pub);
-    list_for_each_entry(node, &c->list_pub_wait_ack, linked_list, iotx_mc_pub_info_t) {
-        if (node->msg_id == msgId) {
-            node->node_state = IOTX_MC_NODE_STATE_INVALID; /* mark as invalid node */
-        }
+    node = c->pub_window[MQTT_PUB_WINDOW_SLOT(msgId)];
+    if (node == NULL || node->msg_id != msgId) {
+        HAL_MutexUnlock(c->lock_list_pub);
+        return FAIL_RETURN;
     }
+    _pub_window_del(c, node);
     HAL_MutexUnlock(c->lock_list_pub);
 
     return SUCCESS_RETURN;
 }
 
-/* push the wait element into list of wait publish ACK */
+/* allocate element with @len bytes buffer, and push it into window of wait publish ACK */
+/* packet id of element is allocated as well, which is sure to map to a free slot of window */
 /* return: 0, success; NOT 0, fail; */
-static int iotx_mc_push_pubInfo_to(iotx_mc_client_t *c, int len, unsigned short msgId, iotx_mc_pub_info_t **node)
+static int iotx_mc_push_pubInfo_to(iotx_mc_client_t *c, int len, iotx_mc_pub_info_t **node)
 {
-    int list_number;
+    int i = 0;
+    unsigned int msgId = 0;
+    iotx_mc_pub_info_t *repubInfo = NULL;
 
     if (!c || !node) {
         mqtt_err("the param of c is error!");
         return FAIL_RETURN;
     }
 
-    list_number = list_entry_number(&c->list_pub_wait_ack);
-
+#if WITH_MQTT_DYN_BUF
+    if ((len < 0) || (len > c->buf_size_send_max)) {
+#else
     if ((len < 0) || (len > c->buf_size_send)) {
+#endif
         mqtt_err("the param of len is error!");
         return FAIL_RETURN;
     }
 
-    if (list_number >= IOTX_MC_REPUB_NUM_MAX) {
-        mqtt_err("more than %u elements in republish list. List overflow!", list_number);
-        return FAIL_RETURN;
-    }
-
-    iotx_mc_pub_info_t *repubInfo = (iotx_mc_pub_info_t *)mqtt_malloc(sizeof(iotx_mc_pub_info_t) + len);
+    repubInfo = (iotx_mc_pub_info_t *)mqtt_obj_malloc(sizeof(iotx_mc_pub_info_t) + len);
     if (NULL == repubInfo) {
         mqtt_err("run iotx_memory_malloc is error!");
         return FAIL_RETURN;
     }
 
-    repubInfo->node_state = IOTX_MC_NODE_STATE_NORMANL;
-    repubInfo->msg_id = msgId;
     repubInfo->len = len;
-    iotx_time_start(&repubInfo->pub_start_time);
     repubInfo->buf = (unsigned char *)repubInfo + sizeof(iotx_mc_pub_info_t);
-
-    memcpy(repubInfo->buf, c->buf_send, len);
+    repubInfo->refs = 1;
     INIT_LIST_HEAD(&repubInfo->linked_list);
 
-    list_add_tail(&repubInfo->linked_list, &c->list_pub_wait_ack);
+    /* packet id is taken outside lock_list_pub, since lock_generic may be held when publish */
+    for (i = 0; i < IOTX_MC_REPUB_NUM_MAX; i++) {
+        msgId = iotx_mc_get_next_packetid(c);
 
-    *node = repubInfo;
+        HAL_MutexLock(c->lock_list_pub);
+        if (c->pub_window[MQTT_PUB_WINDOW_SLOT(msgId)] == NULL) {
+            repubInfo->msg_id = msgId;
+            iotx_time_start(&repubInfo->pub_start_time);
+            c->pub_window[MQTT_PUB_WINDOW_SLOT(msgId)] = repubInfo;
+            list_add_tail(&repubInfo->linked_list, &c->list_pub_wait_ack);
+            HAL_MutexUnlock(c->lock_list_pub);
 
-    return SUCCESS_RETURN;
+            *node = repubInfo;
+            return SUCCESS_RETURN;
+        }
+        HAL_MutexUnlock(c->lock_list_pub);
+    }
+
+    mqtt_err("more than %u elements in republish window. Window overflow!", IOTX_MC_REPUB_NUM_MAX);
+    mqtt_obj_free(repubInfo);
+    return FAIL_RETURN;
 }
 #endif //WITH_MQTT_ONLY_QOS0
 
 /* push the wait element into list of wait subscribe(unsubscribe) ACK */
 /* return: 0, success; NOT 0, fail; */
 static int iotx_mc_push_subInfo_to(iotx_mc_client_t *c, int len, unsigned short msgId, enum msgTypes type,
-                                   iotx_mc_topic_handle_t *handler,
+                                   iotx_mc_topic_handle_t *handler, int handler_num,
                                    iotx_mc_subsribe_info_t **node)
 {
     int list_number = 0;
@@ -1009,6 +1392,7 @@ static int iotx_mc_push_subInfo_to(iotx_mc_client_t *c, int len, unsigned short
     iotx_time_start(&subInfo->sub_start_time);
     subInfo->type = type;
     subInfo->handler = handler;
+    subInfo->handler_num = handler_num;
     INIT_LIST_HEAD(&subInfo->linked_list);
 
 #if 0
@@ -1076,7 +1460,8 @@ static int _dump_wait_list(iotx_mc_client_t *c, const char *type)
 /* remove the list element specified by @msgId from list of wait subscribe(unsubscribe) ACK */
 /* and return message handle by @messageHandler */
 /* return: 0, success; NOT 0, fail; */
-static int iotx_mc_mask_subInfo_from(iotx_mc_client_t *c, unsigned int msgId, iotx_mc_topic_handle_t **messageHandler)
+static int iotx_mc_mask_subInfo_from(iotx_mc_client_t *c, unsigned int msgId, iotx_mc_topic_handle_t **messageHandler,
+                                     int *handler_num)
 {
     iotx_mc_subsribe_info_t *node = NULL;
 
@@ -1087,6 +1472,9 @@ static int iotx_mc_mask_subInfo_from(iotx_mc_client_t *c, unsigned int msgId, io
     list_for_each_entry(node, &c->list_sub_wait_ack, linked_list, iotx_mc_subsribe_info_t) {
         if (node->msg_id == msgId) {
             *messageHandler = node->handler;
+            if (handler_num != NULL) {
+                *handler_num = node->handler_num;
+            }
             node->handler = NULL;
             node->node_state = IOTX_MC_NODE_STATE_INVALID; /* mark as invalid node */
             break;
@@ -1131,7 +1519,7 @@ static int iotx_mc_send_packet(iotx_mc_client_t *c, char *buf, int length, iotx_
     while (sent < length && !utils_time_is_expired(time)) {
         left_t = iotx_time_left(time);
         left_t = (left_t == 0) ? 1 : left_t;
-        rc = c->ipstack->write(c->ipstack, &buf[sent], length, left_t);
+        rc = c->ipstack->write(c->ipstack, &buf[sent], length - sent, left_t);
         if (rc < 0) { /* there was an error writing the data */
             break;
         }
@@ -1147,153 +1535,222 @@ static int iotx_mc_send_packet(iotx_mc_client_t *c, char *buf, int length, iotx_
 }
 
 
-/* decode packet */
-static int iotx_mc_decode_packet(iotx_mc_client_t *c, int *value, int timeout)
+/* decode fixed header at @buf */
+/* return: 1, header complete; 0, more bytes required; < 0, malformed header */
+static int iotx_mc_decode_header(unsigned char *buf, uint32_t len, uint32_t *header_len, uint32_t *rem_len)
 {
-    char i;
-    int multiplier = 1;
-    int len = 0;
-    const int MAX_NO_OF_REMAINING_LENGTH_BYTES = 4;
-
-    if (!c || !value) {
-        return FAIL_RETURN;
-    }
+    const uint32_t MAX_NO_OF_REMAINING_LENGTH_BYTES = 4;
+    uint32_t pos = 1;
+    uint32_t multiplier = 1;
 
-    *value = 0;
+    *rem_len = 0;
     do {
-        int rc = MQTTPACKET_READ_ERROR;
-
-        if (++len > MAX_NO_OF_REMAINING_LENGTH_BYTES) {
+        if (pos > MAX_NO_OF_REMAINING_LENGTH_BYTES) {
             return MQTTPACKET_READ_ERROR; /* bad data */
         }
+        if (pos >= len) {
+            return 0;
+        }
+        *rem_len += (buf[pos] & 127) * multiplier;
+        multiplier *= 128;
+    } while ((buf[pos++] & 128) != 0);
 
-        rc = c->ipstack->read(c->ipstack, &i, 1, timeout == 0 ? 1 : timeout);
-        if (rc != 1) {
-            return MQTT_NETWORK_ERROR;
+    *header_len = pos;
+    return 1;
+}
+
+/* drop the packet which has been handled, release read buffer if nothing left in it */
+/* Required to run in lock_read_buf protection setup by caller */
+static void iotx_mc_read_buf_consume(iotx_mc_client_t *c)
+{
+    if (c->buf_frame_len > 0) {
+        if (c->buf_frame_tail_saved) {
+            c->buf_read[c->buf_read_offset + c->buf_frame_len] = c->buf_frame_tail;
+            c->buf_frame_tail_saved = 0;
         }
+        c->buf_read_offset += c->buf_frame_len;
+        c->buf_read_len -= c->buf_frame_len;
+        c->buf_frame_len = 0;
+    }
 
-        *value += (i & 127) * multiplier;
-        multiplier *= 128;
-    } while ((i & 128) != 0);
+    if (c->buf_read_len == 0) {
+        c->buf_read_offset = 0;
+        if (c->buf_read != NULL) {
+            _reset_recv_buffer(c);
+        }
+    }
+}
 
-    return len;
+/* drop everything in read buffer, used when connection is broken or re-established */
+/* Required to run in lock_read_buf protection setup by caller */
+static void iotx_mc_read_buf_clear(iotx_mc_client_t *c)
+{
+    c->buf_read_offset = 0;
+    c->buf_read_len = 0;
+    c->buf_read_discard = 0;
+    c->buf_frame_len = 0;
+    c->buf_frame_tail_saved = 0;
+    if (c->buf_read != NULL) {
+        _reset_recv_buffer(c);
+    }
 }
 
+/* move unhandled data to the beginning of read buffer */
+static void iotx_mc_read_buf_compact(iotx_mc_client_t *c)
+{
+    if (c->buf_read_offset == 0) {
+        return;
+    }
+    if (c->buf_read_len > 0) {
+        memmove(c->buf_read, c->buf_read + c->buf_read_offset, c->buf_read_len);
+    }
+    c->buf_read_offset = 0;
+}
 
 /* read packet */
+/*
+ * Data is read into c->buf_read as much as available and kept across calls, so one
+ * network read may carry several packets, and a packet may be completed by several reads.
+ * When a whole packet is ready, it lies at c->buf_read + c->buf_read_offset with length
+ * c->buf_frame_len, until iotx_mc_read_buf_consume() drops it.
+ */
 static int iotx_mc_read_packet(iotx_mc_client_t *c, iotx_time_t *timer, unsigned int *packet_type)
 {
     MQTTHeader header = {0};
-    int len = 0;
-    int rem_len = 0;
+    uint32_t header_len = 0;
+    uint32_t rem_len = 0;
+    uint32_t frame_len = 0;
+    uint32_t need = 0;
+    uint32_t space = 0;
+    int overflow = 0;
     int rc = 0;
     unsigned int left_t = 0;
 
     if (!c || !timer || !packet_type) {
         return FAIL_RETURN;
     }
+    *packet_type = 0;
+
     HAL_MutexLock(c->lock_read_buf);
-    rc = _alloc_recv_buffer(c, 0);
-    if (rc < 0) {
-        HAL_MutexUnlock(c->lock_read_buf);
-        return FAIL_RETURN;
-    }
-    /* 1. read the header byte.  This has the packet type in it */
-    left_t = iotx_time_left(timer);
-    left_t = (left_t == 0) ? 1 : left_t;
-    rc = c->ipstack->read(c->ipstack, c->buf_read, 1, left_t);
-    if (0 == rc) { /* timeout */
-        *packet_type = 0;
-        HAL_MutexUnlock(c->lock_read_buf);
-        return SUCCESS_RETURN;
-    } else if (1 != rc) {
-        mqtt_debug("mqtt read error, rc=%d", rc);
-        HAL_MutexUnlock(c->lock_read_buf);
-        return FAIL_RETURN;
+    iotx_mc_read_buf_consume(c);
+    if (c->buf_read == NULL) {
+        rc = _alloc_recv_buffer(c, 0);
+        if (rc < 0) {
+            HAL_MutexUnlock(c->lock_read_buf);
+            return FAIL_RETURN;
+        }
     }
 
-    len = 1;
-
+    for (;;) {
+        frame_len = 0;
+
+        /* 1. drop the rest of packet which exceeds read buffer */
+        if (c->buf_read_discard > 0) {
+            need = LITE_MINIMUM(c->buf_read_discard, c->buf_read_len);
+            c->buf_read_discard -= need;
+            c->buf_read_offset += need;
+            c->buf_read_len -= need;
+            if (c->buf_read_len == 0) {
+                c->buf_read_offset = 0;
+            }
+        }
 
-    /* 2. read the remaining length.  This is variable in itself */
-    left_t = iotx_time_left(timer);
-    left_t = (left_t == 0) ? 1 : left_t;
-    if ((rc = iotx_mc_decode_packet(c, &rem_len, left_t)) < 0) {
-        mqtt_err("decodePacket error,rc = %d", rc);
-        HAL_MutexUnlock(c->lock_read_buf);
-        return rc;
-    }
+        if (c->buf_read_discard > 0) {
+            need = LITE_MINIMUM(c->buf_read_discard, c->buf_size_read);
+        } else {
+            /* 2. decode the header byte and the remaining length */
+            rc = iotx_mc_decode_header((unsigned char *)c->buf_read + c->buf_read_offset, c->buf_read_len,
+                                       &header_len, &rem_len);
+            if (rc < 0) {
+                mqtt_err("decodePacket error,rc = %d", rc);
+                HAL_MutexUnlock(c->lock_read_buf);
+                return rc;
+            }
 
-    len += MQTTPacket_encode((unsigned char *)c->buf_read + 1,
-                             rem_len); /* put the original remaining length back into the buffer */
+            if (rc == 0) {
+                need = (c->buf_read_len < 2) ? (2 - c->buf_read_len) : 1;
+            } else {
+                frame_len = header_len + rem_len;
+                if (frame_len <= c->buf_read_len) {
+                    break;
+                }
 
-    rc = _alloc_recv_buffer(c, rem_len + len);
-    if (rc < 0) {
-        HAL_MutexUnlock(c->lock_read_buf);
-        return FAIL_RETURN;
-    }
+                if (frame_len > c->buf_size_read) {
+                    iotx_mc_read_buf_compact(c);
+                    rc = _alloc_recv_buffer(c, frame_len);
+                    if (rc < 0) {
+                        HAL_MutexUnlock(c->lock_read_buf);
+                        return FAIL_RETURN;
+                    }
+                }
 
-    /* Check if the received data length exceeds mqtt read buffer length */
-    if ((rem_len > 0) && ((rem_len + len) > c->buf_size_read)) {
-        mqtt_err("mqtt read buffer is too short, mqttReadBufLen : %u, remainDataLen : %d", c->buf_size_read, rem_len);
-        int needReadLen = c->buf_size_read - len;
-        left_t = iotx_time_left(timer);
-        left_t = (left_t == 0) ? 1 : left_t;
-        if (c->ipstack->read(c->ipstack, c->buf_read + len, needReadLen, left_t) != needReadLen) {
-            mqtt_err("mqtt read error");
-            HAL_MutexUnlock(c->lock_read_buf);
-            return FAIL_RETURN;
+                /* Check if the received data length exceeds mqtt read buffer length */
+                if (frame_len > c->buf_size_read) {
+                    mqtt_err("mqtt read buffer is too short, mqttReadBufLen : %u, remainDataLen : %d",
+                             c->buf_size_read, rem_len);
+                    /* drop data whitch over the length of mqtt buffer */
+                    c->buf_read_discard = frame_len;
+                    overflow = 1;
+                    continue;
+                }
+                need = frame_len - c->buf_read_len;
+            }
         }
 
-        /* drop data whitch over the length of mqtt buffer */
-        int remainDataLen = rem_len - needReadLen;
-        char *remainDataBuf = mqtt_malloc(remainDataLen + 1);
-        if (!remainDataBuf) {
-            mqtt_err("allocate remain buffer failed");
-            HAL_MutexUnlock(c->lock_read_buf);
-            return FAIL_RETURN;
+        if (c->buf_read_offset + c->buf_read_len + need > c->buf_size_read) {
+            iotx_mc_read_buf_compact(c);
         }
 
+        /* 3. wait for bytes required to go on, then take whatever else is already available */
         left_t = iotx_time_left(timer);
         left_t = (left_t == 0) ? 1 : left_t;
-        if (c->ipstack->read(c->ipstack, remainDataBuf, remainDataLen, left_t) != remainDataLen) {
-            mqtt_err("mqtt read error");
-            mqtt_free(remainDataBuf);
-            remainDataBuf = NULL;
+        rc = c->ipstack->read(c->ipstack, c->buf_read + c->buf_read_offset + c->buf_read_len, need, left_t);
+        if (rc < 0) {
+            mqtt_debug("mqtt read error, rc=%d", rc);
             HAL_MutexUnlock(c->lock_read_buf);
             return FAIL_RETURN;
         }
+        c->buf_read_len += rc;
+        if (rc < need) {
+            /* timeout, data received so far is kept for next time */
+            break;
+        }
 
-        mqtt_free(remainDataBuf);
-        remainDataBuf = NULL;
-        HAL_MutexUnlock(c->lock_read_buf);
-        if (NULL != c->handle_event.h_fp) {
-            iotx_mqtt_event_msg_t msg;
-
-            msg.event_type = IOTX_MQTT_EVENT_BUFFER_OVERFLOW;
-            msg.msg = "mqtt read buffer is too short";
-            _handle_event(&c->handle_event, c, &msg);
+        space = c->buf_size_read - c->buf_read_offset - c->buf_read_len;
+        if (space > 0) {
+            rc = c->ipstack->read(c->ipstack, c->buf_read + c->buf_read_offset + c->buf_read_len, space,
+                                  IOTX_MC_READ_AVAIL_TIMEOUT_MS);
+            if (rc < 0) {
+                mqtt_debug("mqtt read error, rc=%d", rc);
+                HAL_MutexUnlock(c->lock_read_buf);
+                return FAIL_RETURN;
+            }
+            c->buf_read_len += rc;
         }
+    }
 
-        return SUCCESS_RETURN;
+    if (frame_len > 0 && frame_len <= c->buf_read_len && c->buf_read_discard == 0) {
+        c->buf_frame_len = frame_len;
+        header.byte = c->buf_read[c->buf_read_offset];
+        *packet_type = header.bits.type;
 
+        /* keep payload terminated as it used to be, restored by iotx_mc_read_buf_consume() */
+        if (c->buf_read_offset + frame_len < c->buf_size_read) {
+            c->buf_frame_tail = c->buf_read[c->buf_read_offset + frame_len];
+            c->buf_frame_tail_saved = 1;
+            c->buf_read[c->buf_read_offset + frame_len] = '\0';
+        }
     }
+    HAL_MutexUnlock(c->lock_read_buf);
 
-    /* 3. read the rest of the buffer using a callback to supply the rest of the data */
-    left_t = iotx_time_left(timer);
-    left_t = (left_t == 0) ? 1 : left_t;
-    if (rem_len > 0 && (c->ipstack->read(c->ipstack, c->buf_read + len, rem_len, left_t) != rem_len)) {
-        mqtt_err("mqtt read error");
-        HAL_MutexUnlock(c->lock_read_buf);
-        return FAIL_RETURN;
-    }
+    if (overflow && NULL != c->handle_event.h_fp) {
+        iotx_mqtt_event_msg_t msg;
 
-    header.byte = c->buf_read[0];
-    *packet_type = header.bits.type;
-    if ((len + rem_len) < c->buf_size_read) {
-        c->buf_read[len + rem_len] = '\0';
+        msg.event_type = IOTX_MQTT_EVENT_BUFFER_OVERFLOW;
+        msg.msg = "mqtt read buffer is too short";
+        _handle_event(&c->handle_event, c, &msg);
     }
-    HAL_MutexUnlock(c->lock_read_buf);
+
     return SUCCESS_RETURN;
 }
 
@@ -1301,6 +1758,13 @@ static int iotx_mc_read_packet(iotx_mc_client_t *c, iotx_time_t *timer, unsigned
 static void iotx_mc_deliver_message(iotx_mc_client_t *c, MQTTString *topicName, iotx_mqtt_topic_info_pt topic_msg)
 {
     int flag_matched = 0;
+    int i = 0;
+    int handles_num = 0;
+    char *net_topic = NULL;
+    int net_topic_len = 0;
+    char *md5_topic = NULL;
+    iotx_mqtt_event_handle_t handles_local[MQTT_DELIVER_HANDLE_NUM_LOCAL];
+    iotx_mqtt_event_handle_t *handles = handles_local;
 
     if (!c || !topicName || !topic_msg) {
         return;
@@ -1309,13 +1773,6 @@ static void iotx_mc_deliver_message(iotx_mc_client_t *c, MQTTString *topicName,
     topic_msg->ptopic = topicName->lenstring.data;
     topic_msg->topic_len = topicName->lenstring.len;
 
-#if WITH_MQTT_ZIP_TOPIC
-
-    MQTTString      md5_topic;
-    char            md5_topic_data[MQTT_MD5_PATH_DEFAULT_LEN] = {0};
-    char           *net_topic;
-    uint32_t        net_topic_len;
-
     if (topicName->cstring) {
         net_topic = topicName->cstring;
         net_topic_len = strlen(topicName->cstring);
@@ -1323,42 +1780,45 @@ static void iotx_mc_deliver_message(iotx_mc_client_t *c, MQTTString *topicName,
         net_topic = topicName->lenstring.data;
         net_topic_len = topicName->lenstring.len;
     }
-    md5_topic.cstring = NULL;
-    md5_topic.lenstring.data = md5_topic_data;
-    md5_topic.lenstring.len = MQTT_MD5_PATH_DEFAULT_LEN;
+
+#if WITH_MQTT_ZIP_TOPIC
+    char            md5_topic_data[MQTT_MD5_PATH_DEFAULT_LEN] = {0};
+
     iotx_mc_get_md5_topic(net_topic, net_topic_len, md5_topic_data, MQTT_MD5_PATH_DEFAULT_LEN);
-    /* we have to find the right message handler - indexed by topic */
-    HAL_MutexLock(c->lock_generic);
-    iotx_mc_topic_handle_t *h;
-    for (h = c->first_sub_handle; h != NULL; h = h->next) {
-        if (MQTTPacket_equals(&md5_topic, (char *)h->topic_filter)
-            || iotx_mc_is_topic_matched((char *)h->topic_filter, topicName)) {
-#else
-    /* we have to find the right message handler - indexed by topic */
-    HAL_MutexLock(c->lock_generic);
-    iotx_mc_topic_handle_t *h;
-    for (h = c->first_sub_handle; h != NULL; h = h->next) {
-        if (MQTTPacket_equals(topicName, (char *)h->topic_filter)
-            || iotx_mc_is_topic_matched((char *)h->topic_filter, topicName)) {
+    md5_topic = md5_topic_data;
 #endif
-            mqtt_debug("topic be matched");
 
-            iotx_mc_topic_handle_t *msg_handle = h;
-            HAL_MutexUnlock(c->lock_generic);
-
-            if (NULL != msg_handle->handle.h_fp) {
-                iotx_mqtt_event_msg_t msg;
-                msg.event_type = IOTX_MQTT_EVENT_PUBLISH_RECEIVED;
-                msg.msg = (void *)topic_msg;
-                _handle_event(&msg_handle->handle, c, &msg);
-                flag_matched = 1;
-            }
+    /* we have to find the right message handler - indexed by topic */
+    HAL_MutexLock(c->lock_generic);
+    handles_num = iotx_mc_topic_trie_match(&c->sub_handles, net_topic, net_topic_len, md5_topic,
+                                           handles, MQTT_DELIVER_HANDLE_NUM_LOCAL);
+    if (handles_num > MQTT_DELIVER_HANDLE_NUM_LOCAL) {
+        handles = mqtt_malloc(handles_num * sizeof(iotx_mqtt_event_handle_t));
+        if (handles == NULL) {
+            mqtt_err("malloc handles failed, only deliver to first %d", MQTT_DELIVER_HANDLE_NUM_LOCAL);
+            handles = handles_local;
+            handles_num = MQTT_DELIVER_HANDLE_NUM_LOCAL;
+        } else {
+            iotx_mc_topic_trie_match(&c->sub_handles, net_topic, net_topic_len, md5_topic, handles, handles_num);
+        }
+    }
+    HAL_MutexUnlock(c->lock_generic);
 
-            HAL_MutexLock(c->lock_generic);
+    /* handles are copied out, so callbacks are free to subscribe or unsubscribe */
+    for (i = 0; i < handles_num; i++) {
+        if (NULL != handles[i].h_fp) {
+            iotx_mqtt_event_msg_t msg;
+            mqtt_debug("topic be matched");
+            msg.event_type = IOTX_MQTT_EVENT_PUBLISH_RECEIVED;
+            msg.msg = (void *)topic_msg;
+            _handle_event(&handles[i], c, &msg);
+            flag_matched = 1;
         }
     }
 
-    HAL_MutexUnlock(c->lock_generic);
+    if (handles != handles_local) {
+        mqtt_free(handles);
+    }
 
     if (0 == flag_matched) {
         mqtt_debug("NO matching any topic, call default handle function");
@@ -1384,8 +1844,8 @@ static int iotx_mc_handle_recv_CONNACK(iotx_mc_client_t *c)
         return FAIL_RETURN;
     }
 
-    if (MQTTDeserialize_connack((unsigned char *)&sessionPresent, &connack_rc, (unsigned char *)c->buf_read,
-                                c->buf_size_read) != 1) {
+    if (MQTTDeserialize_connack((unsigned char *)&sessionPresent, &connack_rc, MQTT_READ_FRAME(c),
+                                c->buf_frame_len) != 1) {
         mqtt_err("connect ack is error");
         return MQTT_CONNECT_ACK_PACKET_ERROR;
     }
@@ -1429,7 +1889,7 @@ static int iotx_mc_handle_recv_PUBACK(iotx_mc_client_t *c)
         return FAIL_RETURN;
     }
 
-    if (MQTTDeserialize_ack(&type, &dup, &mypacketid, (unsigned char *)c->buf_read, c->buf_size_read) != 1) {
+    if (MQTTDeserialize_ack(&type, &dup, &mypacketid, MQTT_READ_FRAME(c), c->buf_frame_len) != 1) {
         return MQTT_PUBLISH_ACK_PACKET_ERROR;
     }
 
@@ -1451,7 +1911,8 @@ static int iotx_mc_handle_recv_PUBACK(iotx_mc_client_t *c)
 static int iotx_mc_handle_recv_SUBACK(iotx_mc_client_t *c)
 {
     unsigned short mypacketid;
-    int i = 0, count = 0, fail_flag = -1, j = 0;
+    int i = 0, count = 0, fail_flag = 0, j = 0;
+    uint32_t fail_mask = 0;
     int grantedQoS[MUTLI_SUBSCIRBE_MAX];
     int rc;
 
@@ -1459,8 +1920,8 @@ static int iotx_mc_handle_recv_SUBACK(iotx_mc_client_t *c)
         return FAIL_RETURN;
     }
 
-    rc = MQTTDeserialize_suback(&mypacketid, MUTLI_SUBSCIRBE_MAX, &count, grantedQoS, (unsigned char *)c->buf_read,
-                                c->buf_size_read);
+    rc = MQTTDeserialize_suback(&mypacketid, MUTLI_SUBSCIRBE_MAX, &count, grantedQoS, MQTT_READ_FRAME(c),
+                                c->buf_frame_len);
 
     if (rc < 0) {
         mqtt_err("Sub ack packet error, rc = MQTTDeserialize_suback() = %d", rc);
@@ -1482,62 +1943,57 @@ static int iotx_mc_handle_recv_SUBACK(iotx_mc_client_t *c)
 
 #if !(WITH_MQTT_SUB_SHORTCUT)
     iotx_mc_topic_handle_t *messagehandler = NULL;
+    int handler_num = 0;
     int flag_dup = 0;
 
     HAL_MutexLock(c->lock_list_sub);
-    (void)iotx_mc_mask_subInfo_from(c, mypacketid, &messagehandler);
+    (void)iotx_mc_mask_subInfo_from(c, mypacketid, &messagehandler, &handler_num);
     HAL_MutexUnlock(c->lock_list_sub);
     if ((NULL == messagehandler)) {
         return MQTT_SUB_INFO_NOT_FOUND_ERROR;
     }
 
-
-    if (NULL == messagehandler->topic_filter) {
-        mqtt_free(messagehandler);
+    if (NULL == messagehandler->topic_filter || NULL == messagehandler->handle.h_fp) {
+        iotx_mc_topic_handles_free(messagehandler, handler_num);
         return MQTT_SUB_INFO_NOT_FOUND_ERROR;
     }
 
-    if ((NULL == messagehandler->handle.h_fp)) {
-        mqtt_free(messagehandler->topic_filter);
-        mqtt_free(messagehandler);
-        return MQTT_SUB_INFO_NOT_FOUND_ERROR;
-    }
+    /* one return code per topic filter of SUBSCRIBE, missing ones are taken as failure */
+    for (j = 0; j < handler_num; j++) {
+        int topic_fail = (j >= count || (uint8_t)grantedQoS[j] == 0x80);
+#else
+    for (j = 0; j < count; j++) {
+        int topic_fail = ((uint8_t)grantedQoS[j] == 0x80);
 #endif
-
-    for (j = 0; j <  count; j++) {
-        fail_flag = 0;
         /* In negative case, grantedQoS will be 0xFFFF FF80, which means -128 */
-        if ((uint8_t)grantedQoS[j] == 0x80) {
+        if (topic_fail) {
             fail_flag = 1;
+            fail_mask |= (1u << j);
             mqtt_err("MQTT SUBSCRIBE failed, ack code is 0x80");
         }
 
 #if !(WITH_MQTT_SUB_SHORTCUT)
         flag_dup = 0;
         HAL_MutexLock(c->lock_generic);
-        iotx_mc_topic_handle_t *h;
-        for (h = c->first_sub_handle; h; h = h->next) {
-            /* If subscribe the same topic and callback function, then ignore */
-            if (0 == iotx_mc_check_handle_is_identical(h, messagehandler)) {
-                /* if subscribe a identical topic and relate callback function, then ignore this subscribe */
-                flag_dup = 1;
-                mqtt_warning("There exists duplicate topic and related handle in list");
-
-                if (fail_flag == 1) {
-                    remove_handle_from_list(c, h);
-                    mqtt_free(h->topic_filter);
-                    mqtt_free(h);
-                }
-                break;
+        /* If subscribe the same topic and callback function, then ignore */
+        iotx_mc_topic_handle_t *h = iotx_mc_topic_trie_lookup(&c->sub_handles, &messagehandler[j], 1);
+        if (h != NULL) {
+            /* if subscribe a identical topic and relate callback function, then ignore this subscribe */
+            flag_dup = 1;
+            mqtt_warning("There exists duplicate topic and related handle in list");
+
+            if (topic_fail) {
+                iotx_mc_topic_trie_remove(&c->sub_handles, h);
+                mqtt_free(h->topic_filter);
+                mqtt_obj_free(h);
             }
         }
         HAL_MutexUnlock(c->lock_generic);
 
-        if (fail_flag == 0 && flag_dup == 0) {
-            iotx_mc_topic_handle_t *handle = mqtt_malloc(sizeof(iotx_mc_topic_handle_t));
+        if (!topic_fail && flag_dup == 0) {
+            iotx_mc_topic_handle_t *handle = mqtt_obj_malloc(sizeof(iotx_mc_topic_handle_t));
             if (!handle) {
-                mqtt_free(messagehandler[j].topic_filter);
-                mqtt_free(messagehandler);
+                iotx_mc_topic_handles_free(messagehandler, handler_num);
                 return FAIL_RETURN;
             }
 
@@ -1547,16 +2003,21 @@ static int iotx_mc_handle_recv_SUBACK(iotx_mc_client_t *c)
             handle->handle.h_fp = messagehandler[j].handle.h_fp;
             handle->handle.pcontext = messagehandler[j].handle.pcontext;
             handle->topic_type =  messagehandler[j].topic_type;
+            handle->topic_hash = messagehandler[j].topic_hash;
+            messagehandler[j].topic_filter = NULL;
 
             HAL_MutexLock(c->lock_generic);
-            handle->next = c->first_sub_handle;
-            c->first_sub_handle = handle;
+            if (SUCCESS_RETURN != iotx_mc_topic_trie_insert(&c->sub_handles, handle)) {
+                HAL_MutexUnlock(c->lock_generic);
+                mqtt_free(handle->topic_filter);
+                mqtt_obj_free(handle);
+                iotx_mc_topic_handles_free(messagehandler, handler_num);
+                return FAIL_RETURN;
+            }
             HAL_MutexUnlock(c->lock_generic);
-        } else {
-            mqtt_free(messagehandler[j].topic_filter);
         }
     }
-    mqtt_free(messagehandler);
+    iotx_mc_topic_handles_free(messagehandler, handler_num);
 #else
     }
 #endif
@@ -1571,7 +2032,7 @@ static int iotx_mc_handle_recv_SUBACK(iotx_mc_client_t *c)
         msg.event_type = IOTX_MQTT_EVENT_SUBCRIBE_SUCCESS;
     }
 
-    _iotx_mqtt_event_handle_sub(c->handle_event.pcontext, c, &msg);
+    _iotx_mqtt_event_handle_sub(c->handle_event.pcontext, c, &msg, fail_mask);
 
     if (NULL != c->handle_event.h_fp)
     {
@@ -1604,8 +2065,8 @@ static int iotx_mc_handle_recv_PUBLISH(iotx_mc_client_t *c)
                                      &topicName,
                                      (unsigned char **)&topic_msg.payload,
                                      (int *)&payload_len,
-                                     (unsigned char *)c->buf_read,
-                                     c->buf_size_read)) {
+                                     MQTT_READ_FRAME(c),
+                                     c->buf_frame_len)) {
         return MQTT_PUBLISH_PACKET_ERROR;
     }
     topic_msg.qos = (unsigned char)qos;
@@ -1628,7 +2089,7 @@ static int iotx_mc_handle_recv_PUBLISH(iotx_mc_client_t *c)
                topicName.lenstring.data);
     mqtt_debug("%20s : %d / %d", "Payload Len/Room",
                topic_msg.payload_len,
-               c->buf_read + c->buf_size_read - topic_msg.payload);
+               (char *)MQTT_READ_FRAME(c) + c->buf_frame_len - topic_msg.payload);
     mqtt_debug("%20s : %d", "Receive Buflen", c->buf_size_read);
 
 #if defined(INSPECT_MQTT_FLOW)
@@ -1688,7 +2149,7 @@ static int iotx_mc_handle_recv_UNSUBACK(iotx_mc_client_t *c)
         return FAIL_RETURN;
     }
 
-    if (MQTTDeserialize_unsuback(&mypacketid, (unsigned char *)c->buf_read, c->buf_size_read) != 1) {
+    if (MQTTDeserialize_unsuback(&mypacketid, MQTT_READ_FRAME(c), c->buf_frame_len) != 1) {
         return MQTT_UNSUBSCRIBE_ACK_PACKET_ERROR;
     }
 
@@ -1697,7 +2158,7 @@ static int iotx_mc_handle_recv_UNSUBACK(iotx_mc_client_t *c)
     mqtt_debug("receivce UNSUBACK, packetid: %d", mypacketid);
 #endif
     HAL_MutexLock(c->lock_list_sub);
-    (void)iotx_mc_mask_subInfo_from(c, mypacketid, &messageHandler);
+    (void)iotx_mc_mask_subInfo_from(c, mypacketid, &messageHandler, NULL);
     HAL_MutexUnlock(c->lock_list_sub);
 
     if (NULL == messageHandler) {
@@ -1713,21 +2174,9 @@ static int iotx_mc_handle_recv_UNSUBACK(iotx_mc_client_t *c)
 
     /* Remove from message handler array */
     HAL_MutexLock(c->lock_generic);
-    iotx_mc_topic_handle_t *h, *h_next;
-    for (h = c->first_sub_handle; h != NULL; h = h_next) {
-        h_next = h->next;
-
-        if (0 == iotx_mc_check_handle_is_identical_ex(h, messageHandler)) {
-            remove_handle_from_list(c, h);
-            if (h->topic_filter != NULL) {
-                mqtt_free(h->topic_filter);
-                h->topic_filter = NULL;
-            }
-            mqtt_free(h);
-            /* NOTE: in case of more than one register(subscribe) with different callback function,
-             *       so we must keep continuously searching related message handle */
-        }
-    }
+    /* NOTE: in case of more than one register(subscribe) with different callback function,
+     *       all handles related to this topic filter are removed */
+    iotx_mc_remove_topic_handles(c, messageHandler);
 
     if (NULL != c->handle_event.h_fp) {
         iotx_mqtt_event_msg_t msg;
@@ -1766,7 +2215,7 @@ static int iotx_mc_wait_CONNACK(iotx_mc_client_t *c)
         if (rc != SUCCESS_RETURN) {
             mqtt_err("readPacket error,result = %d", rc);
             HAL_MutexLock(c->lock_read_buf);
-            _reset_recv_buffer(c);
+            iotx_mc_read_buf_clear(c);
             HAL_MutexUnlock(c->lock_read_buf);
             return MQTT_NETWORK_ERROR;
         }
@@ -1774,14 +2223,14 @@ static int iotx_mc_wait_CONNACK(iotx_mc_client_t *c)
         if (++wait_connack > WAIT_CONNACK_MAX) {
             mqtt_err("wait connack timeout");
             HAL_MutexLock(c->lock_read_buf);
-            _reset_recv_buffer(c);
+            iotx_mc_read_buf_clear(c);
             HAL_MutexUnlock(c->lock_read_buf);
             return MQTT_NETWORK_ERROR;
         }
     } while (packetType != CONNACK);
     HAL_MutexLock(c->lock_read_buf);
     rc = iotx_mc_handle_recv_CONNACK(c);
-    _reset_recv_buffer(c);
+    iotx_mc_read_buf_consume(c);
     HAL_MutexUnlock(c->lock_read_buf);
     if (SUCCESS_RETURN != rc) {
         mqtt_err("recvConnackProc error,result = %d", rc);
@@ -1817,7 +2266,7 @@ static int iotx_mc_cycle(iotx_mc_client_t *c, iotx_time_t *timer)
     rc = iotx_mc_read_packet(c, timer, &packetType);
     if (rc != SUCCESS_RETURN) {
         HAL_MutexLock(c->lock_read_buf);
-        _reset_recv_buffer(c);
+        iotx_mc_read_buf_clear(c);
         HAL_MutexUnlock(c->lock_read_buf);
         iotx_mc_set_client_state(c, IOTX_MC_STATE_DISCONNECTED);
         mqtt_debug("readPacket error,result = %d", rc);
@@ -1827,7 +2276,7 @@ static int iotx_mc_cycle(iotx_mc_client_t *c, iotx_time_t *timer)
     if (MQTT_CPT_RESERVED == packetType) {
         /* mqtt_debug("wait data timeout"); */
         HAL_MutexLock(c->lock_read_buf);
-        _reset_recv_buffer(c);
+        iotx_mc_read_buf_consume(c);
         HAL_MutexUnlock(c->lock_read_buf);
         return SUCCESS_RETURN;
     }
@@ -1887,11 +2336,11 @@ static int iotx_mc_cycle(iotx_mc_client_t *c, iotx_time_t *timer)
         }
         default:
             mqtt_err("INVALID TYPE");
-            _reset_recv_buffer(c);
+            iotx_mc_read_buf_consume(c);
             HAL_MutexUnlock(c->lock_read_buf);
             return FAIL_RETURN;
     }
-    _reset_recv_buffer(c);
+    iotx_mc_read_buf_consume(c);
     HAL_MutexUnlock(c->lock_read_buf);
     return rc;
 }
@@ -1912,130 +2361,48 @@ static int iotx_mc_check_state_normal(iotx_mc_client_t *c)
     return 0;
 }
 
-#if !(WITH_MQTT_SUB_SHORTCUT)
-/* return: 0, identical; NOT 0, different */
-static int iotx_mc_check_handle_is_identical(iotx_mc_topic_handle_t *messageHandlers1,
-        iotx_mc_topic_handle_t *messageHandler2)
+/* subscribe */
+int iotx_mc_subscribe(iotx_mc_client_t *c,
+                      const char *topicFilter,
+                      iotx_mqtt_qos_t qos,
+                      iotx_mqtt_event_handle_func_fpt topic_handle_func,
+                      void *pcontext)
 {
-    if (!messageHandlers1 || !messageHandler2) {
-        return 1;
-    }
-
-    if (!(messageHandlers1->topic_filter) || !(messageHandler2->topic_filter)) {
-        return 1;
-    }
-
-#if !(WITH_MQTT_ZIP_TOPIC)
-    int topicNameLen = strlen(messageHandlers1->topic_filter);
-
-    if (topicNameLen != strlen(messageHandler2->topic_filter)) {
-        return 1;
-    }
-
-    if (0 != strncmp(messageHandlers1->topic_filter, messageHandler2->topic_filter, topicNameLen)) {
-        return 1;
-    }
-#else
-    int i;
+    iotx_mqtt_multi_sub_t topic;
 
-    if (messageHandlers1->topic_type != messageHandler2->topic_type) {
-        return 1;
-    }
-
-    if (messageHandlers1->topic_type == TOPIC_NAME_TYPE) {
-        for (i = 0; i < MQTT_MD5_PATH_DEFAULT_LEN; i++) {
-            if (messageHandler2->topic_filter[i] != messageHandlers1->topic_filter[i]) {
-                return 1;
-            }
-        }
-    } else {
-        int topicNameLen = strlen(messageHandlers1->topic_filter);
-
-        if (topicNameLen != strlen(messageHandler2->topic_filter)) {
-            return 1;
-        }
-
-        if (0 != strncmp(messageHandlers1->topic_filter, messageHandler2->topic_filter, topicNameLen)) {
-            return 1;
-        }
-    }
-#endif
-    if (messageHandlers1->handle.h_fp != messageHandler2->handle.h_fp) {
-        return 1;
+    if (NULL == c || NULL == topicFilter || !topic_handle_func) {
+        return NULL_VALUE_ERROR;
     }
 
-    /* context must be identical also */
-    if (messageHandlers1->handle.pcontext != messageHandler2->handle.pcontext) {
-        return 1;
-    }
+    topic.topic_filter = topicFilter;
+    topic.qos = qos;
+    topic.topic_handle_func = topic_handle_func;
+    topic.pcontext = pcontext;
 
-    return 0;
+    return iotx_mc_subscribe_multi(c, &topic, 1);
 }
-#endif
 
-/* return: 0, identical; NOT 0, different */
-static int iotx_mc_check_handle_is_identical_ex(iotx_mc_topic_handle_t *messageHandlers1,
-        iotx_mc_topic_handle_t *messageHandler2)
+/* subscribe @count topic filters in one SUBSCRIBE packet */
+int iotx_mc_subscribe_multi(iotx_mc_client_t *c, iotx_mqtt_multi_sub_t *topics, int count)
 {
-    if (!messageHandlers1 || !messageHandler2) {
-        return 1;
-    }
-
-    if (!(messageHandlers1 ->topic_filter) || !(messageHandler2->topic_filter)) {
-        return 1;
-    }
-
-#if !(WITH_MQTT_ZIP_TOPIC)
-    int topicNameLen = strlen(messageHandlers1->topic_filter);
-
-    if (topicNameLen != strlen(messageHandler2->topic_filter)) {
-        return 1;
-    }
+    int rc = FAIL_RETURN;
+    int i = 0;
+    unsigned int msgId;
 
-    if (0 != strncmp(messageHandlers1->topic_filter, messageHandler2->topic_filter, topicNameLen)) {
-        return 1;
+    if (NULL == c || NULL == topics) {
+        return NULL_VALUE_ERROR;
     }
-#else
-    int i;
 
-    if (messageHandlers1->topic_type != messageHandler2->topic_type) {
-        return 1;
+    if (count <= 0 || count > MUTLI_SUBSCIRBE_MAX) {
+        mqtt_err("topic count out of range, count = %d", count);
+        return FAIL_RETURN;
     }
 
-    if (messageHandlers1->topic_type == TOPIC_NAME_TYPE) {
-        for (i = 0; i < MQTT_MD5_PATH_DEFAULT_LEN; i++) {
-            if (messageHandler2->topic_filter[i] != messageHandlers1->topic_filter[1]) {
-                return 1;
-            }
-        }
-    } else {
-        int topicNameLen = strlen(messageHandlers1->topic_filter);
-
-        if (topicNameLen != strlen(messageHandler2->topic_filter)) {
-            return 1;
-        }
-
-        if (0 != strncmp(messageHandlers1->topic_filter, messageHandler2->topic_filter, topicNameLen)) {
-            return 1;
+    for (i = 0; i < count; i++) {
+        if (NULL == topics[i].topic_filter || !topics[i].topic_handle_func) {
+            return NULL_VALUE_ERROR;
         }
     }
-#endif
-
-    return 0;
-}
-
-/* subscribe */
-int iotx_mc_subscribe(iotx_mc_client_t *c,
-                      const char *topicFilter,
-                      iotx_mqtt_qos_t qos,
-                      iotx_mqtt_event_handle_func_fpt topic_handle_func,
-                      void *pcontext)
-{
-    int rc = FAIL_RETURN;
-    unsigned int msgId;
-    if (NULL == c || NULL == topicFilter || !topic_handle_func) {
-        return NULL_VALUE_ERROR;
-    }
     msgId = iotx_mc_get_next_packetid(c);
 
     if (!iotx_mc_check_state_normal(c)) {
@@ -2043,13 +2410,15 @@ int iotx_mc_subscribe(iotx_mc_client_t *c,
         return MQTT_STATE_ERROR;
     }
 
-    if (0 != iotx_mc_check_topic(topicFilter, TOPIC_FILTER_TYPE)) {
-        mqtt_err("topic format is error,topicFilter = %s", topicFilter);
-        return MQTT_TOPIC_FORMAT_ERROR;
+    for (i = 0; i < count; i++) {
+        if (0 != iotx_mc_check_topic(topics[i].topic_filter, TOPIC_FILTER_TYPE)) {
+            mqtt_err("topic format is error,topicFilter = %s", topics[i].topic_filter);
+            return MQTT_TOPIC_FORMAT_ERROR;
+        }
+        mqtt_debug("PERFORM subscribe to '%s' (msgId=%d)", topics[i].topic_filter, msgId);
     }
 
-    mqtt_debug("PERFORM subscribe to '%s' (msgId=%d)", topicFilter, msgId);
-    rc = MQTTSubscribe(c, topicFilter, qos, msgId, topic_handle_func, pcontext);
+    rc = MQTTSubscribe(c, topics, count, msgId);
     if (rc != SUCCESS_RETURN) {
         if (rc == MQTT_NETWORK_ERROR) {
             iotx_mc_set_client_state(c, IOTX_MC_STATE_DISCONNECTED);
@@ -2059,7 +2428,9 @@ int iotx_mc_subscribe(iotx_mc_client_t *c,
         return rc;
     }
 
-    mqtt_info("mqtt subscribe packet sent,topic = %s!", topicFilter);
+    for (i = 0; i < count; i++) {
+        mqtt_info("mqtt subscribe packet sent,topic = %s!", topics[i].topic_filter);
+    }
     return msgId;
 }
 
@@ -2120,10 +2491,6 @@ int iotx_mc_publish(iotx_mc_client_t *c, const char *topicName, iotx_mqtt_topic_
     }
 
 #if !WITH_MQTT_ONLY_QOS0
-    if (topic_msg->qos == IOTX_MQTT_QOS1 || topic_msg->qos == IOTX_MQTT_QOS2) {
-        msg_id = iotx_mc_get_next_packetid(c);
-        topic_msg->packet_id = msg_id;
-    }
     if (topic_msg->qos == IOTX_MQTT_QOS2) {
         mqtt_err("MQTTPublish return error,MQTT_QOS2 is now not supported.");
         return MQTT_PUBLISH_QOS_ERROR;
@@ -2145,6 +2512,11 @@ int iotx_mc_publish(iotx_mc_client_t *c, const char *topicName, iotx_mqtt_topic_
         return rc;
     }
 
+    /* packet id is allocated by MQTTPublish() for QoS1 */
+    if (topic_msg->qos > IOTX_MQTT_QOS0) {
+        msg_id = topic_msg->packet_id;
+    }
+
     return (int)msg_id;
 }
 
@@ -2262,6 +2634,7 @@ int iotx_mc_init(iotx_mc_client_t *pClient, iotx_mqtt_param_t *pInitParams)
     ARGUMENT_SANITY_CHECK(pInitParams->read_buf_size, NULL_VALUE_ERROR);
 
     memset(pClient, 0x0, sizeof(iotx_mc_client_t));
+    iotx_mc_topic_trie_init(&pClient->sub_handles);
 
     pClient->lock_generic = HAL_MutexCreate();
     if (!pClient->lock_generic) {
@@ -2534,6 +2907,7 @@ static int MQTTSubInfoProc(iotx_mc_client_t *pClient)
     uint16_t packet_id = 0;
     enum msgTypes msg_type;
     iotx_mc_topic_handle_t *messageHandler = NULL;
+    int handler_num = 0;
     iotx_mqtt_event_msg_t msg;
     iotx_mc_subsribe_info_t *node = NULL, *next_node = NULL;
 
@@ -2544,6 +2918,7 @@ static int MQTTSubInfoProc(iotx_mc_client_t *pClient)
     HAL_MutexLock(pClient->lock_list_sub);
     list_for_each_entry_safe(node, next_node, &pClient->list_sub_wait_ack, linked_list, iotx_mc_subsribe_info_t) {
         messageHandler = NULL;
+        handler_num = 0;
         memset(&msg, 0, sizeof(iotx_mqtt_event_msg_t));
 
         /* remove invalid node */
@@ -2571,14 +2946,14 @@ static int MQTTSubInfoProc(iotx_mc_client_t *pClient)
         packet_id = node->msg_id;
         msg_type = node->type;
 
-        (void)iotx_mc_mask_subInfo_from(pClient, packet_id, &messageHandler);
+        (void)iotx_mc_mask_subInfo_from(pClient, packet_id, &messageHandler, &handler_num);
 
         /* Wait MQTT SUBSCRIBE ACK timeout */
         if (SUBSCRIBE == msg_type) {
             /* subscribe timeout */
             msg.event_type = IOTX_MQTT_EVENT_SUBCRIBE_TIMEOUT;
             msg.msg = (void *)(uintptr_t)packet_id;
-            _iotx_mqtt_event_handle_sub(pClient->handle_event.pcontext, pClient, &msg);
+            _iotx_mqtt_event_handle_sub(pClient->handle_event.pcontext, pClient, &msg, 0);
         } else { /* if (UNSUBSCRIBE == msg_type) */
             /* unsubscribe timeout */
             msg.event_type = IOTX_MQTT_EVENT_UNSUBCRIBE_TIMEOUT;
@@ -2590,10 +2965,7 @@ static int MQTTSubInfoProc(iotx_mc_client_t *pClient)
             pClient->handle_event.h_fp(pClient->handle_event.pcontext, pClient, &msg);
         }
 
-        if (messageHandler) {
-            mqtt_free(messageHandler->topic_filter);
-            mqtt_free(messageHandler);
-        }
+        iotx_mc_topic_handles_free(messageHandler, handler_num);
 
         list_del(&node->linked_list);
         mqtt_free(node);
@@ -2672,39 +3044,32 @@ static int MQTTRePublish(iotx_mc_client_t *c, char *buf, int len)
 }
 
 
-/* remove node of list of wait publish ACK, which is in invalid state or timeout */
+/* republish elements of window which wait ACK timeout */
 static int MQTTPubInfoProc(iotx_mc_client_t *pClient)
 {
     int rc = 0;
-    iotx_mc_state_t state = IOTX_MC_STATE_INVALID;
     iotx_mc_pub_info_t *node = NULL, *next_node = NULL;
 
     if (!pClient) {
         return FAIL_RETURN;
     }
 
+    if (iotx_mc_get_client_state(pClient) != IOTX_MC_STATE_CONNECTED) {
+        return SUCCESS_RETURN;
+    }
+
     HAL_MutexLock(pClient->lock_list_pub);
     list_for_each_entry_safe(node, next_node, &pClient->list_pub_wait_ack, linked_list, iotx_mc_pub_info_t) {
-        /* remove invalid node */
-        if (IOTX_MC_NODE_STATE_INVALID == node->node_state) {
-            list_del(&node->linked_list);
-            mqtt_free(node);
-            continue;
-        }
-
-        state = iotx_mc_get_client_state(pClient);
-        if (state != IOTX_MC_STATE_CONNECTED) {
-            continue;
-        }
-
-        /* check the request if timeout or not */
+        /* list is in order of start time, nothing timeout behind the first one not timeout */
         if (utils_time_spend(&node->pub_start_time) <= (pClient->request_timeout_ms * 2)) {
-            continue;
+            break;
         }
 
         /* If wait ACK timeout, republish */
         rc = MQTTRePublish(pClient, (char *)node->buf, node->len);
         iotx_time_start(&node->pub_start_time);
+        list_del(&node->linked_list);
+        list_add_tail(&node->linked_list, &pClient->list_pub_wait_ack);
 
         if (MQTT_NETWORK_ERROR == rc) {
             iotx_mc_set_client_state(pClient, IOTX_MC_STATE_DISCONNECTED);
@@ -2727,6 +3092,11 @@ int iotx_mc_connect(iotx_mc_client_t *pClient)
         return NULL_VALUE_ERROR;
     }
 
+    /* nothing received on the previous connection is valid any more */
+    HAL_MutexLock(pClient->lock_read_buf);
+    iotx_mc_read_buf_clear(pClient);
+    HAL_MutexUnlock(pClient->lock_read_buf);
+
     /* Establish TCP or TLS connection */
     rc = pClient->ipstack->connect(pClient->ipstack);
     if (SUCCESS_RETURN != rc) {
@@ -2896,10 +3266,7 @@ static void iotx_sub_wait_ack_list_destroy(iotx_mc_client_t *pClient)
 
     list_for_each_entry_safe(node, next_node, &pClient->list_sub_wait_ack, linked_list, iotx_mc_subsribe_info_t) {
         list_del(&node->linked_list);
-        if (node->handler != NULL) {
-            mqtt_free(node->handler->topic_filter);
-            mqtt_free(node->handler);
-        }
+        iotx_mc_topic_handles_free(node->handler, node->handler_num);
         mqtt_free(node);
     }
 }
@@ -2910,8 +3277,7 @@ static void iotx_pub_wait_ack_list_destroy(iotx_mc_client_t *pClient)
     iotx_mc_pub_info_t *node = NULL, *next_node = NULL;
 
     list_for_each_entry_safe(node, next_node, &pClient->list_pub_wait_ack, linked_list, iotx_mc_pub_info_t) {
-        list_del(&node->linked_list);
-        mqtt_free(node);
+        _pub_window_del(pClient, node);
     }
 }
 #endif
@@ -2928,20 +3294,7 @@ static int iotx_mc_release(iotx_mc_client_t *pClient)
     iotx_mc_set_client_state(pClient, IOTX_MC_STATE_INVALID);
     HAL_SleepMs(100);
 
-    if (pClient->first_sub_handle != NULL) {
-        iotx_mc_topic_handle_t *handler = pClient->first_sub_handle;
-        iotx_mc_topic_handle_t *next_handler = pClient->first_sub_handle;
-        while (handler) {
-            next_handler = handler->next;
-            if (handler->topic_filter != NULL) {
-                mqtt_free(handler->topic_filter);
-                handler->topic_filter = NULL;
-            }
-
-            mqtt_free(handler);
-            handler = next_handler;
-        }
-    }
+    iotx_mc_topic_trie_destroy(&pClient->sub_handles);
     iotx_conn_info_release();
     HAL_MutexDestroy(pClient->lock_generic);
     HAL_MutexDestroy(pClient->lock_list_sub);
@@ -2951,6 +3304,9 @@ static int iotx_mc_release(iotx_mc_client_t *pClient)
     HAL_MutexDestroy(pClient->lock_read_buf);
 
     iotx_sub_wait_ack_list_destroy(pClient);
+#if WITH_MQTT_SEND_QUEUE
+    iotx_mc_send_queue_destroy(pClient);
+#endif
 #if !WITH_MQTT_ONLY_QOS0
     iotx_pub_wait_ack_list_destroy(pClient);
 #endif
@@ -2965,6 +3321,7 @@ static int iotx_mc_release(iotx_mc_client_t *pClient)
     if (NULL != pClient->ipstack) {
         mqtt_free(pClient->ipstack);
     }
+    utils_slab_shrink(&g_mqtt_slab_pool);
     mqtt_info("mqtt release!");
     return SUCCESS_RETURN;
 }
@@ -3030,13 +3387,23 @@ static int iotx_mc_keepalive_sub(iotx_mc_client_t *pClient)
 typedef struct {
     uintptr_t packet_id;
     uint8_t ack_type;
+    uint32_t fail_mask;     /* topics rejected in SUBACK, bit 0 for the first topic of packet */
     iotx_mqtt_event_handle_func_fpt sub_state_cb;
     struct list_head linked_list;
 } mqtt_sub_node_t;
 
+/* topics of one SUBSCRIBE in IOT_MQTT_Subscribe_Multi_Sync, bit i for topics[i] */
+typedef struct {
+    mqtt_sub_node_t node;
+    iotx_mqtt_multi_sub_t *topics;
+    int count;
+    uint32_t pending;       /* not subscribed yet */
+    uint32_t sent;          /* in the SUBSCRIBE in flight */
+} mqtt_sub_batch_t;
+
 static struct list_head g_mqtt_sub_list = LIST_HEAD_INIT(g_mqtt_sub_list);
 
-static void _iotx_mqtt_event_handle_sub(void *pcontext, void *pclient, iotx_mqtt_event_msg_pt msg)
+static void _iotx_mqtt_event_handle_sub(void *pcontext, void *pclient, iotx_mqtt_event_msg_pt msg, uint32_t fail_mask)
 {
     if (pclient == NULL || msg == NULL) {
         return;
@@ -3053,6 +3420,7 @@ static void _iotx_mqtt_event_handle_sub(void *pcontext, void *pclient, iotx_mqtt
     list_for_each_entry_safe(node, next, &g_mqtt_sub_list, linked_list, mqtt_sub_node_t) {
         if (node->packet_id == packet_id) {
             node->ack_type = msg->event_type;
+            node->fail_mask = fail_mask;
         }
     }
     HAL_MutexUnlock(client->lock_generic);
@@ -3220,10 +3588,60 @@ int IOT_MQTT_Destroy(void **phandler)
 }
 
 
+/* time left before @spend_ms since @start reaches @timeout_ms */
+static uint32_t iotx_mc_time_left_since(iotx_time_t *start, uint32_t timeout_ms)
+{
+    uint32_t spend = utils_time_spend(start);
+
+    return (spend < timeout_ms) ? (timeout_ms - spend) : 0;
+}
+
+/* take @due as the nearest deadline if it is still ahead */
+#define MQTT_WAIT_DEADLINE(left, due)   do { uint32_t _due = (due); if (_due > 0 && _due < (left)) (left) = _due; } while (0)
+
+/*
+ * shrink @timer to the nearest of keepalive and pub/sub ack timeout, which yield must wake up for.
+ * Handlers have just run, so a deadline already passed is one they chose to leave, e.g. while
+ * disconnected, waking up for it would only spin.
+ */
+static void iotx_mc_wait_deadline(iotx_mc_client_t *c, iotx_time_t *timer)
+{
+    uint32_t left = iotx_time_left(timer);
+    iotx_mc_subsribe_info_t *sub_node = NULL;
+#if !WITH_MQTT_ONLY_QOS0
+    iotx_mc_pub_info_t *pub_node = NULL;
+#endif
+
+    if (iotx_mc_check_state_normal(c)) {
+        MQTT_WAIT_DEADLINE(left, iotx_time_left(&c->next_ping_time));
+    }
+
+#if !WITH_MQTT_ONLY_QOS0
+    /* the first one in list of wait publish ACK is the earliest to timeout */
+    HAL_MutexLock(c->lock_list_pub);
+    if (!list_empty(&c->list_pub_wait_ack)) {
+        pub_node = list_first_entry(&c->list_pub_wait_ack, iotx_mc_pub_info_t, linked_list);
+        MQTT_WAIT_DEADLINE(left, iotx_mc_time_left_since(&pub_node->pub_start_time, c->request_timeout_ms * 2));
+    }
+    HAL_MutexUnlock(c->lock_list_pub);
+#endif
+
+    HAL_MutexLock(c->lock_list_sub);
+    list_for_each_entry(sub_node, &c->list_sub_wait_ack, linked_list, iotx_mc_subsribe_info_t) {
+        MQTT_WAIT_DEADLINE(left, iotx_mc_time_left_since(&sub_node->sub_start_time,
+                           c->request_timeout_ms * CONFIG_SUBINFO_LIFE));
+    }
+    HAL_MutexUnlock(c->lock_list_sub);
+
+    iotx_time_init(timer);
+    utils_time_countdown_ms(timer, left);
+}
+
 int IOT_MQTT_Yield(void *handle, int timeout_ms)
 {
     int                 rc = SUCCESS_RETURN;
     iotx_time_t         time;
+    iotx_time_t         wait;
 
     iotx_mc_client_t *pClient = (iotx_mc_client_t *)(handle ? handle : g_mqtt_client);
 
@@ -3246,11 +3664,13 @@ int IOT_MQTT_Yield(void *handle, int timeout_ms)
         }
 
         HAL_MutexLock(pClient->lock_yield);
+#if WITH_MQTT_SEND_QUEUE
+        /* pick up packets whose sender lost race of draining */
+        iotx_mc_send_queue_flush(pClient);
+#endif
         /* Keep MQTT alive or reconnect if connection abort */
         iotx_mc_keepalive(pClient);
 
-        /* acquire package in cycle, such as PINGRESP or PUBLISH */
-        rc = iotx_mc_cycle(pClient, &time);
         if (SUCCESS_RETURN == rc) {
 #if !WITH_MQTT_ONLY_QOS0
             /* check list of wait publish ACK to remove node that is ACKED or timeout */
@@ -3259,13 +3679,18 @@ int IOT_MQTT_Yield(void *handle, int timeout_ms)
             /* check list of wait subscribe(or unsubscribe) ACK to remove node that is ACKED or timeout */
             MQTTSubInfoProc(pClient);
         }
+
+        /* block until data arrives or something else is due, instead of polling */
+        wait = time;
+        iotx_mc_wait_deadline(pClient, &wait);
+
+        /* acquire package in cycle, such as PINGRESP or PUBLISH */
+        rc = iotx_mc_cycle(pClient, &wait);
         HAL_MutexUnlock(pClient->lock_yield);
-        /*  */
-        unsigned int left_t = iotx_time_left(&time);
-        if (left_t < 10) {
-            HAL_SleepMs(left_t);
-        } else {
-            HAL_SleepMs(10);
+
+        /* nothing to wait on while connection is down, back off before next reconnect check */
+        if (SUCCESS_RETURN != rc) {
+            HAL_SleepMs(LITE_MINIMUM(iotx_time_left(&time), IOTX_MC_YIELD_IDLE_MS));
         }
     } while (!utils_time_is_expired(&time));
 
@@ -3415,6 +3840,170 @@ int IOT_MQTT_Subscribe_Sync(void *handle,
 }
 
 
+int IOT_MQTT_Subscribe_Multi(void *handle, iotx_mqtt_multi_sub_t *topics, int count)
+{
+    int i = 0;
+    iotx_mc_client_t *client = (iotx_mc_client_t *)(handle ? handle : g_mqtt_client);
+
+    POINTER_SANITY_CHECK(topics, NULL_VALUE_ERROR);
+
+    if (client == NULL) { //do offline subscribe
+        for (i = 0; i < count; i++) {
+            if (iotx_mqtt_offline_subscribe(topics[i].topic_filter, topics[i].qos, topics[i].topic_handle_func,
+                                            topics[i].pcontext) < 0) {
+                return FAIL_RETURN;
+            }
+        }
+        return SUCCESS_RETURN;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (topics[i].qos > IOTX_MQTT_QOS2) {
+            mqtt_warning("Invalid qos(%d) out of [%d, %d], using %d",
+                         topics[i].qos,
+                         IOTX_MQTT_QOS0, IOTX_MQTT_QOS2, IOTX_MQTT_QOS0);
+            topics[i].qos = IOTX_MQTT_QOS0;
+        }
+    }
+    _dump_wait_list(client, "sub");
+    return iotx_mc_subscribe_multi(client, topics, count);
+}
+
+/* Required to run in lock_generic, take SUBACK of @batch and leave it unsent */
+static void _iotx_mc_sub_batch_acked(mqtt_sub_batch_t *batch)
+{
+    int i = 0, k = 0;
+
+    for (i = 0; i < batch->count; i++) {
+        if (!(batch->sent & (1u << i))) {
+            continue;
+        }
+        /* k-th topic of packet is i-th of batch */
+        if (batch->node.ack_type == IOTX_MQTT_EVENT_SUBCRIBE_SUCCESS
+            || (batch->node.ack_type == IOTX_MQTT_EVENT_SUBCRIBE_NACK && !(batch->node.fail_mask & (1u << k)))) {
+            batch->pending &= ~(1u << i);
+        }
+        k++;
+    }
+
+    list_del(&batch->node.linked_list);
+    batch->node.packet_id = 0;
+    batch->node.ack_type = IOTX_MQTT_EVENT_UNDEF;
+    batch->sent = 0;
+}
+
+int IOT_MQTT_Subscribe_Multi_Sync(void *handle, iotx_mqtt_multi_sub_t *topics, int count, int timeout_ms)
+{
+    int                 i = 0;
+    int                 j = 0;
+    int                 k = 0;
+    int                 ret = 0;
+    int                 batch_num = 0;
+    int                 acked = 0;
+    mqtt_sub_batch_t   *batch = NULL;
+    iotx_mqtt_multi_sub_t sub[MUTLI_SUBSCIRBE_MAX];
+    iotx_time_t         timer;
+    iotx_mc_client_t   *client = (iotx_mc_client_t *)(handle ? handle : g_mqtt_client);
+
+    POINTER_SANITY_CHECK(topics, NULL_VALUE_ERROR);
+    if (count <= 0) {
+        return SUCCESS_RETURN;
+    }
+
+    if (client == NULL) {
+        return IOT_MQTT_Subscribe_Multi(handle, topics, count);
+    }
+
+    if (timeout_ms > SUBSCRIBE_SYNC_TIMEOUT_MAX) {
+        timeout_ms = SUBSCRIBE_SYNC_TIMEOUT_MAX;
+    }
+
+    /* one SUBSCRIBE per MUTLI_SUBSCIRBE_MAX topics, all sent before waiting for any SUBACK */
+    batch_num = (count + MUTLI_SUBSCIRBE_MAX - 1) / MUTLI_SUBSCIRBE_MAX;
+    batch = mqtt_malloc(batch_num * sizeof(mqtt_sub_batch_t));
+    if (batch == NULL) {
+        return FAIL_RETURN;
+    }
+    memset(batch, 0, batch_num * sizeof(mqtt_sub_batch_t));
+    for (i = 0; i < batch_num; i++) {
+        batch[i].topics = &topics[i * MUTLI_SUBSCIRBE_MAX];
+        batch[i].count = LITE_MINIMUM(MUTLI_SUBSCIRBE_MAX, count - i * MUTLI_SUBSCIRBE_MAX);
+        batch[i].pending = (1u << batch[i].count) - 1;
+    }
+
+    iotx_time_init(&timer);
+    utils_time_countdown_ms(&timer, timeout_ms);
+
+    do {
+        /* (re)send topics of batches which are not in flight, rejected topics only */
+        for (i = 0; i < batch_num; i++) {
+            if (batch[i].node.packet_id != 0 || batch[i].pending == 0) {
+                continue;
+            }
+            for (j = 0, k = 0; j < batch[i].count; j++) {
+                if (batch[i].pending & (1u << j)) {
+                    sub[k++] = batch[i].topics[j];
+                }
+            }
+            ret = IOT_MQTT_Subscribe_Multi(client, sub, k);
+            if (ret <= 0) {
+                continue;
+            }
+
+            HAL_MutexLock(client->lock_generic);
+            batch[i].node.packet_id = ret;
+            batch[i].node.ack_type = IOTX_MQTT_EVENT_UNDEF;
+            batch[i].sent = batch[i].pending;
+            list_add_tail(&batch[i].node.linked_list, &g_mqtt_sub_list);
+            HAL_MutexUnlock(client->lock_generic);
+        }
+
+        /* can not wait for SUBACK inside callback of yield */
+        if (_is_in_yield_cb() != 0) {
+            break;
+        }
+
+        IOT_MQTT_Yield(client, 100);
+
+        /* barrier: done when every topic has been subscribed */
+        acked = 0;
+        HAL_MutexLock(client->lock_generic);
+        for (i = 0; i < batch_num; i++) {
+            if (batch[i].node.packet_id != 0 && batch[i].node.ack_type != IOTX_MQTT_EVENT_UNDEF) {
+                _iotx_mc_sub_batch_acked(&batch[i]);
+            }
+            if (batch[i].pending == 0) {
+                acked++;
+            }
+        }
+        HAL_MutexUnlock(client->lock_generic);
+    } while (acked < batch_num && !utils_time_is_expired(&timer));
+
+    acked = 0;
+    HAL_MutexLock(client->lock_generic);
+    for (i = 0; i < batch_num; i++) {
+        if (batch[i].node.packet_id != 0) {
+            list_del(&batch[i].node.linked_list);
+            /* inside callback of yield, it succeeds once all packets have been sent */
+            if (_is_in_yield_cb() != 0) {
+                batch[i].pending &= ~batch[i].sent;
+            }
+        }
+        for (j = 0; j < batch[i].count; j++) {
+            batch[i].topics[j].result = (batch[i].pending & (1u << j)) ? FAIL_RETURN : SUCCESS_RETURN;
+        }
+        if (batch[i].pending == 0) {
+            acked++;
+        }
+    }
+    HAL_MutexUnlock(client->lock_generic);
+    mqtt_free(batch);
+
+    mqtt_debug("subscribe %d topics, %d of %d packets acked", count, acked, batch_num);
+
+    return (acked == batch_num) ? SUCCESS_RETURN : FAIL_RETURN;
+}
+
 int IOT_MQTT_Unsubscribe(void *handle, const char *topic_filter)
 {
     iotx_mc_client_t *client = (iotx_mc_client_t *)(handle ? handle : g_mqtt_client);
@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+#include "iotx_mqtt_internal.h"
+#include "mqtt_topic_trie.h"
+
+#define TOPIC_BUCKET_INDEX(hash)    ((hash) & (IOTX_MC_TOPIC_HASH_BUCKETS - 1))
+
+typedef struct {
+    iotx_mqtt_event_handle_t   *handles;
+    int                         handles_max;
+    int                         handles_num;
+} iotx_mc_topic_match_t;
+
+static int _topic_level_is(const char *level, int len, char wildcard)
+{
+    return (1 == len && wildcard == level[0]);
+}
+
+/* find child of @node for @level, create it if not exist and @create is not 0 */
+static iotx_mc_topic_node_t *_topic_node_child(iotx_mc_topic_node_t *node, const char *level, int len, int create)
+{
+    iotx_mc_topic_node_t **slot = NULL;
+    iotx_mc_topic_node_t *child = NULL;
+
+    if (_topic_level_is(level, len, '+')) {
+        slot = &node->plus;
+    } else if (_topic_level_is(level, len, '#')) {
+        slot = &node->hash;
+    } else {
+        for (child = node->child; child != NULL; child = child->sibling) {
+            if (0 == strncmp(child->level, level, len) && '\0' == child->level[len]) {
+                return child;
+            }
+        }
+    }
+
+    if (slot != NULL && *slot != NULL) {
+        return *slot;
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    /* level string is stored right after the node */
+    child = mqtt_malloc(sizeof(iotx_mc_topic_node_t) + len + 1);
+    if (child == NULL) {
+        return NULL;
+    }
+    memset(child, 0, sizeof(iotx_mc_topic_node_t) + len + 1);
+    child->level = (char *)child + sizeof(iotx_mc_topic_node_t);
+    memcpy(child->level, level, len);
+    child->parent = node;
+
+    if (slot != NULL) {
+        *slot = child;
+    } else {
+        child->sibling = node->child;
+        node->child = child;
+    }
+
+    return child;
+}
+
+/* walk down from root along levels of @filter */
+static iotx_mc_topic_node_t *_topic_node_walk(iotx_mc_topic_trie_t *trie, const char *filter, int create)
+{
+    iotx_mc_topic_node_t *node = &trie->root;
+    const char *pos = filter;
+    const char *end = NULL;
+
+    while (node != NULL) {
+        end = strchr(pos, '/');
+        node = _topic_node_child(node, pos, (end == NULL) ? strlen(pos) : (end - pos), create);
+        if (end == NULL) {
+            break;
+        }
+        pos = end + 1;
+    }
+
+    return node;
+}
+
+/* release @node and its ancestors which have no more handles and children */
+static void _topic_node_prune(iotx_mc_topic_node_t *node)
+{
+    iotx_mc_topic_node_t *parent = NULL;
+    iotx_mc_topic_node_t **pp = NULL;
+
+    while (node->parent != NULL && node->handles == NULL &&
+           node->child == NULL && node->plus == NULL && node->hash == NULL) {
+        parent = node->parent;
+        if (parent->plus == node) {
+            parent->plus = NULL;
+        } else if (parent->hash == node) {
+            parent->hash = NULL;
+        } else {
+            for (pp = &parent->child; *pp != node; pp = &(*pp)->sibling);
+            *pp = node->sibling;
+        }
+        mqtt_free(node);
+        node = parent;
+    }
+}
+
+static void _topic_handles_free(iotx_mc_topic_handle_t *handle)
+{
+    iotx_mc_topic_handle_t *next = NULL;
+
+    while (handle != NULL) {
+        next = handle->next;
+        if (handle->topic_filter != NULL) {
+            mqtt_free(handle->topic_filter);
+        }
+        mqtt_obj_free(handle);
+        handle = next;
+    }
+}
+
+static void _topic_node_free(iotx_mc_topic_node_t *node)
+{
+    iotx_mc_topic_node_t *child = NULL;
+    iotx_mc_topic_node_t *next = NULL;
+
+    for (child = node->child; child != NULL; child = next) {
+        next = child->sibling;
+        _topic_node_free(child);
+    }
+    if (node->plus != NULL) {
+        _topic_node_free(node->plus);
+    }
+    if (node->hash != NULL) {
+        _topic_node_free(node->hash);
+    }
+    _topic_handles_free(node->handles);
+
+    if (node->parent != NULL) {
+        mqtt_free(node);
+    }
+}
+
+/* get head of handle list which @handle belongs to */
+static iotx_mc_topic_handle_t **_topic_handles_head(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *handle,
+        int create)
+{
+    iotx_mc_topic_node_t *node = NULL;
+
+    if (TOPIC_NAME_TYPE == handle->topic_type) {
+        return &trie->buckets[TOPIC_BUCKET_INDEX(handle->topic_hash)];
+    }
+
+    node = _topic_node_walk(trie, handle->topic_filter, create);
+    return (node == NULL) ? NULL : &node->handles;
+}
+
+static int _topic_filter_is_identical(iotx_mc_topic_handle_t *handle1, iotx_mc_topic_handle_t *handle2)
+{
+    if (handle1->topic_type != handle2->topic_type) {
+        return 0;
+    }
+
+    if (TOPIC_NAME_TYPE == handle1->topic_type) {
+        if (handle1->topic_hash != handle2->topic_hash) {
+            return 0;
+        }
+#if WITH_MQTT_ZIP_TOPIC
+        return (0 == memcmp(handle1->topic_filter, handle2->topic_filter, MQTT_MD5_PATH_DEFAULT_LEN));
+#endif
+    }
+
+    return (0 == strcmp(handle1->topic_filter, handle2->topic_filter));
+}
+
+static void _topic_match_collect(iotx_mc_topic_match_t *match, iotx_mc_topic_handle_t *handle)
+{
+    for (; handle != NULL; handle = handle->next) {
+        if (match->handles_num < match->handles_max) {
+            match->handles[match->handles_num] = handle->handle;
+        }
+        match->handles_num++;
+    }
+}
+
+/* @node has matched all levels before @pos, @pos is start of current level */
+static void _topic_node_match(iotx_mc_topic_node_t *node, const char *pos, const char *end,
+                              iotx_mc_topic_match_t *match)
+{
+    iotx_mc_topic_node_t *child = NULL;
+    const char *level_end = memchr(pos, '/', end - pos);
+    int level_len = 0;
+
+    if (level_end == NULL) {
+        level_end = end;
+    }
+    level_len = level_end - pos;
+
+    /* '#' consumes current level and all levels behind */
+    if (node->hash != NULL) {
+        _topic_match_collect(match, node->hash->handles);
+    }
+
+    if (node->plus != NULL) {
+        if (level_end < end) {
+            _topic_node_match(node->plus, level_end + 1, end, match);
+        } else {
+            _topic_match_collect(match, node->plus->handles);
+        }
+    }
+
+    for (child = node->child; child != NULL; child = child->sibling) {
+        if (0 == strncmp(child->level, pos, level_len) && '\0' == child->level[level_len]) {
+            if (level_end < end) {
+                _topic_node_match(child, level_end + 1, end, match);
+            } else {
+                _topic_match_collect(match, child->handles);
+            }
+            break;
+        }
+    }
+}
+
+void iotx_mc_topic_trie_init(iotx_mc_topic_trie_t *trie)
+{
+    memset(trie, 0, sizeof(iotx_mc_topic_trie_t));
+}
+
+void iotx_mc_topic_trie_destroy(iotx_mc_topic_trie_t *trie)
+{
+    int i = 0;
+
+    for (i = 0; i < IOTX_MC_TOPIC_HASH_BUCKETS; i++) {
+        _topic_handles_free(trie->buckets[i]);
+    }
+    _topic_node_free(&trie->root);
+
+    iotx_mc_topic_trie_init(trie);
+}
+
+void iotx_mc_topic_handle_hash(iotx_mc_topic_handle_t *handle)
+{
+    handle->topic_hash = 0;
+    if (TOPIC_NAME_TYPE != handle->topic_type) {
+        return;
+    }
+
+#if WITH_MQTT_ZIP_TOPIC
+    handle->topic_hash = LITE_hash_string(handle->topic_filter, MQTT_MD5_PATH_DEFAULT_LEN);
+#else
+    handle->topic_hash = LITE_hash_string(handle->topic_filter, -1);
+#endif
+}
+
+int iotx_mc_topic_trie_insert(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *handle)
+{
+    iotx_mc_topic_handle_t **head = NULL;
+
+    if (trie == NULL || handle == NULL || handle->topic_filter == NULL) {
+        return FAIL_RETURN;
+    }
+
+    head = _topic_handles_head(trie, handle, 1);
+    if (head == NULL) {
+        return FAIL_RETURN;
+    }
+
+    handle->next = *head;
+    *head = handle;
+    trie->handle_num++;
+
+    return SUCCESS_RETURN;
+}
+
+int iotx_mc_topic_trie_remove(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *handle)
+{
+    iotx_mc_topic_handle_t **head = NULL;
+    iotx_mc_topic_handle_t **hp = NULL;
+
+    if (trie == NULL || handle == NULL || handle->topic_filter == NULL) {
+        return FAIL_RETURN;
+    }
+
+    head = _topic_handles_head(trie, handle, 0);
+    if (head == NULL) {
+        return FAIL_RETURN;
+    }
+
+    for (hp = head; *hp != NULL; hp = &(*hp)->next) {
+        if (*hp == handle) {
+            *hp = handle->next;
+            handle->next = NULL;
+            trie->handle_num--;
+
+            if (TOPIC_FILTER_TYPE == handle->topic_type) {
+                _topic_node_prune(container_of(head, iotx_mc_topic_node_t, handles));
+            }
+            return SUCCESS_RETURN;
+        }
+    }
+
+    return FAIL_RETURN;
+}
+
+iotx_mc_topic_handle_t *iotx_mc_topic_trie_lookup(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *key,
+        int with_callback)
+{
+    iotx_mc_topic_handle_t **head = NULL;
+    iotx_mc_topic_handle_t *handle = NULL;
+
+    if (trie == NULL || key == NULL || key->topic_filter == NULL) {
+        return NULL;
+    }
+
+    head = _topic_handles_head(trie, key, 0);
+    if (head == NULL) {
+        return NULL;
+    }
+
+    for (handle = *head; handle != NULL; handle = handle->next) {
+        if (!_topic_filter_is_identical(handle, key)) {
+            continue;
+        }
+        if (with_callback && (handle->handle.h_fp != key->handle.h_fp ||
+                              handle->handle.pcontext != key->handle.pcontext)) {
+            continue;
+        }
+        return handle;
+    }
+
+    return NULL;
+}
+
+int iotx_mc_topic_trie_match(iotx_mc_topic_trie_t *trie, const char *topic, int topic_len, const char *topic_md5,
+                             iotx_mqtt_event_handle_t *handles, int handles_max)
+{
+    iotx_mc_topic_match_t match;
+    iotx_mc_topic_handle_t *handle = NULL;
+    uint32_t hash = 0;
+
+    if (trie == NULL || topic == NULL || topic_len <= 0) {
+        return 0;
+    }
+
+    match.handles = handles;
+    match.handles_max = handles_max;
+    match.handles_num = 0;
+
+    /* topic without wildcard, matched by hash bucket */
+#if WITH_MQTT_ZIP_TOPIC
+    hash = LITE_hash_string(topic_md5, MQTT_MD5_PATH_DEFAULT_LEN);
+#else
+    (void)topic_md5;
+    hash = LITE_hash_string(topic, topic_len);
+#endif
+    for (handle = trie->buckets[TOPIC_BUCKET_INDEX(hash)]; handle != NULL; handle = handle->next) {
+        if (handle->topic_hash != hash) {
+            continue;
+        }
+#if WITH_MQTT_ZIP_TOPIC
+        if (0 != memcmp(handle->topic_filter, topic_md5, MQTT_MD5_PATH_DEFAULT_LEN)) {
+            continue;
+        }
+#else
+        if (0 != strncmp(handle->topic_filter, topic, topic_len) || '\0' != handle->topic_filter[topic_len]) {
+            continue;
+        }
+#endif
+        if (match.handles_num < match.handles_max) {
+            match.handles[match.handles_num] = handle->handle;
+        }
+        match.handles_num++;
+    }
+
+    /* topic filter with wildcard, matched level by level */
+    _topic_node_match(&trie->root, topic, topic + topic_len, &match);
+
+    return match.handles_num;
+}
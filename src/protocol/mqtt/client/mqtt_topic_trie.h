@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+
+
+#ifndef __MQTT_TOPIC_TRIE_H__
+#define __MQTT_TOPIC_TRIE_H__
+
+#include "iotx_mqtt.h"
+
+void iotx_mc_topic_trie_init(iotx_mc_topic_trie_t *trie);
+void iotx_mc_topic_trie_destroy(iotx_mc_topic_trie_t *trie);
+
+/* calculate topic_hash of @handle, must be called once topic_filter and topic_type are set */
+void iotx_mc_topic_handle_hash(iotx_mc_topic_handle_t *handle);
+
+/* add @handle into @trie, @trie takes ownership of it */
+int iotx_mc_topic_trie_insert(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *handle);
+
+/* unlink @handle from @trie without freeing it */
+int iotx_mc_topic_trie_remove(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *handle);
+
+/* find handle which has the same filter with @key, and the same callback also if @with_callback is not 0 */
+iotx_mc_topic_handle_t *iotx_mc_topic_trie_lookup(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *key,
+        int with_callback);
+
+/*
+ * collect event handles of all filters matching @topic into @handles,
+ * @topic_md5 is the MD5 digest of @topic when WITH_MQTT_ZIP_TOPIC enabled, otherwise NULL,
+ * return total number of matched handles, which may be larger than @handles_max
+ */
+int iotx_mc_topic_trie_match(iotx_mc_topic_trie_t *trie, const char *topic, int topic_len, const char *topic_md5,
+                             iotx_mqtt_event_handle_t *handles, int handles_max);
+
+#endif  /* __MQTT_TOPIC_TRIE_H__ */
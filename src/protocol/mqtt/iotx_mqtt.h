@@ -44,9 +44,28 @@ typedef struct iotx_mc_topic_handle_s {
     const char *topic_filter;
     iotx_mc_topic_type_t topic_type;
     iotx_mqtt_event_handle_t handle;
-    struct iotx_mc_topic_handle_s *next;
+    uint32_t topic_hash;                            /* hash of whole filter, valid for TOPIC_NAME_TYPE */
+    struct iotx_mc_topic_handle_s *next;            /* next handle in the same hash bucket or trie node */
 } iotx_mc_topic_handle_t;
 
+/* Node of topic trie, one node per level of wildcard topic filter */
+typedef struct iotx_mc_topic_node_s {
+    char *level;                                    /* level string, NULL for root, "+" or "#" for wildcard */
+    struct iotx_mc_topic_node_s *parent;
+    struct iotx_mc_topic_node_s *child;             /* first exact-level child */
+    struct iotx_mc_topic_node_s *sibling;           /* next exact-level sibling */
+    struct iotx_mc_topic_node_s *plus;              /* '+' child */
+    struct iotx_mc_topic_node_s *hash;              /* '#' child */
+    iotx_mc_topic_handle_t *handles;                /* handles whose filter terminates at this node */
+} iotx_mc_topic_node_t;
+
+/* Subscribed topic handles: exact topics in hash buckets, wildcard filters in level trie */
+typedef struct {
+    iotx_mc_topic_handle_t *buckets[IOTX_MC_TOPIC_HASH_BUCKETS];
+    iotx_mc_topic_node_t    root;
+    uint32_t                handle_num;
+} iotx_mc_topic_trie_t;
+
 /* Handle structure of subscribed topic */
 typedef struct  {
     char *topic_filter;
@@ -62,21 +81,36 @@ typedef struct SUBSCRIBE_INFO {
     uint16_t                    msg_id;             /* packet id of subscribe(unsubcribe) */
     iotx_time_t                 sub_start_time;     /* start time of subscribe request */
     iotx_mc_node_t              node_state;         /* state of this node */
-    iotx_mc_topic_handle_t     *handler;            /* handle of topic subscribed(unsubcribed) */
+    iotx_mc_topic_handle_t     *handler;            /* handles of topics subscribed(unsubcribed) */
+    uint16_t                    handler_num;        /* number of handles in @handler */
     uint16_t                    len;                /* length of subscribe message */
     unsigned char              *buf;                /* subscribe message */
     struct list_head            linked_list;
 } iotx_mc_subsribe_info_t, *iotx_mc_subsribe_info_pt;
 
+#if WITH_MQTT_SEND_QUEUE
+/* Serialized packet waiting in send queue */
+typedef struct SEND_INFO {
+    struct SEND_INFO           *next;               /* next packet in send queue or pool */
+    uint32_t                    len;                /* length of packet */
+    uint32_t                    size;               /* capacity of @buf */
+    unsigned char              *buf;                /* packet, right behind this node unless @pub is set */
+    struct REPUBLISH_INFO      *pub;                /* window node whose packet is queued by reference, or NULL */
+} iotx_mc_send_info_t;
+#endif
+
 #if !WITH_MQTT_ONLY_QOS0
 /* Information structure of published topic */
 typedef struct REPUBLISH_INFO {
     iotx_time_t                 pub_start_time;     /* start time of publish request */
-    iotx_mc_node_t              node_state;         /* state of this node */
     uint16_t                    msg_id;             /* packet id of publish */
     uint32_t                    len;                /* length of publish message */
-    unsigned char              *buf;                /* publish message */
-    struct list_head            linked_list;
+    unsigned char              *buf;                /* publish message, serialized right behind this node */
+    struct list_head            linked_list;        /* in order of pub_start_time */
+    int                         refs;               /* held by window and by send queue, under lock_list_pub */
+#if WITH_MQTT_SEND_QUEUE
+    iotx_mc_send_info_t         send;               /* queues @buf without a copy */
+#endif
 } iotx_mc_pub_info_t, *iotx_mc_pub_info_pt;
 #endif
 /* Reconnected parameter of MQTT client */
@@ -99,7 +133,13 @@ typedef struct Client {
     uint8_t                         keepalive_probes;                           /* keepalive probes */
     char                           *buf_send;                                   /* pointer of send buffer */
     char                           *buf_read;                                   /* pointer of read buffer */
-    iotx_mc_topic_handle_t         *first_sub_handle;                           /* list of subscribe handle */
+    uint32_t                        buf_read_offset;                            /* offset of unhandled data in read buffer */
+    uint32_t                        buf_read_len;                               /* length of unhandled data in read buffer */
+    uint32_t                        buf_read_discard;                           /* bytes of oversize packet still to drop */
+    uint32_t                        buf_frame_len;                              /* length of packet being handled */
+    char                            buf_frame_tail;                             /* byte overwritten by '\0' behind packet */
+    uint8_t                         buf_frame_tail_saved;                       /* buf_frame_tail is valid or not */
+    iotx_mc_topic_trie_t            sub_handles;                                /* table of subscribe handle */
     utils_network_pt                ipstack;                                    /* network parameter */
     iotx_time_t                     next_ping_time;                             /* next ping time */
     int                             ping_mark;                                  /* flag of ping */
@@ -108,6 +148,7 @@ typedef struct Client {
     MQTTPacket_connectData          connect_data;                               /* connection parameter */
 #if !WITH_MQTT_ONLY_QOS0
     struct list_head                list_pub_wait_ack;                          /* list of wait publish ack */
+    iotx_mc_pub_info_t             *pub_window[IOTX_MC_REPUB_NUM_MAX];         /* wait publish ack indexed by packet id */
 #endif
     struct list_head                list_sub_wait_ack;                          /* list of subscribe or unsubscribe ack */
     void                           *lock_list_pub;                              /* lock for list of QoS1 pub */
@@ -115,16 +156,15 @@ typedef struct Client {
     void                           *lock_write_buf;                             /* lock of write */
     void                           *lock_read_buf;                             /* lock of write */
     void                           *lock_yield;
+#if WITH_MQTT_SEND_QUEUE
+    iotx_mc_send_info_t            *send_queue;                                 /* packets to send, newest first */
+    int                             send_draining;                              /* a sender is draining send queue */
+    iotx_mc_send_info_t            *send_pool;                                  /* idle packet buffers, under lock_generic */
+    uint32_t                        send_pool_num;                              /* number of buffers in send_pool */
+#endif
     iotx_mqtt_event_handle_t        handle_event;                               /* event handle */
 } iotx_mc_client_t, *iotx_mc_client_pt;
 
-/* Information structure of mutli-subscribe */
-typedef struct {
-    const char                                    *topicFilter;
-    iotx_mqtt_qos_t                                qos;
-    iotx_mqtt_event_handle_func_fpt                messageHandler;
-} iotx_mutli_sub_info_t, *iotx_mutli_sub_info_pt;
-
 typedef struct {
     struct list_head offline_sub_list;
     void *mutex;
@@ -142,6 +182,7 @@ int iotx_mc_subscribe(iotx_mc_client_t *c,
                       iotx_mqtt_qos_t qos,
                       iotx_mqtt_event_handle_func_fpt topic_handle_func,
                       void *pcontext);
+int iotx_mc_subscribe_multi(iotx_mc_client_t *c, iotx_mqtt_multi_sub_t *topics, int count);
 int iotx_mc_publish(iotx_mc_client_t *c, const char *topicName, iotx_mqtt_topic_info_pt topic_msg);
 
 #endif  /* __IOTX_MQTT_H__ */
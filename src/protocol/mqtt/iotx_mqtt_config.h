@@ -31,8 +31,44 @@
     #define WITH_MQTT_DYN_CONNINFO              (0)
 #endif
 
-/* maximum republish elements in list */
-#define IOTX_MC_REPUB_NUM_MAX                   (20)
+/* publishers enqueue packets, one sender at a time writes them in batch and hands each result back */
+#ifndef WITH_MQTT_SEND_QUEUE
+    #define WITH_MQTT_SEND_QUEUE                (0)
+#endif
+
+/*
+ * size of QoS1 in-flight window, i.e. maximum number of publish waiting for PUBACK.
+ * The window costs one pointer per slot in client, packets are only held while unacked,
+ * lower it for devices which cannot afford that many packets in flight.
+ */
+#ifndef IOTX_MC_REPUB_NUM_MAX
+    #define IOTX_MC_REPUB_NUM_MAX               (64)
+#endif
+
+/* maximum number of idle packet buffers kept for reuse by send queue */
+#ifndef IOTX_MC_SEND_POOL_NUM
+    #define IOTX_MC_SEND_POOL_NUM               (8)
+#endif
+
+/* size of packet buffer kept by send queue, larger packets are allocated on demand */
+#ifndef IOTX_MC_SEND_POOL_BUF_LEN
+    #define IOTX_MC_SEND_POOL_BUF_LEN           (256)
+#endif
+
+/* bytes of one slab page for topic handles and small publishes waiting for PUBACK */
+#ifndef IOTX_MC_SLAB_PAGE_SIZE
+    #define IOTX_MC_SLAB_PAGE_SIZE              (1024)
+#endif
+
+/* slab pages per object size, more objects are allocated from heap */
+#ifndef IOTX_MC_SLAB_MAX_PAGES
+    #define IOTX_MC_SLAB_MAX_PAGES              (8)
+#endif
+
+/* timeout of reading bytes already arrived after a whole packet, HAL read shall not block on 0 */
+#ifndef IOTX_MC_READ_AVAIL_TIMEOUT_MS
+    #define IOTX_MC_READ_AVAIL_TIMEOUT_MS       (0)
+#endif
 
 /* MQTT client version number */
 #define IOTX_MC_MQTT_VERSION                    (4)
@@ -43,6 +79,11 @@
 /* maximum MQTT packet-id */
 #define IOTX_MC_PACKET_ID_MAX                   (65535)
 
+/* number of hash buckets for subscribed topics without wildcard, power of 2 */
+#ifndef IOTX_MC_TOPIC_HASH_BUCKETS
+    #define IOTX_MC_TOPIC_HASH_BUCKETS          (64)
+#endif
+
 /* maximum number of simultaneously invoke subscribe request */
 #define IOTX_MC_SUB_REQUEST_NUM_MAX             (256)
 
@@ -64,5 +105,8 @@
 /* Max times of keepalive which has been send and did not received response package */
 #define IOTX_MC_KEEPALIVE_PROBE_MAX             (3)
 
+/* Interval of yield loop in millisecond while MQTT connection is not established */
+#define IOTX_MC_YIELD_IDLE_MS                   (10)
+
 
 #endif  /* IOTX_MQTT_CONFIG_H__ */
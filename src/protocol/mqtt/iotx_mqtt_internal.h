@@ -26,12 +26,19 @@
 #define mqtt_malloc(size)            LITE_malloc(size, MEM_MAGIC, "mqtt")
 #define mqtt_free                    LITE_free
 
+/* topic handles and publishes waiting for PUBACK, shall be released by mqtt_obj_free */
+extern utils_slab_pool_t g_mqtt_slab_pool;
+#define mqtt_obj_malloc(size)        utils_slab_alloc(&g_mqtt_slab_pool, size)
+#define mqtt_obj_free(ptr)           utils_slab_free(ptr)
+
 #define MQTT_DYNBUF_SEND_MARGIN                      (64)
 
 #define MQTT_DYNBUF_RECV_MARGIN                      (8)
 
 #define MQTT_CONNECT_REQUIRED_BUFLEN                 (256)
 
+#define MQTT_MD5_PATH_DEFAULT_LEN                    (16)
+
 /* MQTT send publish packet */
 
 #endif  /* __IOTX_MQTT_INTERNAL_H__ */
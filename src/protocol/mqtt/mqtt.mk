@@ -5,6 +5,7 @@ $(NAME)_VERSION := 2.3.0
 $(NAME)_SUMMARY :=
 
 $(NAME)_SOURCES := ./client/mqtt_client.c \
+./client/mqtt_topic_trie.c \
 ./MQTTPacket/MQTTPacket.c \
 ./MQTTPacket/MQTTSubscribeClient.c \
 ./MQTTPacket/MQTTDeserializePublish.c \
@@ -205,7 +205,8 @@ int32_t HAL_TCP_Read(uintptr_t fd, char *buf, uint32_t len, uint32_t timeout_ms)
 
     do {
         t_left = _linux_time_left(t_end, _linux_get_time_ms());
-        if (0 == t_left) {
+        /* zero 'timeout_ms' means taking data already arrived only, select() just polls */
+        if (0 == t_left && 0 != timeout_ms) {
             break;
         }
         FD_ZERO(&sets);
@@ -357,6 +357,30 @@ int HAL_UDP_recvfrom(_IN_ intptr_t sockfd,
     return -1;
 }
 
+/* no recvmmsg on this platform, receive one datagram per call */
+int HAL_UDP_recvfrom_batch(_IN_ intptr_t sockfd,
+                           _OU_ NetworkAddr *p_remote,
+                           _OU_ unsigned char *p_data[],
+                           _IN_ unsigned int datalen,
+                           _OU_ unsigned int *p_len,
+                           _IN_ unsigned int count,
+                           _IN_ unsigned int timeout_ms)
+{
+    int ret;
+
+    if (NULL == p_remote || NULL == p_data || NULL == p_len || 0 == count) {
+        return -1;
+    }
+
+    ret = HAL_UDP_recvfrom(sockfd, p_remote, p_data[0], datalen, timeout_ms);
+    if (ret > 0) {
+        p_len[0] = ret;
+        return 1;
+    }
+
+    return ret;
+}
+
 int HAL_UDP_send(_IN_ intptr_t sockfd,
                  _IN_ const unsigned char *p_data,
                  _IN_ unsigned int datalen,
@@ -637,7 +637,7 @@ int HAL_Kv_Set(const char *key, const void *val, int len, int sync)
         }
     }
 
-    return kv_set_blob(kvfile, (char *)key, (char *)val, len);
+    return kv_set_blob(kvfile, (char *)key, (char *)val, len, sync);
 }
 
 int HAL_Kv_Get(const char *key, void *buffer, int *buffer_len)
@@ -5,6 +5,9 @@
 
 
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     /* recvmmsg */
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -358,6 +361,74 @@ int HAL_UDP_recvfrom(_IN_ intptr_t sockfd,
     return -1;
 }
 
+#define HAL_UDP_RECV_BATCH_MAX  (16)
+
+int HAL_UDP_recvfrom_batch(_IN_ intptr_t sockfd,
+                           _OU_ NetworkAddr *p_remote,
+                           _OU_ unsigned char *p_data[],
+                           _IN_ unsigned int datalen,
+                           _OU_ unsigned int *p_len,
+                           _IN_ unsigned int count,
+                           _IN_ unsigned int timeout_ms)
+{
+    int ret;
+    int i;
+    struct sockaddr_in addr[HAL_UDP_RECV_BATCH_MAX];
+    struct iovec iov[HAL_UDP_RECV_BATCH_MAX];
+    struct mmsghdr msgs[HAL_UDP_RECV_BATCH_MAX];
+    fd_set read_fds;
+    struct timeval timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+
+    if (NULL == p_remote || NULL == p_data || NULL == p_len || 0 == count) {
+        return -1;
+    }
+    if (count > HAL_UDP_RECV_BATCH_MAX) {
+        count = HAL_UDP_RECV_BATCH_MAX;
+    }
+
+    FD_ZERO(&read_fds);
+    FD_SET(sockfd, &read_fds);
+
+    ret = select(sockfd + 1, &read_fds, NULL, NULL, &timeout);
+    if (ret == 0) {
+        return 0;    /* receive timeout */
+    }
+
+    if (ret < 0) {
+        if (errno == EINTR) {
+            return -3;    /* want read */
+        }
+        return -4; /* receive failed */
+    }
+
+    memset(msgs, 0, count * sizeof(struct mmsghdr));
+    for (i = 0; i < count; i++) {
+        iov[i].iov_base = p_data[i];
+        iov[i].iov_len = datalen;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &addr[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    }
+
+    /* at least one datagram is ready, take the others already queued without waiting */
+    ret = recvmmsg(sockfd, msgs, count, MSG_DONTWAIT, NULL);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;    /* spurious wakeup, nothing queued after all */
+    }
+    if (ret <= 0) {
+        return -1;
+    }
+
+    for (i = 0; i < ret; i++) {
+        p_len[i] = msgs[i].msg_len;
+        p_remote[i].port = ntohs(addr[i].sin_port);
+        strcpy((char *)p_remote[i].addr, inet_ntoa(addr[i].sin_addr));
+    }
+
+    return ret;
+}
+
 int HAL_UDP_send(_IN_ intptr_t sockfd,
                  _IN_ const unsigned char *p_data,
                  _IN_ unsigned int datalen,
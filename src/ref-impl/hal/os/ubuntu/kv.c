@@ -10,138 +10,595 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <time.h>
 #include <pthread.h>
-#include <libgen.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include "iotx_hal_internal.h"
 #include "kv.h"
 #include "cJSON.h"
 #include "base64.h"
 
+/*
+ * KV file is an append-only log of records:
+ *
+ *   magic[8] | record | record | ...
+ *   record = crc32[4] | type[1] | reserved[1] | key_len[2] | val_len[4] | key | value
+ *
+ * integers are little endian, crc covers everything after itself. All live
+ * items are kept in a hash index in memory, the log is replayed on open and
+ * a torn or corrupted tail is cut off. Writes with sync share one fdatasync
+ * (group commit), others are flushed by a worker thread which also rewrites
+ * the log once most of it is garbage.
+ */
+
+#define KV_LOG_MAGIC            "ALKVLOG1"
+#define KV_LOG_MAGIC_LEN        (8)
+#define KV_REC_HDR_LEN          (12)
+#define KV_REC_SET              (1)
+#define KV_REC_DEL              (2)
+#define KV_KEY_MAXLEN           (0xFFFF)
+#define KV_VAL_MAXLEN           (1024 * 1024)
+#define KV_HASH_INIT_SIZE       (64)
+
+#ifndef KV_SYNC_INTERVAL_MS
+    #define KV_SYNC_INTERVAL_MS     (1000)
+#endif
+
+#ifndef KV_COMPACT_MIN_SIZE
+    #define KV_COMPACT_MIN_SIZE     (16 * 1024)
+#endif
+
+typedef struct kv_item_s {
+    struct kv_item_s *next;
+    uint32_t hash;
+    uint32_t key_len;
+    uint32_t val_len;
+    char *key;                  /* '\0' terminated, value is stored right after it */
+    uint8_t *val;
+} kv_item_t;
+
 struct kv_file_s {
     char filename[128];
-    cJSON *json_root;
+    int fd;
+    off_t size;                 /* length of valid log */
+    off_t live;                 /* bytes of log still referenced by index */
 
+    kv_item_t **buckets;
+    unsigned int bucket_num;
+    unsigned int item_num;
+
+    uint64_t append_seq;        /* records written */
+    uint64_t synced_seq;        /* records known to be on disk */
+    int syncing;
+
+    int stop;
+    pthread_t worker;
     pthread_mutex_t lock;
+    pthread_cond_t synced;
+    pthread_cond_t wakeup;
 };
 
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_table_init(void)
+{
+    uint32_t i, j, c;
+
+    for (i = 0; i < 256; i++) {
+        c = i;
+        for (j = 0; j < 8; j++)
+            c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t kv_crc32(uint32_t crc, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+
+    crc = ~crc;
+    while (len--)
+        crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+static void put_u16(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t get_u16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t kv_hash(const char *key, uint32_t key_len)
+{
+    uint32_t hash = 5381;
+
+    while (key_len--)
+        hash = hash * 33 + (uint8_t)*key++;
+
+    return hash;
+}
+
 /*
- * update KV file atomically:
- *   step 1. save data in temporary file
- *   step 2. rename temporary file to the orignal one
+ * hash index
  */
-static int kv_sync(kv_file_t *file)
+static kv_item_t **index_find(kv_file_t *file, const char *key, uint32_t key_len, uint32_t hash)
+{
+    kv_item_t **pos = &file->buckets[hash & (file->bucket_num - 1)];
+
+    for (; *pos; pos = &(*pos)->next) {
+        if ((*pos)->hash == hash && (*pos)->key_len == key_len && !memcmp((*pos)->key, key, key_len))
+            break;
+    }
+
+    return pos;
+}
+
+static void index_grow(kv_file_t *file)
+{
+    unsigned int num = file->bucket_num * 2;
+    kv_item_t **buckets = calloc(num, sizeof(kv_item_t *));
+    if (!buckets)
+        return;     /* keep chaining in old table */
+
+    unsigned int i;
+    for (i = 0; i < file->bucket_num; i++) {
+        kv_item_t *item = file->buckets[i];
+        while (item) {
+            kv_item_t *next = item->next;
+            item->next = buckets[item->hash & (num - 1)];
+            buckets[item->hash & (num - 1)] = item;
+            item = next;
+        }
+    }
+
+    free(file->buckets);
+    file->buckets = buckets;
+    file->bucket_num = num;
+}
+
+static int rec_len(kv_item_t *item)
+{
+    return KV_REC_HDR_LEN + item->key_len + item->val_len;
+}
+
+/* replace or insert item, old one with same key is released */
+static void index_put(kv_file_t *file, kv_item_t *item)
+{
+    kv_item_t **pos = index_find(file, item->key, item->key_len, item->hash);
+
+    if (*pos) {
+        kv_item_t *old = *pos;
+        item->next = old->next;
+        file->live -= rec_len(old);
+        free(old);
+    } else {
+        item->next = NULL;
+        file->item_num++;
+    }
+    *pos = item;
+    file->live += rec_len(item);
+
+    if (file->item_num > file->bucket_num)
+        index_grow(file);
+}
+
+static int index_del(kv_file_t *file, const char *key, uint32_t key_len, uint32_t hash)
 {
-    char *json = cJSON_Print(file->json_root);
-    if (!json)
+    kv_item_t **pos = index_find(file, key, key_len, hash);
+    kv_item_t *item = *pos;
+
+    if (!item)
         return -1;
 
-    /* create temporary file in the same directory as orignal KV file */
-    char fullpath[128] = {0};
-    strncpy(fullpath, file->filename, sizeof(fullpath) - 1);
+    *pos = item->next;
+    file->live -= rec_len(item);
+    file->item_num--;
+    free(item);
+
+    return 0;
+}
+
+static void index_free(kv_file_t *file)
+{
+    unsigned int i;
+
+    for (i = 0; i < file->bucket_num; i++) {
+        kv_item_t *item = file->buckets[i];
+        while (item) {
+            kv_item_t *next = item->next;
+            free(item);
+            item = next;
+        }
+    }
+
+    free(file->buckets);
+    file->buckets = NULL;
+}
+
+static kv_item_t *item_new(const char *key, uint32_t key_len, const void *val, uint32_t val_len)
+{
+    kv_item_t *item = malloc(sizeof(kv_item_t) + key_len + 1 + val_len);
+    if (!item)
+        return NULL;
 
-    char *dname = dirname(fullpath);
-    char *template = "/tmpfile.XXXXXX";
+    item->hash = kv_hash(key, key_len);
+    item->key_len = key_len;
+    item->val_len = val_len;
+    item->key = (char *)(item + 1);
+    item->val = (uint8_t *)item->key + key_len + 1;
+    memcpy(item->key, key, key_len);
+    item->key[key_len] = '\0';
+    memcpy(item->val, val, val_len);
 
-    int pathlen = strlen(dname) + strlen(template) + 1;
-    if (pathlen > sizeof(fullpath)) {
-        free(json);
+    return item;
+}
+
+/*
+ * log file
+ */
+static void rec_header(uint8_t *hdr, int type, const char *key, uint32_t key_len, const void *val, uint32_t val_len)
+{
+    hdr[4] = type;
+    hdr[5] = 0;
+    put_u16(hdr + 6, key_len);
+    put_u32(hdr + 8, val_len);
+
+    uint32_t crc = kv_crc32(0, hdr + 4, KV_REC_HDR_LEN - 4);
+    crc = kv_crc32(crc, key, key_len);
+    crc = kv_crc32(crc, val, val_len);
+    put_u32(hdr, crc);
+}
+
+static int log_append(kv_file_t *file, int type, const char *key, uint32_t key_len, const void *val, uint32_t val_len)
+{
+    uint8_t hdr[KV_REC_HDR_LEN];
+    struct iovec iov[3];
+
+    rec_header(hdr, type, key, key_len, val, val_len);
+    iov[0].iov_base = hdr;
+    iov[0].iov_len = KV_REC_HDR_LEN;
+    iov[1].iov_base = (void *)key;
+    iov[1].iov_len = key_len;
+    iov[2].iov_base = (void *)val;
+    iov[2].iov_len = val_len;
+
+    ssize_t len = KV_REC_HDR_LEN + key_len + val_len;
+    if (writev(file->fd, iov, 3) != len) {
+        hal_err("kv append");
+        /* drop partial record so that later ones stay readable */
+        if (ftruncate(file->fd, file->size) < 0)
+            hal_err("kv truncate");
         return -1;
     }
 
-    if (dname == fullpath) {    /* see dirname man-page for more detail */
-        strcat(fullpath, template);
+    file->size += len;
+    file->append_seq++;
+
+    return 0;
+}
+
+/*
+ * make records appended so far durable, caller holds lock. Concurrent callers
+ * wait for the one doing fdatasync, whose sync covers their records too.
+ */
+static int log_sync(kv_file_t *file)
+{
+    uint64_t seq = file->append_seq;
+
+    while (file->synced_seq < seq) {
+        if (file->syncing) {
+            pthread_cond_wait(&file->synced, &file->lock);
+            continue;
+        }
+
+        uint64_t target = file->append_seq;
+        int fd = file->fd;
+
+        file->syncing = 1;
+        pthread_mutex_unlock(&file->lock);
+        int ret = fdatasync(fd);
+        pthread_mutex_lock(&file->lock);
+        file->syncing = 0;
+        pthread_cond_broadcast(&file->synced);
+
+        if (ret < 0) {
+            hal_err("kv fdatasync");
+            return -1;
+        }
+        if (target > file->synced_seq)
+            file->synced_seq = target;
+    }
+
+    return 0;
+}
+
+/* make a rename in the directory of @filename durable */
+static int dir_sync(const char *filename)
+{
+    char dirname[128];
+    const char *slash = strrchr(filename, '/');
+
+    if (!slash) {
+        strcpy(dirname, ".");
+    } else if (slash == filename) {
+        strcpy(dirname, "/");
     } else {
-        strcpy(fullpath, dname);
-        strcat(fullpath, template);
+        snprintf(dirname, sizeof(dirname), "%.*s", (int)(slash - filename), filename);
     }
 
-    int tmpfd = mkstemp(fullpath);
-    if (tmpfd < 0) {
-        hal_err("kv_sync open");
-        free(json);
+    int fd = open(dirname, O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
         return -1;
+
+    int ret = fsync(fd);
+    close(fd);
+
+    return ret;
+}
+
+/* write live items into a new log and switch to it, caller holds lock */
+static int log_rewrite(kv_file_t *file)
+{
+    while (file->syncing)
+        pthread_cond_wait(&file->synced, &file->lock);
+
+    off_t size = KV_LOG_MAGIC_LEN + file->live;
+    uint8_t *buf = malloc(size);
+    if (!buf)
+        return -1;
+
+    uint8_t *p = buf;
+    memcpy(p, KV_LOG_MAGIC, KV_LOG_MAGIC_LEN);
+    p += KV_LOG_MAGIC_LEN;
+
+    unsigned int i;
+    for (i = 0; i < file->bucket_num; i++) {
+        kv_item_t *item;
+        for (item = file->buckets[i]; item; item = item->next) {
+            rec_header(p, KV_REC_SET, item->key, item->key_len, item->val, item->val_len);
+            p += KV_REC_HDR_LEN;
+            memcpy(p, item->key, item->key_len);
+            p += item->key_len;
+            memcpy(p, item->val, item->val_len);
+            p += item->val_len;
+        }
     }
 
-    /* write json data into temporary file */
-    int len = strlen(json) + 1;
-    if (write(tmpfd, json, len) != len) {
-        hal_err("kv_sync write");
-        close(tmpfd);
-        free(json);
+    char tmpname[sizeof(file->filename) + 8];
+    snprintf(tmpname, sizeof(tmpname), "%s.XXXXXX", file->filename);
+
+    int fd = mkstemp(tmpname);
+    if (fd < 0) {
+        hal_err("kv rewrite open");
+        free(buf);
         return -1;
     }
 
-    fsync(tmpfd);
-    close(tmpfd);
-    free(json);
+    if (write(fd, buf, size) != size || fdatasync(fd) < 0) {
+        hal_err("kv rewrite write");
+        close(fd);
+        unlink(tmpname);
+        free(buf);
+        return -1;
+    }
+    free(buf);
 
-    /* save KV file atomically */
-    if (rename(fullpath, file->filename) < 0) {
-        hal_err("rename");
+    if (rename(tmpname, file->filename) < 0) {
+        hal_err("kv rewrite rename");
+        close(fd);
+        unlink(tmpname);
         return -1;
     }
 
+    /* new log is complete either way, only a crash right now may bring back the old one */
+    if (dir_sync(file->filename) < 0)
+        hal_err("kv rewrite dir sync");
+
+    /* mkstemp opens without O_APPEND */
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_APPEND);
+    fchmod(fd, 0644);
+
+    if (file->fd >= 0)
+        close(file->fd);
+    file->fd = fd;
+    file->size = size;
+    file->synced_seq = file->append_seq;
+
     return 0;
 }
 
-static char *read_file(char *filename)
+static int log_need_rewrite(kv_file_t *file)
 {
-    int fd = open(filename, O_RDONLY);
-    if (fd < 0)
-        return NULL;
+    return file->size >= KV_COMPACT_MIN_SIZE && file->size > 2 * (KV_LOG_MAGIC_LEN + file->live);
+}
 
+static char *read_file(int fd, off_t *size)
+{
     struct stat st;
-    if (fstat(fd, &st) < 0) {
-        close(fd);
+    if (fstat(fd, &st) < 0)
         return NULL;
-    }
 
-    char *buf = malloc(st.st_size);
-    if (!buf) {
-        close(fd);
+    char *buf = malloc(st.st_size + 1);
+    if (!buf)
         return NULL;
-    }
 
-    if (read(fd, buf, st.st_size) != st.st_size) {
+    if (pread(fd, buf, st.st_size, 0) != st.st_size) {
         free(buf);
-        close(fd);
         return NULL;
     }
-
-    close(fd);
+    buf[st.st_size] = '\0';
+    *size = st.st_size;
 
     return buf;
 }
 
-static int create_json_file(char *filename)
+/* KV file written by old versions is a JSON object of base64 encoded values */
+static int load_json(kv_file_t *file, char *json)
 {
-    int fd = open(filename, O_CREAT | O_RDWR, 0644);
-    if (fd < 0)
+    cJSON *root = cJSON_Parse(json);
+    if (!root)
         return -1;
 
-    if (write(fd, "{}", 3) != 3) {  /* 3 = '{}' + null terminator */
-        close(fd);
-        return -1;
+    cJSON *obj;
+    for (obj = root->child; obj; obj = obj->next) {
+        if (!obj->string || !obj->valuestring)
+            continue;
+
+        char *value = obj->valuestring;
+        int value_len = strlen(value);
+        int decode_len = ABase64_DecodeLen(value);
+        uint8_t *decoded = decode_len > 0 ? malloc(decode_len) : NULL;
+        if (decoded && ABase64_Decode(value, decoded, decode_len) >= 0) {
+            value = (char *)decoded;
+            value_len = decode_len;
+        }
+
+        kv_item_t *item = item_new(obj->string, strlen(obj->string), value, value_len);
+        free(decoded);
+        if (!item) {
+            cJSON_Delete(root);
+            return -1;
+        }
+        index_put(file, item);
     }
 
-    if (fsync(fd) < 0) {
-        close(fd);
-        return -1;
+    cJSON_Delete(root);
+
+    return log_rewrite(file);
+}
+
+/* replay records, anything after the last good one is cut off */
+static int load_log(kv_file_t *file, uint8_t *buf, off_t size)
+{
+    off_t off = KV_LOG_MAGIC_LEN;
+
+    while (size - off >= KV_REC_HDR_LEN) {
+        uint8_t *rec = buf + off;
+        int type = rec[4];
+        uint32_t key_len = get_u16(rec + 6);
+        uint32_t val_len = get_u32(rec + 8);
+
+        if ((type != KV_REC_SET && type != KV_REC_DEL) || val_len > KV_VAL_MAXLEN
+            || size - off - KV_REC_HDR_LEN < (off_t)key_len + val_len)
+            break;
+
+        const char *key = (char *)rec + KV_REC_HDR_LEN;
+        uint32_t crc = kv_crc32(0, rec + 4, KV_REC_HDR_LEN - 4 + key_len + val_len);
+        if (crc != get_u32(rec))
+            break;
+
+        if (type == KV_REC_SET) {
+            kv_item_t *item = item_new(key, key_len, key + key_len, val_len);
+            if (!item)
+                return -1;
+            index_put(file, item);
+        } else {
+            index_del(file, key, key_len, kv_hash(key, key_len));
+        }
+
+        off += KV_REC_HDR_LEN + key_len + val_len;
     }
 
-    close(fd);
+    if (off < size) {
+        hal_warning("kv drop %d bytes at tail of %s", (int)(size - off), file->filename);
+        if (ftruncate(file->fd, off) < 0 || fdatasync(file->fd) < 0) {
+            hal_err("kv truncate");
+            return -1;
+        }
+    }
+    file->size = off;
+
     return 0;
 }
 
+static int kv_load(kv_file_t *file)
+{
+    off_t size = 0;
+    char *buf = read_file(file->fd, &size);
+    if (!buf)
+        return -1;
+
+    int ret = -1;
+    if (size < KV_LOG_MAGIC_LEN && !memcmp(buf, KV_LOG_MAGIC, size)) {
+        /* new file, or crashed before magic reached disk */
+        if (ftruncate(file->fd, 0) == 0
+            && write(file->fd, KV_LOG_MAGIC, KV_LOG_MAGIC_LEN) == KV_LOG_MAGIC_LEN
+            && fdatasync(file->fd) == 0) {
+            file->size = KV_LOG_MAGIC_LEN;
+            ret = 0;
+        }
+    } else if (size >= KV_LOG_MAGIC_LEN && !memcmp(buf, KV_LOG_MAGIC, KV_LOG_MAGIC_LEN)) {
+        ret = load_log(file, (uint8_t *)buf, size);
+    } else if (buf[0] == '{') {
+        ret = load_json(file, buf);
+    } else {
+        hal_err("kv unknown format of %s", file->filename);
+    }
+
+    free(buf);
+
+    return ret;
+}
+
+static void *kv_worker(void *arg)
+{
+    kv_file_t *file = arg;
+
+    pthread_mutex_lock(&file->lock);
+    while (!file->stop) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += KV_SYNC_INTERVAL_MS / 1000;
+        ts.tv_nsec += (KV_SYNC_INTERVAL_MS % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&file->wakeup, &file->lock, &ts);
+
+        if (file->synced_seq < file->append_seq)
+            log_sync(file);
+        if (log_need_rewrite(file))
+            log_rewrite(file);
+    }
+    pthread_mutex_unlock(&file->lock);
+
+    return NULL;
+}
+
 kv_file_t *kv_open(char *filename)
 {
+    pthread_once(&crc_once, crc_table_init);
+
     kv_file_t *file = malloc(sizeof(kv_file_t));
     if (!file)
         return NULL;
     memset(file, 0, sizeof(kv_file_t));
+    file->fd = -1;
 
     if (strlen(filename) > sizeof(file->filename) - 1) {
         hal_err("filename %s is too long\n", filename);
@@ -150,31 +607,35 @@ kv_file_t *kv_open(char *filename)
 
     strncpy(file->filename, filename, sizeof(file->filename) - 1);
 
-    if (access(file->filename, F_OK) < 0) {
-        /* create KV file when not exist */
-        if (create_json_file(file->filename) < 0)
-            goto fail;
-    }
-
-    char *json = read_file(filename);
-    if (!json)
+    file->bucket_num = KV_HASH_INIT_SIZE;
+    file->buckets = calloc(file->bucket_num, sizeof(kv_item_t *));
+    if (!file->buckets)
         goto fail;
 
-    file->json_root = cJSON_Parse(json);
-    if (!file->json_root) {
-        free(json);
+    file->fd = open(file->filename, O_CREAT | O_RDWR | O_APPEND, 0644);
+    if (file->fd < 0)
         goto fail;
-    }
 
     pthread_mutex_init(&file->lock, NULL);
+    pthread_cond_init(&file->synced, NULL);
+    pthread_cond_init(&file->wakeup, NULL);
 
-    free(json);
+    if (kv_load(file) < 0)
+        goto fail_lock;
+
+    if (pthread_create(&file->worker, NULL, kv_worker, file) != 0)
+        goto fail_lock;
 
     return file;
 
+fail_lock:
+    pthread_cond_destroy(&file->wakeup);
+    pthread_cond_destroy(&file->synced);
+    pthread_mutex_destroy(&file->lock);
 fail:
-    if (file->json_root)
-        cJSON_Delete(file->json_root);
+    if (file->fd >= 0)
+        close(file->fd);
+    index_free(file);
     free(file);
 
     return NULL;
@@ -185,112 +646,138 @@ int kv_close(kv_file_t *file)
     if (!file)
         return -1;
 
+    pthread_mutex_lock(&file->lock);
+    file->stop = 1;
+    pthread_cond_signal(&file->wakeup);
+    pthread_mutex_unlock(&file->lock);
+    pthread_join(file->worker, NULL);
+
+    pthread_mutex_lock(&file->lock);
+    int ret = log_sync(file);
+    pthread_mutex_unlock(&file->lock);
+
+    pthread_cond_destroy(&file->wakeup);
+    pthread_cond_destroy(&file->synced);
     pthread_mutex_destroy(&file->lock);
 
-    if (file->json_root)
-        cJSON_Delete(file->json_root);
+    close(file->fd);
+    index_free(file);
     free(file);
 
-    return 0;
+    return ret;
+}
+
+static int kv_put(kv_file_t *file, char *key, const void *value, int value_len, int sync)
+{
+    uint32_t key_len = strlen(key);
+    if (key_len > KV_KEY_MAXLEN || value_len < 0 || value_len > KV_VAL_MAXLEN)
+        return -1;
+
+    kv_item_t *item = item_new(key, key_len, value, value_len);
+    if (!item)
+        return -1;
+
+    pthread_mutex_lock(&file->lock);
+    int ret = log_append(file, KV_REC_SET, key, key_len, value, value_len);
+    if (ret == 0) {
+        index_put(file, item);
+        if (log_need_rewrite(file))
+            pthread_cond_signal(&file->wakeup);
+        if (sync)
+            ret = log_sync(file);
+    } else {
+        free(item);
+    }
+    pthread_mutex_unlock(&file->lock);
+
+    return ret;
+}
+
+static kv_item_t *kv_find(kv_file_t *file, char *key)
+{
+    uint32_t key_len = strlen(key);
+
+    return *index_find(file, key, key_len, kv_hash(key, key_len));
 }
 
 int kv_get(kv_file_t *file, char *key, char *value, int value_len)
 {
-    if (!file || !file->json_root || !key || !value || value_len <= 0)
+    if (!file || !key || !value || value_len <= 0)
         return -1;
 
     pthread_mutex_lock(&file->lock);
 
-    cJSON *obj = cJSON_GetObjectItem(file->json_root, key);
-    if (!obj) {
+    kv_item_t *item = kv_find(file, key);
+    if (!item) {
         pthread_mutex_unlock(&file->lock);
         return -1;
     }
 
-    strncpy(value, obj->valuestring, value_len - 1);
-    value[value_len - 1] = '\0';
+    int len = item->val_len < value_len - 1 ? item->val_len : value_len - 1;
+    memcpy(value, item->val, len);
+    value[len] = '\0';
 
     pthread_mutex_unlock(&file->lock);
 
     return 0;
 }
 
-int kv_set(kv_file_t *file, char *key, char *value)
+int kv_set(kv_file_t *file, char *key, char *value, int sync)
 {
-    if (!file || !file->json_root || !key || !value)
+    if (!file || !key || !value)
         return -1;
 
-    pthread_mutex_lock(&file->lock);
-    /* remove old value if exist */
-    cJSON_DeleteItemFromObject(file->json_root, key);
-    cJSON_AddItemToObject(file->json_root, key, cJSON_CreateString(value));
-
-    int ret = kv_sync(file);
-    pthread_mutex_unlock(&file->lock);
-
-    return ret;
+    return kv_put(file, key, value, strlen(value), sync);
 }
 
 int kv_del(kv_file_t *file, char *key)
 {
-    if (!file || !file->json_root || !key)
+    if (!file || !key)
+        return -1;
+
+    uint32_t key_len = strlen(key);
+    if (key_len > KV_KEY_MAXLEN)
         return -1;
 
-    /* remove old value if exist */
     pthread_mutex_lock(&file->lock);
-    cJSON_DeleteItemFromObject(file->json_root, key);
-    int ret = kv_sync(file);
+    int ret = 0;
+    if (kv_find(file, key)) {
+        ret = log_append(file, KV_REC_DEL, key, key_len, NULL, 0);
+        if (ret == 0) {
+            index_del(file, key, key_len, kv_hash(key, key_len));
+            ret = log_sync(file);
+        }
+    }
     pthread_mutex_unlock(&file->lock);
 
     return ret;
 }
 
-int kv_set_blob(kv_file_t *file, char *key, void *value, int value_len)
+int kv_set_blob(kv_file_t *file, char *key, void *value, int value_len, int sync)
 {
-    int encoded_len = ABase64_EncodeLen(value_len);
-
-    char *encoded = malloc(encoded_len);
-    if (!encoded)
+    if (!file || !key || (!value && value_len))
         return -1;
 
-    ABase64_Encode(value, value_len, encoded, encoded_len);
-
-    int ret = kv_set(file, key, encoded);
-
-    free(encoded);
-
-    return ret;
+    return kv_put(file, key, value, value_len, sync);
 }
 
 int kv_get_blob(kv_file_t *file, char *key, void *value, int *value_len)
 {
-    if (!file || !file->json_root || !key || !value || !value_len || *value_len <= 0)
+    if (!file || !key || !value || !value_len || *value_len <= 0)
         return -1;
 
-    int ret = kv_get(file, key, value, *value_len);
-    if (ret < 0)
-        return ret;
-
-    int decode_len = ABase64_DecodeLen(value);
-
-    uint8_t *decoded = malloc(decode_len);
-    if (!decoded)
-        return -1;
-
-    if (ABase64_Decode(value, decoded, decode_len) < 0) {
-        free(decoded);
-        return -1;
-    }
+    pthread_mutex_lock(&file->lock);
 
-    if (decode_len > *value_len) {
-        free(decoded);
+    kv_item_t *item = kv_find(file, key);
+    if (!item || item->val_len > *value_len) {
+        pthread_mutex_unlock(&file->lock);
         return -1;
     }
 
-    memcpy(value, decoded, decode_len);
-    free(decoded);
+    memcpy(value, item->val, item->val_len);
+    *value_len = item->val_len;
 
-    *value_len = decode_len;
+    pthread_mutex_unlock(&file->lock);
 
     return 0;
 }
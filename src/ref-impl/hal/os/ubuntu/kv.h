@@ -13,9 +13,10 @@ kv_file_t *kv_open(char *filename);
 int kv_close(kv_file_t *file);
 
 int kv_get(kv_file_t *file, char *key, char *value, int value_len);
-int kv_set(kv_file_t *file, char *key, char *value);
+/* without sync, value reaches disk within KV_SYNC_INTERVAL_MS */
+int kv_set(kv_file_t *file, char *key, char *value, int sync);
 
-int kv_set_blob(kv_file_t *file, char *key, void *value, int  value_len);
+int kv_set_blob(kv_file_t *file, char *key, void *value, int  value_len, int sync);
 int kv_get_blob(kv_file_t *file, char *key, void *value, int *value_len);
 
 int kv_del(kv_file_t *file, char *key);
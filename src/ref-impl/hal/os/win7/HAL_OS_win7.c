@@ -490,6 +490,17 @@ int HAL_UDP_recvfrom(_IN_ intptr_t sockfd,
     return 0;
 }
 
+int HAL_UDP_recvfrom_batch(_IN_ intptr_t sockfd,
+                           _OU_ NetworkAddr *p_remote,
+                           _OU_ unsigned char *p_data[],
+                           _IN_ unsigned int datalen,
+                           _OU_ unsigned int *p_len,
+                           _IN_ unsigned int count,
+                           _IN_ unsigned int timeout_ms)
+{
+    return 0;
+}
+
 int HAL_UDP_joinmulticast(_IN_ intptr_t sockfd,
                           _IN_ char *p_group)
 {
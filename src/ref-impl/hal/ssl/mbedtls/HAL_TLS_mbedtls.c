@@ -17,6 +17,7 @@
     #include <netdb.h>
     #include <signal.h>
     #include <unistd.h>
+    #include <sys/select.h>
 #endif
 #include "mbedtls/error.h"
 #include "mbedtls/ssl.h"
@@ -28,6 +29,7 @@
 
 #include "iot_import.h"
 #include "iotx_hal_internal.h"
+#include "utils_atomic.h"
 
 #define SEND_TIMEOUT_SECONDS                (10)
 #define GUIDER_ONLINE_HOSTNAME              ("iot-auth.cn-shanghai.aliyuncs.com")
@@ -53,6 +55,37 @@ typedef struct {
     int size;
 } mbedtls_mem_info_t;
 
+#if defined(MBEDTLS_SSL_CLI_C)
+/*
+ * sessions of last connections, offered to server on reconnect so that
+ * it can resume by session ticket (RFC 5077) or session id, which skips
+ * certificate verify and key exchange
+ */
+#ifndef TLS_SESSION_CACHE_NUM
+    #define TLS_SESSION_CACHE_NUM           (2)
+#endif
+#define TLS_SESSION_KEY_LEN                 (80)    /* host:port */
+#define TLS_SESSION_TICKET_MAXLEN           (1024)
+
+/*
+ * TLS_SESSION_SAVE, off by default, also writes sessions through HAL_Kv_Set() so that
+ * they survive a restart. A saved session holds the master secret in plain, anyone who
+ * reads the KV store can decrypt traffic of that session and resume it as the device,
+ * so only define it where the KV store is private to the device or encrypted.
+ */
+/* bump when layout of saved session changes, records of other versions are ignored */
+#define TLS_SESSION_KV_VERSION              (1)
+
+typedef struct {
+    char key[TLS_SESSION_KEY_LEN];
+    uint64_t saved_ms;
+    mbedtls_ssl_session session;
+} tls_session_cache_t;
+
+static tls_session_cache_t g_tls_sessions[TLS_SESSION_CACHE_NUM];
+static void *g_tls_session_mutex = NULL;
+#endif
+
 static unsigned int _avRandom()
 {
     return (((unsigned int)rand() << 16) + rand());
@@ -324,6 +357,281 @@ void _SSLFree_wrapper(void *ptr)
     g_ssl_hooks.free(mem_info);
 }
 
+#if defined(MBEDTLS_SSL_CLI_C)
+/* called before any connection, so that racing ones don't each create a mutex */
+static void _ssl_session_mutex_init(void)
+{
+#if UTILS_ATOMIC_LOCK_FREE
+    void *mutex = NULL;
+
+    if (NULL != UTILS_ATOMIC_LOAD(&g_tls_session_mutex)) {
+        return;
+    }
+    mutex = HAL_MutexCreate();
+    if (NULL != mutex && !UTILS_ATOMIC_CAS(&g_tls_session_mutex, NULL, mutex)) {
+        HAL_MutexDestroy(mutex);
+    }
+#else
+    if (NULL == g_tls_session_mutex) {
+        g_tls_session_mutex = HAL_MutexCreate();
+    }
+#endif
+}
+
+static void _ssl_session_lock(void)
+{
+    if (NULL != g_tls_session_mutex) {
+        HAL_MutexLock(g_tls_session_mutex);
+    }
+}
+
+static void _ssl_session_unlock(void)
+{
+    if (NULL != g_tls_session_mutex) {
+        HAL_MutexUnlock(g_tls_session_mutex);
+    }
+}
+
+static tls_session_cache_t *_ssl_session_find(const char *key)
+{
+    int i;
+
+    for (i = 0; i < TLS_SESSION_CACHE_NUM; i++) {
+        if (g_tls_sessions[i].key[0] && !strcmp(g_tls_sessions[i].key, key)) {
+            return &g_tls_sessions[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* a free slot, or the oldest one */
+static tls_session_cache_t *_ssl_session_slot(void)
+{
+    tls_session_cache_t *item = &g_tls_sessions[0];
+    int i;
+
+    for (i = 0; i < TLS_SESSION_CACHE_NUM; i++) {
+        if (!g_tls_sessions[i].key[0]) {
+            return &g_tls_sessions[i];
+        }
+        if (g_tls_sessions[i].saved_ms < item->saved_ms) {
+            item = &g_tls_sessions[i];
+        }
+    }
+
+    return item;
+}
+
+static void _ssl_session_clear(tls_session_cache_t *item)
+{
+    mbedtls_ssl_session_free(&item->session);
+    memset(item, 0, sizeof(tls_session_cache_t));
+}
+
+#if defined(TLS_SESSION_SAVE)
+/*
+ * layout in kv: version[1] | sizeof(session)[2] | session | ticket_len[2] | ticket
+ * pointers are not kept, peer cert is not needed to resume
+ */
+#define TLS_SESSION_KV_HDR_LEN              (5)
+
+static void _ssl_session_kv_save(const char *key, const mbedtls_ssl_session *session)
+{
+    char kv_key[TLS_SESSION_KEY_LEN + 4];
+    mbedtls_ssl_session plain;
+    unsigned char *buf, *p;
+    size_t ticket_len = 0;
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    ticket_len = session->ticket_len;
+#endif
+    if (ticket_len > TLS_SESSION_TICKET_MAXLEN) {
+        return;
+    }
+
+    buf = HAL_Malloc(TLS_SESSION_KV_HDR_LEN + sizeof(mbedtls_ssl_session) + ticket_len);
+    if (NULL == buf) {
+        return;
+    }
+
+    memcpy(&plain, session, sizeof(mbedtls_ssl_session));
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    plain.peer_cert = NULL;
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    plain.ticket = NULL;
+#endif
+
+    p = buf;
+    *p++ = TLS_SESSION_KV_VERSION;
+    *p++ = (unsigned char)(sizeof(mbedtls_ssl_session) >> 8 & 0xFF);
+    *p++ = (unsigned char)(sizeof(mbedtls_ssl_session)      & 0xFF);
+    memcpy(p, &plain, sizeof(mbedtls_ssl_session));
+    p += sizeof(mbedtls_ssl_session);
+    *p++ = (unsigned char)(ticket_len >> 8 & 0xFF);
+    *p++ = (unsigned char)(ticket_len      & 0xFF);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    if (ticket_len) {
+        memcpy(p, session->ticket, ticket_len);
+        p += ticket_len;
+    }
+#endif
+
+    HAL_Snprintf(kv_key, sizeof(kv_key), "tls_%s", key);
+    HAL_Kv_Set(kv_key, buf, p - buf, 0);
+    memset(buf, 0, p - buf);
+    HAL_Free(buf);
+}
+
+static int _ssl_session_kv_load(const char *key, mbedtls_ssl_session *session)
+{
+    char kv_key[TLS_SESSION_KEY_LEN + 4];
+    int len = TLS_SESSION_KV_HDR_LEN + sizeof(mbedtls_ssl_session) + TLS_SESSION_TICKET_MAXLEN;
+    unsigned char *buf, *p;
+    size_t ticket_len;
+    int ret = -1;
+
+    buf = HAL_Malloc(len);
+    if (NULL == buf) {
+        return -1;
+    }
+
+    HAL_Snprintf(kv_key, sizeof(kv_key), "tls_%s", key);
+    if (0 != HAL_Kv_Get(kv_key, buf, &len) || len < TLS_SESSION_KV_HDR_LEN + sizeof(mbedtls_ssl_session)
+        || buf[0] != TLS_SESSION_KV_VERSION || ((buf[1] << 8) | buf[2]) != sizeof(mbedtls_ssl_session)) {
+        goto exit;
+    }
+
+    p = buf + 3;
+    memcpy(session, p, sizeof(mbedtls_ssl_session));
+    p += sizeof(mbedtls_ssl_session);
+    ticket_len = (p[0] << 8) | p[1];
+    p += 2;
+    if (len != p - buf + ticket_len) {
+        memset(session, 0, sizeof(mbedtls_ssl_session));
+        goto exit;
+    }
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    session->ticket_len = ticket_len;
+    if (ticket_len) {
+        session->ticket = mbedtls_calloc(1, ticket_len);
+        if (NULL == session->ticket) {
+            memset(session, 0, sizeof(mbedtls_ssl_session));
+            goto exit;
+        }
+        memcpy(session->ticket, p, ticket_len);
+    }
+#endif
+    ret = 0;
+
+exit:
+    memset(buf, 0, TLS_SESSION_KV_HDR_LEN + sizeof(mbedtls_ssl_session) + TLS_SESSION_TICKET_MAXLEN);
+    HAL_Free(buf);
+    return ret;
+}
+#endif  /* #if defined(TLS_SESSION_SAVE) */
+
+/* offer session of last connection to the same server, if any */
+static void _ssl_session_restore(mbedtls_ssl_context *ssl, const char *key)
+{
+    tls_session_cache_t *item;
+    int ret;
+
+    _ssl_session_lock();
+    item = _ssl_session_find(key);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    if (NULL != item && item->session.ticket_lifetime
+        && HAL_UptimeMs() - item->saved_ms > (uint64_t)item->session.ticket_lifetime * 1000) {
+        _ssl_session_clear(item);
+        item = NULL;
+    }
+#endif
+#if defined(TLS_SESSION_SAVE)
+    if (NULL == item) {
+        mbedtls_ssl_session loaded;
+
+        /* evict a cached session only for one really loaded */
+        memset(&loaded, 0, sizeof(mbedtls_ssl_session));
+        if (0 == _ssl_session_kv_load(key, &loaded)) {
+            item = _ssl_session_slot();
+            _ssl_session_clear(item);
+            memcpy(&item->session, &loaded, sizeof(mbedtls_ssl_session));
+            memset(&loaded, 0, sizeof(mbedtls_ssl_session));
+            strcpy(item->key, key);
+            item->saved_ms = HAL_UptimeMs();
+        }
+    }
+#endif
+    if (NULL != item) {
+        ret = mbedtls_ssl_set_session(ssl, &item->session);
+        hal_info("offer cached session for %s, ret = -0x%04x", key, -ret);
+    }
+    _ssl_session_unlock();
+}
+
+static void _ssl_session_store(mbedtls_ssl_context *ssl, const char *key)
+{
+    tls_session_cache_t *item;
+
+    _ssl_session_lock();
+    item = _ssl_session_find(key);
+    if (NULL == item) {
+        item = _ssl_session_slot();
+    }
+    _ssl_session_clear(item);
+
+    if (0 == mbedtls_ssl_get_session(ssl, &item->session)) {
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+        /* not needed for resumption, keep cache small */
+        if (NULL != item->session.peer_cert) {
+            mbedtls_x509_crt_free(item->session.peer_cert);
+            mbedtls_free(item->session.peer_cert);
+            item->session.peer_cert = NULL;
+        }
+#endif
+        strcpy(item->key, key);
+        item->saved_ms = HAL_UptimeMs();
+#if defined(TLS_SESSION_SAVE)
+        _ssl_session_kv_save(key, &item->session);
+#endif
+    } else {
+        _ssl_session_clear(item);
+    }
+    _ssl_session_unlock();
+}
+
+static void _ssl_session_drop(const char *key)
+{
+    tls_session_cache_t *item;
+
+    _ssl_session_lock();
+    item = _ssl_session_find(key);
+    if (NULL != item) {
+        _ssl_session_clear(item);
+    }
+#if defined(TLS_SESSION_SAVE)
+    {
+        char kv_key[TLS_SESSION_KEY_LEN + 4];
+        HAL_Snprintf(kv_key, sizeof(kv_key), "tls_%s", key);
+        HAL_Kv_Del(kv_key);
+    }
+#endif
+    _ssl_session_unlock();
+}
+
+/* only when server rejects the session or it turns out bad, not on timeout or socket error */
+static int _ssl_session_is_bad(int ret)
+{
+    return MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE == ret
+           || MBEDTLS_ERR_SSL_BAD_HS_FINISHED == ret
+           || MBEDTLS_ERR_SSL_INVALID_MAC == ret
+           || MBEDTLS_ERR_SSL_PEER_VERIFY_FAILED == ret
+           || MBEDTLS_ERR_X509_CERT_VERIFY_FAILED == ret;
+}
+#endif  /* #if defined(MBEDTLS_SSL_CLI_C) */
+
 /**
  * @brief This function connects to the specific SSL server with TLS, and returns a value that indicates whether the connection is create successfully or not. Call #NewNetwork() to initialize network structure before calling this function.
  * @param[in] n is the the network structure pointer.
@@ -347,6 +655,9 @@ static int _TLSConnectNetwork(TLSDataParams_t *pTlsData, const char *addr, const
                               const char *client_pwd, size_t client_pwd_len)
 {
     int ret = -1;
+#if defined(MBEDTLS_SSL_CLI_C)
+    char session_key[TLS_SESSION_KEY_LEN] = {0};
+#endif
     /*
      * 0. Init
      */
@@ -425,6 +736,13 @@ static int _TLSConnectNetwork(TLSDataParams_t *pTlsData, const char *addr, const
 #endif
     mbedtls_ssl_set_bio(&(pTlsData->ssl), &(pTlsData->fd), mbedtls_net_send, mbedtls_net_recv, mbedtls_net_recv_timeout);
 
+#if defined(MBEDTLS_SSL_CLI_C)
+    if (strlen(addr) + strlen(port) + 2 <= sizeof(session_key)) {
+        HAL_Snprintf(session_key, sizeof(session_key), "%s:%s", addr, port);
+        _ssl_session_restore(&(pTlsData->ssl), session_key);
+    }
+#endif
+
     /*
       * 4. Handshake
       */
@@ -433,6 +751,11 @@ static int _TLSConnectNetwork(TLSDataParams_t *pTlsData, const char *addr, const
     while ((ret = mbedtls_ssl_handshake(&(pTlsData->ssl))) != 0) {
         if ((ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE)) {
             hal_err("failed  ! mbedtls_ssl_handshake returned -0x%04x", -ret);
+#if defined(MBEDTLS_SSL_CLI_C)
+            if (session_key[0] && _ssl_session_is_bad(ret)) {
+                _ssl_session_drop(session_key);
+            }
+#endif
             return ret;
         }
     }
@@ -443,8 +766,18 @@ static int _TLSConnectNetwork(TLSDataParams_t *pTlsData, const char *addr, const
     hal_info("  . Verifying peer X.509 certificate..");
     if (0 != (ret = _real_confirm(mbedtls_ssl_get_verify_result(&(pTlsData->ssl))))) {
         hal_err(" failed  ! verify result not confirmed.");
+#if defined(MBEDTLS_SSL_CLI_C)
+        if (session_key[0]) {
+            _ssl_session_drop(session_key);
+        }
+#endif
         return ret;
     }
+#if defined(MBEDTLS_SSL_CLI_C)
+    if (session_key[0]) {
+        _ssl_session_store(&(pTlsData->ssl), session_key);
+    }
+#endif
     /* n->my_socket = (int)((n->tlsdataparams.fd).fd); */
     /* WRITE_IOT_DEBUG_LOG("my_socket=%d", n->my_socket); */
 
@@ -452,15 +785,39 @@ static int _TLSConnectNetwork(TLSDataParams_t *pTlsData, const char *addr, const
 
 }
 
+/* check whether decrypted data or raw data from socket can be read without blocking */
+static int _network_ssl_readable(TLSDataParams_t *pTlsData)
+{
+#if defined(_PLATFORM_IS_LINUX_)
+    fd_set          sets;
+    struct timeval  timeout = {0, 0};
+
+    if (mbedtls_ssl_get_bytes_avail(&(pTlsData->ssl)) > 0) {
+        return 1;
+    }
+
+    FD_ZERO(&sets);
+    FD_SET(pTlsData->fd.fd, &sets);
+    return (select(pTlsData->fd.fd + 1, &sets, NULL, NULL, &timeout) > 0) ? 1 : 0;
+#else
+    return (mbedtls_ssl_get_bytes_avail(&(pTlsData->ssl)) > 0) ? 1 : 0;
+#endif
+}
+
 static int _network_ssl_read(TLSDataParams_t *pTlsData, char *buffer, int len, int timeout_ms)
 {
     uint32_t        readLen = 0;
     static int      net_status = 0;
     int             ret = -1;
     char            err_str[33];
+    int             poll_only = (0 == timeout_ms);
 
-    mbedtls_ssl_conf_read_timeout(&(pTlsData->conf), timeout_ms);
+    /* zero 'timeout_ms' means taking data already arrived only, but zero means forever for mbedtls */
+    mbedtls_ssl_conf_read_timeout(&(pTlsData->conf), poll_only ? 1 : timeout_ms);
     while (readLen < len) {
+        if (poll_only && !_network_ssl_readable(pTlsData)) {
+            break;
+        }
         ret = mbedtls_ssl_read(&(pTlsData->ssl), (unsigned char *)(buffer + readLen), (len - readLen));
         if (ret > 0) {
             readLen += ret;
@@ -596,6 +953,9 @@ uintptr_t HAL_SSL_Establish(const char *host,
     }
     memset(pTlsData, 0x0, sizeof(TLSDataParams_t));
 
+#if defined(MBEDTLS_SSL_CLI_C)
+    _ssl_session_mutex_init();
+#endif
     sprintf(port_str, "%u", port);
 
 #if defined(ON_PRE)
@@ -720,6 +720,38 @@ void *linkkit_set_tsl(const char *tsl, int tsl_len)
     return thing_id;
 }
 
+being_deprecated void *linkkit_set_tsl_table(const void *tsl_table)
+{
+    int res = 0;
+    void *thing_id = NULL;
+    linkkit_solo_legacy_ctx_t *linkkit_solo_ctx = _linkkit_solo_legacy_get_ctx();
+
+    if (tsl_table == NULL) {
+        sdk_err("Invalid Parameter");
+        return NULL;
+    }
+
+    if (linkkit_solo_ctx->is_started == 0) {
+        return NULL;
+    }
+
+    _linkkit_solo_mutex_lock();
+    res = iotx_dm_deprecated_set_tsl_table(IOTX_DM_LOCAL_NODE_DEVID, (const struct dm_shw_table_s *)tsl_table);
+    if (res != SUCCESS_RETURN) {
+        _linkkit_solo_mutex_unlock();
+        return NULL;
+    }
+
+    res = iotx_dm_deprecated_legacy_get_thingid_by_devid(IOTX_DM_LOCAL_NODE_DEVID, &thing_id);
+    if (res != SUCCESS_RETURN) {
+        _linkkit_solo_mutex_unlock();
+        return NULL;
+    }
+
+    _linkkit_solo_mutex_unlock();
+    return thing_id;
+}
+
 int being_deprecated linkkit_set_value(linkkit_method_set_t method_set, const void *thing_id, const char *identifier,
                                        const void *value,
                                        const char *value_str)
@@ -4,7 +4,7 @@
 
 #include "sdk-impl_internal.h"
 
-#if defined(DEVICE_MODEL_ENABLED) && !defined(DEPRECATED_LINKKIT)
+#if defined(DEVICE_MODEL_ENABLED)
     #include "iotx_dm.h"
 #endif
 
@@ -185,6 +185,14 @@ int IOT_Ioctl(int option, void *data)
             res = iotx_dm_set_opt(IMPL_LINKKIT_IOCTL_SWITCH_PROPERTY_SET_REPLY, data);
         }
         break;
+        case IOTX_IOCTL_SET_PROP_POST_COALESCE: {
+            res = iotx_dm_set_opt(IMPL_LINKKIT_IOCTL_PROPERTY_POST_COALESCE, data);
+        }
+        break;
+        case IOTX_IOCTL_GET_PROP_POST_STATS: {
+            res = iotx_dm_get_opt(IMPL_LINKKIT_IOCTL_PROPERTY_POST_STATS, data);
+        }
+        break;
 #endif
         case IOTX_IOCTL_SET_SUBDEV_SIGN: {
             /* todo */
@@ -194,6 +202,18 @@ int IOT_Ioctl(int option, void *data)
             /* todo */
         }
         break;
+#endif
+#if defined(DEVICE_MODEL_ENABLED) && defined(DEPRECATED_LINKKIT)
+        case IOTX_IOCTL_SET_TSL_TABLE: {
+            iotx_ioctl_set_tsl_table_t *tsl_table = (iotx_ioctl_set_tsl_table_t *)data;
+
+            if (tsl_table->product_key == NULL) {
+                res = FAIL_RETURN;
+                break;
+            }
+            res = iotx_dm_set_tsl_table((char *)tsl_table->product_key, (const struct dm_shw_table_s *)tsl_table->tsl_table);
+        }
+        break;
 #endif
         default: {
             sdk_err("Unknown Ioctl Option");
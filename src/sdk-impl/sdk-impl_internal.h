@@ -56,6 +56,8 @@ typedef enum {
     IMPL_LINKKIT_IOCTL_SWITCH_PROPERTY_POST_REPLY,           /* only for master device, choose whether you need receive property post reply message */
     IMPL_LINKKIT_IOCTL_SWITCH_EVENT_POST_REPLY,              /* only for master device, choose whether you need receive event post reply message */
     IMPL_LINKKIT_IOCTL_SWITCH_PROPERTY_SET_REPLY,            /* only for master device, choose whether you need send property set reply message */
+    IMPL_LINKKIT_IOCTL_PROPERTY_POST_COALESCE,               /* merge property reports inside window of milliseconds, 0 disables */
+    IMPL_LINKKIT_IOCTL_PROPERTY_POST_STATS,                  /* get statistics of property report coalescing */
     IMPL_LINKKIT_IOCTL_MAX
 } impl_linkkit_ioctl_cmd_t;
 
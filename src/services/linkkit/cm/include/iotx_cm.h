@@ -112,11 +112,20 @@ typedef struct {
     void                          *cb_context;
 } iotx_cm_ext_params_t;
 
+/* topic and its handle in multi-topic subscribe */
+typedef struct {
+    const char                    *topic;
+    iotx_cm_data_handle_cb        topic_handle_func;
+    void                          *pcontext;
+    int                           result;         /* set by iotx_cm_sub_multi, 0 once subscribed */
+} iotx_cm_sub_topic_t;
+
 int iotx_cm_open(iotx_cm_init_param_t *params);
 int iotx_cm_connect(int fd, uint32_t timeout);
 int iotx_cm_yield(int fd, unsigned int timeout);
 int iotx_cm_sub(int fd, iotx_cm_ext_params_t *ext, const char *topic,
                 iotx_cm_data_handle_cb topic_handle_func, void *pcontext);
+int iotx_cm_sub_multi(int fd, iotx_cm_ext_params_t *ext, iotx_cm_sub_topic_t *topics, int count);
 int iotx_cm_unsub(int fd, const char *topic);
 int iotx_cm_pub(int fd, iotx_cm_ext_params_t *ext, const char *topic, const char *payload, unsigned int payload_len);
 int iotx_cm_close(int fd);
@@ -171,6 +171,39 @@ int iotx_cm_sub(int fd, iotx_cm_ext_params_t *ext, const char *topic,
     return sub_func(ext, topic, topic_handle_func, pcontext);
 }
 
+/* subscribe @count topics, in SUBSCRIBE packets of several topics if the connection supports */
+/* with IOTX_CM_SYNC, all requests are sent before waiting, and it returns after all of them are acknowledged */
+int iotx_cm_sub_multi(int fd, iotx_cm_ext_params_t *ext, iotx_cm_sub_topic_t *topics, int count)
+{
+    int i = 0;
+    int ret = 0;
+
+    if (_fd_is_valid(fd) == -1 || topics == NULL) {
+        CM_ERR(ERR_INVALID_PARAMS);
+        return -1;
+    }
+
+    iotx_cm_sub_fp sub_func;
+    iotx_cm_sub_multi_fp sub_multi_func;
+    HAL_MutexLock(fd_lock);
+    sub_func =  _cm_fd[fd]->sub_func;
+    sub_multi_func = _cm_fd[fd]->sub_multi_func;
+    HAL_MutexUnlock(fd_lock);
+
+    if (sub_multi_func != NULL) {
+        return sub_multi_func(ext, topics, count);
+    }
+
+    for (i = 0; i < count; i++) {
+        topics[i].result = sub_func(ext, topics[i].topic, topics[i].topic_handle_func, topics[i].pcontext) < 0 ? -1 : 0;
+        if (topics[i].result < 0) {
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
 int iotx_cm_unsub(int fd, const char *topic)
 {
     if (_fd_is_valid(fd) == -1) {
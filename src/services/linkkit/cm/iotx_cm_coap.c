@@ -387,6 +387,7 @@ static void _set_common_handlers()
     if (_coap_conncection != NULL) {
         _coap_conncection->connect_func = _coap_connect;
         _coap_conncection->sub_func = _coap_sub;
+        _coap_conncection->sub_multi_func = NULL;
         _coap_conncection->unsub_func = _coap_unsub;
         _coap_conncection->pub_func = _coap_publish;
         _coap_conncection->yield_func = _coap_yield;
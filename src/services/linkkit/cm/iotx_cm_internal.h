@@ -28,6 +28,7 @@ typedef int (*iotx_cm_connect_fp)(uint32_t timeout);
 typedef int (*iotx_cm_yield_fp)(unsigned int timeout);
 typedef int (*iotx_cm_sub_fp)(iotx_cm_ext_params_t *params, const char *topic,
                               iotx_cm_data_handle_cb topic_handle_func, void *pcontext);
+typedef int (*iotx_cm_sub_multi_fp)(iotx_cm_ext_params_t *params, iotx_cm_sub_topic_t *topics, int count);
 typedef int (*iotx_cm_unsub_fp)(const char *topic);
 typedef int (*iotx_cm_pub_fp)(iotx_cm_ext_params_t *params, const char *topic, const char *payload,
                               unsigned int payload_len);
@@ -42,6 +43,7 @@ typedef struct iotx_connection_st {
     iotx_cm_protocol_types_t         protocol_type;
     iotx_cm_connect_fp               connect_func;
     iotx_cm_sub_fp                   sub_func;
+    iotx_cm_sub_multi_fp             sub_multi_func;        /* optional, NULL if not supported */
     iotx_cm_unsub_fp                 unsub_func;
     iotx_cm_pub_fp                   pub_func;
     iotx_cm_yield_fp                 yield_func;
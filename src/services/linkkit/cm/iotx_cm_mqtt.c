@@ -15,6 +15,7 @@ static int _mqtt_publish(iotx_cm_ext_params_t *params, const char *topic, const
                          unsigned int payload_len);
 static int _mqtt_sub(iotx_cm_ext_params_t *params, const char *topic,
                      iotx_cm_data_handle_cb topic_handle_func, void *pcontext);
+static int _mqtt_sub_multi(iotx_cm_ext_params_t *params, iotx_cm_sub_topic_t *topics, int count);
 static iotx_mqtt_qos_t _get_mqtt_qos(iotx_cm_ack_types_t ack_type);
 static int _mqtt_unsub(const char *topic);
 static int _mqtt_close();
@@ -337,6 +338,77 @@ static int _mqtt_sub(iotx_cm_ext_params_t *ext, const char *topic,
     return ret;
 }
 
+static int _mqtt_sub_multi(iotx_cm_ext_params_t *ext, iotx_cm_sub_topic_t *topics, int count)
+{
+    int i = 0;
+    int qos = 0;
+    int ret = 0;
+
+    POINTER_SANITY_CHECK(_mqtt_conncection, NULL_VALUE_ERROR);
+    POINTER_SANITY_CHECK(topics, NULL_VALUE_ERROR);
+
+#ifdef MAL_ENABLED
+    for (i = 0; i < count; i++) {
+        topics[i].result = _mqtt_sub(ext, topics[i].topic, topics[i].topic_handle_func, topics[i].pcontext) < 0 ? -1 : 0;
+        if (topics[i].result < 0) {
+            ret = -1;
+        }
+    }
+#else
+    iotx_mqtt_multi_sub_t *mqtt_topics = NULL;
+
+    if (count <= 0) {
+        return 0;
+    }
+
+    for (i = 0; i < count; i++) {
+        POINTER_SANITY_CHECK(topics[i].topic, NULL_VALUE_ERROR);
+        POINTER_SANITY_CHECK(topics[i].topic_handle_func, NULL_VALUE_ERROR);
+    }
+
+    if (ext != NULL) {
+        qos = (int)_get_mqtt_qos(ext->ack_type);
+    }
+
+    mqtt_topics = cm_malloc(count * sizeof(iotx_mqtt_multi_sub_t));
+    if (mqtt_topics == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        mqtt_topics[i].topic_filter = topics[i].topic;
+        mqtt_topics[i].qos = qos;
+        mqtt_topics[i].topic_handle_func = iotx_cloud_conn_mqtt_event_handle;
+        mqtt_topics[i].pcontext = topics[i].topic_handle_func;
+        mqtt_topics[i].result = -1;
+    }
+
+    if (ext != NULL && ext->sync_mode == IOTX_CM_SYNC) {
+        ret = IOT_MQTT_Subscribe_Multi_Sync(_mqtt_conncection->context, mqtt_topics, count, ext->sync_timeout);
+    } else {
+        for (i = 0; i < count; i += MUTLI_SUBSCIRBE_MAX) {
+            int j, num = LITE_MINIMUM(MUTLI_SUBSCIRBE_MAX, count - i);
+            int res = IOT_MQTT_Subscribe_Multi(_mqtt_conncection->context, &mqtt_topics[i], num) < 0 ? -1 : 0;
+
+            for (j = i; j < i + num; j++) {
+                mqtt_topics[j].result = res;
+            }
+            if (res < 0) {
+                ret = -1;
+            }
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        topics[i].result = mqtt_topics[i].result;
+    }
+
+    cm_free(mqtt_topics);
+#endif
+
+    return ret;
+}
+
 static int _mqtt_unsub(const char *topic)
 {
     int ret;
@@ -381,6 +453,7 @@ static void _set_common_handlers()
     if (_mqtt_conncection != NULL) {
         _mqtt_conncection->connect_func = _mqtt_connect;
         _mqtt_conncection->sub_func = _mqtt_sub;
+        _mqtt_conncection->sub_multi_func = _mqtt_sub_multi;
         _mqtt_conncection->unsub_func = _mqtt_unsub;
         _mqtt_conncection->pub_func = _mqtt_publish;
         _mqtt_conncection->yield_func = (iotx_cm_yield_fp)_mqtt_yield;
@@ -28,6 +28,9 @@ static dm_client_uri_map_t g_dm_client_uri_map[] = {
     {DM_URI_THING_DISABLE,                    DM_URI_SYS_PREFIX,         IOTX_DM_DEVICE_GATEWAY, (void *)dm_client_thing_disable                      },
     {DM_URI_THING_ENABLE,                     DM_URI_SYS_PREFIX,         IOTX_DM_DEVICE_GATEWAY, (void *)dm_client_thing_enable                       },
     {DM_URI_THING_DELETE,                     DM_URI_SYS_PREFIX,         IOTX_DM_DEVICE_GATEWAY, (void *)dm_client_thing_delete                       },
+#if !defined(DEVICE_MODEL_RAWDATA_SOLO)
+    {DM_URI_THING_EVENT_PROPERTY_PACK_POST_REPLY, DM_URI_SYS_PREFIX,     IOTX_DM_DEVICE_GATEWAY, (void *)dm_client_thing_event_post_reply             },
+#endif
 #endif
 };
 
@@ -40,8 +43,13 @@ static int _dm_client_subscribe_filter(char *uri, char *uri_name, char product_k
 
 #if !defined(DEVICE_MODEL_RAWDATA_SOLO)
     int res = 0;
-    if (strlen(uri_name) == strlen(DM_URI_THING_EVENT_POST_REPLY_WILDCARD) &&
-        memcmp(uri_name, DM_URI_THING_EVENT_POST_REPLY_WILDCARD, strlen(uri_name)) == 0) {
+    if ((strlen(uri_name) == strlen(DM_URI_THING_EVENT_POST_REPLY_WILDCARD) &&
+         memcmp(uri_name, DM_URI_THING_EVENT_POST_REPLY_WILDCARD, strlen(uri_name)) == 0)
+#ifdef DEVICE_MODEL_GATEWAY
+        || (strlen(uri_name) == strlen(DM_URI_THING_EVENT_PROPERTY_PACK_POST_REPLY) &&
+            memcmp(uri_name, DM_URI_THING_EVENT_PROPERTY_PACK_POST_REPLY, strlen(uri_name)) == 0)
+#endif
+       ) {
         int event_post_reply_opt = 0;
         res = dm_opt_get(DM_OPT_DOWNSTREAM_EVENT_POST_REPLY, &event_post_reply_opt);
         if (res == SUCCESS_RETURN && event_post_reply_opt == 0) {
@@ -56,9 +64,16 @@ static int _dm_client_subscribe_filter(char *uri, char *uri_name, char product_k
 
 int dm_client_subscribe_all(char product_key[PRODUCT_KEY_MAXLEN], char device_name[DEVICE_NAME_MAXLEN], int dev_type)
 {
-    int res = 0, index = 0, fail_count = 0;
+    int res = 0, index = 0, count = 0, retry = 0, failed = 0;
     int number = sizeof(g_dm_client_uri_map) / sizeof(dm_client_uri_map_t);
     char *uri = NULL;
+    iotx_cm_sub_topic_t *topics = NULL;
+
+    topics = DM_malloc(number * sizeof(iotx_cm_sub_topic_t));
+    if (topics == NULL) {
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+    memset(topics, 0, number * sizeof(iotx_cm_sub_topic_t));
 
     for (index = 0; index < number; index++) {
         if ((g_dm_client_uri_map[index].dev_type & dev_type) == 0) {
@@ -66,14 +81,9 @@ int dm_client_subscribe_all(char product_key[PRODUCT_KEY_MAXLEN], char device_na
         }
         dm_log_info("index: %d", index);
 
-        if (fail_count >= IOTX_DM_CLIENT_SUB_RETRY_MAX_COUNTS) {
-            fail_count = 0;
-            continue;
-        }
         res = dm_utils_service_name((char *)g_dm_client_uri_map[index].uri_prefix, (char *)g_dm_client_uri_map[index].uri_name,
                                     product_key, device_name, &uri);
         if (res < SUCCESS_RETURN) {
-            index--;
             continue;
         }
         res = _dm_client_subscribe_filter(uri, (char *)g_dm_client_uri_map[index].uri_name, product_key, device_name);
@@ -82,17 +92,32 @@ int dm_client_subscribe_all(char product_key[PRODUCT_KEY_MAXLEN], char device_na
             continue;
         }
 
-        res = dm_client_subscribe(uri, (void *)g_dm_client_uri_map[index].callback, NULL);
-        if (res < SUCCESS_RETURN) {
-            index--;
-            fail_count++;
-            DM_free(uri);
-            continue;
+        topics[count].topic = uri;
+        topics[count].topic_handle_func = (iotx_cm_data_handle_cb)g_dm_client_uri_map[index].callback;
+        topics[count].pcontext = NULL;
+        topics[count].result = -1;
+        count++;
+    }
+
+    /* all topics are subscribed in pipeline, retry the failed ones only */
+    for (retry = 0; retry < IOTX_DM_CLIENT_SUB_RETRY_MAX_COUNTS && count > 0; retry++) {
+        res = dm_client_subscribe_multi(topics, count);
+        for (index = 0, failed = 0; index < count; index++) {
+            if (res >= SUCCESS_RETURN || topics[index].result == 0) {
+                uri = (char *)topics[index].topic;
+                DM_free(uri);
+            } else {
+                topics[failed++] = topics[index];
+            }
         }
+        count = failed;
+    }
 
-        fail_count = 0;
+    for (index = 0; index < count; index++) {
+        uri = (char *)topics[index].topic;
         DM_free(uri);
     }
+    DM_free(topics);
 
     return SUCCESS_RETURN;
 }
@@ -82,6 +82,29 @@ int dm_client_subscribe(char *uri, iotx_cm_data_handle_cb callback, void *contex
     return SUCCESS_RETURN;
 }
 
+int dm_client_subscribe_multi(iotx_cm_sub_topic_t *topics, int count)
+{
+    int res = 0;
+    dm_client_ctx_t *ctx = dm_client_get_ctx();
+    iotx_cm_ext_params_t sub_params;
+
+    memset(&sub_params, 0, sizeof(iotx_cm_ext_params_t));
+
+    sub_params.ack_type = IOTX_CM_MESSAGE_NO_ACK;
+    sub_params.sync_mode = IOTX_CM_SYNC;
+    sub_params.sync_timeout = IOTX_DM_CLIENT_SUB_TIMEOUT_MS;
+    sub_params.ack_cb = NULL;
+
+    res = iotx_cm_sub_multi(ctx->fd, &sub_params, topics, count);
+    dm_log_info("Subscribe %d Topics Result: %d", count, res);
+
+    if (res < SUCCESS_RETURN) {
+        return res;
+    }
+
+    return SUCCESS_RETURN;
+}
+
 int dm_client_unsubscribe(char *uri)
 {
     int res = 0;
@@ -11,6 +11,7 @@ int dm_client_open(void);
 int dm_client_connect(int timeout_ms);
 int dm_client_close(void);
 int dm_client_subscribe(char *uri, iotx_cm_data_handle_cb callback, void *context);
+int dm_client_subscribe_multi(iotx_cm_sub_topic_t *topics, int count);
 int dm_client_unsubscribe(char *uri);
 int dm_client_publish(char *uri, unsigned char *payload, int payload_len, iotx_cm_data_handle_cb callback);
 int dm_client_yield(unsigned int timeout);
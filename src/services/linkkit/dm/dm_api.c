@@ -65,6 +65,11 @@ int iotx_dm_open(void)
         goto ERROR;
     }
 #endif
+#if !defined(DEVICE_MODEL_RAWDATA_SOLO)
+    /* DM Property Report Coalescing Init */
+    dm_coalesce_init();
+#endif
+
     /* DM Cloud Message Parse And Assemble Module Init */
     res = dm_msg_init();
     if (res != SUCCESS_RETURN) {
@@ -118,6 +123,9 @@ ERROR:
     dm_mgr_deinit();
     dm_ipc_deinit();
     dm_msg_deinit();
+#if !defined(DEVICE_MODEL_RAWDATA_SOLO)
+    dm_coalesce_deinit();
+#endif
 #if !defined(DM_MESSAGE_CACHE_DISABLED)
     dm_msg_cache_deinit();
 #endif
@@ -209,6 +217,13 @@ int iotx_dm_close(void)
 {
     dm_api_ctx_t *ctx = _dm_api_get_ctx();
 
+#if !defined(DEVICE_MODEL_RAWDATA_SOLO)
+    /* Send Pending Coalesced Property Before Connection Closed */
+    _dm_api_lock();
+    dm_coalesce_flush();
+    _dm_api_unlock();
+#endif
+
     dm_client_close();
 #ifdef ALCS_ENABLED
     dm_server_close();
@@ -216,6 +231,9 @@ int iotx_dm_close(void)
     dm_mgr_deinit();
     dm_ipc_deinit();
     dm_msg_deinit();
+#if !defined(DEVICE_MODEL_RAWDATA_SOLO)
+    dm_coalesce_deinit();
+#endif
 #if !defined(DM_MESSAGE_CACHE_DISABLED)
     dm_msg_cache_deinit();
 #endif
@@ -248,29 +266,29 @@ int iotx_dm_yield(int timeout_ms)
 void iotx_dm_dispatch(void)
 {
     int count = 0;
-    void *data = NULL;
+    dm_ipc_msg_t *msg = NULL;
     dm_api_ctx_t *ctx = _dm_api_get_ctx();
 
 #if !defined(DM_MESSAGE_CACHE_DISABLED)
     dm_msg_cache_tick();
 #endif
+#if !defined(DEVICE_MODEL_RAWDATA_SOLO)
+    _dm_api_lock();
+    dm_coalesce_tick();
+    _dm_api_unlock();
+#endif
 #if defined(OTA_ENABLED) && !defined(BUILD_AOS)
     dm_cota_status_check();
     dm_fota_status_check();
 #endif
     while (CONFIG_DISPATCH_QUEUE_MAXLEN == 0 || count++ < CONFIG_DISPATCH_QUEUE_MAXLEN) {
-        if (dm_ipc_msg_next(&data) == SUCCESS_RETURN) {
-            dm_ipc_msg_t *msg = (dm_ipc_msg_t *)data;
-
+        if (dm_ipc_msg_next(&msg) == SUCCESS_RETURN) {
             if (ctx->event_callback) {
                 ctx->event_callback(msg->type, msg->data);
             }
 
-            if (msg->data) {
-                DM_free(msg->data);
-            }
-            DM_free(msg);
-            data = NULL;
+            dm_ipc_msg_release(msg);
+            msg = NULL;
         } else {
             break;
         }
@@ -300,16 +318,39 @@ int iotx_dm_post_rawdata(_IN_ int devid, _IN_ char *payload, _IN_ int payload_le
 #if !defined(DEVICE_MODEL_RAWDATA_SOLO)
 int iotx_dm_set_opt(int opt, void *data)
 {
-    return dm_opt_set(opt, data);
+    int res = 0;
+
+    if (opt != DM_OPT_UPSTREAM_PROPERTY_POST_COALESCE) {
+        return dm_opt_set(opt, data);
+    }
+
+    /* Pending Reports Belong To Old Window */
+    _dm_api_lock();
+    dm_coalesce_flush();
+    res = dm_opt_set(opt, data);
+    _dm_api_unlock();
+
+    return res;
 }
 
 int iotx_dm_get_opt(int opt, void *data)
 {
+    int res = 0;
+
     if (data == NULL) {
         return FAIL_RETURN;
     }
 
-    return dm_opt_get(opt, data);
+    if (opt != DM_OPT_UPSTREAM_PROPERTY_POST_STATS) {
+        return dm_opt_get(opt, data);
+    }
+
+    /* Stats Are Updated By Posts Under Api Lock */
+    _dm_api_lock();
+    res = dm_opt_get(opt, data);
+    _dm_api_unlock();
+
+    return res;
 }
 
 int iotx_dm_post_property(_IN_ int devid, _IN_ char *payload, _IN_ int payload_len)
@@ -318,7 +359,11 @@ int iotx_dm_post_property(_IN_ int devid, _IN_ char *payload, _IN_ int payload_l
 
     _dm_api_lock();
 
-    res = dm_mgr_upstream_thing_property_post(devid, payload, payload_len);
+    if (dm_coalesce_enabled()) {
+        res = dm_coalesce_property_post(devid, payload, payload_len);
+    } else {
+        res = dm_mgr_upstream_thing_property_post(devid, payload, payload_len);
+    }
     if (res < SUCCESS_RETURN) {
         _dm_api_unlock();
         return FAIL_RETURN;
@@ -830,6 +875,36 @@ int iotx_dm_deprecated_set_tsl(_IN_ int devid, _IN_ iotx_dm_tsl_source_t source,
     return FAIL_RETURN;
 }
 
+int iotx_dm_set_tsl_table(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ const struct dm_shw_table_s *table)
+{
+    int res = 0;
+
+    if (product_key == NULL || strlen(product_key) >= PRODUCT_KEY_MAXLEN) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    _dm_api_lock();
+    res = dm_mgr_set_tsl_table(product_key, table);
+    _dm_api_unlock();
+
+    return res;
+}
+
+int iotx_dm_deprecated_set_tsl_table(_IN_ int devid, _IN_ const struct dm_shw_table_s *table)
+{
+    int res = 0;
+
+    if (devid < 0 || table == NULL) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    _dm_api_lock();
+    res = dm_mgr_deprecated_set_tsl_table(devid, table);
+    _dm_api_unlock();
+
+    return res;
+}
+
 int iotx_dm_deprecated_set_property_value(_IN_ int devid, _IN_ char *key, _IN_ int key_len, _IN_ void *value,
         _IN_ int value_len)
 {
@@ -994,14 +1069,9 @@ int iotx_dm_deprecated_post_property_start(_IN_ int devid, _OU_ void **handle)
     /* Set Devid */
     dapi_property->devid = devid;
 
-    /* Init Json Object */
-    dapi_property->lite = lite_cjson_create_object();
-    if (dapi_property->lite == NULL) {
-        DM_free(dapi_property->mutex);
-        DM_free(dapi_property);
-        _dm_api_unlock();
-        return FAIL_RETURN;
-    }
+    /* Init Json Writer */
+    dm_utils_json_writer_init(&dapi_property->writer, NULL, 0);
+    dm_utils_json_writer_object_begin(&dapi_property->writer, NULL);
 
     *handle = (void *)dapi_property;
 
@@ -1020,7 +1090,7 @@ static int _iotx_dm_deprecated_post_property_add(_IN_ void *handle, _IN_ char *i
     dapi_property = (dm_api_property_t *)handle;
 
     /* Assemble Property Payload */
-    res = dm_mgr_deprecated_assemble_property(dapi_property->devid, identifier, identifier_len, dapi_property->lite);
+    res = dm_mgr_deprecated_assemble_property(dapi_property->devid, identifier, identifier_len, &dapi_property->writer);
     if (res != SUCCESS_RETURN) {
         return FAIL_RETURN;
     }
@@ -1085,7 +1155,7 @@ int iotx_dm_deprecated_post_property_add(_IN_ void *handle, _IN_ char *identifie
 
 int iotx_dm_deprecated_post_property_end(_IN_ void **handle)
 {
-    int res = 0;
+    int res = 0, payload_len = 0;
     char *payload = NULL;
     dm_api_property_t *dapi_property = NULL;
 
@@ -1096,23 +1166,24 @@ int iotx_dm_deprecated_post_property_end(_IN_ void **handle)
     _dm_api_lock();
     dapi_property = *((dm_api_property_t **)handle);
 
-    payload = lite_cjson_print_unformatted(dapi_property->lite);
-    if (payload == NULL) {
-        lite_cjson_delete(dapi_property->lite);
+    dm_utils_json_writer_object_end(&dapi_property->writer);
+    res = dm_utils_json_writer_finish(&dapi_property->writer, &payload, &payload_len);
+    dm_utils_json_writer_deinit(&dapi_property->writer);
+    if (res != SUCCESS_RETURN) {
         if (dapi_property->mutex) {
             HAL_MutexDestroy(dapi_property->mutex);
         }
         DM_free(dapi_property);
+        *handle = NULL;
         _dm_api_unlock();
         return DM_MEMORY_NOT_ENOUGH;
     }
 
-    dm_log_debug("Current Property Post Payload, Length: %d, Payload: %s", strlen(payload), payload);
+    dm_log_debug("Current Property Post Payload, Length: %d, Payload: %s", payload_len, payload);
 
-    res = dm_mgr_upstream_thing_property_post(dapi_property->devid, payload, strlen(payload));
+    res = dm_mgr_upstream_thing_property_post(dapi_property->devid, payload, payload_len);
 
     DM_free(payload);
-    lite_cjson_delete(dapi_property->lite);
     if (dapi_property->mutex) {
         HAL_MutexDestroy(dapi_property->mutex);
     }
@@ -1125,37 +1196,34 @@ int iotx_dm_deprecated_post_property_end(_IN_ void **handle)
 
 int iotx_dm_deprecated_post_event(_IN_ int devid, _IN_ char *identifier, _IN_ int identifier_len)
 {
-    int res = 0;
+    int res = 0, payload_len = 0;
     void *event = NULL;
-    lite_cjson_item_t *lite = NULL;
     char *method = NULL, *payload = NULL;
+    dm_utils_json_writer_t writer;
 
     if (devid < 0 || identifier == NULL || identifier_len <= 0) {
         return DM_INVALID_PARAMETER;
     }
 
     _dm_api_lock();
-    lite = lite_cjson_create_object();
-    if (lite == NULL) {
-        _dm_api_unlock();
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-
-    res = dm_mgr_deprecated_assemble_event_output(devid, identifier, identifier_len, lite);
+    dm_utils_json_writer_init(&writer, NULL, 0);
+    dm_utils_json_writer_object_begin(&writer, NULL);
+    res = dm_mgr_deprecated_assemble_event_output(devid, identifier, identifier_len, &writer);
     if (res != SUCCESS_RETURN) {
-        lite_cjson_delete(lite);
+        dm_utils_json_writer_deinit(&writer);
         _dm_api_unlock();
         return FAIL_RETURN;
     }
 
-    payload = lite_cjson_print_unformatted(lite);
-    lite_cjson_delete(lite);
-    if (payload == NULL) {
+    dm_utils_json_writer_object_end(&writer);
+    res = dm_utils_json_writer_finish(&writer, &payload, &payload_len);
+    dm_utils_json_writer_deinit(&writer);
+    if (res != SUCCESS_RETURN) {
         _dm_api_unlock();
         return DM_MEMORY_NOT_ENOUGH;
     }
 
-    dm_log_debug("Current Event Post Payload, Length: %d, Payload: %s", strlen(payload), payload);
+    dm_log_debug("Current Event Post Payload, Length: %d, Payload: %s", payload_len, payload);
 
     res = dm_mgr_deprecated_get_event_by_identifier(devid, identifier, &event);
     if (res != SUCCESS_RETURN) {
@@ -1173,7 +1241,7 @@ int iotx_dm_deprecated_post_event(_IN_ int devid, _IN_ char *identifier, _IN_ in
 
     dm_log_debug("Current Event Method: %s", method);
 
-    res = dm_mgr_upstream_thing_event_post(devid, identifier, identifier_len, method, payload, strlen(payload));
+    res = dm_mgr_upstream_thing_event_post(devid, identifier, identifier_len, method, payload, payload_len);
 
     DM_free(payload);
     DM_free(method);
@@ -1887,39 +1955,36 @@ int iotx_dm_deprecated_send_service_response(_IN_ int devid, _IN_ int msgid, _IN
         _IN_ char *identifier,
         _IN_ int identifier_len)
 {
-    int res = 0;
-    lite_cjson_item_t *lite = NULL;
+    int res = 0, payload_len = 0;
     char *payload = NULL;
+    dm_utils_json_writer_t writer;
 
     if (devid < 0 || msgid < 0 || identifier == NULL || identifier_len <= 0) {
         return DM_INVALID_PARAMETER;
     }
 
     _dm_api_lock();
-    lite = lite_cjson_create_object();
-    if (lite == NULL) {
-        _dm_api_unlock();
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-
-    res = dm_mgr_deprecated_assemble_service_output(devid, identifier, identifier_len, lite);
+    dm_utils_json_writer_init(&writer, NULL, 0);
+    dm_utils_json_writer_object_begin(&writer, NULL);
+    res = dm_mgr_deprecated_assemble_service_output(devid, identifier, identifier_len, &writer);
     if (res != SUCCESS_RETURN) {
-        lite_cjson_delete(lite);
+        dm_utils_json_writer_deinit(&writer);
         _dm_api_unlock();
         return FAIL_RETURN;
     }
 
-    payload = lite_cjson_print_unformatted(lite);
-    lite_cjson_delete(lite);
-    if (payload == NULL) {
+    dm_utils_json_writer_object_end(&writer);
+    res = dm_utils_json_writer_finish(&writer, &payload, &payload_len);
+    dm_utils_json_writer_deinit(&writer);
+    if (res != SUCCESS_RETURN) {
         _dm_api_unlock();
         return DM_MEMORY_NOT_ENOUGH;
     }
 
-    dm_log_debug("Current Service Response Payload, Length: %d, Payload: %s", strlen(payload), payload);
+    dm_log_debug("Current Service Response Payload, Length: %d, Payload: %s", payload_len, payload);
 
     res = dm_mgr_deprecated_upstream_thing_service_response(devid, msgid, code, identifier, identifier_len, payload,
-            strlen(payload));
+            payload_len);
 
     DM_free(payload);
 
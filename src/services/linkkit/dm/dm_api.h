@@ -21,7 +21,7 @@ typedef struct {
 typedef struct {
     void *mutex;
     int devid;
-    lite_cjson_item_t *lite;
+    dm_utils_json_writer_t writer;
 } dm_api_property_t;
 #endif
 
@@ -0,0 +1,499 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+#if !defined(DEVICE_MODEL_RAWDATA_SOLO)
+#include "iotx_dm_internal.h"
+
+/*
+ * Property reports inside one window are merged per devid, last writer wins per property,
+ * and sent as one thing.event.property.post. On gateway, reports of several devices in the
+ * same window are sent together as one thing.event.property.pack.post.
+ */
+
+static dm_coalesce_ctx_t g_dm_coalesce_ctx;
+
+static dm_coalesce_ctx_t *_dm_coalesce_get_ctx(void)
+{
+    return &g_dm_coalesce_ctx;
+}
+
+/* bytes one property takes in params: "key":value, */
+static int _dm_coalesce_prop_len(_IN_ dm_coalesce_prop_t *prop)
+{
+    int len = strlen(prop->key) + prop->value_len + 4;
+
+#ifdef DEVICE_MODEL_GATEWAY
+    /* {"value":,"time":} around value in pack */
+    len += 18 + DM_UTILS_UINT64_STRLEN;
+#endif
+
+    return len;
+}
+
+static void _dm_coalesce_node_free(_IN_ dm_coalesce_node_t *node)
+{
+    int index = 0;
+
+    for (index = 0; index < node->prop_num; index++) {
+        DM_free(node->props[index].key);
+    }
+    if (node->props) {
+        DM_free(node->props);
+    }
+    list_del(&node->linked_list);
+    DM_free(node);
+}
+
+static void _dm_coalesce_reset(void)
+{
+    dm_coalesce_ctx_t *ctx = _dm_coalesce_get_ctx();
+    dm_coalesce_node_t *node = NULL, *next = NULL;
+
+    list_for_each_entry_safe(node, next, &ctx->node_list, linked_list, dm_coalesce_node_t) {
+        _dm_coalesce_node_free(node);
+    }
+    ctx->msgid = -1;
+    ctx->payload_len = 0;
+    ctx->node_num = 0;
+}
+
+int dm_coalesce_init(void)
+{
+    dm_coalesce_ctx_t *ctx = _dm_coalesce_get_ctx();
+
+    memset(ctx, 0, sizeof(dm_coalesce_ctx_t));
+    ctx->msgid = -1;
+    INIT_LIST_HEAD(&ctx->node_list);
+
+    return SUCCESS_RETURN;
+}
+
+int dm_coalesce_deinit(void)
+{
+    dm_coalesce_ctx_t *ctx = _dm_coalesce_get_ctx();
+
+    if (ctx->node_list.next == NULL) {
+        return SUCCESS_RETURN;
+    }
+    _dm_coalesce_reset();
+
+    return SUCCESS_RETURN;
+}
+
+int dm_coalesce_enabled(void)
+{
+    int window_ms = 0;
+
+    if (dm_opt_get(DM_OPT_UPSTREAM_PROPERTY_POST_COALESCE, &window_ms) != SUCCESS_RETURN) {
+        return 0;
+    }
+
+    return (window_ms > 0) ? (1) : (0);
+}
+
+static int _dm_coalesce_node_search(_IN_ int devid, _OU_ dm_coalesce_node_t **node)
+{
+    dm_coalesce_ctx_t *ctx = _dm_coalesce_get_ctx();
+    dm_coalesce_node_t *search_node = NULL;
+
+    list_for_each_entry(search_node, &ctx->node_list, linked_list, dm_coalesce_node_t) {
+        if (search_node->devid == devid) {
+            *node = search_node;
+            return SUCCESS_RETURN;
+        }
+    }
+
+    return FAIL_RETURN;
+}
+
+/* "key\0value\0" of one property, value keeps quotes of string */
+static char *_dm_coalesce_prop_text(_IN_ lite_cjson_t *key, _IN_ lite_cjson_t *value)
+{
+    char *raw = value->value;
+    int raw_len = value->value_length;
+    char *text = NULL;
+
+    /* value text of lite_cjson string starts after quote */
+    if (lite_cjson_is_string(value)) {
+        raw--;
+        raw_len += 2;
+    }
+
+    text = DM_malloc(key->value_length + 1 + raw_len + 1);
+    if (text == NULL) {
+        return NULL;
+    }
+    memcpy(text, key->value, key->value_length);
+    text[key->value_length] = '\0';
+    memcpy(text + key->value_length + 1, raw, raw_len);
+    text[key->value_length + 1 + raw_len] = '\0';
+
+    return text;
+}
+
+/* make room for @num more properties in @node */
+static int _dm_coalesce_prop_reserve(_IN_ dm_coalesce_node_t *node, _IN_ int num)
+{
+    int size = (node->prop_size == 0) ? (4) : (node->prop_size);
+    dm_coalesce_prop_t *props = NULL;
+
+    if (node->prop_num + num <= node->prop_size) {
+        return SUCCESS_RETURN;
+    }
+
+    while (size < node->prop_num + num) {
+        size *= 2;
+    }
+    props = DM_malloc(size * sizeof(dm_coalesce_prop_t));
+    if (props == NULL) {
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+    memset(props, 0, size * sizeof(dm_coalesce_prop_t));
+    if (node->props) {
+        memcpy(props, node->props, node->prop_num * sizeof(dm_coalesce_prop_t));
+        DM_free(node->props);
+    }
+    node->props = props;
+    node->prop_size = size;
+
+    return SUCCESS_RETURN;
+}
+
+/* replace value of same key or append @text as new property, room is reserved already, payload_len of ctx is adjusted */
+static void _dm_coalesce_prop_merge(_IN_ dm_coalesce_node_t *node, _IN_ char *text)
+{
+    dm_coalesce_ctx_t *ctx = _dm_coalesce_get_ctx();
+    dm_coalesce_prop_t *prop = NULL;
+    int index = 0;
+
+    for (index = 0; index < node->prop_num; index++) {
+        if (strcmp(node->props[index].key, text) == 0) {
+            prop = &node->props[index];
+            ctx->payload_len -= _dm_coalesce_prop_len(prop);
+            DM_free(prop->key);
+            ctx->stats.overwritten++;
+            break;
+        }
+    }
+
+    if (prop == NULL) {
+        prop = &node->props[node->prop_num++];
+    }
+
+    prop->key = text;
+    prop->value = text + strlen(text) + 1;
+    prop->value_len = strlen(prop->value);
+#ifdef DEVICE_MODEL_GATEWAY
+    prop->time = HAL_UTC_Get();
+#endif
+    ctx->payload_len += _dm_coalesce_prop_len(prop);
+}
+
+static void _dm_coalesce_write_props(_IN_ dm_utils_json_writer_t *writer, _IN_ dm_coalesce_node_t *node, _IN_ int pack)
+{
+    int index = 0;
+    dm_coalesce_prop_t *prop = NULL;
+
+    for (index = 0; index < node->prop_num; index++) {
+        prop = &node->props[index];
+#ifdef DEVICE_MODEL_GATEWAY
+        if (pack) {
+            char time[DM_UTILS_UINT64_STRLEN + 1] = {0};
+
+            HAL_Snprintf(time, sizeof(time), "%lld", prop->time);
+            dm_utils_json_writer_escaped_object_begin(writer, prop->key);
+            dm_utils_json_writer_raw(writer, "value", prop->value, prop->value_len);
+            dm_utils_json_writer_raw(writer, "time", time, strlen(time));
+            dm_utils_json_writer_object_end(writer);
+            continue;
+        }
+#endif
+        dm_utils_json_writer_escaped_raw(writer, prop->key, prop->value, prop->value_len);
+    }
+}
+
+static int _dm_coalesce_post(_IN_ int msgid, _IN_ dm_coalesce_node_t *node)
+{
+    int res = 0, payload_len = 0;
+    char *payload = NULL;
+    dm_utils_json_writer_t writer;
+
+    dm_utils_json_writer_init(&writer, NULL, _dm_coalesce_get_ctx()->payload_len + 2);
+    dm_utils_json_writer_object_begin(&writer, NULL);
+    _dm_coalesce_write_props(&writer, node, 0);
+    dm_utils_json_writer_object_end(&writer);
+    res = dm_utils_json_writer_finish(&writer, &payload, &payload_len);
+    dm_utils_json_writer_deinit(&writer);
+    if (res != SUCCESS_RETURN) {
+        return res;
+    }
+
+    res = dm_mgr_upstream_thing_property_post_coalesced(msgid, node->devid, payload, payload_len);
+    DM_free(payload);
+
+    return res;
+}
+
+#ifdef DEVICE_MODEL_GATEWAY
+/* {"properties":{...},"subDevices":[{"identity":{"productKey":"","deviceName":""},"properties":{...}}]} */
+static int _dm_coalesce_pack_post(_IN_ int msgid)
+{
+    dm_coalesce_ctx_t *ctx = _dm_coalesce_get_ctx();
+    dm_coalesce_node_t *node = NULL;
+    int res = 0, payload_len = 0;
+    char *payload = NULL;
+    char product_key[PRODUCT_KEY_MAXLEN] = {0};
+    char device_name[DEVICE_NAME_MAXLEN] = {0};
+    char device_secret[DEVICE_SECRET_MAXLEN] = {0};
+    dm_utils_json_writer_t writer;
+
+    dm_utils_json_writer_init(&writer, NULL, ctx->payload_len + 32);
+    dm_utils_json_writer_object_begin(&writer, NULL);
+
+    dm_utils_json_writer_object_begin(&writer, "properties");
+    list_for_each_entry(node, &ctx->node_list, linked_list, dm_coalesce_node_t) {
+        if (node->devid == IOTX_DM_LOCAL_NODE_DEVID) {
+            _dm_coalesce_write_props(&writer, node, 1);
+        }
+    }
+    dm_utils_json_writer_object_end(&writer);
+
+    dm_utils_json_writer_array_begin(&writer, "subDevices");
+    list_for_each_entry(node, &ctx->node_list, linked_list, dm_coalesce_node_t) {
+        if (node->devid == IOTX_DM_LOCAL_NODE_DEVID) {
+            continue;
+        }
+
+        memset(product_key, 0, PRODUCT_KEY_MAXLEN);
+        memset(device_name, 0, DEVICE_NAME_MAXLEN);
+        res = dm_mgr_search_device_by_devid(node->devid, product_key, device_name, device_secret);
+        if (res != SUCCESS_RETURN) {
+            dm_log_warning("Coalesced Property Of Devid %d Dropped, Device Not Found", node->devid);
+            node->reports = 0;
+            continue;
+        }
+
+        dm_utils_json_writer_object_begin(&writer, NULL);
+        dm_utils_json_writer_object_begin(&writer, "identity");
+        dm_utils_json_writer_string(&writer, "productKey", product_key, strlen(product_key));
+        dm_utils_json_writer_string(&writer, "deviceName", device_name, strlen(device_name));
+        dm_utils_json_writer_object_end(&writer);
+        dm_utils_json_writer_object_begin(&writer, "properties");
+        _dm_coalesce_write_props(&writer, node, 1);
+        dm_utils_json_writer_object_end(&writer);
+        dm_utils_json_writer_object_end(&writer);
+    }
+    dm_utils_json_writer_array_end(&writer);
+
+    dm_utils_json_writer_object_end(&writer);
+    res = dm_utils_json_writer_finish(&writer, &payload, &payload_len);
+    dm_utils_json_writer_deinit(&writer);
+    if (res != SUCCESS_RETURN) {
+        return res;
+    }
+
+    res = dm_mgr_upstream_thing_property_pack_post(msgid, payload, payload_len);
+    DM_free(payload);
+
+    return res;
+}
+#endif
+
+int dm_coalesce_flush(void)
+{
+    dm_coalesce_ctx_t *ctx = _dm_coalesce_get_ctx();
+    dm_coalesce_node_t *node = NULL;
+    int res = 0, ret = SUCCESS_RETURN, msgid = ctx->msgid;
+
+    if (ctx->node_list.next == NULL || list_empty(&ctx->node_list)) {
+        return SUCCESS_RETURN;
+    }
+
+#ifdef DEVICE_MODEL_GATEWAY
+    if (ctx->node_num > 1) {
+        int reports = 0;
+
+        res = _dm_coalesce_pack_post(msgid);
+        if (res >= SUCCESS_RETURN) {
+            list_for_each_entry(node, &ctx->node_list, linked_list, dm_coalesce_node_t) {
+                reports += node->reports;
+            }
+            ctx->stats.posts++;
+            ctx->stats.saved += (reports > 0) ? (reports - 1) : (0);
+        } else {
+            dm_log_warning("Coalesced Property Pack Post Failed: %d", res);
+            ret = FAIL_RETURN;
+        }
+        _dm_coalesce_reset();
+        return ret;
+    }
+#endif
+
+    list_for_each_entry(node, &ctx->node_list, linked_list, dm_coalesce_node_t) {
+        /* only the first post can use msgid handed out for this window */
+        res = _dm_coalesce_post((msgid >= 0) ? (msgid) : (iotx_report_id()), node);
+        msgid = -1;
+        if (res >= SUCCESS_RETURN) {
+            ctx->stats.posts++;
+            ctx->stats.saved += node->reports - 1;
+        } else {
+            dm_log_warning("Coalesced Property Post Of Devid %d Failed: %d", node->devid, res);
+            ret = FAIL_RETURN;
+        }
+    }
+    _dm_coalesce_reset();
+
+    return ret;
+}
+
+void dm_coalesce_tick(void)
+{
+    dm_coalesce_ctx_t *ctx = _dm_coalesce_get_ctx();
+    uint64_t current_time = 0;
+    int window_ms = 0;
+
+    if (ctx->node_list.next == NULL || list_empty(&ctx->node_list)) {
+        return;
+    }
+
+    dm_opt_get(DM_OPT_UPSTREAM_PROPERTY_POST_COALESCE, &window_ms);
+    current_time = HAL_UptimeMs();
+    if (current_time < ctx->window_start) {
+        ctx->window_start = current_time;
+    }
+    if (current_time - ctx->window_start < window_ms) {
+        return;
+    }
+
+    dm_coalesce_flush();
+}
+
+static void _dm_coalesce_texts_free(_IN_ char **texts, _IN_ int num)
+{
+    int index = 0;
+
+    for (index = 0; index < num; index++) {
+        DM_free(texts[index]);
+    }
+    DM_free(texts);
+}
+
+int dm_coalesce_property_post(_IN_ int devid, _IN_ char *payload, _IN_ int payload_len)
+{
+    int res = 0, msgid = 0, index = 0, num = 0;
+    dm_coalesce_ctx_t *ctx = _dm_coalesce_get_ctx();
+    dm_coalesce_node_t *node = NULL;
+    char product_key[PRODUCT_KEY_MAXLEN] = {0};
+    char device_name[DEVICE_NAME_MAXLEN] = {0};
+    char device_secret[DEVICE_SECRET_MAXLEN] = {0};
+    char **texts = NULL;
+    lite_cjson_t lite, lite_key, lite_value;
+    lite_cjson_iter_t iter;
+
+    if (devid < 0 || payload == NULL || payload_len <= 0) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    res = dm_mgr_search_device_by_devid(devid, product_key, device_name, device_secret);
+    if (res != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    memset(&lite, 0, sizeof(lite_cjson_t));
+    res = lite_cjson_parse(payload, payload_len, &lite);
+    if (res != SUCCESS_RETURN) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    /* Nothing To Merge, Send It As It Is After Pending Ones To Keep Order */
+    if (!lite_cjson_is_object(&lite) || lite.size == 0) {
+        dm_coalesce_flush();
+        return dm_mgr_upstream_thing_property_post(devid, payload, payload_len);
+    }
+
+    /* Allocate Everything Before Merging, So A Report Is Merged Whole Or Not At All */
+    texts = DM_malloc(lite.size * sizeof(char *));
+    if (texts == NULL) {
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+    lite_cjson_iter_init(&lite, &iter);
+    while (num < lite.size && lite_cjson_iter_next(&iter, &lite_key, &lite_value) == SUCCESS_RETURN) {
+        texts[num] = _dm_coalesce_prop_text(&lite_key, &lite_value);
+        if (texts[num] == NULL) {
+            _dm_coalesce_texts_free(texts, num);
+            return DM_MEMORY_NOT_ENOUGH;
+        }
+        num++;
+    }
+
+    /* Size Bound Of Window */
+    if (ctx->node_num > 0 && ctx->payload_len + payload_len > DM_COALESCE_PARAMS_MAXLEN) {
+        dm_coalesce_flush();
+    }
+
+    if (_dm_coalesce_node_search(devid, &node) != SUCCESS_RETURN) {
+#ifdef DEVICE_MODEL_GATEWAY
+        if (ctx->node_num >= DM_COALESCE_PACK_SUBDEV_MAX) {
+            dm_coalesce_flush();
+        }
+#endif
+        node = DM_malloc(sizeof(dm_coalesce_node_t));
+        if (node == NULL) {
+            _dm_coalesce_texts_free(texts, num);
+            return DM_MEMORY_NOT_ENOUGH;
+        }
+        memset(node, 0, sizeof(dm_coalesce_node_t));
+        node->devid = devid;
+        INIT_LIST_HEAD(&node->linked_list);
+        if (_dm_coalesce_prop_reserve(node, num) != SUCCESS_RETURN) {
+            DM_free(node);
+            _dm_coalesce_texts_free(texts, num);
+            return DM_MEMORY_NOT_ENOUGH;
+        }
+        list_add_tail(&node->linked_list, &ctx->node_list);
+        ctx->node_num++;
+#ifdef DEVICE_MODEL_GATEWAY
+        /* {"identity":{"productKey":"","deviceName":""},"properties":{}} of subdevice in pack */
+        if (devid != IOTX_DM_LOCAL_NODE_DEVID) {
+            ctx->payload_len += strlen(product_key) + strlen(device_name) + 64;
+        }
+#endif
+    } else if (_dm_coalesce_prop_reserve(node, num) != SUCCESS_RETURN) {
+        _dm_coalesce_texts_free(texts, num);
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+
+    /* Open Window */
+    if (ctx->msgid < 0) {
+        ctx->msgid = iotx_report_id();
+        ctx->window_start = HAL_UptimeMs();
+    }
+
+    for (index = 0; index < num; index++) {
+        _dm_coalesce_prop_merge(node, texts[index]);
+    }
+    DM_free(texts);
+    node->reports++;
+    ctx->stats.reports++;
+
+    msgid = ctx->msgid;
+    if (ctx->payload_len >= DM_COALESCE_PARAMS_MAXLEN) {
+        dm_coalesce_flush();
+    }
+
+    return msgid;
+}
+
+int dm_coalesce_get_stats(_OU_ iotx_ioctl_prop_post_stats_t *stats)
+{
+    dm_coalesce_ctx_t *ctx = _dm_coalesce_get_ctx();
+
+    if (stats == NULL) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    memcpy(stats, &ctx->stats, sizeof(iotx_ioctl_prop_post_stats_t));
+
+    return SUCCESS_RETURN;
+}
+#endif
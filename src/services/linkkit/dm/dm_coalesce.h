@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+#if !defined(DEVICE_MODEL_RAWDATA_SOLO)
+#ifndef _DM_COALESCE_H_
+#define _DM_COALESCE_H_
+
+#include "iotx_dm_internal.h"
+
+typedef struct {
+    char *key;                          //escaped key text as reported, '\0' terminated
+    char *value;                        //complete JSON text of value, stored right after key
+    int value_len;
+#ifdef DEVICE_MODEL_GATEWAY
+    long long time;                     //utc ms of report, pack post carries it per property
+#endif
+} dm_coalesce_prop_t;
+
+typedef struct {
+    int devid;
+    int prop_num;
+    int prop_size;
+    dm_coalesce_prop_t *props;
+    int reports;                        //reports merged into this node since last flush
+    struct list_head linked_list;
+} dm_coalesce_node_t;
+
+typedef struct {
+    int msgid;                          //shared by all reports of current window, returned to caller
+    uint64_t window_start;
+    int payload_len;                    //estimated length of params of pending posts
+    int node_num;
+    struct list_head node_list;         //ordered by first report of device in window
+    iotx_ioctl_prop_post_stats_t stats;
+} dm_coalesce_ctx_t;
+
+/* all functions run under lock of dm_api */
+int dm_coalesce_init(void);
+int dm_coalesce_deinit(void);
+int dm_coalesce_enabled(void);
+int dm_coalesce_property_post(_IN_ int devid, _IN_ char *payload, _IN_ int payload_len);
+int dm_coalesce_flush(void);
+void dm_coalesce_tick(void);
+int dm_coalesce_get_stats(_OU_ iotx_ioctl_prop_post_stats_t *stats);
+
+#endif
+#endif
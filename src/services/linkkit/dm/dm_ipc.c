@@ -5,6 +5,7 @@
 
 
 #include "iotx_dm_internal.h"
+#include "utils_atomic.h"
 
 dm_ipc_t g_dm_ipc;
 
@@ -13,37 +14,118 @@ static dm_ipc_t *_dm_ipc_get_ctx(void)
     return &g_dm_ipc;
 }
 
-static void _dm_ipc_lock(void)
+#if UTILS_ATOMIC_LOCK_FREE
+#define _dm_ipc_cas(ptr, oldval, newval) UTILS_ATOMIC_CAS(ptr, oldval, newval)
+#define _dm_ipc_load(ptr)                UTILS_ATOMIC_LOAD(ptr)
+#else
+static int _dm_ipc_cas(volatile unsigned int *ptr, unsigned int oldval, unsigned int newval)
 {
+    int res = 0;
     dm_ipc_t *ctx = _dm_ipc_get_ctx();
-    if (ctx->mutex) {
-        HAL_MutexLock(ctx->mutex);
+
+    HAL_MutexLock(ctx->mutex);
+    if (*ptr == oldval) {
+        *ptr = newval;
+        res = 1;
     }
+    HAL_MutexUnlock(ctx->mutex);
+
+    return res;
 }
 
-static void _dm_ipc_unlock(void)
+static unsigned int _dm_ipc_load(volatile unsigned int *ptr)
 {
+    unsigned int value = 0;
     dm_ipc_t *ctx = _dm_ipc_get_ctx();
-    if (ctx->mutex) {
-        HAL_MutexUnlock(ctx->mutex);
+
+    HAL_MutexLock(ctx->mutex);
+    value = *ptr;
+    HAL_MutexUnlock(ctx->mutex);
+
+    return value;
+}
+#endif
+
+static dm_ipc_slot_t *_dm_ipc_slot(unsigned int pos)
+{
+    dm_ipc_t *ctx = _dm_ipc_get_ctx();
+
+    return (dm_ipc_slot_t *)(ctx->slots + (pos & ctx->mask) * ctx->slot_size);
+}
+
+/* claim a free slot for producer, fail if max_size messages are queued */
+static dm_ipc_slot_t *_dm_ipc_claim(unsigned int *pos)
+{
+    dm_ipc_t *ctx = _dm_ipc_get_ctx();
+    dm_ipc_slot_t *slot = NULL;
+    unsigned int cur = 0;
+    int diff = 0;
+
+    if (ctx->slots == NULL) {
+        return NULL;
     }
+
+    cur = _dm_ipc_load(&ctx->enqueue_pos);
+    for (;;) {
+        slot = _dm_ipc_slot(cur);
+        diff = (int)(_dm_ipc_load(&slot->seq) - cur);
+        if (diff == 0) {
+            if (cur - _dm_ipc_load(&ctx->dequeue_pos) >= ctx->max_size) {
+                diff = -1;
+            } else if (_dm_ipc_cas(&ctx->enqueue_pos, cur, cur + 1)) {
+                break;
+            }
+        }
+        if (diff < 0) {
+            dm_log_warning("dm ipc list full");
+            return NULL;
+        }
+        cur = _dm_ipc_load(&ctx->enqueue_pos);
+    }
+
+    *pos = cur;
+    return slot;
+}
+
+/* hand a filled slot to consumer, CAS also acts as release barrier for slot content */
+static void _dm_ipc_publish(dm_ipc_slot_t *slot, unsigned int pos)
+{
+    _dm_ipc_cas(&slot->seq, pos, pos + 1);
 }
 
 int dm_ipc_init(int max_size)
 {
     dm_ipc_t *ctx = _dm_ipc_get_ctx();
+    unsigned int index = 0, capacity = 2;
 
     memset(ctx, 0, sizeof(dm_ipc_t));
 
+#if !UTILS_ATOMIC_LOCK_FREE
     //Create Mutex
     ctx->mutex = HAL_MutexCreate();
     if (ctx->mutex == NULL) {
         return DM_INVALID_PARAMETER;
     }
+#endif
 
-    //Init List
-    ctx->msg_list.max_size = max_size;
-    INIT_LIST_HEAD(&ctx->msg_list.message_list);
+    //Init Ring, capacity is power of 2 and at least 2, or a held slot would look free for next round
+    while (capacity < (unsigned int)max_size) {
+        capacity <<= 1;
+    }
+    ctx->mask = capacity - 1;
+    ctx->max_size = (max_size > 0) ? (unsigned int)max_size : 1;
+    ctx->slot_size = (sizeof(dm_ipc_slot_t) + DM_IPC_CACHE_LINE_SIZE - 1) & ~(DM_IPC_CACHE_LINE_SIZE - 1);
+
+    ctx->ring = DM_malloc(capacity * ctx->slot_size + DM_IPC_CACHE_LINE_SIZE);
+    if (ctx->ring == NULL) {
+        dm_ipc_deinit();
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+    ctx->slots = (char *)(((uintptr_t)ctx->ring + DM_IPC_CACHE_LINE_SIZE - 1) & ~(uintptr_t)(DM_IPC_CACHE_LINE_SIZE - 1));
+
+    for (index = 0; index < capacity; index++) {
+        _dm_ipc_slot(index)->seq = index;
+    }
 
     return SUCCESS_RETURN;
 }
@@ -51,85 +133,130 @@ int dm_ipc_init(int max_size)
 void dm_ipc_deinit(void)
 {
     dm_ipc_t *ctx = _dm_ipc_get_ctx();
-    dm_ipc_msg_node_t *del_node = NULL;
-    dm_ipc_msg_node_t *next_node = NULL;
-    dm_ipc_msg_t *del_msg = NULL;
+    dm_ipc_msg_t *msg = NULL;
+
+    //Free Pending Messages
+    while (dm_ipc_msg_next(&msg) == SUCCESS_RETURN) {
+        dm_ipc_msg_release(msg);
+        msg = NULL;
+    }
+
+    ctx->slots = NULL;
+    if (ctx->ring) {
+        DM_free(ctx->ring);
+    }
 
     if (ctx->mutex) {
         HAL_MutexDestroy(ctx->mutex);
+        ctx->mutex = NULL;
     }
+}
 
-    list_for_each_entry_safe(del_node, next_node, &ctx->msg_list.message_list, linked_list, dm_ipc_msg_node_t) {
-        //Free Message
-        del_msg = (dm_ipc_msg_t *)del_node->data;
-        if (del_msg->data) {
-            DM_free(del_msg->data);
-        }
-        DM_free(del_msg);
-        del_msg = NULL;
+int dm_ipc_msg_insert(iotx_dm_event_types_t type, char *data)
+{
+    dm_ipc_slot_t *slot = NULL;
+    unsigned int pos = 0;
 
-        //Free Node
-        list_del(&del_node->linked_list);
-        DM_free(del_node);
+    slot = _dm_ipc_claim(&pos);
+    if (slot == NULL) {
+        return FAIL_RETURN;
     }
+
+    slot->msg.type = type;
+    slot->msg.data = data;
+    _dm_ipc_publish(slot, pos);
+
+    return SUCCESS_RETURN;
 }
 
-int dm_ipc_msg_insert(void *data)
+int dm_ipc_msg_insert_vfmt(iotx_dm_event_types_t type, int data_len, const char *fmt, va_list args)
 {
-    dm_ipc_t *ctx = _dm_ipc_get_ctx();
-    dm_ipc_msg_node_t *node = NULL;
+    dm_ipc_slot_t *slot = NULL;
+    unsigned int pos = 0;
+    char *data = NULL;
 
-    if (data == NULL) {
+    if (data_len <= 0 || fmt == NULL) {
         return DM_INVALID_PARAMETER;
     }
 
-    _dm_ipc_lock();
-    dm_log_debug("dm msg list size: %d, max size: %d", ctx->msg_list.size, ctx->msg_list.max_size);
-    if (ctx->msg_list.size >= ctx->msg_list.max_size) {
-        dm_log_warning("dm ipc list full");
-        _dm_ipc_unlock();
+    //Large Message Spills To Heap, Allocated Before Claiming So Consumer Never Waits On malloc
+    if (data_len > DM_IPC_MSG_INLINE_SIZE) {
+        data = DM_malloc(data_len);
+        if (data == NULL) {
+            return DM_MEMORY_NOT_ENOUGH;
+        }
+        HAL_Vsnprintf(data, data_len, fmt, args);
+    }
+
+    slot = _dm_ipc_claim(&pos);
+    if (slot == NULL) {
+        if (data) {
+            DM_free(data);
+        }
         return FAIL_RETURN;
     }
 
-    node = DM_malloc(sizeof(dm_ipc_msg_node_t));
-    if (node == NULL) {
-        _dm_ipc_unlock();
-        return DM_MEMORY_NOT_ENOUGH;
+    if (data == NULL) {
+        data = slot->payload;
+        HAL_Vsnprintf(data, data_len, fmt, args);
     }
-    memset(node, 0, sizeof(dm_ipc_msg_node_t));
 
-    node->data = data;
-    INIT_LIST_HEAD(&node->linked_list);
-    ctx->msg_list.size++;
-    list_add_tail(&node->linked_list, &ctx->msg_list.message_list);
+    slot->msg.type = type;
+    slot->msg.data = data;
+    _dm_ipc_publish(slot, pos);
 
-    _dm_ipc_unlock();
     return SUCCESS_RETURN;
 }
 
-int dm_ipc_msg_next(void **data)
+int dm_ipc_msg_next(dm_ipc_msg_t **msg)
 {
     dm_ipc_t *ctx = _dm_ipc_get_ctx();
+    dm_ipc_slot_t *slot = NULL;
+    unsigned int cur = 0;
+    int diff = 0;
 
-    if (data == NULL || *data != NULL) {
+    if (msg == NULL || *msg != NULL) {
         return DM_INVALID_PARAMETER;
     }
 
-    _dm_ipc_lock();
-
-    if (list_empty(&ctx->msg_list.message_list)) {
-        _dm_ipc_unlock();
+    if (ctx->slots == NULL) {
         return FAIL_RETURN;
     }
 
-    dm_ipc_msg_node_t *node = list_first_entry(&ctx->msg_list.message_list, dm_ipc_msg_node_t, linked_list);
-    list_del(&node->linked_list);
-    ctx->msg_list.size--;
-
-    *data = node->data;
-    DM_free(node);
+    cur = _dm_ipc_load(&ctx->dequeue_pos);
+    for (;;) {
+        slot = _dm_ipc_slot(cur);
+        diff = (int)(_dm_ipc_load(&slot->seq) - (cur + 1));
+        if (diff == 0) {
+            if (_dm_ipc_cas(&ctx->dequeue_pos, cur, cur + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return FAIL_RETURN;
+        }
+        cur = _dm_ipc_load(&ctx->dequeue_pos);
+    }
 
-    _dm_ipc_unlock();
+    *msg = &slot->msg;
     return SUCCESS_RETURN;
 }
 
+void dm_ipc_msg_release(dm_ipc_msg_t *msg)
+{
+    dm_ipc_t *ctx = _dm_ipc_get_ctx();
+    dm_ipc_slot_t *slot = (dm_ipc_slot_t *)msg;
+    unsigned int seq = 0;
+
+    if (msg == NULL) {
+        return;
+    }
+
+    if (msg->data && msg->data != slot->payload) {
+        DM_free(msg->data);
+    }
+    msg->data = NULL;
+
+    //Slot Becomes Free For Producer Of Next Round
+    seq = slot->seq;
+    _dm_ipc_cas(&slot->seq, seq, seq + ctx->mask);
+}
@@ -14,25 +14,46 @@ typedef struct {
     char *data;
 } dm_ipc_msg_t;
 
+/*
+ * One slot of the message ring, @seq tells its owner (Vyukov bounded queue):
+ * seq == pos: free for producer of position pos, seq == pos + 1: ready for consumer.
+ * msg.data points to @payload for small messages, or to heap memory owned by the slot
+ */
 typedef struct {
-    void *data;
-    struct list_head linked_list;
-} dm_ipc_msg_node_t;
-
-typedef struct {
-    int max_size;
-    int size;
-    struct list_head message_list;
-} dm_ipc_msg_list_t;
+    dm_ipc_msg_t msg;
+    volatile unsigned int seq;
+    char payload[DM_IPC_MSG_INLINE_SIZE];
+} dm_ipc_slot_t;
 
 typedef struct {
+    /* claimed by producers, padded away from consumer side to avoid false sharing, no pad if line fits position only */
+    volatile unsigned int enqueue_pos;
+#if DM_IPC_CACHE_LINE_SIZE > 4
+    char enqueue_pad[DM_IPC_CACHE_LINE_SIZE - sizeof(unsigned int)];
+#endif
+    volatile unsigned int dequeue_pos;
+#if DM_IPC_CACHE_LINE_SIZE > 4
+    char dequeue_pad[DM_IPC_CACHE_LINE_SIZE - sizeof(unsigned int)];
+#endif
+    unsigned int mask;
+    unsigned int max_size;      /* messages allowed in ring, slots beyond it only round capacity up */
+    int slot_size;
+    char *slots;
+    void *ring;
     void *mutex;
-    dm_ipc_msg_list_t msg_list;
 } dm_ipc_t;
 
 int dm_ipc_init(int max_size);
 void dm_ipc_deinit(void);
-int dm_ipc_msg_insert(void *data);
-int dm_ipc_msg_next(void **data);
+
+/* queue heap allocated @data, the ring takes it over only on success */
+int dm_ipc_msg_insert(iotx_dm_event_types_t type, char *data);
+
+/* format message of at most @data_len bytes (including '\0') into the ring, inline if it fits */
+int dm_ipc_msg_insert_vfmt(iotx_dm_event_types_t type, int data_len, const char *fmt, va_list args);
+
+/* take the oldest message, which stays valid until dm_ipc_msg_release() */
+int dm_ipc_msg_next(dm_ipc_msg_t **msg);
+void dm_ipc_msg_release(dm_ipc_msg_t *msg);
 
 #endif
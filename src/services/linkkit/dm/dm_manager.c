@@ -6,6 +6,8 @@
 
 #include "iotx_dm_internal.h"
 
+#define DM_MGR_BUCKET_MIN_NUM (16)
+
 static dm_mgr_ctx g_dm_mgr = {0};
 
 static dm_mgr_ctx *_dm_mgr_get_ctx(void)
@@ -36,18 +38,39 @@ static int _dm_mgr_next_devid(void)
     return ctx->global_devid++;
 }
 
+static uint32_t _dm_mgr_pkdn_hash(_IN_ const char *product_key, _IN_ const char *device_name)
+{
+    uint32_t hash = 2166136261u;
+
+    /* FNV-1a of product key and device name, '\0' in between */
+    for (; *product_key != '\0'; product_key++) {
+        hash ^= (uint8_t)*product_key;
+        hash *= 16777619u;
+    }
+    hash *= 16777619u;
+    for (; *device_name != '\0'; device_name++) {
+        hash ^= (uint8_t)*device_name;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
 static int _dm_mgr_search_dev_by_devid(_IN_ int devid, _OU_ dm_mgr_dev_node_t **node)
 {
     dm_mgr_ctx *ctx = _dm_mgr_get_ctx();
     dm_mgr_dev_node_t *search_node = NULL;
 
-    list_for_each_entry(search_node, &ctx->dev_list, linked_list, dm_mgr_dev_node_t) {
-        if (search_node->devid == devid) {
-            /* dm_log_debug("Device Found, devid: %d", devid); */
-            if (node) {
-                *node = search_node;
+    if (ctx->devid_buckets != NULL && devid >= 0) {
+        for (search_node = ctx->devid_buckets[devid & (ctx->bucket_num - 1)]; search_node != NULL;
+             search_node = search_node->devid_next) {
+            if (search_node->devid == devid) {
+                /* dm_log_debug("Device Found, devid: %d", devid); */
+                if (node) {
+                    *node = search_node;
+                }
+                return SUCCESS_RETURN;
             }
-            return SUCCESS_RETURN;
         }
     }
 
@@ -58,19 +81,23 @@ static int _dm_mgr_search_dev_by_devid(_IN_ int devid, _OU_ dm_mgr_dev_node_t **
 static int _dm_mgr_search_dev_by_pkdn(_IN_ char product_key[PRODUCT_KEY_MAXLEN],
                                       _IN_ char device_name[DEVICE_NAME_MAXLEN], _OU_ dm_mgr_dev_node_t **node)
 {
+    uint32_t hash = 0;
     dm_mgr_ctx *ctx = _dm_mgr_get_ctx();
     dm_mgr_dev_node_t *search_node = NULL;
 
-    list_for_each_entry(search_node, &ctx->dev_list, linked_list, dm_mgr_dev_node_t) {
-        if ((strlen(search_node->product_key) == strlen(product_key)) &&
-            (memcmp(search_node->product_key, product_key, strlen(product_key)) == 0) &&
-            (strlen(search_node->device_name) == strlen(device_name)) &&
-            (memcmp(search_node->device_name, device_name, strlen(device_name)) == 0)) {
-            /* dm_log_debug("Device Found, Product Key: %s, Device Name: %s", product_key, device_name); */
-            if (node) {
-                *node = search_node;
+    if (ctx->pkdn_buckets != NULL) {
+        hash = _dm_mgr_pkdn_hash(product_key, device_name);
+        for (search_node = ctx->pkdn_buckets[hash & (ctx->bucket_num - 1)]; search_node != NULL;
+             search_node = search_node->pkdn_next) {
+            if (search_node->pkdn_hash == hash &&
+                strcmp(search_node->product_key, product_key) == 0 &&
+                strcmp(search_node->device_name, device_name) == 0) {
+                /* dm_log_debug("Device Found, Product Key: %s, Device Name: %s", product_key, device_name); */
+                if (node) {
+                    *node = search_node;
+                }
+                return SUCCESS_RETURN;
             }
-            return SUCCESS_RETURN;
         }
     }
 
@@ -78,6 +105,140 @@ static int _dm_mgr_search_dev_by_pkdn(_IN_ char product_key[PRODUCT_KEY_MAXLEN],
     return FAIL_RETURN;
 }
 
+static int _dm_mgr_rehash(_IN_ int bucket_num)
+{
+    dm_mgr_ctx *ctx = _dm_mgr_get_ctx();
+    dm_mgr_dev_node_t **devid_buckets = NULL;
+    dm_mgr_dev_node_t **pkdn_buckets = NULL;
+    dm_mgr_dev_node_t *search_node = NULL;
+
+    devid_buckets = DM_malloc(bucket_num * sizeof(dm_mgr_dev_node_t *));
+    pkdn_buckets = DM_malloc(bucket_num * sizeof(dm_mgr_dev_node_t *));
+    if (devid_buckets == NULL || pkdn_buckets == NULL) {
+        if (devid_buckets) {
+            DM_free(devid_buckets);
+        }
+        if (pkdn_buckets) {
+            DM_free(pkdn_buckets);
+        }
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+    memset(devid_buckets, 0, bucket_num * sizeof(dm_mgr_dev_node_t *));
+    memset(pkdn_buckets, 0, bucket_num * sizeof(dm_mgr_dev_node_t *));
+
+    /* every device in list is in hash */
+    list_for_each_entry(search_node, &ctx->dev_list, linked_list, dm_mgr_dev_node_t) {
+        search_node->devid_next = devid_buckets[search_node->devid & (bucket_num - 1)];
+        devid_buckets[search_node->devid & (bucket_num - 1)] = search_node;
+        search_node->pkdn_next = pkdn_buckets[search_node->pkdn_hash & (bucket_num - 1)];
+        pkdn_buckets[search_node->pkdn_hash & (bucket_num - 1)] = search_node;
+    }
+
+    if (ctx->devid_buckets) {
+        DM_free(ctx->devid_buckets);
+    }
+    if (ctx->pkdn_buckets) {
+        DM_free(ctx->pkdn_buckets);
+    }
+    ctx->devid_buckets = devid_buckets;
+    ctx->pkdn_buckets = pkdn_buckets;
+    ctx->bucket_num = bucket_num;
+
+    return SUCCESS_RETURN;
+}
+
+/* index @node by devid and pkdn, called before @node is added into device list */
+static int _dm_mgr_index_dev(_IN_ dm_mgr_dev_node_t *node)
+{
+    int res = 0;
+    dm_mgr_ctx *ctx = _dm_mgr_get_ctx();
+    dm_mgr_dev_node_t **bucket = NULL;
+
+    node->pkdn_hash = _dm_mgr_pkdn_hash(node->product_key, node->device_name);
+    if (ctx->dev_number >= ctx->bucket_num) {
+        res = _dm_mgr_rehash((ctx->bucket_num > 0) ? (ctx->bucket_num << 1) : DM_MGR_BUCKET_MIN_NUM);
+        if (res != SUCCESS_RETURN) {
+            return res;
+        }
+    }
+
+    bucket = &ctx->devid_buckets[node->devid & (ctx->bucket_num - 1)];
+    node->devid_next = *bucket;
+    *bucket = node;
+
+    bucket = &ctx->pkdn_buckets[node->pkdn_hash & (ctx->bucket_num - 1)];
+    node->pkdn_next = *bucket;
+    *bucket = node;
+
+    ctx->dev_number++;
+
+    return SUCCESS_RETURN;
+}
+
+static void _dm_mgr_unindex_dev(_IN_ dm_mgr_dev_node_t *node)
+{
+    dm_mgr_ctx *ctx = _dm_mgr_get_ctx();
+    dm_mgr_dev_node_t **bucket = NULL;
+
+    for (bucket = &ctx->devid_buckets[node->devid & (ctx->bucket_num - 1)]; *bucket != NULL;
+         bucket = &(*bucket)->devid_next) {
+        if (*bucket == node) {
+            *bucket = node->devid_next;
+            break;
+        }
+    }
+    node->devid_next = NULL;
+
+    for (bucket = &ctx->pkdn_buckets[node->pkdn_hash & (ctx->bucket_num - 1)]; *bucket != NULL;
+         bucket = &(*bucket)->pkdn_next) {
+        if (*bucket == node) {
+            *bucket = node->pkdn_next;
+            break;
+        }
+    }
+    node->pkdn_next = NULL;
+
+    ctx->dev_number--;
+}
+
+#ifdef DEPRECATED_LINKKIT
+/* precompiled TSL tables by product key, registered before or after dm starts, so kept out of dm_mgr_ctx */
+typedef struct {
+    char product_key[PRODUCT_KEY_MAXLEN];
+    const dm_shw_table_t *table;
+} dm_mgr_tsl_table_t;
+
+static dm_mgr_tsl_table_t g_dm_mgr_tsl_tables[DM_TSL_TABLE_PRODUCT_MAX];
+
+static const dm_shw_table_t *_dm_mgr_tsl_table_get(_IN_ char product_key[PRODUCT_KEY_MAXLEN])
+{
+    int index = 0;
+
+    for (index = 0; index < DM_TSL_TABLE_PRODUCT_MAX; index++) {
+        if (g_dm_mgr_tsl_tables[index].table != NULL &&
+            strcmp(g_dm_mgr_tsl_tables[index].product_key, product_key) == 0) {
+            return g_dm_mgr_tsl_tables[index].table;
+        }
+    }
+
+    return NULL;
+}
+
+/* shadow of device whose product has table registered is created along with device, no TSL parsed */
+static void _dm_mgr_create_dev_shadow_from_table(_IN_ dm_mgr_dev_node_t *node)
+{
+    const dm_shw_table_t *table = _dm_mgr_tsl_table_get(node->product_key);
+
+    if (table == NULL || node->dev_shadow != NULL) {
+        return;
+    }
+
+    if (dm_shw_create_from_table(table, &node->dev_shadow) != SUCCESS_RETURN) {
+        dm_log_warning("TSL Table Of Product Key %s Not Loaded", node->product_key);
+    }
+}
+#endif
+
 static int _dm_mgr_insert_dev(_IN_ int devid, _IN_ int dev_type, char product_key[PRODUCT_KEY_MAXLEN],
                               char device_name[DEVICE_NAME_MAXLEN])
 {
@@ -107,11 +268,93 @@ static int _dm_mgr_insert_dev(_IN_ int devid, _IN_ int dev_type, char product_ke
     memcpy(node->device_name, device_name, strlen(device_name));
     INIT_LIST_HEAD(&node->linked_list);
 
+    res = _dm_mgr_index_dev(node);
+    if (res != SUCCESS_RETURN) {
+        DM_free(node);
+        return res;
+    }
+
     list_add_tail(&node->linked_list, &ctx->dev_list);
+#ifdef DEPRECATED_LINKKIT
+    _dm_mgr_create_dev_shadow_from_table(node);
+#endif
+
+    return SUCCESS_RETURN;
+}
+
+#ifdef DEPRECATED_LINKKIT
+#if WITH_DM_SHW_SCHEMA_SHARE
+static int _dm_mgr_schema_get(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ iotx_dm_tsl_type_t tsl_type,
+                              _IN_ const char *tsl, _IN_ int tsl_len, _OU_ dm_mgr_schema_node_t **node)
+{
+    int res = 0;
+    uint32_t tsl_hash = dm_shw_table_hash(0, tsl, tsl_len);
+    dm_mgr_ctx *ctx = _dm_mgr_get_ctx();
+    dm_mgr_schema_node_t *search_node = NULL;
+
+    list_for_each_entry(search_node, &ctx->schema_list, linked_list, dm_mgr_schema_node_t) {
+        if ((strlen(search_node->product_key) == strlen(product_key)) &&
+            (memcmp(search_node->product_key, product_key, strlen(product_key)) == 0) &&
+            search_node->tsl_len == tsl_len && search_node->tsl_hash == tsl_hash) {
+            search_node->ref_count++;
+            *node = search_node;
+            return SUCCESS_RETURN;
+        }
+    }
+
+    search_node = DM_malloc(sizeof(dm_mgr_schema_node_t));
+    if (search_node == NULL) {
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+    memset(search_node, 0, sizeof(dm_mgr_schema_node_t));
+
+    res = dm_shw_schema_create(tsl_type, tsl, tsl_len, &search_node->schema);
+    if (res != SUCCESS_RETURN) {
+        DM_free(search_node);
+        return FAIL_RETURN;
+    }
+
+    memcpy(search_node->product_key, product_key, strlen(product_key));
+    search_node->tsl_hash = tsl_hash;
+    search_node->tsl_len = tsl_len;
+    search_node->ref_count = 1;
+    INIT_LIST_HEAD(&search_node->linked_list);
+
+    list_add_tail(&search_node->linked_list, &ctx->schema_list);
+    dm_log_info("TSL Schema Created, Product Key: %s", product_key);
+
+    *node = search_node;
 
     return SUCCESS_RETURN;
 }
 
+static void _dm_mgr_schema_put(_IN_ dm_mgr_schema_node_t **node)
+{
+    if (node == NULL || *node == NULL) {
+        return;
+    }
+
+    if (--(*node)->ref_count > 0) {
+        *node = NULL;
+        return;
+    }
+
+    dm_log_info("TSL Schema Destroyed, Product Key: %s", (*node)->product_key);
+    list_del(&(*node)->linked_list);
+    dm_shw_schema_destroy(&(*node)->schema);
+    DM_free(*node);
+}
+#endif
+
+static void _dm_mgr_destroy_dev_shadow(_IN_ dm_mgr_dev_node_t *node)
+{
+    dm_shw_destroy(&node->dev_shadow);
+#if WITH_DM_SHW_SCHEMA_SHARE
+    _dm_mgr_schema_put(&node->dev_schema);
+#endif
+}
+#endif
+
 static void _dm_mgr_destroy_devlist(void)
 {
     dm_mgr_ctx *ctx = _dm_mgr_get_ctx();
@@ -121,10 +364,19 @@ static void _dm_mgr_destroy_devlist(void)
     list_for_each_entry_safe(del_node, next_node, &ctx->dev_list, linked_list, dm_mgr_dev_node_t) {
         list_del(&del_node->linked_list);
 #ifdef DEPRECATED_LINKKIT
-        dm_shw_destroy(&del_node->dev_shadow);
+        _dm_mgr_destroy_dev_shadow(del_node);
 #endif
         DM_free(del_node);
     }
+
+    if (ctx->devid_buckets) {
+        DM_free(ctx->devid_buckets);
+    }
+    if (ctx->pkdn_buckets) {
+        DM_free(ctx->pkdn_buckets);
+    }
+    ctx->dev_number = 0;
+    ctx->bucket_num = 0;
 }
 
 #ifdef DEPRECATED_LINKKIT
@@ -132,19 +384,10 @@ static int _dm_mgr_legacy_thing_created(int devid)
 {
     int res = 0, message_len = 0;
     const char *thing_created_fmt = "{\"devid\":%d}";
-    char *message = NULL;
 
     message_len = strlen(thing_created_fmt) + DM_UTILS_UINT32_STRLEN + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, thing_created_fmt, devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_LEGACY_THING_CREATED, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_LEGACY_THING_CREATED, message_len, thing_created_fmt, devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -172,6 +415,9 @@ int dm_mgr_init(void)
 
     /* Init Device List */
     INIT_LIST_HEAD(&ctx->dev_list);
+#ifdef DEPRECATED_LINKKIT
+    INIT_LIST_HEAD(&ctx->schema_list);
+#endif
 
     /* Local Node */
     HAL_GetProductKey(product_key);
@@ -245,6 +491,7 @@ int dm_mgr_device_create(_IN_ int dev_type, _IN_ char product_key[PRODUCT_KEY_MA
     node->dev_type = dev_type;
 #if defined(DEPRECATED_LINKKIT)
     node->dev_shadow = NULL;
+    node->dev_schema = NULL;
     node->tsl_source = IOTX_DM_TSL_SOURCE_CLOUD;
 #endif
     memcpy(node->product_key, product_key, strlen(product_key));
@@ -255,7 +502,16 @@ int dm_mgr_device_create(_IN_ int dev_type, _IN_ char product_key[PRODUCT_KEY_MA
     node->dev_status = IOTX_DM_DEV_STATUS_AUTHORIZED;
     INIT_LIST_HEAD(&node->linked_list);
 
+    res = _dm_mgr_index_dev(node);
+    if (res != SUCCESS_RETURN) {
+        DM_free(node);
+        return res;
+    }
+
     list_add_tail(&node->linked_list, &ctx->dev_list);
+#ifdef DEPRECATED_LINKKIT
+    _dm_mgr_create_dev_shadow_from_table(node);
+#endif
 
     if (devid) {
         *devid = node->devid;
@@ -282,12 +538,11 @@ int dm_mgr_device_destroy(_IN_ int devid)
         return FAIL_RETURN;
     }
 
+    _dm_mgr_unindex_dev(node);
     list_del(&node->linked_list);
 
 #if defined(DEPRECATED_LINKKIT)
-    if (node->dev_shadow) {
-        dm_shw_destroy(&node->dev_shadow);
-    }
+    _dm_mgr_destroy_dev_shadow(node);
 #endif
     DM_free(node);
 
@@ -296,15 +551,9 @@ int dm_mgr_device_destroy(_IN_ int devid)
 
 int dm_mgr_device_number(void)
 {
-    int index = 0;
     dm_mgr_ctx *ctx = _dm_mgr_get_ctx();
-    dm_mgr_dev_node_t *search_node = NULL;
-
-    list_for_each_entry(search_node, &ctx->dev_list, linked_list, dm_mgr_dev_node_t) {
-        index++;
-    }
 
-    return index;
+    return ctx->dev_number;
 }
 
 int dm_mgr_get_devid_by_index(_IN_ int index, _OU_ int *devid)
@@ -554,20 +803,11 @@ int dm_mgr_set_device_secret(_IN_ int devid, _IN_ char device_secret[DEVICE_SECR
 int dm_mgr_dev_initialized(int devid)
 {
     int res = 0, message_len = 0;
-    char *message = NULL;
     const char *fmt = "{\"devid\":%d}";
 
     message_len = strlen(fmt) + DM_UTILS_UINT32_STRLEN + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, fmt, devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_INITIALIZED, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_INITIALIZED, message_len, fmt, devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -1040,18 +1280,15 @@ static int _dm_mgr_upstream_request_assemble(_IN_ int msgid, _IN_ int devid, _IN
     return SUCCESS_RETURN;
 }
 
-int dm_mgr_upstream_thing_property_post(_IN_ int devid, _IN_ char *payload, _IN_ int payload_len)
+static int _dm_mgr_upstream_thing_property_post(_IN_ int msgid, _IN_ int devid, _IN_ const char *service_name,
+        _IN_ char *method, _IN_ dm_msg_dest_type_t dest, _IN_ char *payload, _IN_ int payload_len)
 {
     int res = 0;
     dm_msg_request_t request;
 
-    if (devid < 0 || payload == NULL || payload_len <= 0) {
-        return DM_INVALID_PARAMETER;
-    }
-
     memset(&request, 0, sizeof(dm_msg_request_t));
-    res = _dm_mgr_upstream_request_assemble(iotx_report_id(), devid, DM_URI_SYS_PREFIX, DM_URI_THING_EVENT_PROPERTY_POST,
-                                            payload, payload_len, "thing.event.property.post", &request);
+    res = _dm_mgr_upstream_request_assemble(msgid, devid, DM_URI_SYS_PREFIX, service_name,
+                                            payload, payload_len, method, &request);
     if (res != SUCCESS_RETURN) {
         return FAIL_RETURN;
     }
@@ -1060,7 +1297,7 @@ int dm_mgr_upstream_thing_property_post(_IN_ int devid, _IN_ char *payload, _IN_
     request.callback = dm_client_thing_event_post_reply;
 
     /* Send Message To Cloud */
-    res = dm_msg_request(DM_MSG_DEST_ALL, &request);
+    res = dm_msg_request(dest, &request);
 #if !defined(DM_MESSAGE_CACHE_DISABLED)
     if (res == SUCCESS_RETURN) {
         int prop_post_reply = 0;
@@ -1074,6 +1311,40 @@ int dm_mgr_upstream_thing_property_post(_IN_ int devid, _IN_ char *payload, _IN_
     return res;
 }
 
+int dm_mgr_upstream_thing_property_post(_IN_ int devid, _IN_ char *payload, _IN_ int payload_len)
+{
+    if (devid < 0 || payload == NULL || payload_len <= 0) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    return _dm_mgr_upstream_thing_property_post(iotx_report_id(), devid, DM_URI_THING_EVENT_PROPERTY_POST,
+            "thing.event.property.post", DM_MSG_DEST_ALL, payload, payload_len);
+}
+
+int dm_mgr_upstream_thing_property_post_coalesced(_IN_ int msgid, _IN_ int devid, _IN_ char *payload,
+        _IN_ int payload_len)
+{
+    if (msgid < 0 || devid < 0 || payload == NULL || payload_len <= 0) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    return _dm_mgr_upstream_thing_property_post(msgid, devid, DM_URI_THING_EVENT_PROPERTY_POST,
+            "thing.event.property.post", DM_MSG_DEST_ALL, payload, payload_len);
+}
+
+#ifdef DEVICE_MODEL_GATEWAY
+int dm_mgr_upstream_thing_property_pack_post(_IN_ int msgid, _IN_ char *payload, _IN_ int payload_len)
+{
+    if (msgid < 0 || payload == NULL || payload_len <= 0) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    /* Pack Of Gateway And Its Subdevices Goes To Cloud On Gateway Connection, And To Local As Single Posts Do */
+    return _dm_mgr_upstream_thing_property_post(msgid, IOTX_DM_LOCAL_NODE_DEVID, DM_URI_THING_EVENT_PROPERTY_PACK_POST,
+            "thing.event.property.pack.post", DM_MSG_DEST_ALL, payload, payload_len);
+}
+#endif
+
 int dm_mgr_upstream_thing_event_post(_IN_ int devid, _IN_ char *identifier, _IN_ int identifier_len, _IN_ char *method,
                                      _IN_ char *payload, _IN_ int payload_len)
 {
@@ -1504,6 +1775,33 @@ int dm_mgr_deprecated_set_tsl(int devid, iotx_dm_tsl_type_t tsl_type, const char
         return FAIL_RETURN;
     }
 
+    /* shadow from registered table stays, TSL from local or cloud describes the same product */
+    if (node->dev_shadow != NULL && node->dev_shadow->table != NULL &&
+        node->dev_shadow->table == _dm_mgr_tsl_table_get(node->product_key)) {
+        return SUCCESS_RETURN;
+    }
+
+#if WITH_DM_SHW_SCHEMA_SHARE
+    if (tsl_type == IOTX_DM_TSL_TYPE_ALINK) {
+        if (node->dev_shadow != NULL) {
+            return FAIL_RETURN;
+        }
+
+        res = _dm_mgr_schema_get(node->product_key, tsl_type, tsl, tsl_len, &node->dev_schema);
+        if (res != SUCCESS_RETURN) {
+            return FAIL_RETURN;
+        }
+
+        res = dm_shw_create_from_schema(node->dev_schema->schema, &node->dev_shadow);
+        if (res != SUCCESS_RETURN) {
+            _dm_mgr_schema_put(&node->dev_schema);
+            return FAIL_RETURN;
+        }
+
+        return SUCCESS_RETURN;
+    }
+#endif
+
     res = dm_shw_create(tsl_type, tsl, tsl_len, &node->dev_shadow);
     if (res != SUCCESS_RETURN) {
         return FAIL_RETURN;
@@ -1512,6 +1810,63 @@ int dm_mgr_deprecated_set_tsl(int devid, iotx_dm_tsl_type_t tsl_type, const char
     return SUCCESS_RETURN;
 }
 
+int dm_mgr_set_tsl_table(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ const dm_shw_table_t *table)
+{
+    int index = 0, empty = -1;
+
+    if (product_key == NULL || strlen(product_key) == 0 || strlen(product_key) >= PRODUCT_KEY_MAXLEN) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    for (index = 0; index < DM_TSL_TABLE_PRODUCT_MAX; index++) {
+        if (g_dm_mgr_tsl_tables[index].table == NULL) {
+            if (empty < 0) {
+                empty = index;
+            }
+            continue;
+        }
+        if (strcmp(g_dm_mgr_tsl_tables[index].product_key, product_key) == 0) {
+            g_dm_mgr_tsl_tables[index].table = table;
+            return SUCCESS_RETURN;
+        }
+    }
+
+    if (table == NULL) {
+        return SUCCESS_RETURN;
+    }
+    if (empty < 0) {
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+
+    memset(g_dm_mgr_tsl_tables[empty].product_key, 0, PRODUCT_KEY_MAXLEN);
+    memcpy(g_dm_mgr_tsl_tables[empty].product_key, product_key, strlen(product_key));
+    g_dm_mgr_tsl_tables[empty].table = table;
+
+    return SUCCESS_RETURN;
+}
+
+int dm_mgr_deprecated_set_tsl_table(int devid, const dm_shw_table_t *table)
+{
+    int res = 0;
+    dm_mgr_dev_node_t *node = NULL;
+
+    if (table == NULL) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    res = _dm_mgr_search_dev_by_devid(devid, &node);
+    if (res != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    res = dm_shw_create_from_table(table, &node->dev_shadow);
+    if (res != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    return SUCCESS_RETURN;
+}
+
 int dm_mgr_deprecated_get_property_data(_IN_ int devid, _IN_ char *key, _IN_ int key_len, _OU_ void **data)
 {
     int res = 0;
@@ -1957,12 +2312,12 @@ int dm_mgr_deprecated_get_service_output_value(_IN_ int devid, _IN_ char *key, _
 }
 
 int dm_mgr_deprecated_assemble_property(_IN_ int devid, _IN_ char *identifier, _IN_ int identifier_len,
-                                        _IN_ lite_cjson_item_t *lite)
+                                        _IN_ dm_utils_json_writer_t *writer)
 {
     int res = 0;
     dm_mgr_dev_node_t *node = NULL;
 
-    if (devid < 0 || identifier == NULL || identifier_len <= 0 || lite == NULL || lite->type != cJSON_Object) {
+    if (devid < 0 || identifier == NULL || identifier_len <= 0 || writer == NULL) {
         return DM_INVALID_PARAMETER;
     }
 
@@ -1971,7 +2326,7 @@ int dm_mgr_deprecated_assemble_property(_IN_ int devid, _IN_ char *identifier, _
         return FAIL_RETURN;
     }
 
-    res = dm_shw_assemble_property(node->dev_shadow, identifier, identifier_len, lite);
+    res = dm_shw_assemble_property(node->dev_shadow, identifier, identifier_len, writer);
     if (res != SUCCESS_RETURN) {
         return FAIL_RETURN;
     }
@@ -1980,12 +2335,12 @@ int dm_mgr_deprecated_assemble_property(_IN_ int devid, _IN_ char *identifier, _
 }
 
 int dm_mgr_deprecated_assemble_event_output(_IN_ int devid, _IN_ char *identifier, _IN_ int identifier_len,
-        _IN_ lite_cjson_item_t *lite)
+        _IN_ dm_utils_json_writer_t *writer)
 {
     int res = 0;
     dm_mgr_dev_node_t *node = NULL;
 
-    if (devid < 0 || identifier == NULL || identifier_len <= 0 || lite == NULL || lite->type != cJSON_Object) {
+    if (devid < 0 || identifier == NULL || identifier_len <= 0 || writer == NULL) {
         return DM_INVALID_PARAMETER;
     }
 
@@ -1994,7 +2349,7 @@ int dm_mgr_deprecated_assemble_event_output(_IN_ int devid, _IN_ char *identifie
         return FAIL_RETURN;
     }
 
-    res = dm_shw_assemble_event_output(node->dev_shadow, identifier, identifier_len, lite);
+    res = dm_shw_assemble_event_output(node->dev_shadow, identifier, identifier_len, writer);
     if (res != SUCCESS_RETURN) {
         return FAIL_RETURN;
     }
@@ -2003,12 +2358,12 @@ int dm_mgr_deprecated_assemble_event_output(_IN_ int devid, _IN_ char *identifie
 }
 
 int dm_mgr_deprecated_assemble_service_output(_IN_ int devid, _IN_ char *identifier, _IN_ int identifier_len,
-        _IN_ lite_cjson_item_t *lite)
+        _IN_ dm_utils_json_writer_t *writer)
 {
     int res = 0;
     dm_mgr_dev_node_t *node = NULL;
 
-    if (devid < 0 || identifier == NULL || identifier_len <= 0 || lite == NULL || lite->type != cJSON_Object) {
+    if (devid < 0 || identifier == NULL || identifier_len <= 0 || writer == NULL) {
         return DM_INVALID_PARAMETER;
     }
 
@@ -2017,7 +2372,7 @@ int dm_mgr_deprecated_assemble_service_output(_IN_ int devid, _IN_ char *identif
         return FAIL_RETURN;
     }
 
-    res = dm_shw_assemble_service_output(node->dev_shadow, identifier, identifier_len, lite);
+    res = dm_shw_assemble_service_output(node->dev_shadow, identifier, identifier_len, writer);
     if (res != SUCCESS_RETURN) {
         return FAIL_RETURN;
     }
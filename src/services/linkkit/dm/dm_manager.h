@@ -9,11 +9,23 @@
 
 #include "iotx_dm_internal.h"
 
+#if defined(DEPRECATED_LINKKIT)
 typedef struct {
+    char product_key[PRODUCT_KEY_MAXLEN];
+    uint32_t tsl_hash;                           //schema is shared only by identical TSL
+    int tsl_len;
+    int ref_count;                               //number of devices whose shadow created from schema
+    dm_shw_schema_t *schema;
+    struct list_head linked_list;
+} dm_mgr_schema_node_t;
+#endif
+
+typedef struct dm_mgr_dev_node_s {
     int devid;
     int dev_type;
 #if defined(DEPRECATED_LINKKIT)
     dm_shw_t *dev_shadow;
+    dm_mgr_schema_node_t *dev_schema;
     iotx_dm_tsl_source_t tsl_source;
 #endif
     char product_key[PRODUCT_KEY_MAXLEN];
@@ -21,13 +33,23 @@ typedef struct {
     char device_secret[DEVICE_SECRET_MAXLEN];
     iotx_dm_dev_avail_t status;
     iotx_dm_dev_status_t dev_status;
+    uint32_t pkdn_hash;
+    struct dm_mgr_dev_node_s *pkdn_next;         //next node in the same bucket of pkdn hash
+    struct dm_mgr_dev_node_s *devid_next;        //next node in the same bucket of devid
     struct list_head linked_list;
 } dm_mgr_dev_node_t;
 
 typedef struct {
     void *mutex;
     int global_devid;
-    struct list_head dev_list;
+    struct list_head dev_list;                   //devices in creation order
+    int dev_number;
+    int bucket_num;                              //power of 2, no less than dev_number
+    dm_mgr_dev_node_t **devid_buckets;           //devices hashed by devid, devid is never reused
+    dm_mgr_dev_node_t **pkdn_buckets;            //devices hashed by product key and device name
+#if defined(DEPRECATED_LINKKIT)
+    struct list_head schema_list;
+#endif
 } dm_mgr_ctx;
 
 int dm_mgr_init(void);
@@ -67,6 +89,11 @@ int dm_mgr_dev_initialized(int devid);
 int dm_mgr_upstream_thing_model_up_raw(_IN_ int devid, _IN_ char *payload, _IN_ int payload_len);
 #if !defined(DEVICE_MODEL_RAWDATA_SOLO)
 int dm_mgr_upstream_thing_property_post(_IN_ int devid, _IN_ char *payload, _IN_ int payload_len);
+int dm_mgr_upstream_thing_property_post_coalesced(_IN_ int msgid, _IN_ int devid, _IN_ char *payload,
+        _IN_ int payload_len);
+#ifdef DEVICE_MODEL_GATEWAY
+    int dm_mgr_upstream_thing_property_pack_post(_IN_ int msgid, _IN_ char *payload, _IN_ int payload_len);
+#endif
 int dm_mgr_upstream_thing_event_post(_IN_ int devid, _IN_ char *identifier, _IN_ int identifier_len, _IN_ char *method,
                                      _IN_ char *payload, _IN_ int payload_len);
 int dm_mgr_upstream_thing_deviceinfo_update(_IN_ int devid, _IN_ char *payload, _IN_ int payload_len);
@@ -88,6 +115,8 @@ int dm_mgr_deprecated_set_tsl_source(_IN_ int devid, _IN_ iotx_dm_tsl_source_t t
 int dm_mgr_deprecated_get_tsl_source(_IN_ int devid, _IN_ iotx_dm_tsl_source_t *tsl_source);
 int dm_mgr_deprecated_search_devid_by_device_node(_IN_ void *node, _OU_ int *devid);
 int dm_mgr_deprecated_set_tsl(int devid, iotx_dm_tsl_type_t tsl_type, const char *tsl, int tsl_len);
+int dm_mgr_set_tsl_table(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ const dm_shw_table_t *table);
+int dm_mgr_deprecated_set_tsl_table(int devid, const dm_shw_table_t *table);
 int dm_mgr_deprecated_get_property_data(_IN_ int devid, _IN_ char *key, _IN_ int key_len, _OU_ void **data);
 int dm_mgr_deprecated_get_service_input_data(_IN_ int devid, _IN_ char *key, _IN_ int key_len, _OU_ void **data);
 int dm_mgr_deprecated_get_service_output_data(_IN_ int devid, _IN_ char *key, _IN_ int key_len, _OU_ void **data);
@@ -117,11 +146,11 @@ int dm_mgr_deprecated_set_service_output_value(_IN_ int devid, _IN_ char *key, _
         _IN_ int value_len);
 int dm_mgr_deprecated_get_service_output_value(_IN_ int devid, _IN_ char *key, _IN_ int key_len, _IN_ void *value);
 int dm_mgr_deprecated_assemble_property(_IN_ int devid, _IN_ char *identifier, _IN_ int identifier_len,
-                                        _IN_ lite_cjson_item_t *lite);
+                                        _IN_ dm_utils_json_writer_t *writer);
 int dm_mgr_deprecated_assemble_event_output(_IN_ int devid, _IN_ char *identifier, _IN_ int identifier_len,
-        _IN_ lite_cjson_item_t *lite);
+        _IN_ dm_utils_json_writer_t *writer);
 int dm_mgr_deprecated_assemble_service_output(_IN_ int devid, _IN_ char *identifier, _IN_ int identifier_len,
-        _IN_ lite_cjson_item_t *lite);
+        _IN_ dm_utils_json_writer_t *writer);
 int dm_mgr_deprecated_upstream_thing_service_response(_IN_ int devid, _IN_ int msgid, _IN_ iotx_dm_error_code_t code,
         _IN_ char *identifier, _IN_ int identifier_len, _IN_ char *payload, _IN_ int payload_len);
 #endif
@@ -31,20 +31,25 @@ int dm_msg_deinit(void)
 int _dm_msg_send_to_user(iotx_dm_event_types_t type, char *message)
 {
     int res = 0;
-    dm_ipc_msg_t *dipc_msg = NULL;
 
-    dipc_msg = DM_malloc(sizeof(dm_ipc_msg_t));
-    if (dipc_msg == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
+    res = dm_ipc_msg_insert(type, message);
+    if (res != SUCCESS_RETURN) {
+        return FAIL_RETURN;
     }
-    memset(dipc_msg, 0, sizeof(dm_ipc_msg_t));
 
-    dipc_msg->type = type;
-    dipc_msg->data = message;
+    return SUCCESS_RETURN;
+}
+
+int _dm_msg_send_to_user_fmt(iotx_dm_event_types_t type, int message_len, const char *fmt, ...)
+{
+    int res = 0;
+    va_list args;
+
+    va_start(args, fmt);
+    res = dm_ipc_msg_insert_vfmt(type, message_len, fmt, args);
+    va_end(args);
 
-    res = dm_ipc_msg_insert((void *)dipc_msg);
     if (res != SUCCESS_RETURN) {
-        DM_free(dipc_msg);
         return FAIL_RETURN;
     }
 
@@ -55,19 +60,11 @@ const char DM_MSG_SEND_MSG_TIMEOUT_FMT[] DM_READ_ONLY = "{\"id\":%d,\"code\":%d,
 int dm_msg_send_msg_timeout_to_user(int msg_id, int devid, iotx_dm_event_types_t type)
 {
     int res = 0, message_len = 0;
-    char *message = NULL;
 
     message_len = strlen(DM_MSG_SEND_MSG_TIMEOUT_FMT) + DM_UTILS_UINT32_STRLEN * 3 + 1;
-    message = DM_malloc(message_len + 1);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_SEND_MSG_TIMEOUT_FMT, msg_id, IOTX_DM_ERR_CODE_TIMEOUT, devid);
-
-    res = _dm_msg_send_to_user(type, message);
+    res = _dm_msg_send_to_user_fmt(type, message_len, DM_MSG_SEND_MSG_TIMEOUT_FMT,
+                                   msg_id, IOTX_DM_ERR_CODE_TIMEOUT, devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -165,17 +162,36 @@ int dm_msg_response_parse(_IN_ char *payload, _IN_ int payload_len, _OU_ dm_msg_
     return SUCCESS_RETURN;
 }
 
-const char DM_MSG_REQUEST[] DM_READ_ONLY = "{\"id\":\"%d\",\"version\":\"%s\",\"params\":%.*s,\"method\":\"%s\"}";
+/* raw JSON given by caller is checked once, the envelope written by dm_utils_json_writer is valid by construction */
+static int _dm_msg_raw_json_check(_IN_ char *raw, _IN_ int raw_len)
+{
+    lite_cjson_t lite;
+
+    memset(&lite, 0, sizeof(lite_cjson_t));
+    if (lite_cjson_parse(raw, raw_len, &lite) < SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    return SUCCESS_RETURN;
+}
+
+/* {"id":"%d","version":"%s","params":%.*s,"method":"%s"} */
 int dm_msg_request(dm_msg_dest_type_t type, _IN_ dm_msg_request_t *request)
 {
     int res = 0, payload_len = 0;
     char *payload = NULL, *uri = NULL;
-    lite_cjson_t lite;
+    char msgid[DM_UTILS_UINT32_STRLEN + 2] = {0};
+    dm_utils_json_writer_t writer;
 
-    if (request == NULL || request->params == NULL || request->method == NULL) {
+    if (request == NULL || request->params == NULL || request->params_len <= 0 || request->method == NULL) {
         return DM_INVALID_PARAMETER;
     }
 
+    if (_dm_msg_raw_json_check(request->params, request->params_len) != SUCCESS_RETURN) {
+        dm_log_info("Wrong JSON Format, Params: %.*s", request->params_len, request->params);
+        return FAIL_RETURN;
+    }
+
     /* Request URI */
     res = dm_utils_service_name(request->service_prefix, request->service_name,
                                 request->product_key, request->device_name, &uri);
@@ -183,35 +199,34 @@ int dm_msg_request(dm_msg_dest_type_t type, _IN_ dm_msg_request_t *request)
         return FAIL_RETURN;
     }
 
-    payload_len = strlen(DM_MSG_REQUEST) + 10 + strlen(DM_MSG_VERSION) + request->params_len + strlen(
-                              request->method) + 1;
-    payload = DM_malloc(payload_len);
-    if (payload == NULL) {
-        DM_free(uri);
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(payload, 0, payload_len);
-    HAL_Snprintf(payload, payload_len, DM_MSG_REQUEST, request->msgid,
-                 DM_MSG_VERSION, request->params_len, request->params, request->method);
+    /* Request Payload, Sized So That Writer Allocates Only Once */
+    HAL_Snprintf(msgid, sizeof(msgid), "%d", request->msgid);
+    payload_len = strlen("{\"id\":\"\",\"version\":\"\",\"params\":,\"method\":\"\"}") + strlen(msgid) +
+                  strlen(DM_MSG_VERSION) + request->params_len + strlen(request->method) + 1;
+    dm_utils_json_writer_init(&writer, NULL, payload_len);
+    dm_utils_json_writer_object_begin(&writer, NULL);
+    dm_utils_json_writer_string(&writer, DM_MSG_KEY_ID, msgid, strlen(msgid));
+    dm_utils_json_writer_string(&writer, DM_MSG_KEY_VERSION, DM_MSG_VERSION, strlen(DM_MSG_VERSION));
+    dm_utils_json_writer_raw(&writer, DM_MSG_KEY_PARAMS, request->params, request->params_len);
+    dm_utils_json_writer_string(&writer, DM_MSG_KEY_METHOD, request->method, strlen(request->method));
+    dm_utils_json_writer_object_end(&writer);
 
-    memset(&lite, 0, sizeof(lite_cjson_t));
-    res = lite_cjson_parse(payload, payload_len, &lite);
-    if (res < SUCCESS_RETURN) {
-        dm_log_info("Wrong JSON Format, URI: %s, Payload: %s", uri, payload);
+    res = dm_utils_json_writer_finish(&writer, &payload, &payload_len);
+    dm_utils_json_writer_deinit(&writer);
+    if (res != SUCCESS_RETURN) {
         DM_free(uri);
-        DM_free(payload);
-        return FAIL_RETURN;
+        return DM_MEMORY_NOT_ENOUGH;
     }
 
     dm_log_info("DM Send Message, URI: %s, Payload: %s", uri, payload);
 
     if (type & DM_MSG_DEST_CLOUD) {
-        dm_client_publish(uri, (unsigned char *)payload, strlen(payload), request->callback);
+        dm_client_publish(uri, (unsigned char *)payload, payload_len, request->callback);
     }
 
 #ifdef ALCS_ENABLED
     if (type & DM_MSG_DEST_LOCAL) {
-        dm_server_send(uri, (unsigned char *)payload, strlen(payload), NULL);
+        dm_server_send(uri, (unsigned char *)payload, payload_len, NULL);
     }
 #endif
 
@@ -220,18 +235,23 @@ int dm_msg_request(dm_msg_dest_type_t type, _IN_ dm_msg_request_t *request)
     return SUCCESS_RETURN;
 }
 
-const char DM_MSG_RESPONSE_WITH_DATA[] DM_READ_ONLY = "{\"id\":\"%.*s\",\"code\":%d,\"data\":%.*s}";
+/* {"id":"%.*s","code":%d,"data":%.*s} */
 int dm_msg_response(dm_msg_dest_type_t type, _IN_ dm_msg_request_payload_t *request, _IN_ dm_msg_response_t *response,
                     _IN_ char *data, _IN_ int data_len, _IN_ void *user_data)
 {
     int res = 0, payload_len = 0;
     char *uri = NULL, *payload = NULL;
-    lite_cjson_t lite;
+    dm_utils_json_writer_t writer;
 
     if (request == NULL || response == NULL || data == NULL || data_len <= 0) {
         return DM_INVALID_PARAMETER;
     }
 
+    if (_dm_msg_raw_json_check(data, data_len) != SUCCESS_RETURN) {
+        dm_log_info("Wrong JSON Format, Data: %.*s", data_len, data);
+        return FAIL_RETURN;
+    }
+
     /* Response URI */
     res = dm_utils_service_name(response->service_prefix, response->service_name,
                                 response->product_key, response->device_name, &uri);
@@ -239,35 +259,32 @@ int dm_msg_response(dm_msg_dest_type_t type, _IN_ dm_msg_request_payload_t *requ
         return FAIL_RETURN;
     }
 
-    /* Response Payload */
-    payload_len = strlen(DM_MSG_RESPONSE_WITH_DATA) + request->id.value_length + DM_UTILS_UINT32_STRLEN + data_len + 1;
-    payload = DM_malloc(payload_len);
-    if (payload == NULL) {
-        DM_free(uri);
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(payload, 0, payload_len);
-    HAL_Snprintf(payload, payload_len, DM_MSG_RESPONSE_WITH_DATA,
-                 request->id.value_length, request->id.value, response->code, data_len, data);
+    /* Response Payload, id is string content from request and is already escaped */
+    payload_len = strlen("{\"id\":\"\",\"code\":,\"data\":}") + request->id.value_length + DM_UTILS_UINT32_STRLEN +
+                  1 + data_len + 1;
+    dm_utils_json_writer_init(&writer, NULL, payload_len);
+    dm_utils_json_writer_object_begin(&writer, NULL);
+    dm_utils_json_writer_escaped_string(&writer, DM_MSG_KEY_ID, request->id.value, request->id.value_length);
+    dm_utils_json_writer_int(&writer, DM_MSG_KEY_CODE, response->code);
+    dm_utils_json_writer_raw(&writer, DM_MSG_KEY_DATA, data, data_len);
+    dm_utils_json_writer_object_end(&writer);
 
-    memset(&lite, 0, sizeof(lite_cjson_t));
-    res = lite_cjson_parse(payload, payload_len, &lite);
-    if (res < SUCCESS_RETURN) {
-        dm_log_info("Wrong JSON Format, URI: %s, Payload: %s", uri, payload);
+    res = dm_utils_json_writer_finish(&writer, &payload, &payload_len);
+    dm_utils_json_writer_deinit(&writer);
+    if (res != SUCCESS_RETURN) {
         DM_free(uri);
-        DM_free(payload);
-        return FAIL_RETURN;
+        return DM_MEMORY_NOT_ENOUGH;
     }
 
     dm_log_info("Send URI: %s, Payload: %s", uri, payload);
 
     if (type & DM_MSG_DEST_CLOUD) {
-        dm_client_publish(uri, (unsigned char *)payload, strlen(payload), NULL);
+        dm_client_publish(uri, (unsigned char *)payload, payload_len, NULL);
     }
 
 #ifdef ALCS_ENABLED
     if (type & DM_MSG_DEST_LOCAL) {
-        dm_server_send(uri, (unsigned char *)payload, strlen(payload), user_data);
+        dm_server_send(uri, (unsigned char *)payload, payload_len, user_data);
     }
 #endif
 
@@ -371,19 +388,11 @@ const char DM_MSG_PROPERTY_SET_FMT[] DM_READ_ONLY = "{\"devid\":%d,\"payload\":%
 int dm_msg_property_set(int devid, dm_msg_request_payload_t *request)
 {
     int res = 0, message_len = 0;
-    char *message = NULL;
 
     message_len = strlen(DM_MSG_PROPERTY_SET_FMT) + DM_UTILS_UINT32_STRLEN + request->params.value_length + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_PROPERTY_SET_FMT, devid, request->params.value_length, request->params.value);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_PROPERTY_SET, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_PROPERTY_SET, message_len, DM_MSG_PROPERTY_SET_FMT,
+                                   devid, request->params.value_length, request->params.value);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
     return SUCCESS_RETURN;
@@ -395,13 +404,7 @@ int dm_msg_property_get(_IN_ int devid, _IN_ dm_msg_request_payload_t *request,
 {
     int res = 0, message_len = 0;
     uintptr_t ctx_addr_num = (uintptr_t)ctx;
-    char *ctx_addr_str = NULL, *message = NULL;
-
-    ctx_addr_str = DM_malloc(sizeof(uintptr_t) * 2 + 1);
-    if (ctx_addr_str == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(ctx_addr_str, 0, sizeof(uintptr_t) * 2 + 1);
+    char ctx_addr_str[sizeof(uintptr_t) * 2 + 1] = {0};
 
     /*  dm_log_debug("ctx: %p", ctx);
      dm_log_debug("ctx_addr_num: %0x016llX", ctx_addr_num); */
@@ -410,20 +413,10 @@ int dm_msg_property_get(_IN_ int devid, _IN_ dm_msg_request_payload_t *request,
 
     message_len = strlen(DM_MSG_THING_PROPERTY_GET_FMT) + request->id.value_length + DM_UTILS_UINT32_STRLEN +
                   request->params.value_length + strlen(ctx_addr_str) + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        DM_free(ctx_addr_str);
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_THING_PROPERTY_GET_FMT, request->id.value_length, request->id.value, devid,
-                 request->params.value_length, request->params.value, ctx_addr_str);
-
-    DM_free(ctx_addr_str);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_PROPERTY_GET, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_PROPERTY_GET, message_len, DM_MSG_THING_PROPERTY_GET_FMT,
+                                   request->id.value_length, request->id.value, devid,
+                                   request->params.value_length, request->params.value, ctx_addr_str);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -436,7 +429,6 @@ int dm_msg_thing_service_request(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_
                                  char *identifier, int identifier_len, dm_msg_request_payload_t *request)
 {
     int res = 0, devid = 0, message_len = 0;
-    char *message = NULL;
 
     res = dm_mgr_search_device_by_pkdn(product_key, device_name, &devid);
     if (res != SUCCESS_RETURN) {
@@ -445,18 +437,11 @@ int dm_msg_thing_service_request(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_
 
     message_len = strlen(DM_MSG_SERVICE_REQUEST_FMT) + request->id.value_length + DM_UTILS_UINT32_STRLEN + identifier_len +
                   request->params.value_length + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_SERVICE_REQUEST_FMT, request->id.value_length, request->id.value, devid,
-                 identifier_len, identifier,
-                 request->params.value_length, request->params.value);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_THING_SERVICE_REQUEST, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_THING_SERVICE_REQUEST, message_len, DM_MSG_SERVICE_REQUEST_FMT,
+                                   request->id.value_length, request->id.value, devid,
+                                   identifier_len, identifier,
+                                   request->params.value_length, request->params.value);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -471,7 +456,7 @@ int dm_msg_rrpc_request(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ char dev
 {
     int res = 0, devid = 0, message_len = 0;
     int service_offset = 0, serviceid_len = 0;
-    char *serviceid = NULL, *message = NULL;
+    char *serviceid = NULL;
 
     /* Get Devid */
     res = dm_mgr_search_device_by_pkdn(product_key, device_name, &devid);
@@ -492,18 +477,11 @@ int dm_msg_rrpc_request(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ char dev
     message_len = strlen(DM_MSG_EVENT_RRPC_REQUEST_FMT) + request->id.value_length + DM_UTILS_UINT32_STRLEN + serviceid_len
                   + rrpcid_len +
                   request->params.value_length + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_RRPC_REQUEST_FMT, request->id.value_length, request->id.value, devid,
-                 serviceid_len, serviceid, rrpcid_len, rrpcid,
-                 request->params.value_length, request->params.value);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_RRPC_REQUEST, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_RRPC_REQUEST, message_len, DM_MSG_EVENT_RRPC_REQUEST_FMT,
+                                   request->id.value_length, request->id.value, devid,
+                                   serviceid_len, serviceid, rrpcid_len, rrpcid,
+                                   request->params.value_length, request->params.value);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -515,7 +493,7 @@ const char DM_MSG_EVENT_PROPERTY_POST_REPLY_FMT[] DM_READ_ONLY =
 int dm_msg_thing_event_property_post_reply(dm_msg_response_payload_t *response)
 {
     int res = 0, devid = 0, id = 0, message_len = 0, payload_len = 0;
-    char *message = NULL, *payload = NULL;
+    char *payload = NULL;
     char int_id[DM_UTILS_UINT32_STRLEN] = {0};
 
     /* Message ID */
@@ -547,17 +525,10 @@ int dm_msg_thing_event_property_post_reply(dm_msg_response_payload_t *response)
 
     message_len = strlen(DM_MSG_EVENT_PROPERTY_POST_REPLY_FMT) + DM_UTILS_UINT32_STRLEN * 3 + payload_len +
                   1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_PROPERTY_POST_REPLY_FMT, id, response->code.value_int, devid,
-                 payload_len, payload);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_EVENT_PROPERTY_POST_REPLY, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_EVENT_PROPERTY_POST_REPLY, message_len, DM_MSG_EVENT_PROPERTY_POST_REPLY_FMT,
+                                   id, response->code.value_int, devid,
+                                   payload_len, payload);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -570,7 +541,6 @@ int dm_msg_thing_event_post_reply(_IN_ char *identifier, _IN_ int identifier_len
                                   _IN_ dm_msg_response_payload_t *response)
 {
     int res = 0, devid = 0, id = 0, message_len = 0;
-    char *message = NULL;
     char int_id[DM_UTILS_UINT32_STRLEN] = {0};
 
     /* Message ID */
@@ -593,17 +563,10 @@ int dm_msg_thing_event_post_reply(_IN_ char *identifier, _IN_ int identifier_len
 
     message_len = strlen(DM_MSG_EVENT_SPECIFIC_POST_REPLY_FMT) + DM_UTILS_UINT32_STRLEN * 3 + strlen(
                               identifier) + response->message.value_length + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_SPECIFIC_POST_REPLY_FMT, id, response->code.value_int, devid,
-                 identifier_len, identifier, response->message.value_length, response->message.value);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_EVENT_SPECIFIC_POST_REPLY, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_EVENT_SPECIFIC_POST_REPLY, message_len, DM_MSG_EVENT_SPECIFIC_POST_REPLY_FMT,
+                                   id, response->code.value_int, devid,
+                                   identifier_len, identifier, response->message.value_length, response->message.value);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -614,7 +577,6 @@ const char DM_MSG_EVENT_DEVICEINFO_UPDATE_REPLY_FMT[] DM_READ_ONLY = "{\"id\":%d
 int dm_msg_thing_deviceinfo_update_reply(dm_msg_response_payload_t *response)
 {
     int res = 0, devid = 0, id = 0, message_len = 0;
-    char *message = NULL;
     char int_id[DM_UTILS_UINT32_STRLEN] = {0};
 
     /* Message ID */
@@ -636,16 +598,9 @@ int dm_msg_thing_deviceinfo_update_reply(dm_msg_response_payload_t *response)
 #endif
 
     message_len = strlen(DM_MSG_EVENT_DEVICEINFO_UPDATE_REPLY_FMT) + DM_UTILS_UINT32_STRLEN * 3 + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_DEVICEINFO_UPDATE_REPLY_FMT, id, response->code.value_int, devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_DEVICEINFO_UPDATE_REPLY, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_DEVICEINFO_UPDATE_REPLY, message_len, DM_MSG_EVENT_DEVICEINFO_UPDATE_REPLY_FMT,
+                                   id, response->code.value_int, devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -656,7 +611,6 @@ const char DM_MSG_EVENT_DEVICEINFO_DELETE_REPLY_FMT[] DM_READ_ONLY = "{\"id\":%d
 int dm_msg_thing_deviceinfo_delete_reply(dm_msg_response_payload_t *response)
 {
     int res = 0, devid = 0, id = 0, message_len = 0;
-    char *message = NULL;
     char int_id[DM_UTILS_UINT32_STRLEN] = {0};
 
     /* Message ID */
@@ -678,16 +632,9 @@ int dm_msg_thing_deviceinfo_delete_reply(dm_msg_response_payload_t *response)
 #endif
 
     message_len = strlen(DM_MSG_EVENT_DEVICEINFO_DELETE_REPLY_FMT) + DM_UTILS_UINT32_STRLEN * 3 + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_DEVICEINFO_DELETE_REPLY_FMT, id, response->code.value_int, devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_DEVICEINFO_DELETE_REPLY, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_DEVICEINFO_DELETE_REPLY, message_len, DM_MSG_EVENT_DEVICEINFO_DELETE_REPLY_FMT,
+                                   id, response->code.value_int, devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -768,7 +715,6 @@ const char DM_MSG_THING_NTP_RESPONSE_FMT[] DM_READ_ONLY = "{\"utc\":\"%.*s\"}";
 int dm_msg_ntp_response(char *payload, int payload_len)
 {
     int res = 0, message_len = 0;
-    char *message = NULL;
     uint64_t utc = 0;
     lite_cjson_t lite, lite_item_server_send_time;
     const char *serverSendTime = "serverSendTime";
@@ -796,17 +742,10 @@ int dm_msg_ntp_response(char *payload, int payload_len)
     /* Send Message To User */
     message_len = strlen(DM_MSG_THING_NTP_RESPONSE_FMT) + DM_UTILS_UINT32_STRLEN + lite_item_server_send_time.value_length +
                   1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_THING_NTP_RESPONSE_FMT, lite_item_server_send_time.value_length,
-                 lite_item_server_send_time.value);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_NTP_RESPONSE, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_NTP_RESPONSE, message_len, DM_MSG_THING_NTP_RESPONSE_FMT,
+                                   lite_item_server_send_time.value_length,
+                                   lite_item_server_send_time.value);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -861,6 +800,7 @@ int dm_msg_topo_add_notify(_IN_ char *payload, _IN_ int payload_len)
 {
     int ret = SUCCESS_RETURN, res = 0, index = 0, devid = 0, message_len = 0;
     lite_cjson_t lite, lite_item, lite_item_pk, lite_item_dn;
+    lite_cjson_iter_t iter;
     char product_key[PRODUCT_KEY_MAXLEN] = {0};
     char device_name[DEVICE_NAME_MAXLEN] = {0};
     char *message = NULL;
@@ -871,6 +811,7 @@ int dm_msg_topo_add_notify(_IN_ char *payload, _IN_ int payload_len)
         return DM_JSON_PARSE_FAILED;
     }
 
+    lite_cjson_iter_init(&lite, &iter);
     for (index = 0; index < lite.size; index++) {
         devid = 0;
         message_len = 0;
@@ -881,7 +822,7 @@ int dm_msg_topo_add_notify(_IN_ char *payload, _IN_ int payload_len)
         memset(product_key, 0, PRODUCT_KEY_MAXLEN);
         memset(device_name, 0, DEVICE_NAME_MAXLEN);
 
-        res = lite_cjson_array_item(&lite, index, &lite_item);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_item);
         if (res != SUCCESS_RETURN) {
             ret = FAIL_RETURN;
             continue;
@@ -941,7 +882,6 @@ const char DM_MSG_EVENT_THING_DISABLE_FMT[] DM_READ_ONLY = "{\"devid\":%d}";
 int dm_msg_thing_disable(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ char device_name[DEVICE_NAME_MAXLEN])
 {
     int res = 0, devid = 0, message_len = 0;
-    char *message = NULL;
 
     if (product_key == NULL || device_name == NULL ||
         (strlen(product_key) >= PRODUCT_KEY_MAXLEN) ||
@@ -957,16 +897,8 @@ int dm_msg_thing_disable(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ char de
     res = dm_mgr_set_dev_disable(devid);
 
     message_len = strlen(DM_MSG_EVENT_THING_DISABLE_FMT) + DM_UTILS_UINT32_STRLEN + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_THING_DISABLE_FMT, devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_THING_DISABLE, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_THING_DISABLE, message_len, DM_MSG_EVENT_THING_DISABLE_FMT, devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -977,7 +909,6 @@ const char DM_MSG_EVENT_THING_ENABLE_FMT[] DM_READ_ONLY = "{\"devid\":%d}";
 int dm_msg_thing_enable(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ char device_name[DEVICE_NAME_MAXLEN])
 {
     int res = 0, devid = 0, message_len = 0;
-    char *message = NULL;
 
     if (product_key == NULL || device_name == NULL ||
         (strlen(product_key) >= PRODUCT_KEY_MAXLEN) ||
@@ -996,16 +927,8 @@ int dm_msg_thing_enable(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ char dev
     }
 
     message_len = strlen(DM_MSG_EVENT_THING_ENABLE_FMT) + DM_UTILS_UINT32_STRLEN + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_THING_ENABLE_FMT, devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_THING_ENABLE, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_THING_ENABLE, message_len, DM_MSG_EVENT_THING_ENABLE_FMT, devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -1017,7 +940,6 @@ const char DM_MSG_EVENT_THING_DELETE_FMT[] DM_READ_ONLY =
 int dm_msg_thing_delete(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ char device_name[DEVICE_NAME_MAXLEN])
 {
     int res = 0, message_len = 0, devid = 0;
-    char *message = NULL;
 
     if (product_key == NULL || device_name == NULL ||
         (strlen(product_key) >= PRODUCT_KEY_MAXLEN) ||
@@ -1036,16 +958,9 @@ int dm_msg_thing_delete(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ char dev
     }
 
     message_len = strlen(DM_MSG_EVENT_THING_DELETE_FMT) + strlen(product_key) + strlen(device_name) + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_THING_DELETE_FMT, res, product_key, device_name, devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_THING_DELETE, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_THING_DELETE, message_len, DM_MSG_EVENT_THING_DELETE_FMT,
+                                   res, product_key, device_name, devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -1088,6 +1003,7 @@ int dm_msg_thing_sub_register_reply(dm_msg_response_payload_t *response)
 {
     int res = 0, index = 0, message_len = 0, devid = 0;
     lite_cjson_t lite, lite_item, lite_item_pk, lite_item_dn, lite_item_ds;
+    lite_cjson_iter_t iter;
     char *message = NULL;
     char product_key[PRODUCT_KEY_MAXLEN] = {0};
     char device_name[DEVICE_NAME_MAXLEN] = {0};
@@ -1103,6 +1019,7 @@ int dm_msg_thing_sub_register_reply(dm_msg_response_payload_t *response)
         return DM_JSON_PARSE_FAILED;
     }
 
+    lite_cjson_iter_init(&lite, &iter);
     for (index = 0; index < lite.size; index++) {
         devid = 0;
         message_len = 0;
@@ -1117,7 +1034,7 @@ int dm_msg_thing_sub_register_reply(dm_msg_response_payload_t *response)
 
         /* dm_log_debug("Current Index: %d", index); */
         /* Item */
-        res = lite_cjson_array_item(&lite, index, &lite_item);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_item);
         if (res != SUCCESS_RETURN || !lite_cjson_is_object(&lite_item)) {
             continue;
         }
@@ -1233,7 +1150,6 @@ int dm_msg_thing_topo_add_reply(dm_msg_response_payload_t *response)
 {
     int res = 0, devid = 0, id = 0, message_len = 0;
     char int_id[DM_UTILS_UINT32_STRLEN] = {0};
-    char *message = NULL;
 
     if (response->id.value_length > DM_UTILS_UINT32_STRLEN) {
         return FAIL_RETURN;
@@ -1259,16 +1175,9 @@ int dm_msg_thing_topo_add_reply(dm_msg_response_payload_t *response)
 #endif
 
     message_len = strlen(DM_MSG_EVENT_THING_TOPO_ADD_REPLY_FMT) + DM_UTILS_UINT32_STRLEN * 3 + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_THING_TOPO_ADD_REPLY_FMT, id, response->code.value_int, devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_TOPO_ADD_REPLY, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_TOPO_ADD_REPLY, message_len, DM_MSG_EVENT_THING_TOPO_ADD_REPLY_FMT,
+                                   id, response->code.value_int, devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -1280,7 +1189,6 @@ int dm_msg_thing_topo_delete_reply(dm_msg_response_payload_t *response)
 {
     int res = 0, devid = 0, id = 0, message_len = 0;
     char int_id[DM_UTILS_UINT32_STRLEN] = {0};
-    char *message = NULL;
 
     if (response->id.value_length > DM_UTILS_UINT32_STRLEN) {
         return FAIL_RETURN;
@@ -1306,16 +1214,9 @@ int dm_msg_thing_topo_delete_reply(dm_msg_response_payload_t *response)
 #endif
 
     message_len = strlen(DM_MSG_EVENT_THING_TOPO_DELETE_REPLY_FMT) + DM_UTILS_UINT32_STRLEN * 3 + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_THING_TOPO_DELETE_REPLY_FMT, id, response->code.value_int, devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_TOPO_DELETE_REPLY, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_TOPO_DELETE_REPLY, message_len, DM_MSG_EVENT_THING_TOPO_DELETE_REPLY_FMT,
+                                   id, response->code.value_int, devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -1326,7 +1227,6 @@ const char DM_MSG_TOPO_GET_REPLY_FMT[] DM_READ_ONLY = "{\"id\":%d,\"code\":%d,\"
 int dm_msg_topo_get_reply(dm_msg_response_payload_t *response)
 {
     int res = 0, id = 0, message_len = 0;
-    char *message = NULL;
     char int_id[DM_UTILS_UINT32_STRLEN] = {0};
 
     if (response == NULL) {
@@ -1343,18 +1243,11 @@ int dm_msg_topo_get_reply(dm_msg_response_payload_t *response)
     /* dm_log_debug("Current ID: %d", id); */
 
     message_len = strlen(DM_MSG_TOPO_GET_REPLY_FMT) + DM_UTILS_UINT32_STRLEN * 3 + response->data.value_length + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_TOPO_GET_REPLY_FMT, id, response->code.value_int, IOTX_DM_LOCAL_NODE_DEVID,
-                 response->data.value_length,
-                 response->data.value);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_TOPO_GET_REPLY, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_TOPO_GET_REPLY, message_len, DM_MSG_TOPO_GET_REPLY_FMT,
+                                   id, response->code.value_int, IOTX_DM_LOCAL_NODE_DEVID,
+                                   response->data.value_length,
+                                   response->data.value);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -1370,7 +1263,6 @@ const char DM_MSG_EVENT_COMBINE_LOGIN_REPLY_FMT[] DM_READ_ONLY = "{\"id\":%d,\"c
 int dm_msg_combine_login_reply(dm_msg_response_payload_t *response)
 {
     int res = 0, message_len = 0, devid = 0;
-    char *message = NULL;
     lite_cjson_t lite, lite_item_pk, lite_item_dn;
     char product_key[PRODUCT_KEY_MAXLEN] = {0};
     char device_name[DEVICE_NAME_MAXLEN] = {0};
@@ -1416,17 +1308,10 @@ int dm_msg_combine_login_reply(dm_msg_response_payload_t *response)
     memcpy(temp_id, response->id.value, response->id.value_length);
 
     message_len = strlen(DM_MSG_EVENT_COMBINE_LOGIN_REPLY_FMT) + DM_UTILS_UINT32_STRLEN * 3 + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_COMBINE_LOGIN_REPLY_FMT, atoi(temp_id), response->code.value_int,
-                 devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_COMBINE_LOGIN_REPLY, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_COMBINE_LOGIN_REPLY, message_len, DM_MSG_EVENT_COMBINE_LOGIN_REPLY_FMT,
+                                   atoi(temp_id), response->code.value_int,
+                                   devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -1441,7 +1326,6 @@ const char DM_MSG_EVENT_COMBINE_LOGOUT_REPLY_FMT[] DM_READ_ONLY = "{\"id\":%d,\"
 int dm_msg_combine_logout_reply(dm_msg_response_payload_t *response)
 {
     int res = 0, message_len = 0, devid = 0;
-    char *message = NULL;
     lite_cjson_t lite, lite_item_pk, lite_item_dn;
     char product_key[PRODUCT_KEY_MAXLEN] = {0};
     char device_name[DEVICE_NAME_MAXLEN] = {0};
@@ -1487,17 +1371,10 @@ int dm_msg_combine_logout_reply(dm_msg_response_payload_t *response)
     memcpy(temp_id, response->id.value, response->id.value_length);
 
     message_len = strlen(DM_MSG_EVENT_COMBINE_LOGOUT_REPLY_FMT) + DM_UTILS_UINT32_STRLEN * 3 + 1;
-    message = DM_malloc(message_len);
-    if (message == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-    memset(message, 0, message_len);
-    HAL_Snprintf(message, message_len, DM_MSG_EVENT_COMBINE_LOGOUT_REPLY_FMT, atoi(temp_id), response->code.value_int,
-                 devid);
-
-    res = _dm_msg_send_to_user(IOTX_DM_EVENT_COMBINE_LOGOUT_REPLY, message);
+    res = _dm_msg_send_to_user_fmt(IOTX_DM_EVENT_COMBINE_LOGOUT_REPLY, message_len, DM_MSG_EVENT_COMBINE_LOGOUT_REPLY_FMT,
+                                   atoi(temp_id), response->code.value_int,
+                                   devid);
     if (res != SUCCESS_RETURN) {
-        DM_free(message);
         return FAIL_RETURN;
     }
 
@@ -2060,11 +1937,13 @@ static int _dm_msg_set_object(dm_msg_set_type_t type, int devid, char *key, lite
     int res = 0, index = 0;
     lite_cjson_t lite_item_key;
     lite_cjson_t lite_item_value;
+    lite_cjson_iter_t iter;
     char *new_key = NULL;
     int new_key_len = 0;
 
+    lite_cjson_iter_init(root, &iter);
     for (index = 0; index < root->size; index++) {
-        res = lite_cjson_object_item_by_index(root, index, &lite_item_key, &lite_item_value);
+        res = lite_cjson_iter_next(&iter, &lite_item_key, &lite_item_value);
         if (res != SUCCESS_RETURN) {
             continue;
         }
@@ -2112,13 +1991,15 @@ static int _dm_msg_set_array(dm_msg_set_type_t type, int devid, char *key, lite_
 {
     int res = 0, index = 0;
     lite_cjson_t lite_item_value;
+    lite_cjson_iter_t iter;
     char *ascii_index = NULL;
     char *new_key = NULL;
     int new_key_len = 0;
 
+    lite_cjson_iter_init(root, &iter);
     for (index = 0; index < root->size; index++) {
 
-        res = lite_cjson_array_item(root, index, &lite_item_value);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_item_value);
         if (res != SUCCESS_RETURN) {
             continue;
         }
@@ -2216,11 +2097,14 @@ int dm_msg_property_set(int devid, dm_msg_request_payload_t *request)
 #else
     int index = 0;
     lite_cjson_t lite_item_key, lite_item_value;
+    lite_cjson_iter_t iter;
+
+    lite_cjson_iter_init(&lite, &iter);
     for (index = 0; index < lite.size; index++) {
         memset(&lite_item_key, 0, sizeof(lite_cjson_t));
         memset(&lite_item_value, 0, sizeof(lite_cjson_t));
 
-        res = lite_cjson_object_item_by_index(&lite, index, &lite_item_key, &lite_item_value);
+        res = lite_cjson_iter_next(&iter, &lite_item_key, &lite_item_value);
         if (res != SUCCESS_RETURN) {
             continue;
         }
@@ -2248,17 +2132,13 @@ int dm_msg_property_get(_IN_ int devid, _IN_ dm_msg_request_payload_t *request,
 {
     int res = 0, index = 0;
     lite_cjson_t lite, lite_item;
-    lite_cjson_item_t *lite_cjson_item = NULL;
+    lite_cjson_iter_t iter;
+    dm_utils_json_writer_t writer;
 
     if (devid < 0 || request == NULL || payload == NULL || *payload != NULL || payload_len == NULL) {
         return DM_INVALID_PARAMETER;
     }
 
-    lite_cjson_item = lite_cjson_create_object();
-    if (lite_cjson_item == NULL) {
-        return DM_MEMORY_NOT_ENOUGH;
-    }
-
     /* Parse Root */
     memset(&lite, 0, sizeof(lite_cjson_t));
     res = lite_cjson_parse(request->params.value, request->params.value_length, &lite);
@@ -2267,34 +2147,37 @@ int dm_msg_property_get(_IN_ int devid, _IN_ dm_msg_request_payload_t *request,
     }
     /* dm_log_info("Property Get, Size: %d", lite.size); */
 
+    dm_utils_json_writer_init(&writer, NULL, 0);
+    dm_utils_json_writer_object_begin(&writer, NULL);
+
     /* Parse Params */
+    lite_cjson_iter_init(&lite, &iter);
     for (index = 0; index < lite.size; index++) {
         memset(&lite_item, 0, sizeof(lite_cjson_t));
-        res = lite_cjson_array_item(&lite, index, &lite_item);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_item);
         if (res != SUCCESS_RETURN) {
-            lite_cjson_delete(lite_cjson_item);
+            dm_utils_json_writer_deinit(&writer);
             return FAIL_RETURN;
         }
 
         if (!lite_cjson_is_string(&lite_item)) {
-            lite_cjson_delete(lite_cjson_item);
+            dm_utils_json_writer_deinit(&writer);
             return FAIL_RETURN;
         }
 
-        res = dm_mgr_deprecated_assemble_property(devid, lite_item.value, lite_item.value_length, lite_cjson_item);
+        res = dm_mgr_deprecated_assemble_property(devid, lite_item.value, lite_item.value_length, &writer);
         if (res != SUCCESS_RETURN) {
-            lite_cjson_delete(lite_cjson_item);
+            dm_utils_json_writer_deinit(&writer);
             return FAIL_RETURN;
         }
     }
 
-    *payload = lite_cjson_print_unformatted(lite_cjson_item);
-    if (*payload == NULL) {
-        lite_cjson_delete(lite_cjson_item);
+    dm_utils_json_writer_object_end(&writer);
+    res = dm_utils_json_writer_finish(&writer, payload, payload_len);
+    dm_utils_json_writer_deinit(&writer);
+    if (res != SUCCESS_RETURN) {
         return FAIL_RETURN;
     }
-    lite_cjson_delete(lite_cjson_item);
-    *payload_len = strlen(*payload);
 
     return SUCCESS_RETURN;
 }
@@ -89,6 +89,7 @@ typedef struct {
 int dm_msg_init(void);
 int dm_msg_deinit(void);
 int _dm_msg_send_to_user(iotx_dm_event_types_t type, char *message);
+int _dm_msg_send_to_user_fmt(iotx_dm_event_types_t type, int message_len, const char *fmt, ...);
 int dm_msg_send_msg_timeout_to_user(int msg_id, int devid, iotx_dm_event_types_t type);
 int dm_msg_uri_parse_pkdn(_IN_ char *uri, _IN_ int uri_len, _IN_ int start_deli, _IN_ int end_deli,
                           _OU_ char product_key[PRODUCT_KEY_MAXLEN], _OU_ char device_name[DEVICE_NAME_MAXLEN]);
@@ -6,6 +6,12 @@
 
 dm_msg_cache_ctx_t g_dm_msg_cache_ctx;
 
+static const utils_slab_config_t g_dm_msg_cache_slab_config = {
+    "dm", DM_MSG_CACHE_SLAB_PAGE_SIZE, DM_MSG_CACHE_SLAB_MAX_PAGES, 1, { sizeof(dm_msg_cache_node_t) }
+};
+
+static utils_slab_pool_t g_dm_msg_cache_slab = UTILS_SLAB_POOL_INIT(&g_dm_msg_cache_slab_config);
+
 dm_msg_cache_ctx_t *_dm_msg_cache_get_ctx(void)
 {
     return &g_dm_msg_cache_ctx;
@@ -45,6 +51,64 @@ int dm_msg_cache_init(void)
     return SUCCESS_RETURN;
 }
 
+static dm_msg_cache_node_t **_dm_msg_cache_bucket(_IN_ int msgid)
+{
+    dm_msg_cache_ctx_t *ctx = _dm_msg_cache_get_ctx();
+
+    /* message id is sequential, low bits spread well */
+    return &ctx->hash_buckets[(uint32_t)msgid & (ctx->hash_bucket_num - 1)];
+}
+
+static int _dm_msg_cache_rehash(_IN_ int bucket_num)
+{
+    dm_msg_cache_ctx_t *ctx = _dm_msg_cache_get_ctx();
+    dm_msg_cache_node_t **buckets = NULL;
+    dm_msg_cache_node_t **bucket = NULL;
+    dm_msg_cache_node_t *node = NULL;
+
+    buckets = DM_malloc(bucket_num * sizeof(dm_msg_cache_node_t *));
+    if (buckets == NULL) {
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+    memset(buckets, 0, bucket_num * sizeof(dm_msg_cache_node_t *));
+
+    if (ctx->hash_buckets) {
+        DM_free(ctx->hash_buckets);
+    }
+    ctx->hash_buckets = buckets;
+    ctx->hash_bucket_num = bucket_num;
+
+    /* walk list in order, so that the first inserted one of duplicated msgid is still found first */
+    list_for_each_entry(node, &ctx->dmc_list, linked_list, dm_msg_cache_node_t) {
+        for (bucket = _dm_msg_cache_bucket(node->msgid); *bucket != NULL; bucket = &(*bucket)->hash_next);
+        node->hash_next = NULL;
+        *bucket = node;
+    }
+
+    return SUCCESS_RETURN;
+}
+
+static void _dm_msg_cache_unlink(_IN_ dm_msg_cache_node_t *node)
+{
+    dm_msg_cache_ctx_t *ctx = _dm_msg_cache_get_ctx();
+    dm_msg_cache_node_t **bucket = NULL;
+
+    for (bucket = _dm_msg_cache_bucket(node->msgid); *bucket != NULL; bucket = &(*bucket)->hash_next) {
+        if (*bucket == node) {
+            *bucket = node->hash_next;
+            break;
+        }
+    }
+
+    list_del(&node->linked_list);
+    ctx->dmc_list_size--;
+
+    if (node->data) {
+        DM_free(node->data);
+    }
+    utils_slab_free(node);
+}
+
 int dm_msg_cache_deinit(void)
 {
     dm_msg_cache_ctx_t *ctx = _dm_msg_cache_get_ctx();
@@ -53,15 +117,16 @@ int dm_msg_cache_deinit(void)
 
     _dm_msg_cache_mutex_lock();
     list_for_each_entry_safe(node, next, &ctx->dmc_list, linked_list, dm_msg_cache_node_t) {
-        list_del(&node->linked_list);
-        if (node->data) {
-            DM_free(node->data);
-        }
-        DM_free(node);
-        _dm_msg_cache_mutex_unlock();
+        _dm_msg_cache_unlink(node);
+    }
+    if (ctx->hash_buckets) {
+        DM_free(ctx->hash_buckets);
     }
+    ctx->hash_bucket_num = 0;
     _dm_msg_cache_mutex_unlock();
 
+    utils_slab_shrink(&g_dm_msg_cache_slab);
+
     if (ctx->mutex) {
         HAL_MutexDestroy(ctx->mutex);
     }
@@ -71,19 +136,20 @@ int dm_msg_cache_deinit(void)
 
 int dm_msg_cache_insert(int msgid, int devid, iotx_dm_event_types_t type, char *data)
 {
+    int res = 0;
     dm_msg_cache_ctx_t *ctx = _dm_msg_cache_get_ctx();
     dm_msg_cache_node_t *node = NULL;
+    dm_msg_cache_node_t **bucket = NULL;
 
     dm_log_debug("dmc list size: %d", ctx->dmc_list_size);
     if (ctx->dmc_list_size >= CONFIG_MSGCACHE_QUEUE_MAXLEN) {
         return FAIL_RETURN;
     }
 
-    node = DM_malloc(sizeof(dm_msg_cache_node_t));
+    node = utils_slab_alloc(&g_dm_msg_cache_slab, sizeof(dm_msg_cache_node_t));
     if (node == NULL) {
         return DM_MEMORY_NOT_ENOUGH;
     }
-    memset(node, 0, sizeof(dm_msg_cache_node_t));
 
     node->msgid = msgid;
     node->devid = devid;
@@ -93,7 +159,19 @@ int dm_msg_cache_insert(int msgid, int devid, iotx_dm_event_types_t type, char *
     INIT_LIST_HEAD(&node->linked_list);
 
     _dm_msg_cache_mutex_lock();
+    if (ctx->dmc_list_size >= ctx->hash_bucket_num) {
+        res = _dm_msg_cache_rehash((ctx->hash_bucket_num > 0) ? (ctx->hash_bucket_num << 1) : DM_MSG_CACHE_HASH_SIZE_MIN);
+        if (res != SUCCESS_RETURN) {
+            _dm_msg_cache_mutex_unlock();
+            utils_slab_free(node);
+            return res;
+        }
+    }
+
+    /* every node has the same timeout, appending keeps list ordered by expiry */
     list_add_tail(&node->linked_list, &ctx->dmc_list);
+    for (bucket = _dm_msg_cache_bucket(msgid); *bucket != NULL; bucket = &(*bucket)->hash_next);
+    *bucket = node;
     ctx->dmc_list_size++;
     _dm_msg_cache_mutex_unlock();
 
@@ -110,11 +188,13 @@ int dm_msg_cache_search(_IN_ int msgid, _OU_ dm_msg_cache_node_t **node)
     }
 
     _dm_msg_cache_mutex_lock();
-    list_for_each_entry(search_node, &ctx->dmc_list, linked_list, dm_msg_cache_node_t) {
-        if (search_node->msgid == msgid) {
-            *node = search_node;
-            _dm_msg_cache_mutex_unlock();
-            return SUCCESS_RETURN;
+    if (ctx->hash_buckets != NULL) {
+        for (search_node = *_dm_msg_cache_bucket(msgid); search_node != NULL; search_node = search_node->hash_next) {
+            if (search_node->msgid == msgid) {
+                *node = search_node;
+                _dm_msg_cache_mutex_unlock();
+                return SUCCESS_RETURN;
+            }
         }
     }
 
@@ -126,20 +206,16 @@ int dm_msg_cache_remove(int msgid)
 {
     dm_msg_cache_ctx_t *ctx = _dm_msg_cache_get_ctx();
     dm_msg_cache_node_t *node = NULL;
-    dm_msg_cache_node_t *next = NULL;
 
     _dm_msg_cache_mutex_lock();
-    list_for_each_entry_safe(node, next, &ctx->dmc_list, linked_list, dm_msg_cache_node_t) {
-        if (node->msgid == msgid) {
-            list_del(&node->linked_list);
-            if (node->data) {
-                DM_free(node->data);
+    if (ctx->hash_buckets != NULL) {
+        for (node = *_dm_msg_cache_bucket(msgid); node != NULL; node = node->hash_next) {
+            if (node->msgid == msgid) {
+                _dm_msg_cache_unlink(node);
+                dm_log_debug("Remove Message ID: %d", msgid);
+                _dm_msg_cache_mutex_unlock();
+                return SUCCESS_RETURN;
             }
-            ctx->dmc_list_size--;
-            DM_free(node);
-            dm_log_debug("Remove Message ID: %d", msgid);
-            _dm_msg_cache_mutex_unlock();
-            return SUCCESS_RETURN;
         }
     }
 
@@ -151,25 +227,24 @@ void dm_msg_cache_tick(void)
 {
     dm_msg_cache_ctx_t *ctx = _dm_msg_cache_get_ctx();
     dm_msg_cache_node_t *node = NULL;
-    dm_msg_cache_node_t *next = NULL;
     uint64_t current_time = HAL_UptimeMs();
 
+    /* list is ordered by ctime, stop at the first one not expired */
     _dm_msg_cache_mutex_lock();
-    list_for_each_entry_safe(node, next, &ctx->dmc_list, linked_list, dm_msg_cache_node_t) {
+    while (!list_empty(&ctx->dmc_list)) {
+        node = list_first_entry(&ctx->dmc_list, dm_msg_cache_node_t, linked_list);
         if (current_time < node->ctime) {
             node->ctime = current_time;
         }
-        if (current_time - node->ctime >= DM_MSG_CACHE_TIMEOUT_MS_DEFAULT) {
-            dm_log_debug("Message ID Timeout: %d", node->msgid);
-            /* Send Timeout Message To User */
-            dm_msg_send_msg_timeout_to_user(node->msgid, node->devid, node->response_type);
-            list_del(&node->linked_list);
-            if (node->data) {
-                DM_free(node->data);
-            }
-            DM_free(node);
+        if (current_time - node->ctime < DM_MSG_CACHE_TIMEOUT_MS_DEFAULT) {
+            break;
         }
+
+        dm_log_debug("Message ID Timeout: %d", node->msgid);
+        /* Send Timeout Message To User */
+        dm_msg_send_msg_timeout_to_user(node->msgid, node->devid, node->response_type);
+        _dm_msg_cache_unlink(node);
     }
     _dm_msg_cache_mutex_unlock();
 }
-#endif
\ No newline at end of file
+#endif
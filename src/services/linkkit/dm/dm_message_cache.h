@@ -10,20 +10,26 @@
 #include "iotx_dm_internal.h"
 
 #define DM_MSG_CACHE_TIMEOUT_MS_DEFAULT (10000)
+#define DM_MSG_CACHE_HASH_SIZE_MIN      (16)
+#define DM_MSG_CACHE_SLAB_PAGE_SIZE     (1024)
+#define DM_MSG_CACHE_SLAB_MAX_PAGES     (16)
 
-typedef struct {
+typedef struct dm_msg_cache_node_s {
     int msgid;
     int devid;
     iotx_dm_event_types_t response_type;
     char *data;
     uint64_t ctime;
+    struct dm_msg_cache_node_s *hash_next;       //next node in the same bucket of msgid hash
     struct list_head linked_list;
 } dm_msg_cache_node_t;
 
 typedef struct {
     void *mutex;
     int dmc_list_size;
-    struct list_head dmc_list;
+    struct list_head dmc_list;                   //ordered by ctime, so that the first node expires first
+    int hash_bucket_num;                         //power of 2, no less than dmc_list_size
+    dm_msg_cache_node_t **hash_buckets;          //nodes hashed by msgid
 } dm_msg_cache_ctx_t;
 
 int dm_msg_cache_init(void);
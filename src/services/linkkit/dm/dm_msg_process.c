@@ -78,6 +78,8 @@ const char DM_URI_DEV_CORE_SERVICE_DEV[]              DM_READ_ONLY = "/dev/core/
     const char DM_URI_THING_TOPO_GET_REPLY[]              DM_READ_ONLY = "thing/topo/get_reply";
     const char DM_URI_THING_LIST_FOUND[]                  DM_READ_ONLY = "thing/list/found";
     const char DM_URI_THING_LIST_FOUND_REPLY[]            DM_READ_ONLY = "thing/list/found_reply";
+    const char DM_URI_THING_EVENT_PROPERTY_PACK_POST[]    DM_READ_ONLY = "thing/event/property/pack/post";
+    const char DM_URI_THING_EVENT_PROPERTY_PACK_POST_REPLY[] DM_READ_ONLY = "thing/event/property/pack/post_reply";
     const char DM_URI_COMBINE_LOGIN[]                     DM_READ_ONLY = "combine/login";
     const char DM_URI_COMBINE_LOGIN_REPLY[]               DM_READ_ONLY = "combine/login_reply";
     const char DM_URI_COMBINE_LOGOUT[]                    DM_READ_ONLY = "combine/logout";
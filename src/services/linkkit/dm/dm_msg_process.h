@@ -80,6 +80,8 @@ extern const char DM_URI_DEV_CORE_SERVICE_DEV[]              DM_READ_ONLY;
     extern const char DM_URI_THING_TOPO_GET_REPLY[]              DM_READ_ONLY;
     extern const char DM_URI_THING_LIST_FOUND[]                  DM_READ_ONLY;
     extern const char DM_URI_THING_LIST_FOUND_REPLY[]            DM_READ_ONLY;
+    extern const char DM_URI_THING_EVENT_PROPERTY_PACK_POST[]    DM_READ_ONLY;
+    extern const char DM_URI_THING_EVENT_PROPERTY_PACK_POST_REPLY[] DM_READ_ONLY;
     extern const char DM_URI_COMBINE_LOGIN[]                     DM_READ_ONLY;
     extern const char DM_URI_COMBINE_LOGIN_REPLY[]               DM_READ_ONLY;
     extern const char DM_URI_COMBINE_LOGOUT[]                    DM_READ_ONLY;
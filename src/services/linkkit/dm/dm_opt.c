@@ -6,7 +6,7 @@
 #include "iotx_dm_internal.h"
 
 static dm_opt_ctx g_dm_opt = {
-    0, 0, 1
+    0, 0, 1, 0
 };
 
 int dm_opt_set(dm_opt_t opt, void *data)
@@ -33,6 +33,14 @@ int dm_opt_set(dm_opt_t opt, void *data)
             g_dm_opt.prop_set_reply_opt = opt;
         }
         break;
+        case DM_OPT_UPSTREAM_PROPERTY_POST_COALESCE: {
+            int opt = *(int *)(data);
+            if (opt < 0) {
+                return FAIL_RETURN;
+            }
+            g_dm_opt.prop_post_coalesce_ms = opt;
+        }
+        break;
         default: {
             res = FAIL_RETURN;
         }
@@ -63,6 +71,14 @@ int dm_opt_get(dm_opt_t opt, void *data)
             *(int *)(data) = g_dm_opt.prop_set_reply_opt;
         }
         break;
+        case DM_OPT_UPSTREAM_PROPERTY_POST_COALESCE: {
+            *(int *)(data) = g_dm_opt.prop_post_coalesce_ms;
+        }
+        break;
+        case DM_OPT_UPSTREAM_PROPERTY_POST_STATS: {
+            res = dm_coalesce_get_stats((iotx_ioctl_prop_post_stats_t *)data);
+        }
+        break;
         default: {
             res = FAIL_RETURN;
         }
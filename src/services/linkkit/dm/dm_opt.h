@@ -9,13 +9,16 @@
 typedef enum {
     DM_OPT_DOWNSTREAM_PROPERTY_POST_REPLY,
     DM_OPT_DOWNSTREAM_EVENT_POST_REPLY,
-    DM_OPT_UPSTREAM_PROPERTY_SET_REPLY
+    DM_OPT_UPSTREAM_PROPERTY_SET_REPLY,
+    DM_OPT_UPSTREAM_PROPERTY_POST_COALESCE,
+    DM_OPT_UPSTREAM_PROPERTY_POST_STATS
 } dm_opt_t;
 
 typedef struct {
     int prop_post_reply_opt;
     int event_post_reply_opt;
     int prop_set_reply_opt;
+    int prop_post_coalesce_ms;
 } dm_opt_ctx;
 
 int dm_opt_set(dm_opt_t opt, void *data);
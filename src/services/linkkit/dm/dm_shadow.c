@@ -346,10 +346,382 @@ static int _dm_shw_data_search(_IN_ dm_shw_data_t *input, _IN_ char *key,
     return FAIL_RETURN;
 }
 
+static uint32_t _dm_shw_hash_update(_IN_ uint32_t hash, _IN_ const char *key, _IN_ int key_len)
+{
+    int index = 0;
+
+    /* FNV-1a */
+    for (index = 0; index < key_len; index++) {
+        hash ^= (uint8_t)key[index];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+uint32_t dm_shw_table_hash(_IN_ uint32_t seed, _IN_ const char *key, _IN_ int key_len)
+{
+    return _dm_shw_hash_update(2166136261u ^ seed, key, key_len);
+}
+
+/* candidate index of top level identifier @key in precompiled table, -1 if absent */
+static int _dm_shw_table_search(_IN_ dm_shw_t *shadow, _IN_ const short *slots, _IN_ char *key, _IN_ int key_len)
+{
+    const dm_shw_table_t *table = shadow->table;
+
+    if (slots == NULL || table->hash_size <= 0) {
+        return -1;
+    }
+
+    return slots[dm_shw_table_hash(table->hash_seed, key, key_len) & (table->hash_size - 1)];
+}
+
+#if WITH_DM_SHW_INDEX
+/* each kind has its own namespace of paths, event and service entries are roots of their datas */
+typedef enum {
+    DM_SHW_INDEX_KIND_PROPERTY,
+    DM_SHW_INDEX_KIND_EVENT,
+    DM_SHW_INDEX_KIND_SERVICE_INPUT,
+    DM_SHW_INDEX_KIND_SERVICE_OUTPUT
+} dm_shw_index_kind_e;
+
+typedef struct {
+    uint32_t hash;                               //hash of kind and full path, such as "a.b[3].c"
+    int next;                                    //next entry in the same bucket, -1 for end
+    int parent;                                  //entry of parent path, -1 for top level
+    int element;                                 //index in struct array if entry is an element, otherwise -1
+    dm_shw_index_kind_e kind;
+    uintptr_t node;                              //dm_shw_data_t, or dm_shw_event_t/dm_shw_service_t for top level,
+                                                 //relative to shadow if shadow is created from table
+} dm_shw_index_entry_t;
+
+typedef struct dm_shw_index_s {
+    int entry_num;
+    int bucket_num;                              //power of 2
+    dm_shw_index_entry_t *entries;
+    int *buckets;
+} dm_shw_index_t;
+
+static int _dm_shw_index_is_data(_IN_ dm_shw_index_entry_t *entry)
+{
+    return (entry->parent >= 0 || entry->kind == DM_SHW_INDEX_KIND_PROPERTY);
+}
+
+/* shadows created from the same table share layout, so that they can share one index */
+static uintptr_t _dm_shw_index_base(_IN_ dm_shw_t *shadow)
+{
+    return (shadow->table != NULL) ? (uintptr_t)shadow : 0;
+}
+
+static void *_dm_shw_index_node(_IN_ dm_shw_t *shadow, _IN_ dm_shw_index_entry_t *entry)
+{
+    return (void *)(entry->node + _dm_shw_index_base(shadow));
+}
+
+static const char *_dm_shw_index_identifier(_IN_ dm_shw_t *shadow, _IN_ dm_shw_index_entry_t *entry)
+{
+    void *node = _dm_shw_index_node(shadow, entry);
+
+    if (_dm_shw_index_is_data(entry)) {
+        return ((dm_shw_data_t *)node)->identifier;
+    }
+    if (entry->kind == DM_SHW_INDEX_KIND_EVENT) {
+        return ((dm_shw_event_t *)node)->identifier;
+    }
+    return ((dm_shw_service_t *)node)->identifier;
+}
+
+/* compare path of @entry with @key segment by segment from the tail */
+static int _dm_shw_index_match(_IN_ dm_shw_t *shadow, _IN_ dm_shw_index_entry_t *entry, _IN_ const char *key,
+                               _IN_ int key_len)
+{
+    int len = 0;
+    const char *segment = NULL;
+    char element[DM_UTILS_UINT32_STRLEN + 2] = {0};
+
+    while (1) {
+        if (entry->element >= 0) {
+            len = HAL_Snprintf(element, sizeof(element), "[%d]", entry->element);
+            segment = element;
+        } else {
+            segment = _dm_shw_index_identifier(shadow, entry);
+            len = (segment == NULL) ? 0 : strlen(segment);
+        }
+        if (len == 0 || len > key_len || memcmp(key + key_len - len, segment, len) != 0) {
+            return 0;
+        }
+        key_len -= len;
+
+        if (entry->parent < 0) {
+            return (key_len == 0);
+        }
+        if (entry->element < 0) {
+            if (key_len == 0 || key[key_len - 1] != DM_SHW_KEY_DELIMITER) {
+                return 0;
+            }
+            key_len--;
+        }
+        entry = shadow->index->entries + entry->parent;
+    }
+}
+
+static dm_shw_index_entry_t *_dm_shw_index_lookup(_IN_ dm_shw_t *shadow, _IN_ dm_shw_index_kind_e kind,
+        _IN_ const char *key, _IN_ int key_len)
+{
+    int pos = 0;
+    uint32_t hash = dm_shw_table_hash(kind, key, key_len);
+    dm_shw_index_t *index = shadow->index;
+    dm_shw_index_entry_t *entry = NULL;
+
+    for (pos = index->buckets[hash & (index->bucket_num - 1)]; pos >= 0; pos = entry->next) {
+        entry = index->entries + pos;
+        if (entry->hash == hash && entry->kind == kind && _dm_shw_index_match(shadow, entry, key, key_len)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * resolve @key of @kind to its node, trailing index of primitive array like "a.b[3]" is returned by @array_index,
+ * element of struct array itself is not addressable as _dm_shw_data_search() does
+ */
+static int _dm_shw_index_search(_IN_ dm_shw_t *shadow, _IN_ dm_shw_index_kind_e kind, _IN_ char *key,
+                                _IN_ int key_len, _OU_ void **node, _OU_ int *array_index)
+{
+    int pos = 0, number = 0;
+    dm_shw_index_entry_t *entry = NULL;
+    dm_shw_data_t *data = NULL;
+    dm_shw_data_value_complex_t *complex_array = NULL;
+
+    if (shadow->index == NULL) {
+        return FAIL_RETURN;
+    }
+
+    entry = _dm_shw_index_lookup(shadow, kind, key, key_len);
+    if (entry != NULL) {
+        if (!_dm_shw_index_is_data(entry) || entry->element >= 0) {
+            return FAIL_RETURN;
+        }
+        if (node) {
+            *node = _dm_shw_index_node(shadow, entry);
+        }
+        return SUCCESS_RETURN;
+    }
+
+    if (key_len < 3 || key[key_len - 1] != ']') {
+        return FAIL_RETURN;
+    }
+    for (pos = key_len - 2; pos > 0 && key[pos] >= '0' && key[pos] <= '9'; pos--);
+    if (pos <= 0 || pos == key_len - 2 || key[pos] != '[') {
+        return FAIL_RETURN;
+    }
+
+    entry = _dm_shw_index_lookup(shadow, kind, key, pos);
+    if (entry == NULL || !_dm_shw_index_is_data(entry) || entry->element >= 0) {
+        return FAIL_RETURN;
+    }
+    data = (dm_shw_data_t *)_dm_shw_index_node(shadow, entry);
+    if (data->data_value.type != DM_SHW_DATA_TYPE_ARRAY) {
+        return FAIL_RETURN;
+    }
+    complex_array = (dm_shw_data_value_complex_t *)data->data_value.value;
+    if (complex_array == NULL || complex_array->type == DM_SHW_DATA_TYPE_ARRAY ||
+        complex_array->type == DM_SHW_DATA_TYPE_STRUCT) {
+        return FAIL_RETURN;
+    }
+
+    for (pos = pos + 1, number = 0; pos < key_len - 1; pos++) {
+        number = number * 10 + (key[pos] - '0');
+    }
+    if (node) {
+        *node = data;
+    }
+    if (array_index) {
+        *array_index = number;
+    }
+
+    return SUCCESS_RETURN;
+}
+
+static uint32_t _dm_shw_index_member_hash(_IN_ uint32_t hash, _IN_ const char *identifier)
+{
+    hash = _dm_shw_hash_update(hash, ".", 1);
+    return _dm_shw_hash_update(hash, identifier, (identifier == NULL) ? 0 : strlen(identifier));
+}
+
+static int _dm_shw_index_data_count(_IN_ dm_shw_data_t *data)
+{
+    int count = 1, index = 0;
+    dm_shw_data_value_complex_t *complex_value = (dm_shw_data_value_complex_t *)data->data_value.value;
+
+    if (complex_value == NULL || complex_value->value == NULL) {
+        return count;
+    }
+
+    /* members of struct, or elements of struct array which are structs themselves */
+    if (data->data_value.type == DM_SHW_DATA_TYPE_STRUCT ||
+        (data->data_value.type == DM_SHW_DATA_TYPE_ARRAY && complex_value->type == DM_SHW_DATA_TYPE_STRUCT)) {
+        for (index = 0; index < complex_value->size; index++) {
+            count += _dm_shw_index_data_count((dm_shw_data_t *)complex_value->value + index);
+        }
+    }
+
+    return count;
+}
+
+static int _dm_shw_index_insert(_IN_ dm_shw_index_t *index, _IN_ dm_shw_index_kind_e kind, _IN_ int parent,
+                                _IN_ int element, _IN_ uint32_t hash, _IN_ void *node)
+{
+    int *slot = NULL;
+    dm_shw_index_entry_t *entry = index->entries + index->entry_num;
+
+    entry->hash = hash;
+    entry->next = -1;
+    entry->parent = parent;
+    entry->element = element;
+    entry->kind = kind;
+    entry->node = (uintptr_t)node;
+
+    /* append to tail so that the first one of duplicated paths wins, same as linear search */
+    for (slot = &index->buckets[hash & (index->bucket_num - 1)]; *slot >= 0; slot = &index->entries[*slot].next);
+    *slot = index->entry_num;
+
+    return index->entry_num++;
+}
+
+static void _dm_shw_index_data_add(_IN_ dm_shw_index_t *index, _IN_ dm_shw_index_kind_e kind, _IN_ int parent,
+                                   _IN_ int element, _IN_ uint32_t hash, _IN_ dm_shw_data_t *data)
+{
+    int pos = 0, item_index = 0, len = 0;
+    char path[DM_UTILS_UINT32_STRLEN + 2] = {0};
+    dm_shw_data_t *item = NULL;
+    dm_shw_data_value_complex_t *complex_value = (dm_shw_data_value_complex_t *)data->data_value.value;
+
+    pos = _dm_shw_index_insert(index, kind, parent, element, hash, data);
+
+    if (complex_value == NULL || complex_value->value == NULL) {
+        return;
+    }
+
+    if (data->data_value.type == DM_SHW_DATA_TYPE_STRUCT) {
+        for (item_index = 0; item_index < complex_value->size; item_index++) {
+            item = (dm_shw_data_t *)complex_value->value + item_index;
+            _dm_shw_index_data_add(index, kind, pos, -1, _dm_shw_index_member_hash(hash, item->identifier), item);
+        }
+    } else if (data->data_value.type == DM_SHW_DATA_TYPE_ARRAY && complex_value->type == DM_SHW_DATA_TYPE_STRUCT) {
+        for (item_index = 0; item_index < complex_value->size; item_index++) {
+            item = (dm_shw_data_t *)complex_value->value + item_index;
+            len = HAL_Snprintf(path, sizeof(path), "[%d]", item_index);
+            _dm_shw_index_data_add(index, kind, pos, item_index, _dm_shw_hash_update(hash, path, len), item);
+        }
+    }
+}
+
+static void _dm_shw_index_datas_add(_IN_ dm_shw_index_t *index, _IN_ dm_shw_index_kind_e kind, _IN_ int parent,
+                                    _IN_ dm_shw_data_t *datas, _IN_ int number)
+{
+    int item_index = 0;
+    uint32_t hash = index->entries[parent].hash;
+
+    for (item_index = 0; item_index < number; item_index++) {
+        _dm_shw_index_data_add(index, kind, parent, -1, _dm_shw_index_member_hash(hash, datas[item_index].identifier),
+                               datas + item_index);
+    }
+}
+
+static uint32_t _dm_shw_index_root_hash(_IN_ dm_shw_index_kind_e kind, _IN_ const char *identifier)
+{
+    return dm_shw_table_hash(kind, identifier, (identifier == NULL) ? 0 : strlen(identifier));
+}
+
+static int _dm_shw_index_build(_IN_ dm_shw_t *shadow, _OU_ dm_shw_index_t **shadow_index)
+{
+    int count = 0, bucket_num = 1, item_index = 0, data_index = 0, pos = 0;
+    dm_shw_index_t *index = NULL;
+    dm_shw_data_t *data = NULL;
+    dm_shw_event_t *event = NULL;
+    dm_shw_service_t *service = NULL;
+
+    /* count entries first, then everything is allocated in one block */
+    for (item_index = 0; item_index < shadow->property_number; item_index++) {
+        count += _dm_shw_index_data_count(shadow->properties + item_index);
+    }
+    for (item_index = 0; item_index < shadow->event_number; item_index++) {
+        event = shadow->events + item_index;
+        count += 1;
+        for (data_index = 0; data_index < event->output_data_number; data_index++) {
+            count += _dm_shw_index_data_count(event->output_datas + data_index);
+        }
+    }
+    for (item_index = 0; item_index < shadow->service_number; item_index++) {
+        service = shadow->services + item_index;
+        count += 2;
+        for (data_index = 0; data_index < service->input_data_number; data_index++) {
+            count += _dm_shw_index_data_count(service->input_datas + data_index);
+        }
+        for (data_index = 0; data_index < service->output_data_number; data_index++) {
+            count += _dm_shw_index_data_count(service->output_datas + data_index);
+        }
+    }
+
+    if (count == 0) {
+        return SUCCESS_RETURN;
+    }
+    while (bucket_num < count) {
+        bucket_num <<= 1;
+    }
+
+    index = DM_malloc(sizeof(dm_shw_index_t) + count * sizeof(dm_shw_index_entry_t) + bucket_num * sizeof(int));
+    if (index == NULL) {
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+    memset(index, 0, sizeof(dm_shw_index_t));
+    index->bucket_num = bucket_num;
+    index->entries = (dm_shw_index_entry_t *)(index + 1);
+    index->buckets = (int *)(index->entries + count);
+    memset(index->buckets, 0xFF, bucket_num * sizeof(int));
+
+    for (item_index = 0; item_index < shadow->property_number; item_index++) {
+        data = shadow->properties + item_index;
+        _dm_shw_index_data_add(index, DM_SHW_INDEX_KIND_PROPERTY, -1, -1,
+                               _dm_shw_index_root_hash(DM_SHW_INDEX_KIND_PROPERTY, data->identifier), data);
+    }
+    for (item_index = 0; item_index < shadow->event_number; item_index++) {
+        event = shadow->events + item_index;
+        pos = _dm_shw_index_insert(index, DM_SHW_INDEX_KIND_EVENT, -1, -1,
+                                   _dm_shw_index_root_hash(DM_SHW_INDEX_KIND_EVENT, event->identifier), event);
+        _dm_shw_index_datas_add(index, DM_SHW_INDEX_KIND_EVENT, pos, event->output_datas, event->output_data_number);
+    }
+    for (item_index = 0; item_index < shadow->service_number; item_index++) {
+        service = shadow->services + item_index;
+        pos = _dm_shw_index_insert(index, DM_SHW_INDEX_KIND_SERVICE_INPUT, -1, -1,
+                                   _dm_shw_index_root_hash(DM_SHW_INDEX_KIND_SERVICE_INPUT, service->identifier), service);
+        _dm_shw_index_datas_add(index, DM_SHW_INDEX_KIND_SERVICE_INPUT, pos, service->input_datas,
+                                service->input_data_number);
+        pos = _dm_shw_index_insert(index, DM_SHW_INDEX_KIND_SERVICE_OUTPUT, -1, -1,
+                                   _dm_shw_index_root_hash(DM_SHW_INDEX_KIND_SERVICE_OUTPUT, service->identifier), service);
+        _dm_shw_index_datas_add(index, DM_SHW_INDEX_KIND_SERVICE_OUTPUT, pos, service->output_datas,
+                                service->output_data_number);
+    }
+
+    for (pos = 0; pos < index->entry_num; pos++) {
+        index->entries[pos].node -= _dm_shw_index_base(shadow);
+    }
+
+    *shadow_index = index;
+    dm_log_debug("TSL Index Built, Entry: %d, Bucket: %d", index->entry_num, index->bucket_num);
+
+    return SUCCESS_RETURN;
+}
+#endif
+
 static int _dm_shw_property_search(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ int key_len,
                                    _OU_ dm_shw_data_t **property, _OU_ int *index)
 {
-    int res = 0, item_index = 0;
+    int res = 0, item_index = 0, deli_offset = 0;
+    int partial_input_len = 0, array_input_len = 0, array_index = 0;
     dm_shw_data_t *property_item = NULL;
 
     if (shadow == NULL || key == NULL || key_len <= 0) {
@@ -360,6 +732,34 @@ static int _dm_shw_property_search(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ i
         return DM_TSL_PROPERTY_NOT_EXIST;
     }
 
+#if WITH_DM_SHW_INDEX
+    if (_dm_shw_index_search(shadow, DM_SHW_INDEX_KIND_PROPERTY, key, key_len, (void **)&property_item,
+                             index) == SUCCESS_RETURN) {
+        if (property) {
+            *property = property_item;
+        }
+        return SUCCESS_RETURN;
+    }
+#endif
+
+    if (shadow->table != NULL && shadow->table->property_index != NULL) {
+        /* top level identifier ends at first delimiter or array index */
+        res = dm_utils_memtok(key, key_len, DM_SHW_KEY_DELIMITER, 1, &deli_offset);
+        if (res != SUCCESS_RETURN) {
+            deli_offset = key_len;
+        }
+        res = dm_utils_strarr_index(key, deli_offset, &partial_input_len, &array_input_len, &array_index);
+        if (res == SUCCESS_RETURN) {
+            deli_offset = partial_input_len;
+        }
+
+        item_index = _dm_shw_table_search(shadow, shadow->table->property_index, key, deli_offset);
+        if (item_index < 0 || item_index >= shadow->property_number) {
+            return FAIL_RETURN;
+        }
+        return _dm_shw_data_search(shadow->properties + item_index, key, key_len, property, index);
+    }
+
     for (item_index = 0; item_index < shadow->property_number; item_index++) {
         property_item = shadow->properties + item_index;
         res = _dm_shw_data_search(property_item, key, key_len, property, index);
@@ -396,11 +796,43 @@ static int _dm_shw_event_search(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ int
 {
     int index = 0;
     dm_shw_event_t *dtsl_event = NULL;
+#if WITH_DM_SHW_INDEX
+    dm_shw_index_entry_t *entry = NULL;
+#endif
 
     if (shadow == NULL || key == NULL || key_len <= 0) {
         return DM_INVALID_PARAMETER;
     }
 
+#if WITH_DM_SHW_INDEX
+    if (shadow->index != NULL) {
+        entry = _dm_shw_index_lookup(shadow, DM_SHW_INDEX_KIND_EVENT, key, key_len);
+        if (entry == NULL || entry->parent >= 0) {
+            return FAIL_RETURN;
+        }
+        if (event) {
+            *event = (dm_shw_event_t *)_dm_shw_index_node(shadow, entry);
+        }
+        return SUCCESS_RETURN;
+    }
+#endif
+
+    if (shadow->table != NULL && shadow->table->event_index != NULL) {
+        index = _dm_shw_table_search(shadow, shadow->table->event_index, key, key_len);
+        if (index < 0 || index >= shadow->event_number) {
+            return FAIL_RETURN;
+        }
+        dtsl_event = shadow->events + index;
+        if ((strlen(dtsl_event->identifier) != key_len) ||
+            (memcmp(dtsl_event->identifier, key, key_len) != 0)) {
+            return FAIL_RETURN;
+        }
+        if (event) {
+            *event = dtsl_event;
+        }
+        return SUCCESS_RETURN;
+    }
+
     for (index = 0; index < shadow->event_number; index++) {
         dtsl_event = shadow->events + index;
         if ((strlen(dtsl_event->identifier) == key_len) &&
@@ -449,11 +881,43 @@ static int _dm_shw_service_search(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ in
 {
     int index = 0;
     dm_shw_service_t *dtsl_service = NULL;
+#if WITH_DM_SHW_INDEX
+    dm_shw_index_entry_t *entry = NULL;
+#endif
 
     if (shadow == NULL || key == NULL || key_len <= 0) {
         return DM_INVALID_PARAMETER;
     }
 
+#if WITH_DM_SHW_INDEX
+    if (shadow->index != NULL) {
+        entry = _dm_shw_index_lookup(shadow, DM_SHW_INDEX_KIND_SERVICE_INPUT, key, key_len);
+        if (entry == NULL || entry->parent >= 0) {
+            return FAIL_RETURN;
+        }
+        if (service) {
+            *service = (dm_shw_service_t *)_dm_shw_index_node(shadow, entry);
+        }
+        return SUCCESS_RETURN;
+    }
+#endif
+
+    if (shadow->table != NULL && shadow->table->service_index != NULL) {
+        index = _dm_shw_table_search(shadow, shadow->table->service_index, key, key_len);
+        if (index < 0 || index >= shadow->service_number) {
+            return FAIL_RETURN;
+        }
+        dtsl_service = shadow->services + index;
+        if ((strlen(dtsl_service->identifier) != key_len) ||
+            (memcmp(dtsl_service->identifier, key, key_len) != 0)) {
+            return FAIL_RETURN;
+        }
+        if (service) {
+            *service = dtsl_service;
+        }
+        return SUCCESS_RETURN;
+    }
+
     for (index = 0; index < shadow->service_number; index++) {
         dtsl_service = shadow->services + index;
         if ((strlen(dtsl_service->identifier) == key_len) &&
@@ -466,36 +930,426 @@ static int _dm_shw_service_search(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ in
         }
     }
 
-    /* dm_log_debug("TSL Service Not Found: %.*s",key_len,key); */
+    /* dm_log_debug("TSL Service Not Found: %.*s",key_len,key); */
+
+    return FAIL_RETURN;
+}
+
+/* @key is "event.data", @offset is the position of first delimiter */
+static int _dm_shw_event_data_search(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ int key_len, _IN_ int offset,
+                                     _OU_ dm_shw_data_t **event_data, _OU_ int *index)
+{
+    int res = 0;
+    dm_shw_event_t *event = NULL;
+    dm_shw_data_t *data = NULL;
+
+#if WITH_DM_SHW_INDEX
+    if (_dm_shw_index_search(shadow, DM_SHW_INDEX_KIND_EVENT, key, key_len, (void **)&data, index) == SUCCESS_RETURN) {
+        *event_data = data;
+        return SUCCESS_RETURN;
+    }
+#endif
+
+    res = _dm_shw_event_search(shadow, key, offset, &event);
+    if (res != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    res = _dm_shw_event_output_search(event->output_datas, event->output_data_number, key + offset + 1,
+                                      key_len - offset - 1, &data, index);
+    if (res != SUCCESS_RETURN || data == NULL) {
+        return FAIL_RETURN;
+    }
+
+    *event_data = data;
+
+    return SUCCESS_RETURN;
+}
+
+/* @key is "service.data", @offset is the position of first delimiter */
+static int _dm_shw_service_data_search(_IN_ dm_shw_data_target_e type, _IN_ dm_shw_t *shadow, _IN_ char *key,
+                                       _IN_ int key_len, _IN_ int offset, _OU_ dm_shw_data_t **service_data, _OU_ int *index)
+{
+    int res = 0;
+    dm_shw_service_t *service = NULL;
+    dm_shw_data_t *data = NULL;
+
+#if WITH_DM_SHW_INDEX
+    dm_shw_index_kind_e kind = (type == DM_SHW_DATA_TARGET_SERVICE_INPUT_DATA) ?
+                               DM_SHW_INDEX_KIND_SERVICE_INPUT : DM_SHW_INDEX_KIND_SERVICE_OUTPUT;
+
+    if (_dm_shw_index_search(shadow, kind, key, key_len, (void **)&data, index) == SUCCESS_RETURN) {
+        *service_data = data;
+        return SUCCESS_RETURN;
+    }
+#endif
+
+    res = _dm_shw_service_search(shadow, key, offset, &service);
+    if (res != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    res = _dm_shw_service_input_output_search(type, service, key + offset + 1, key_len - offset - 1, &data, index);
+    if (res != SUCCESS_RETURN || data == NULL) {
+        return FAIL_RETURN;
+    }
+
+    *service_data = data;
+
+    return SUCCESS_RETURN;
+}
+
+int dm_shw_create(_IN_ iotx_dm_tsl_type_t type, _IN_ const char *tsl, _IN_ int tsl_len, _OU_ dm_shw_t **shadow)
+{
+    int res = 0;
+
+    if (shadow == NULL || *shadow != NULL || tsl == NULL || tsl_len <= 0) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    switch (type) {
+        case IOTX_DM_TSL_TYPE_ALINK: {
+            res = dm_tsl_alink_create(tsl, tsl_len, shadow);
+        }
+        break;
+        case IOTX_DM_TSL_TYPE_TLV: {
+            /* TODO for yusan*/
+            res = FAIL_RETURN;
+        }
+        break;
+        default:
+            dm_log_err("Unknown TSL Type");
+            res = FAIL_RETURN;
+            break;
+    }
+
+#if WITH_DM_SHW_INDEX
+    if (res == SUCCESS_RETURN && *shadow != NULL && _dm_shw_index_build(*shadow, &(*shadow)->index) != SUCCESS_RETURN) {
+        dm_log_warning("TSL Index Build Failed, Use Linear Search");
+    }
+#endif
+
+    return res;
+}
+
+#define DM_SHW_TABLE_ALIGN(size) (((size) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+
+static int _dm_shw_table_array_item_size(_IN_ dm_shw_data_type_e type)
+{
+    switch (type) {
+        case DM_SHW_DATA_TYPE_INT:
+        case DM_SHW_DATA_TYPE_ENUM:
+        case DM_SHW_DATA_TYPE_BOOL:
+            return sizeof(int);
+        case DM_SHW_DATA_TYPE_FLOAT:
+            return sizeof(float);
+        case DM_SHW_DATA_TYPE_DOUBLE:
+            return sizeof(double);
+        case DM_SHW_DATA_TYPE_TEXT:
+        case DM_SHW_DATA_TYPE_DATE:
+            return sizeof(char *);
+        case DM_SHW_DATA_TYPE_STRUCT:
+            return sizeof(dm_shw_data_t);
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+/* memory needed to instantiate complex value of template @data_value */
+static int _dm_shw_table_value_size(_IN_ const dm_shw_data_value_t *data_value)
+{
+    int index = 0, size = 0;
+    const dm_shw_data_value_complex_t *complex_value = (const dm_shw_data_value_complex_t *)data_value->value;
+    const dm_shw_data_t *item = NULL;
+
+    if ((data_value->type != DM_SHW_DATA_TYPE_ARRAY && data_value->type != DM_SHW_DATA_TYPE_STRUCT) ||
+        complex_value == NULL) {
+        return 0;
+    }
+
+    size = DM_SHW_TABLE_ALIGN(sizeof(dm_shw_data_value_complex_t));
+    if (data_value->type == DM_SHW_DATA_TYPE_ARRAY) {
+        size += DM_SHW_TABLE_ALIGN(complex_value->size * _dm_shw_table_array_item_size(complex_value->type));
+        if (complex_value->type == DM_SHW_DATA_TYPE_STRUCT && complex_value->value != NULL) {
+            item = (const dm_shw_data_t *)complex_value->value;
+            size += complex_value->size * _dm_shw_table_value_size(&item->data_value);
+        }
+    } else {
+        size += DM_SHW_TABLE_ALIGN(complex_value->size * sizeof(dm_shw_data_t));
+        for (index = 0; index < complex_value->size; index++) {
+            item = (const dm_shw_data_t *)complex_value->value + index;
+            size += _dm_shw_table_value_size(&item->data_value);
+        }
+    }
+
+    return size;
+}
+
+static int _dm_shw_table_datas_size(_IN_ const dm_shw_data_t *datas, _IN_ int number)
+{
+    int index = 0, size = 0;
+
+    if (datas == NULL || number <= 0) {
+        return 0;
+    }
+
+    size = DM_SHW_TABLE_ALIGN(number * sizeof(dm_shw_data_t));
+    for (index = 0; index < number; index++) {
+        size += _dm_shw_table_value_size(&datas[index].data_value);
+    }
+
+    return size;
+}
+
+/* instantiate template @src into @dst, complex values take zeroed memory from @block */
+static void _dm_shw_table_value_copy(_OU_ dm_shw_data_value_t *dst, _IN_ const dm_shw_data_value_t *src,
+                                     _IN_ char **block)
+{
+    int index = 0, item_size = 0;
+    const dm_shw_data_value_complex_t *src_complex = (const dm_shw_data_value_complex_t *)src->value;
+    dm_shw_data_value_complex_t *dst_complex = NULL;
+    const dm_shw_data_t *src_item = NULL;
+    dm_shw_data_t *dst_item = NULL;
+
+    memcpy(dst, src, sizeof(dm_shw_data_value_t));
+    if ((src->type != DM_SHW_DATA_TYPE_ARRAY && src->type != DM_SHW_DATA_TYPE_STRUCT) || src_complex == NULL) {
+        return;
+    }
+
+    dst_complex = (dm_shw_data_value_complex_t *)(*block);
+    *block += DM_SHW_TABLE_ALIGN(sizeof(dm_shw_data_value_complex_t));
+    dst_complex->type = src_complex->type;
+    dst_complex->size = src_complex->size;
+    dst_complex->value = NULL;
+    dst->value = (void *)dst_complex;
+
+    if (src->type == DM_SHW_DATA_TYPE_ARRAY) {
+        item_size = _dm_shw_table_array_item_size(src_complex->type);
+        if (item_size == 0 || src_complex->size <= 0) {
+            return;
+        }
+        dst_complex->value = (void *)(*block);
+        *block += DM_SHW_TABLE_ALIGN(src_complex->size * item_size);
+
+        if (src_complex->type == DM_SHW_DATA_TYPE_STRUCT && src_complex->value != NULL) {
+            /* every element is instantiated from the single template element */
+            src_item = (const dm_shw_data_t *)src_complex->value;
+            for (index = 0; index < src_complex->size; index++) {
+                dst_item = (dm_shw_data_t *)dst_complex->value + index;
+                dst_item->identifier = src_item->identifier;
+                _dm_shw_table_value_copy(&dst_item->data_value, &src_item->data_value, block);
+            }
+        }
+        return;
+    }
+
+    dst_complex->value = (void *)(*block);
+    *block += DM_SHW_TABLE_ALIGN(src_complex->size * sizeof(dm_shw_data_t));
+    for (index = 0; index < src_complex->size; index++) {
+        src_item = (const dm_shw_data_t *)src_complex->value + index;
+        dst_item = (dm_shw_data_t *)dst_complex->value + index;
+        dst_item->identifier = src_item->identifier;
+        _dm_shw_table_value_copy(&dst_item->data_value, &src_item->data_value, block);
+    }
+}
+
+static dm_shw_data_t *_dm_shw_table_datas_copy(_IN_ const dm_shw_data_t *datas, _IN_ int number, _IN_ char **block)
+{
+    int index = 0;
+    dm_shw_data_t *copy = NULL;
+
+    if (datas == NULL || number <= 0) {
+        return NULL;
+    }
+
+    copy = (dm_shw_data_t *)(*block);
+    *block += DM_SHW_TABLE_ALIGN(number * sizeof(dm_shw_data_t));
+    for (index = 0; index < number; index++) {
+        copy[index].identifier = datas[index].identifier;
+        _dm_shw_table_value_copy(&copy[index].data_value, &datas[index].data_value, block);
+    }
+
+    return copy;
+}
+
+/* identifiers stay in table, the rest of shadow lives in one memory block */
+static int _dm_shw_table_shadow_size(_IN_ const dm_shw_t *tmpl)
+{
+    int index = 0, size = 0;
+    const dm_shw_event_t *src_event = NULL;
+    const dm_shw_service_t *src_service = NULL;
+
+    size = DM_SHW_TABLE_ALIGN(sizeof(dm_shw_t));
+    size += _dm_shw_table_datas_size(tmpl->properties, tmpl->property_number);
+    size += DM_SHW_TABLE_ALIGN(tmpl->event_number * sizeof(dm_shw_event_t));
+    for (index = 0; index < tmpl->event_number; index++) {
+        src_event = tmpl->events + index;
+        size += _dm_shw_table_datas_size(src_event->output_datas, src_event->output_data_number);
+    }
+    size += DM_SHW_TABLE_ALIGN(tmpl->service_number * sizeof(dm_shw_service_t));
+    for (index = 0; index < tmpl->service_number; index++) {
+        src_service = tmpl->services + index;
+        size += _dm_shw_table_datas_size(src_service->input_datas, src_service->input_data_number);
+        size += _dm_shw_table_datas_size(src_service->output_datas, src_service->output_data_number);
+    }
+
+    return size;
+}
+
+int dm_shw_create_from_table(_IN_ const dm_shw_table_t *table, _OU_ dm_shw_t **shadow)
+{
+    int index = 0, size = 0;
+    char *block = NULL;
+    const dm_shw_t *tmpl = NULL;
+    const dm_shw_event_t *src_event = NULL;
+    const dm_shw_service_t *src_service = NULL;
+    dm_shw_event_t *event = NULL;
+    dm_shw_service_t *service = NULL;
+
+    if (table == NULL || table->shadow == NULL || shadow == NULL || *shadow != NULL) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    if (table->hash_size & (table->hash_size - 1)) {
+        dm_log_err("Invalid TSL Table Hash Size: %d", table->hash_size);
+        return DM_INVALID_PARAMETER;
+    }
+
+    tmpl = table->shadow;
+    size = _dm_shw_table_shadow_size(tmpl);
+
+    /* accounted as module "dm_shadow" of mem_stats, which is the footprint of devices */
+    block = DM_SHW_malloc(size);
+    if (block == NULL) {
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+    memset(block, 0, size);
+
+    *shadow = (dm_shw_t *)block;
+    block += DM_SHW_TABLE_ALIGN(sizeof(dm_shw_t));
+    (*shadow)->table = table;
+
+    (*shadow)->property_number = tmpl->property_number;
+    (*shadow)->properties = _dm_shw_table_datas_copy(tmpl->properties, tmpl->property_number, &block);
+
+    if (tmpl->event_number > 0) {
+        (*shadow)->event_number = tmpl->event_number;
+        (*shadow)->events = (dm_shw_event_t *)block;
+        block += DM_SHW_TABLE_ALIGN(tmpl->event_number * sizeof(dm_shw_event_t));
+        for (index = 0; index < tmpl->event_number; index++) {
+            src_event = tmpl->events + index;
+            event = (*shadow)->events + index;
+            event->identifier = src_event->identifier;
+            event->output_data_number = src_event->output_data_number;
+            event->output_datas = _dm_shw_table_datas_copy(src_event->output_datas, src_event->output_data_number, &block);
+        }
+    }
+
+    if (tmpl->service_number > 0) {
+        (*shadow)->service_number = tmpl->service_number;
+        (*shadow)->services = (dm_shw_service_t *)block;
+        block += DM_SHW_TABLE_ALIGN(tmpl->service_number * sizeof(dm_shw_service_t));
+        for (index = 0; index < tmpl->service_number; index++) {
+            src_service = tmpl->services + index;
+            service = (*shadow)->services + index;
+            service->identifier = src_service->identifier;
+            service->input_data_number = src_service->input_data_number;
+            service->input_datas = _dm_shw_table_datas_copy(src_service->input_datas, src_service->input_data_number,
+                                   &block);
+            service->output_data_number = src_service->output_data_number;
+            service->output_datas = _dm_shw_table_datas_copy(src_service->output_datas, src_service->output_data_number,
+                                    &block);
+        }
+    }
+
+    return SUCCESS_RETURN;
+}
+
+int dm_shw_schema_create(_IN_ iotx_dm_tsl_type_t type, _IN_ const char *tsl, _IN_ int tsl_len,
+                         _OU_ dm_shw_schema_t **schema)
+{
+    int res = 0;
+    dm_shw_schema_t *new_schema = NULL;
+#if WITH_DM_SHW_INDEX
+    dm_shw_t *probe = NULL;
+#endif
+
+    if (tsl == NULL || tsl_len <= 0 || schema == NULL || *schema != NULL) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    if (type != IOTX_DM_TSL_TYPE_ALINK) {
+        dm_log_err("Unsupported TSL Type: %d", type);
+        return FAIL_RETURN;
+    }
+
+    new_schema = DM_malloc(sizeof(dm_shw_schema_t));
+    if (new_schema == NULL) {
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+    memset(new_schema, 0, sizeof(dm_shw_schema_t));
+
+    /* template is never indexed or set, shadows created from it are */
+    res = dm_tsl_alink_create(tsl, tsl_len, &new_schema->tsl);
+    if (res != SUCCESS_RETURN) {
+        dm_shw_schema_destroy(&new_schema);
+        return FAIL_RETURN;
+    }
+    new_schema->table.shadow = new_schema->tsl;
+    new_schema->shadow_size = _dm_shw_table_shadow_size(new_schema->tsl);
+
+#if WITH_DM_SHW_INDEX
+    /* all shadows of schema have the same layout, index built on one of them fits every one */
+    res = dm_shw_create_from_table(&new_schema->table, &probe);
+    if (res == SUCCESS_RETURN) {
+        res = _dm_shw_index_build(probe, &new_schema->index);
+        dm_shw_destroy(&probe);
+    }
+    if (res != SUCCESS_RETURN) {
+        dm_log_warning("TSL Index Build Failed, Use Linear Search");
+    }
+#endif
+
+    dm_log_info("TSL Schema Created, Shadow Size: %d", new_schema->shadow_size);
+    *schema = new_schema;
+
+    return SUCCESS_RETURN;
+}
+
+int dm_shw_create_from_schema(_IN_ dm_shw_schema_t *schema, _OU_ dm_shw_t **shadow)
+{
+    int res = 0;
+
+    if (schema == NULL || shadow == NULL || *shadow != NULL) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    res = dm_shw_create_from_table(&schema->table, shadow);
+    if (res != SUCCESS_RETURN) {
+        return res;
+    }
+    (*shadow)->index = schema->index;
 
-    return FAIL_RETURN;
+    return SUCCESS_RETURN;
 }
 
-int dm_shw_create(_IN_ iotx_dm_tsl_type_t type, _IN_ const char *tsl, _IN_ int tsl_len, _OU_ dm_shw_t **shadow)
+void dm_shw_schema_destroy(_IN_ dm_shw_schema_t **schema)
 {
-    int res = 0;
+    if (schema == NULL || *schema == NULL) {
+        return;
+    }
 
-    if (shadow == NULL || *shadow != NULL || tsl == NULL || tsl_len <= 0) {
-        return DM_INVALID_PARAMETER;
+    if ((*schema)->tsl) {
+        dm_shw_destroy(&(*schema)->tsl);
     }
 
-    switch (type) {
-        case IOTX_DM_TSL_TYPE_ALINK: {
-            res = dm_tsl_alink_create(tsl, tsl_len, shadow);
-        }
-        break;
-        case IOTX_DM_TSL_TYPE_TLV: {
-            /* TODO for yusan*/
-            res = FAIL_RETURN;
-        }
-        break;
-        default:
-            dm_log_err("Unknown TSL Type");
-            res = FAIL_RETURN;
-            break;
+    if ((*schema)->index) {
+        DM_free((*schema)->index);
     }
 
-    return res;
+    DM_free(*schema);
 }
 
 int dm_shw_get_property_data(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ int key_len, _OU_ void **data)
@@ -519,8 +1373,6 @@ int dm_shw_get_service_input_output_data(_IN_ dm_shw_data_target_e type, _IN_ dm
 {
     int res = 0;
     int offset = 0, array_index = 0;
-    char *pos = NULL;
-    dm_shw_service_t *service = NULL;
     dm_shw_data_t *service_data = NULL;
 
     if (type < DM_SHW_DATA_TARGET_SERVICE_INPUT_DATA || type > DM_SHW_DATA_TARGET_SERVICE_OUTPUT_DATA || shadow == NULL
@@ -535,15 +1387,7 @@ int dm_shw_get_service_input_output_data(_IN_ dm_shw_data_target_e type, _IN_ dm
 
     dm_log_debug("Key: %.*s", key_len, key);
 
-    res = _dm_shw_service_search(shadow, key, offset, &service);
-    if (res != SUCCESS_RETURN) {
-        return DM_TSL_EVENT_NOT_EXIST;
-    }
-
-    pos = key + offset + 1;
-    dm_log_debug("TSL Service input/output Data Search, Event Data ID: %s", pos);
-
-    res = _dm_shw_service_input_output_search(type, service, pos, strlen(pos), &service_data, &array_index);
+    res = _dm_shw_service_data_search(type, shadow, key, key_len, offset, &service_data, &array_index);
     if (res != SUCCESS_RETURN) {
         return DM_TSL_EVENT_NOT_EXIST;
     }
@@ -559,8 +1403,6 @@ int dm_shw_get_event_output_data(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ int
 {
     int res = 0;
     int offset = 0, array_index = 0;
-    char *pos = NULL;
-    dm_shw_event_t *event = NULL;
     dm_shw_data_t *event_data = NULL;
 
     if (shadow == NULL || key == NULL || key_len <= 0) {
@@ -574,16 +1416,7 @@ int dm_shw_get_event_output_data(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ int
 
     dm_log_debug("Key: %.*s", key_len, key);
 
-    res = _dm_shw_event_search(shadow, key, offset, &event);
-    if (res != SUCCESS_RETURN) {
-        return DM_TSL_EVENT_NOT_EXIST;
-    }
-
-    pos = key + offset + 1;
-    /* dm_log_debug("TSL Event Output Data Search, Event Data ID: %s",pos); */
-
-    res = _dm_shw_event_output_search(event->output_datas, event->output_data_number, pos, strlen(pos), &event_data,
-                                      &array_index);
+    res = _dm_shw_event_data_search(shadow, key, key_len, offset, &event_data, &array_index);
     if (res != SUCCESS_RETURN) {
         return DM_TSL_EVENT_NOT_EXIST;
     }
@@ -615,48 +1448,20 @@ int dm_shw_get_data_type(_IN_ void *data, _OU_ dm_shw_data_type_e *type)
 
 int dm_shw_get_event(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ int key_len, _OU_ void **event)
 {
-    int index = 0;
-    dm_shw_event_t *dtsl_event = NULL;
-
     if (shadow == NULL || key == NULL || key_len <= 0) {
         return DM_INVALID_PARAMETER;
     }
 
-    for (index = 0; index < shadow->event_number; index++) {
-        dtsl_event = shadow->events + index;
-        if ((strlen(dtsl_event->identifier) == key_len) &&
-            (memcmp(dtsl_event->identifier, key, key_len) == 0)) {
-            if (event) {
-                *event = (dm_shw_event_t *)dtsl_event;
-            }
-            return SUCCESS_RETURN;
-        }
-    }
-
-    return FAIL_RETURN;
+    return _dm_shw_event_search(shadow, key, key_len, (dm_shw_event_t **)event);
 }
 
 int dm_shw_get_service(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ int key_len, _OU_ void **service)
 {
-    int index = 0;
-    dm_shw_service_t *dtsl_service = NULL;
-
     if (shadow == NULL || key == NULL || key_len <= 0) {
         return DM_INVALID_PARAMETER;
     }
 
-    for (index = 0; index < shadow->event_number; index++) {
-        dtsl_service = shadow->services + index;
-        if ((strlen(dtsl_service->identifier) == key_len) &&
-            (memcmp(dtsl_service->identifier, key, key_len) == 0)) {
-            if (service) {
-                *service = (dm_shw_service_t *)dtsl_service;
-            }
-            return SUCCESS_RETURN;
-        }
-    }
-
-    return FAIL_RETURN;
+    return _dm_shw_service_search(shadow, key, key_len, (dm_shw_service_t **)service);
 }
 
 int dm_shw_get_property_number(_IN_ dm_shw_t *shadow, _OU_ int *number)
@@ -730,46 +1535,22 @@ int dm_shw_get_event_by_index(_IN_ dm_shw_t *shadow, _IN_ int index, _OU_ void *
 
 int dm_shw_get_service_by_identifier(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _OU_ void **service)
 {
-    int index = 0;
-    dm_shw_service_t *search_service = NULL;
-
     if (shadow == NULL || identifier == NULL ||
         service == NULL || *service != NULL) {
         return DM_INVALID_PARAMETER;
     }
 
-    for (index = 0; index < shadow->service_number; index++) {
-        search_service = shadow->services + index;
-        if ((strlen(search_service->identifier) == strlen(identifier)) &&
-            (memcmp(search_service->identifier, identifier, strlen(identifier)) == 0)) {
-            *service = (void *)search_service;
-            return SUCCESS_RETURN;
-        }
-    }
-
-    return FAIL_RETURN;
+    return _dm_shw_service_search(shadow, identifier, strlen(identifier), (dm_shw_service_t **)service);
 }
 
 int dm_shw_get_event_by_identifier(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _OU_ void **event)
 {
-    int index = 0;
-    dm_shw_event_t *search_event = NULL;
-
     if (shadow == NULL || identifier == NULL ||
         event == NULL || *event != NULL) {
         return DM_INVALID_PARAMETER;
     }
 
-    for (index = 0; index < shadow->event_number; index++) {
-        search_event = shadow->events + index;
-        if ((strlen(search_event->identifier) == strlen(identifier)) &&
-            (memcmp(search_event->identifier, identifier, strlen(identifier)) == 0)) {
-            *event = (void *)search_event;
-            return SUCCESS_RETURN;
-        }
-    }
-
-    return FAIL_RETURN;
+    return _dm_shw_event_search(shadow, identifier, strlen(identifier), (dm_shw_event_t **)event);
 }
 
 int dm_shw_get_property_identifier(_IN_ void *property, _OU_ char **identifier)
@@ -1320,8 +2101,6 @@ int dm_shw_set_event_output_value(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ in
 {
     int res = 0, array_index = 0;
     int offset = 0;
-    char *pos = NULL;
-    dm_shw_event_t *event = NULL;
     dm_shw_data_t *event_data = NULL;
 
     if (shadow == NULL || key == NULL || key_len <= 0) {
@@ -1335,16 +2114,7 @@ int dm_shw_set_event_output_value(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ in
 
     dm_log_debug("Key: %.*s", key_len, key);
 
-    res = _dm_shw_event_search(shadow, key, offset, &event);
-    if (res != SUCCESS_RETURN) {
-        return DM_TSL_EVENT_NOT_EXIST;
-    }
-
-    pos = key + offset + 1;
-    /* dm_log_debug("TSL Event Output Data Search, Event Data ID: %s",pos); */
-
-    res = _dm_shw_event_output_search(event->output_datas, event->output_data_number, pos, strlen(pos), &event_data,
-                                      &array_index);
+    res = _dm_shw_event_data_search(shadow, key, key_len, offset, &event_data, &array_index);
     if (res != SUCCESS_RETURN) {
         return DM_TSL_EVENT_NOT_EXIST;
     }
@@ -1368,8 +2138,6 @@ int dm_shw_get_event_output_value(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ in
 {
     int res = 0;
     int offset = 0, array_index = 0;
-    char *pos = NULL;
-    dm_shw_event_t *event = NULL;
     dm_shw_data_t *event_data = NULL;
 
     if (shadow == NULL || key == NULL || key_len <= 0) {
@@ -1383,16 +2151,7 @@ int dm_shw_get_event_output_value(_IN_ dm_shw_t *shadow, _IN_ char *key, _IN_ in
 
     dm_log_debug("Key: %.*s", key_len, key);
 
-    res = _dm_shw_event_search(shadow, key, offset, &event);
-    if (res != SUCCESS_RETURN) {
-        return DM_TSL_EVENT_NOT_EXIST;
-    }
-
-    pos = key + offset + 1;
-    dm_log_debug("TSL Event Output Data Search, Event Data ID: %s", pos);
-
-    res = _dm_shw_event_output_search(event->output_datas, event->output_data_number, pos, strlen(pos), &event_data,
-                                      &array_index);
+    res = _dm_shw_event_data_search(shadow, key, key_len, offset, &event_data, &array_index);
     if (res != SUCCESS_RETURN) {
         return DM_TSL_EVENT_NOT_EXIST;
     }
@@ -1417,8 +2176,6 @@ int dm_shw_set_service_input_output_value(_IN_ dm_shw_data_target_e type, _IN_ d
 {
     int res = 0, array_index = 0;
     int offset = 0;
-    char *pos = NULL;
-    dm_shw_service_t *service = NULL;
     dm_shw_data_t *service_data = NULL;
 
     if (type < DM_SHW_DATA_TARGET_SERVICE_INPUT_DATA || type > DM_SHW_DATA_TARGET_SERVICE_OUTPUT_DATA || shadow == NULL
@@ -1433,15 +2190,7 @@ int dm_shw_set_service_input_output_value(_IN_ dm_shw_data_target_e type, _IN_ d
 
     dm_log_debug("Key: %.*s", key_len, key);
 
-    res = _dm_shw_service_search(shadow, key, offset, &service);
-    if (res != SUCCESS_RETURN) {
-        return DM_TSL_SERVICE_NOT_EXIST;
-    }
-
-    pos = key + offset + 1;
-    dm_log_debug("TSL Service Input/Output Data Search, Event Data ID: %s", pos);
-
-    res = _dm_shw_service_input_output_search(type, service, pos, strlen(pos), &service_data, &array_index);
+    res = _dm_shw_service_data_search(type, shadow, key, key_len, offset, &service_data, &array_index);
     if (res != SUCCESS_RETURN) {
         return DM_TSL_SERVICE_NOT_EXIST;
     }
@@ -1466,8 +2215,6 @@ int dm_shw_get_service_input_output_value(_IN_ dm_shw_data_target_e type, _IN_ d
 {
     int res = 0;
     int offset = 0, array_index = 0;
-    char *pos = NULL;
-    dm_shw_service_t *service = NULL;
     dm_shw_data_t *service_data = NULL;
 
     if (shadow == NULL || key == NULL || key_len <= 0) {
@@ -1481,15 +2228,7 @@ int dm_shw_get_service_input_output_value(_IN_ dm_shw_data_target_e type, _IN_ d
 
     dm_log_debug("key: %.*s", key_len, key);
 
-    res = _dm_shw_service_search(shadow, key, offset, &service);
-    if (res != SUCCESS_RETURN) {
-        return DM_TSL_SERVICE_NOT_EXIST;
-    }
-
-    pos = key + offset + 1;
-    dm_log_debug("TSL Service Input/Output Data Search, Event Data ID: %s", pos);
-
-    res = _dm_shw_service_input_output_search(type, service, pos, strlen(pos), &service_data, &array_index);
+    res = _dm_shw_service_data_search(type, shadow, key, key_len, offset, &service_data, &array_index);
     if (res != SUCCESS_RETURN) {
         return DM_TSL_SERVICE_NOT_EXIST;
     }
@@ -1509,325 +2248,209 @@ int dm_shw_get_service_input_output_value(_IN_ dm_shw_data_target_e type, _IN_ d
     return SUCCESS_RETURN;
 }
 
-static int _dm_shw_int_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ lite_cjson_item_t *lite)
+static int _dm_shw_int_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ dm_utils_json_writer_t *writer)
 {
-    lite_cjson_add_number_to_object(lite, data->identifier, data->data_value.value_int);
-
-    return SUCCESS_RETURN;
+    return dm_utils_json_writer_int(writer, data->identifier, data->data_value.value_int);
 }
 
-static int _dm_shw_float_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ lite_cjson_item_t *lite)
+static int _dm_shw_float_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ dm_utils_json_writer_t *writer)
 {
-    lite_cjson_add_number_to_object(lite, data->identifier, data->data_value.value_float);
-
-    return SUCCESS_RETURN;
+    return dm_utils_json_writer_double(writer, data->identifier, data->data_value.value_float);
 }
 
-static int _dm_shw_double_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ lite_cjson_item_t *lite)
+static int _dm_shw_double_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ dm_utils_json_writer_t *writer)
 {
-    lite_cjson_add_number_to_object(lite, data->identifier, data->data_value.value_double);
-
-    return SUCCESS_RETURN;
+    return dm_utils_json_writer_double(writer, data->identifier, data->data_value.value_double);
 }
 
-static int _dm_shw_string_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ lite_cjson_item_t *lite)
+static int _dm_shw_string_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ dm_utils_json_writer_t *writer)
 {
     char *value = (data->data_value.value == NULL) ? ("") : (data->data_value.value);
-    lite_cjson_add_string_to_object(lite, data->identifier, value);
 
-    return SUCCESS_RETURN;
+    return dm_utils_json_writer_string(writer, data->identifier, value, strlen(value));
 }
 
-static int _dm_shw_array_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ lite_cjson_item_t *lite);
-static int _dm_shw_struct_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ lite_cjson_item_t *lite);
-static int _dm_shw_data_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ lite_cjson_item_t *lite);
+static int _dm_shw_array_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ dm_utils_json_writer_t *writer);
+static int _dm_shw_struct_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ dm_utils_json_writer_t *writer);
+static int _dm_shw_data_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ dm_utils_json_writer_t *writer);
 
-static int _dm_shw_array_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ lite_cjson_item_t *lite)
+static int _dm_shw_array_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ dm_utils_json_writer_t *writer)
 {
-    int res = SUCCESS_RETURN, index = 0;
-    lite_cjson_item_t *array = NULL, *array_item = NULL;
+    int res = SUCCESS_RETURN, index = 0, wrapped = 0;
     dm_shw_data_value_complex_t *complex_array = NULL;
 
-    if (data == NULL || lite == NULL) {
+    if (data == NULL || writer == NULL) {
         return DM_INVALID_PARAMETER;
     }
 
     complex_array = data->data_value.value;
 
-    if (lite->type == cJSON_Array) {
-        array = lite_cjson_create_object();
-        if (array == NULL) {
-            return DM_MEMORY_NOT_ENOUGH;
-        }
+    switch (complex_array->type) {
+        case DM_SHW_DATA_TYPE_INT:
+        case DM_SHW_DATA_TYPE_BOOL:
+        case DM_SHW_DATA_TYPE_ENUM:
+        case DM_SHW_DATA_TYPE_FLOAT:
+        case DM_SHW_DATA_TYPE_DOUBLE:
+        case DM_SHW_DATA_TYPE_TEXT:
+        case DM_SHW_DATA_TYPE_DATE:
+        case DM_SHW_DATA_TYPE_STRUCT:
+            break;
+        default:
+            /* Array Of Array: TODO */
+            return res;
     }
 
-    array_item = lite_cjson_create_array();
-    if (array_item == NULL) {
-        if (array) {
-            lite_cjson_delete(array);
-        }
-        return DM_MEMORY_NOT_ENOUGH;
+    /* Array Item Inside Array Is Written As {"identifier":[...]} */
+    if (dm_utils_json_writer_in_array(writer)) {
+        dm_utils_json_writer_object_begin(writer, NULL);
+        wrapped = 1;
     }
+    dm_utils_json_writer_array_begin(writer, data->identifier);
 
-    switch (complex_array->type) {
-        case DM_SHW_DATA_TYPE_INT:
-        case DM_SHW_DATA_TYPE_BOOL:
-        case DM_SHW_DATA_TYPE_ENUM: {
-            int value = 0;
-            for (index = 0; index < complex_array->size; index++) {
-                value = *((int *)(complex_array->value) + index);
-                lite_cjson_add_item_to_array(array_item, lite_cjson_create_number((double)value));
-            }
-            if (lite->type == cJSON_Array) {
-                lite_cjson_add_item_to_object(array, data->identifier, array_item);
-                lite_cjson_add_item_to_array(lite, array);
-            } else {
-                lite_cjson_add_item_to_object(lite, data->identifier, array_item);
-                lite_cjson_delete(array);
-            }
-        }
-        break;
-        case DM_SHW_DATA_TYPE_FLOAT: {
-            float value = 0;
-            for (index = 0; index < complex_array->size; index++) {
-                value = *((float *)(complex_array->value) + index);
-                lite_cjson_add_item_to_array(array_item, lite_cjson_create_number((double)value));
-            }
-            if (lite->type == cJSON_Array) {
-                lite_cjson_add_item_to_object(array, data->identifier, array_item);
-                lite_cjson_add_item_to_array(lite, array);
-            } else {
-                lite_cjson_add_item_to_object(lite, data->identifier, array_item);
-                lite_cjson_delete(array);
+    for (index = 0; index < complex_array->size; index++) {
+        switch (complex_array->type) {
+            case DM_SHW_DATA_TYPE_INT:
+            case DM_SHW_DATA_TYPE_BOOL:
+            case DM_SHW_DATA_TYPE_ENUM: {
+                dm_utils_json_writer_int(writer, NULL, *((int *)(complex_array->value) + index));
             }
-        }
-        break;
-        case DM_SHW_DATA_TYPE_DOUBLE: {
-            double value = 0;
-            for (index = 0; index < complex_array->size; index++) {
-                value = *((double *)(complex_array->value) + index);
-                lite_cjson_add_item_to_array(array_item, lite_cjson_create_number(value));
+            break;
+            case DM_SHW_DATA_TYPE_FLOAT: {
+                dm_utils_json_writer_double(writer, NULL, *((float *)(complex_array->value) + index));
             }
-            if (lite->type == cJSON_Array) {
-                lite_cjson_add_item_to_object(array, data->identifier, array_item);
-                lite_cjson_add_item_to_array(lite, array);
-            } else {
-                lite_cjson_add_item_to_object(lite, data->identifier, array_item);
-                lite_cjson_delete(array);
+            break;
+            case DM_SHW_DATA_TYPE_DOUBLE: {
+                dm_utils_json_writer_double(writer, NULL, *((double *)(complex_array->value) + index));
             }
-        }
-        break;
-        case DM_SHW_DATA_TYPE_TEXT:
-        case DM_SHW_DATA_TYPE_DATE: {
-            char *value = NULL;
-            for (index = 0; index < complex_array->size; index++) {
-                value = *((char **)(complex_array->value) + index);
+            break;
+            case DM_SHW_DATA_TYPE_TEXT:
+            case DM_SHW_DATA_TYPE_DATE: {
+                char *value = *((char **)(complex_array->value) + index);
                 value = (value == NULL) ? ("") : (value);
-                lite_cjson_add_item_to_array(array_item, lite_cjson_create_string((const char *)value));
+                dm_utils_json_writer_string(writer, NULL, value, strlen(value));
             }
-            if (lite->type == cJSON_Array) {
-                lite_cjson_add_item_to_object(array, data->identifier, array_item);
-                lite_cjson_add_item_to_array(lite, array);
-            } else {
-                lite_cjson_add_item_to_object(lite, data->identifier, array_item);
-                lite_cjson_delete(array);
+            break;
+            case DM_SHW_DATA_TYPE_STRUCT: {
+                _dm_shw_struct_insert_json_item((dm_shw_data_t *)(complex_array->value) + index, writer);
             }
+            break;
+            default:
+                break;
         }
-        break;
-        case DM_SHW_DATA_TYPE_ARRAY: {
-            /* TODO */
-        }
-        break;
-        case DM_SHW_DATA_TYPE_STRUCT: {
-            dm_shw_data_t *array_data = NULL;
-            for (index = 0; index < complex_array->size; index++) {
-                array_data = (dm_shw_data_t *)(complex_array->value) + index;
-                if (array_data) {
-                    _dm_shw_struct_insert_json_item(array_data, array_item);
-                }
-            }
+    }
 
-            if (lite->type == cJSON_Array) {
-                lite_cjson_add_item_to_object(array, data->identifier, array_item);
-                lite_cjson_add_item_to_array(lite, array);
-            } else {
-                lite_cjson_add_item_to_object(lite, data->identifier, array_item);
-                lite_cjson_delete(array);
-            }
-        }
-        break;
-        default: {
-            lite_cjson_delete(array_item);
-            lite_cjson_delete(array);
-        }
-        break;
+    dm_utils_json_writer_array_end(writer);
+    if (wrapped) {
+        dm_utils_json_writer_object_end(writer);
     }
 
     return res;
 }
 
-static int _dm_shw_struct_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ lite_cjson_item_t *lite)
+static int _dm_shw_struct_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ dm_utils_json_writer_t *writer)
 {
-    int res = 0, index = 0;
-    lite_cjson_item_t *lite_object = NULL, *lite_item = NULL;
+    int index = 0, in_array = 0;
     dm_shw_data_t *current_data = NULL;
     dm_shw_data_value_complex_t *complex_struct = NULL;
 
-    if (data == NULL || lite == NULL) {
+    if (data == NULL || writer == NULL) {
         return DM_INVALID_PARAMETER;
     }
 
-    if (lite->type == cJSON_Array) {
-        lite_object = lite_cjson_create_object();
-        if (lite_object == NULL) {
-            return DM_MEMORY_NOT_ENOUGH;
-        }
+    in_array = dm_utils_json_writer_in_array(writer);
+    if (!in_array && data->identifier == NULL) {
+        return FAIL_RETURN;
     }
 
-    lite_item = lite_cjson_create_object();
-    if (lite_item == NULL) {
-        lite_cjson_delete(lite_object);
-        return DM_MEMORY_NOT_ENOUGH;
+    /* Inside Array: {"identifier":{...}} or {...} If Struct Has No Identifier */
+    if (in_array && data->identifier) {
+        dm_utils_json_writer_object_begin(writer, NULL);
     }
+    dm_utils_json_writer_object_begin(writer, (dm_utils_json_writer_in_array(writer)) ? (NULL) : (data->identifier));
 
     complex_struct = data->data_value.value;
 
     for (index = 0; index < complex_struct->size; index++) {
         current_data = (dm_shw_data_t *)complex_struct->value + index;
-        _dm_shw_data_insert_json_item(current_data, lite_item);
+        _dm_shw_data_insert_json_item(current_data, writer);
     }
-    if (lite->type == cJSON_Array) {
-        if (data->identifier) {
-            lite_cjson_add_item_to_object(lite_object, data->identifier, lite_item);
-            lite_cjson_add_item_to_array(lite, lite_object);
-        } else {
-            lite_cjson_add_item_to_array(lite, lite_item);
-            lite_cjson_delete(lite_object);
-        }
-    } else {
-        if (data->identifier) {
-            lite_cjson_add_item_to_object(lite, data->identifier, lite_item);
-            lite_cjson_delete(lite_object);
-        } else {
-            res = FAIL_RETURN;
-            lite_cjson_delete(lite_item);
-            lite_cjson_delete(lite_object);
-        }
+
+    dm_utils_json_writer_object_end(writer);
+    if (in_array && data->identifier) {
+        dm_utils_json_writer_object_end(writer);
     }
 
-    return res;
+    return SUCCESS_RETURN;
 }
 
-static int _dm_shw_data_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ lite_cjson_item_t *lite)
+static int _dm_shw_data_insert_json_item(_IN_ dm_shw_data_t *data, _IN_ dm_utils_json_writer_t *writer)
 {
-    int res = 0;
-    lite_cjson_item_t *data_object = NULL;
+    int res = 0, wrapped = 0;
 
-    if (data == NULL || lite == NULL) {
+    if (data == NULL || writer == NULL) {
         return DM_INVALID_PARAMETER;
     }
 
-    if (lite->type == cJSON_Array) {
-        data_object = lite_cjson_create_object();
-        if (data_object == NULL) {
-            return DM_MEMORY_NOT_ENOUGH;
-        }
+    if (data->data_value.type < DM_SHW_DATA_TYPE_INT || data->data_value.type > DM_SHW_DATA_TYPE_STRUCT) {
+        return FAIL_RETURN;
+    }
+
+    /* Data Inside Array Is Written As {"identifier":value} */
+    if (dm_utils_json_writer_in_array(writer)) {
+        dm_utils_json_writer_object_begin(writer, NULL);
+        wrapped = 1;
     }
 
     switch (data->data_value.type) {
         case DM_SHW_DATA_TYPE_INT:
         case DM_SHW_DATA_TYPE_BOOL:
         case DM_SHW_DATA_TYPE_ENUM: {
-            if (lite->type == cJSON_Array) {
-                res = _dm_shw_int_insert_json_item(data, data_object);
-                if (res == SUCCESS_RETURN) {
-                    lite_cjson_add_item_to_array(lite, data_object);
-                }
-            } else {
-                res = _dm_shw_int_insert_json_item(data, lite);
-                lite_cjson_delete(data_object);
-            }
+            res = _dm_shw_int_insert_json_item(data, writer);
         }
         break;
         case DM_SHW_DATA_TYPE_FLOAT: {
-            if (lite->type == cJSON_Array) {
-                res = _dm_shw_float_insert_json_item(data, data_object);
-                if (res == SUCCESS_RETURN) {
-                    lite_cjson_add_item_to_array(lite, data_object);
-                }
-            } else {
-                res = _dm_shw_float_insert_json_item(data, lite);
-                lite_cjson_delete(data_object);
-            }
+            res = _dm_shw_float_insert_json_item(data, writer);
         }
         break;
         case DM_SHW_DATA_TYPE_DOUBLE: {
-            if (lite->type == cJSON_Array) {
-                res = _dm_shw_double_insert_json_item(data, data_object);
-                if (res == SUCCESS_RETURN) {
-                    lite_cjson_add_item_to_array(lite, data_object);
-                }
-            } else {
-                res = _dm_shw_double_insert_json_item(data, lite);
-                lite_cjson_delete(data_object);
-            }
+            res = _dm_shw_double_insert_json_item(data, writer);
         }
         break;
         case DM_SHW_DATA_TYPE_TEXT:
         case DM_SHW_DATA_TYPE_DATE: {
-            if (lite->type == cJSON_Array) {
-                res = _dm_shw_string_insert_json_item(data, data_object);
-                if (res == SUCCESS_RETURN) {
-                    lite_cjson_add_item_to_array(lite, data_object);
-                }
-            } else {
-                res = _dm_shw_string_insert_json_item(data, lite);
-                lite_cjson_delete(data_object);
-            }
+            res = _dm_shw_string_insert_json_item(data, writer);
         }
         break;
         case DM_SHW_DATA_TYPE_ARRAY: {
             /* dm_log_debug("DM_SHW_DATA_TYPE_ARRAY"); */
-            if (lite->type == cJSON_Array) {
-                res = _dm_shw_array_insert_json_item(data, data_object);
-                if (res == SUCCESS_RETURN) {
-                    lite_cjson_add_item_to_array(lite, data_object);
-                }
-            } else {
-                res = _dm_shw_array_insert_json_item(data, lite);
-                lite_cjson_delete(data_object);
-            }
+            res = _dm_shw_array_insert_json_item(data, writer);
         }
         break;
         case DM_SHW_DATA_TYPE_STRUCT: {
             /* dm_log_debug("DM_SHW_DATA_TYPE_STRUCT"); */
-            if (lite->type == cJSON_Array) {
-                res = _dm_shw_struct_insert_json_item(data, data_object);
-                if (res == SUCCESS_RETURN) {
-                    lite_cjson_add_item_to_array(lite, data_object);
-                }
-            } else {
-                res = _dm_shw_struct_insert_json_item(data, lite);
-                lite_cjson_delete(data_object);
-            }
+            res = _dm_shw_struct_insert_json_item(data, writer);
         }
         break;
         default:
-            lite_cjson_delete(data_object);
             res = FAIL_RETURN;
             break;
     }
 
+    if (wrapped) {
+        dm_utils_json_writer_object_end(writer);
+    }
+
     return res;
 }
 
 int dm_shw_assemble_property(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _IN_ int identifier_len,
-                             _IN_ lite_cjson_item_t *lite)
+                             _IN_ dm_utils_json_writer_t *writer)
 {
     int res = 0, index = 0;
     dm_shw_data_t *property = NULL;
 
-    if (shadow == NULL || identifier == NULL || identifier_len <= 0 || lite == NULL || lite->type != cJSON_Object) {
+    if (shadow == NULL || identifier == NULL || identifier_len <= 0 || writer == NULL ||
+        dm_utils_json_writer_in_array(writer)) {
         return DM_INVALID_PARAMETER;
     }
 
@@ -1845,7 +2468,7 @@ int dm_shw_assemble_property(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _IN_
         return FAIL_RETURN;
     }
 
-    res = _dm_shw_data_insert_json_item(property, lite);
+    res = _dm_shw_data_insert_json_item(property, writer);
     if (res != SUCCESS_RETURN) {
         return FAIL_RETURN;
     }
@@ -1854,13 +2477,14 @@ int dm_shw_assemble_property(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _IN_
 }
 
 int dm_shw_assemble_event_output(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _IN_ int identifier_len,
-                                 _IN_ lite_cjson_item_t *lite)
+                                 _IN_ dm_utils_json_writer_t *writer)
 {
     int res = 0, index = 0;
     dm_shw_data_t *event_outputdata = NULL;
     dm_shw_event_t *event = NULL;
 
-    if (shadow == NULL || identifier == NULL || identifier_len <= 0 || lite == NULL || lite->type != cJSON_Object) {
+    if (shadow == NULL || identifier == NULL || identifier_len <= 0 || writer == NULL ||
+        dm_utils_json_writer_in_array(writer)) {
         return DM_INVALID_PARAMETER;
     }
 
@@ -1881,7 +2505,7 @@ int dm_shw_assemble_event_output(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _
     for (index = 0; index < event->output_data_number; index++) {
         event_outputdata = event->output_datas + index;
 
-        res = _dm_shw_data_insert_json_item(event_outputdata, lite);
+        res = _dm_shw_data_insert_json_item(event_outputdata, writer);
         if (res != SUCCESS_RETURN) {
             return FAIL_RETURN;
         }
@@ -1891,13 +2515,14 @@ int dm_shw_assemble_event_output(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _
 }
 
 int dm_shw_assemble_service_output(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _IN_ int identifier_len,
-                                   _IN_ lite_cjson_item_t *lite)
+                                   _IN_ dm_utils_json_writer_t *writer)
 {
     int res = 0, index = 0;
     dm_shw_data_t *service_outputdata = NULL;
     dm_shw_service_t *service = NULL;
 
-    if (shadow == NULL || identifier == NULL || identifier_len <= 0 || lite == NULL || lite->type != cJSON_Object) {
+    if (shadow == NULL || identifier == NULL || identifier_len <= 0 || writer == NULL ||
+        dm_utils_json_writer_in_array(writer)) {
         return DM_INVALID_PARAMETER;
     }
 
@@ -1918,7 +2543,7 @@ int dm_shw_assemble_service_output(_IN_ dm_shw_t *shadow, _IN_ char *identifier,
     for (index = 0; index < service->output_data_number; index++) {
         service_outputdata = service->output_datas + index;
 
-        res = _dm_shw_data_insert_json_item(service_outputdata, lite);
+        res = _dm_shw_data_insert_json_item(service_outputdata, writer);
         if (res != SUCCESS_RETURN) {
             return FAIL_RETURN;
         }
@@ -2230,12 +2855,88 @@ static void _dm_shw_services_free(_IN_ dm_shw_service_t *services, _IN_ int numb
     }
 }
 
+/* shadow from precompiled table only owns text and date values, everything else is in the shadow block */
+static void _dm_shw_table_value_free(_IN_ dm_shw_data_value_t *data_value)
+{
+    int index = 0;
+    dm_shw_data_t *item = NULL;
+    dm_shw_data_value_complex_t *complex_value = NULL;
+
+    switch (data_value->type) {
+        case DM_SHW_DATA_TYPE_TEXT:
+        case DM_SHW_DATA_TYPE_DATE: {
+            g_iotx_data_type_mapping[data_value->type].func_free(data_value);
+        }
+        break;
+        case DM_SHW_DATA_TYPE_ARRAY: {
+            complex_value = (dm_shw_data_value_complex_t *)data_value->value;
+            if (complex_value == NULL || complex_value->value == NULL) {
+                break;
+            }
+            if (complex_value->type == DM_SHW_DATA_TYPE_TEXT || complex_value->type == DM_SHW_DATA_TYPE_DATE) {
+                g_iotx_data_type_mapping[complex_value->type].func_array_free(data_value);
+            } else if (complex_value->type == DM_SHW_DATA_TYPE_STRUCT) {
+                for (index = 0; index < complex_value->size; index++) {
+                    item = (dm_shw_data_t *)complex_value->value + index;
+                    _dm_shw_table_value_free(&item->data_value);
+                }
+            }
+        }
+        break;
+        case DM_SHW_DATA_TYPE_STRUCT: {
+            complex_value = (dm_shw_data_value_complex_t *)data_value->value;
+            if (complex_value == NULL) {
+                break;
+            }
+            for (index = 0; index < complex_value->size; index++) {
+                item = (dm_shw_data_t *)complex_value->value + index;
+                _dm_shw_table_value_free(&item->data_value);
+            }
+        }
+        break;
+        default:
+            break;
+    }
+}
+
+static void _dm_shw_table_datas_free(_IN_ dm_shw_data_t *datas, _IN_ int number)
+{
+    int index = 0;
+
+    for (index = 0; datas != NULL && index < number; index++) {
+        _dm_shw_table_value_free(&datas[index].data_value);
+    }
+}
+
+static void _dm_shw_table_free(_IN_ dm_shw_t *shadow)
+{
+    int index = 0;
+    dm_shw_service_t *service = NULL;
+
+    _dm_shw_table_datas_free(shadow->properties, shadow->property_number);
+    for (index = 0; index < shadow->event_number; index++) {
+        _dm_shw_table_datas_free(shadow->events[index].output_datas, shadow->events[index].output_data_number);
+    }
+    for (index = 0; index < shadow->service_number; index++) {
+        service = shadow->services + index;
+        _dm_shw_table_datas_free(service->input_datas, service->input_data_number);
+        _dm_shw_table_datas_free(service->output_datas, service->output_data_number);
+    }
+}
+
 void dm_shw_destroy(_IN_ dm_shw_t **shadow)
 {
     if (shadow == NULL || *shadow == NULL) {
         return;
     }
 
+    if ((*shadow)->table != NULL) {
+        _dm_shw_table_free(*shadow);
+        DM_free(*shadow);
+        *shadow = NULL;
+        return;
+    }
+
     //Free Properties
     if ((*shadow)->properties) {
         _dm_shw_properties_free((*shadow)->properties, (*shadow)->property_number);
@@ -2257,6 +2958,12 @@ void dm_shw_destroy(_IN_ dm_shw_t **shadow)
         (*shadow)->services = NULL;
     }
 
+    //Free Index
+    if ((*shadow)->index) {
+        DM_free((*shadow)->index);
+        (*shadow)->index = NULL;
+    }
+
     DM_free(*shadow);
     *shadow = NULL;
 }
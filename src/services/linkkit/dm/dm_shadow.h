@@ -109,6 +109,9 @@ typedef struct {
     dm_shw_data_t *output_datas;              //output_data array, type is dm_shw_data_t
 } dm_shw_service_t;
 
+struct dm_shw_table_s;
+struct dm_shw_index_s;
+
 typedef struct {
     int property_number;
     dm_shw_data_t *properties;                //property array, type is dm_shw_data_t
@@ -116,8 +119,38 @@ typedef struct {
     dm_shw_event_t *events;                   //event array, type is dm_shw_event_t
     int service_number;
     dm_shw_service_t *services;               //service array, type is dm_shw_service_t
+    const struct dm_shw_table_s *table;       //table or schema this shadow created from, NULL if parsed from TSL
+    struct dm_shw_index_s *index;             //hash of identifier paths, NULL if not built, borrowed if table is set
 } dm_shw_t;
 
+/*
+ * Precompiled TSL generated by linkkit_tsl_convert -c, all of it const and never modified.
+ * @shadow is the template of shadow: identifiers point to const strings, values are all zero,
+ * complex value of array points to nothing except array of struct, which points to a single element as template.
+ * @xxx_index are perfect hash tables of top level identifiers, each has @hash_size slots holding
+ * index into template arrays or -1 for empty slot, slot of identifier is dm_shw_table_hash() & (@hash_size - 1)
+ */
+typedef struct dm_shw_table_s {
+    const dm_shw_t *shadow;
+    uint32_t hash_seed;
+    int hash_size;
+    const short *property_index;
+    const short *event_index;
+    const short *service_index;
+} dm_shw_table_t;
+
+/*
+ * TSL parsed once and shared by devices of the same product, never modified after created.
+ * @table refers to @tsl as template without perfect hash, shadows created from it only hold values,
+ * and share @index whose nodes are relative to shadow.
+ */
+typedef struct {
+    dm_shw_t *tsl;
+    dm_shw_table_t table;
+    struct dm_shw_index_s *index;
+    int shadow_size;                             //memory of each shadow created from schema
+} dm_shw_schema_t;
+
 /**
  * @brief Create TSL struct from TSL string.
  *        This function used to parse TSL string into TSL struct.
@@ -132,6 +165,70 @@ typedef struct {
  */
 int dm_shw_create(_IN_ iotx_dm_tsl_type_t type, _IN_ const char *tsl, _IN_ int tsl_len, _OU_ dm_shw_t **shadow);
 
+/**
+ * @brief Create TSL struct from precompiled table.
+ *        This function used to instantiate TSL struct without parsing TSL string,
+ *        identifiers are referenced from table and the rest is allocated in one memory block.
+ *
+ * @param table. The precompiled table generated by linkkit_tsl_convert.
+ * @param shadow. The pointer of TSL Struct pointer, will be malloc memory.
+ *                This memory should be free by dm_shw_destroy.
+ *
+ * @return success or fail.
+ *
+ */
+int dm_shw_create_from_table(_IN_ const dm_shw_table_t *table, _OU_ dm_shw_t **shadow);
+
+/**
+ * @brief Create shared TSL schema from TSL string.
+ *        This function used to parse TSL string once for all devices of the same product.
+ *
+ * @param tsl. The TSL string in JSON format.
+ * @param tsl_len. The length of tsl
+ * @param schema. The pointer of TSL schema pointer, will be malloc memory.
+ *                This memory should be free by dm_shw_schema_destroy after all shadows created from it are destroyed.
+ *
+ * @return success or fail.
+ *
+ */
+int dm_shw_schema_create(_IN_ iotx_dm_tsl_type_t type, _IN_ const char *tsl, _IN_ int tsl_len,
+                         _OU_ dm_shw_schema_t **schema);
+
+/**
+ * @brief Create TSL struct from shared TSL schema.
+ *        This function used to instantiate values of device only, identifiers and index are referenced from schema.
+ *
+ * @param schema. The TSL schema created by dm_shw_schema_create.
+ * @param shadow. The pointer of TSL Struct pointer, will be malloc memory.
+ *                This memory should be free by dm_shw_destroy.
+ *
+ * @return success or fail.
+ *
+ */
+int dm_shw_create_from_schema(_IN_ dm_shw_schema_t *schema, _OU_ dm_shw_t **shadow);
+
+/**
+ * @brief Destroy TSL schema.
+ *
+ * @param schema. The pointer of TSL schema pointer.
+ *
+ * @return void.
+ *
+ */
+void dm_shw_schema_destroy(_IN_ dm_shw_schema_t **schema);
+
+/**
+ * @brief Hash of identifier used by precompiled table, must be the same as linkkit_tsl_convert.
+ *
+ * @param seed. The hash seed of table.
+ * @param key. The identifier.
+ * @param key_len. The length of key.
+ *
+ * @return hash value.
+ *
+ */
+uint32_t dm_shw_table_hash(_IN_ uint32_t seed, _IN_ const char *key, _IN_ int key_len);
+
 /**
  * @brief Get property from TSL struct.
  *        This function used to get property from TSL struct.
@@ -461,7 +558,7 @@ int dm_shw_get_service_input_output_value(_IN_ dm_shw_data_target_e type, _IN_ d
  * @param shadow. The pointer of TSL Struct
  * @param identifier. The Property Identifier
  * @param identifier_len. The Property Identifier Length
- * @param lite. The pointer to json array where to store property value
+ * @param writer. The json writer with object opened, where to append property value
  *
  * @warning The payload malloc by this function and need to be free manully.
  *
@@ -469,7 +566,7 @@ int dm_shw_get_service_input_output_value(_IN_ dm_shw_data_target_e type, _IN_ d
  *
  */
 int dm_shw_assemble_property(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _IN_ int identifier_len,
-                             _IN_ lite_cjson_item_t *lite);
+                             _IN_ dm_utils_json_writer_t *writer);
 
 /**
  * @brief Get event output payload from TSL struct.
@@ -478,7 +575,7 @@ int dm_shw_assemble_property(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _IN_
  * @param shadow. The pointer of TSL Struct
  * @param identifier. The Event Identifier
  * @param identifier_len. The Event Identifier Length
- * @param lite. The pointer to json array where to store event output value
+ * @param writer. The json writer with object opened, where to append event output value
  *
  * @warning The payload malloc by this function and need to be free manully.
  *
@@ -486,7 +583,7 @@ int dm_shw_assemble_property(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _IN_
  *
  */
 int dm_shw_assemble_event_output(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _IN_ int identifier_len,
-                                 _IN_ lite_cjson_item_t *lite);
+                                 _IN_ dm_utils_json_writer_t *writer);
 
 /**
  * @brief Get service output payload from TSL struct.
@@ -495,7 +592,7 @@ int dm_shw_assemble_event_output(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _
  * @param shadow. The pointer of TSL Struct
  * @param identifier. The Service Identifier
  * @param identifier_len. The Service Identifier Length
- * @param lite. The pointer to json array where to store service output value
+ * @param writer. The json writer with object opened, where to append service output value
  *
  * @warning The payload malloc by this function and need to be free manully.
  *
@@ -503,7 +600,7 @@ int dm_shw_assemble_event_output(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _
  *
  */
 int dm_shw_assemble_service_output(_IN_ dm_shw_t *shadow, _IN_ char *identifier, _IN_ int identifier_len,
-                                   _IN_ lite_cjson_item_t *lite);
+                                   _IN_ dm_utils_json_writer_t *writer);
 
 /**
  * @brief Free TSL struct.
@@ -429,6 +429,7 @@ static int _dm_shw_struct_parse(_IN_ dm_shw_data_value_t *data_value, _IN_ lite_
 {
     int res = 0, index = 0;
     lite_cjson_t lite_item;
+    lite_cjson_iter_t iter;
     dm_shw_data_t *property = NULL;
     dm_shw_data_value_complex_t *complex_struct = NULL;
 
@@ -457,12 +458,13 @@ static int _dm_shw_struct_parse(_IN_ dm_shw_data_value_t *data_value, _IN_ lite_
     }
     memset(complex_struct->value, 0, (complex_struct->size) * (sizeof(dm_shw_data_t)));
 
+    lite_cjson_iter_init(root, &iter);
     for (index = 0; index < complex_struct->size; index++) {
         memset(&lite_item, 0, sizeof(lite_cjson_t));
         property = (dm_shw_data_t *)complex_struct->value + index;
         /* dm_log_debug("TSL Property Struct Index: %d",index); */
 
-        res = lite_cjson_array_item(root, index, &lite_item);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_item);
         if (res != SUCCESS_RETURN || !lite_cjson_is_object(&lite_item)) {
             return DM_JSON_PARSE_FAILED;
         }
@@ -551,6 +553,7 @@ static int _dm_shw_properties_parse(_IN_ dm_shw_t *shadow, _IN_ lite_cjson_t *ro
 {
     int res = 0, index = 0;
     lite_cjson_t lite_properties, lite_property;
+    lite_cjson_iter_t iter;
 
     memset(&lite_properties, 0, sizeof(lite_cjson_t));
     res = lite_cjson_object_item(root, DM_SHW_KEY_PROPERTIES, strlen(DM_SHW_KEY_PROPERTIES), &lite_properties);
@@ -575,9 +578,10 @@ static int _dm_shw_properties_parse(_IN_ dm_shw_t *shadow, _IN_ lite_cjson_t *ro
     }
     memset(shadow->properties, 0, sizeof(dm_shw_data_t) * (lite_properties.size));
 
+    lite_cjson_iter_init(&lite_properties, &iter);
     for (index = 0; index < lite_properties.size; index++) {
         memset(&lite_property, 0, sizeof(lite_cjson_t));
-        res = lite_cjson_array_item(&lite_properties, index, &lite_property);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_property);
         if (res != SUCCESS_RETURN || !lite_cjson_is_object(&lite_property)) {
             return FAIL_RETURN;
         }
@@ -627,6 +631,7 @@ static int _dm_shw_event_outputdatas_parse(_IN_ dm_shw_t *shadow, _IN_ dm_shw_ev
 {
     int res = 0, index = 0;
     lite_cjson_t lite_item;
+    lite_cjson_iter_t iter;
     dm_shw_data_t *output_data = NULL;
 
     dm_log_debug("Number: %d", event->output_data_number);
@@ -641,11 +646,12 @@ static int _dm_shw_event_outputdatas_parse(_IN_ dm_shw_t *shadow, _IN_ dm_shw_ev
     }
     memset(event->output_datas, 0, (event->output_data_number) * (sizeof(dm_shw_data_t)));
 
+    lite_cjson_iter_init(root, &iter);
     for (index = 0; index < event->output_data_number; index++) {
         memset(&lite_item, 0, sizeof(lite_cjson_t));
         output_data = event->output_datas + index;
 
-        res = lite_cjson_array_item(root, index, &lite_item);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_item);
         if (res != SUCCESS_RETURN || !lite_cjson_is_object(&lite_item)) {
             return FAIL_RETURN;
         }
@@ -700,6 +706,7 @@ static int _dm_shw_events_parse(_IN_ dm_shw_t *shadow, _IN_ lite_cjson_t *root)
 {
     int res = 0, index = 0;
     lite_cjson_t lite_events, lite_event;
+    lite_cjson_iter_t iter;
 
     memset(&lite_events, 0, sizeof(lite_cjson_t));
     res = lite_cjson_object_item(root, DM_SHW_KEY_EVENTS, strlen(DM_SHW_KEY_EVENTS), &lite_events);
@@ -724,9 +731,10 @@ static int _dm_shw_events_parse(_IN_ dm_shw_t *shadow, _IN_ lite_cjson_t *root)
     }
     memset(shadow->events, 0, sizeof(dm_shw_event_t) * (lite_events.size));
 
+    lite_cjson_iter_init(&lite_events, &iter);
     for (index = 0; index < lite_events.size; index++) {
         memset(&lite_event, 0, sizeof(lite_cjson_t));
-        res = lite_cjson_array_item(&lite_events, index, &lite_event);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_event);
         if (res != SUCCESS_RETURN || !lite_cjson_is_object(&lite_event)) {
             return FAIL_RETURN;
         }
@@ -776,6 +784,7 @@ static int _dm_shw_service_outputdatas_parse(_IN_ dm_shw_t *shadow, _IN_ dm_shw_
 {
     int res = 0, index = 0;
     lite_cjson_t lite_item;
+    lite_cjson_iter_t iter;
     dm_shw_data_t *output_data = NULL;
 
     dm_log_debug("Number: %d", service->output_data_number);
@@ -790,11 +799,12 @@ static int _dm_shw_service_outputdatas_parse(_IN_ dm_shw_t *shadow, _IN_ dm_shw_
     }
     memset(service->output_datas, 0, (service->output_data_number) * (sizeof(dm_shw_data_t)));
 
+    lite_cjson_iter_init(root, &iter);
     for (index = 0; index < service->output_data_number; index++) {
         memset(&lite_item, 0, sizeof(lite_cjson_t));
         output_data = service->output_datas + index;
 
-        res = lite_cjson_array_item(root, index, &lite_item);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_item);
         if (res != SUCCESS_RETURN || !lite_cjson_is_object(&lite_item)) {
             return FAIL_RETURN;
         }
@@ -849,6 +859,7 @@ static int _dm_shw_service_inputdatas_parse(_IN_ dm_shw_t *shadow, _IN_ dm_shw_s
 {
     int res = 0, index = 0;
     lite_cjson_t lite_item;
+    lite_cjson_iter_t iter;
     dm_shw_data_t *input_data = NULL;
 
     dm_log_debug("Number: %d", service->input_data_number);
@@ -863,11 +874,12 @@ static int _dm_shw_service_inputdatas_parse(_IN_ dm_shw_t *shadow, _IN_ dm_shw_s
     }
     memset(service->input_datas, 0, (service->input_data_number) * (sizeof(dm_shw_data_t)));
 
+    lite_cjson_iter_init(root, &iter);
     for (index = 0; index < service->input_data_number; index++) {
         memset(&lite_item, 0, sizeof(lite_cjson_t));
         input_data = service->input_datas + index;
 
-        res = lite_cjson_array_item(root, index, &lite_item);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_item);
         if (res != SUCCESS_RETURN) {
             return FAIL_RETURN;
         }
@@ -937,6 +949,7 @@ static int _dm_shw_services_parse(_IN_ dm_shw_t *shadow, _IN_ lite_cjson_t *root
 {
     int res = 0, index = 0;
     lite_cjson_t lite_services, lite_service;
+    lite_cjson_iter_t iter;
     dm_shw_service_t *service = NULL;
 
     memset(&lite_services, 0, sizeof(lite_cjson_t));
@@ -962,11 +975,12 @@ static int _dm_shw_services_parse(_IN_ dm_shw_t *shadow, _IN_ lite_cjson_t *root
     }
     memset(shadow->services, 0, sizeof(dm_shw_service_t) * (lite_services.size));
 
+    lite_cjson_iter_init(&lite_services, &iter);
     for (index = 0; index < lite_services.size; index++) {
         memset(&lite_service, 0, sizeof(lite_cjson_t));
         service = shadow->services + index;
 
-        res = lite_cjson_array_item(&lite_services, index, &lite_service);
+        res = lite_cjson_iter_next(&iter, NULL, &lite_service);
         if (res != SUCCESS_RETURN || !lite_cjson_is_object(&lite_service)) {
             return FAIL_RETURN;
         }
@@ -409,6 +409,386 @@ int dm_utils_json_object_item(_IN_ lite_cjson_t *lite, _IN_ const char *key, _IN
     return SUCCESS_RETURN;
 }
 
+void dm_utils_json_writer_init(_IN_ dm_utils_json_writer_t *writer, _IN_ char *buffer, _IN_ int size)
+{
+    if (writer == NULL) {
+        return;
+    }
+
+    memset(writer, 0, sizeof(dm_utils_json_writer_t));
+    writer->buffer = buffer;
+    writer->size = (size > 0) ? (size) : (0);
+    writer->dynamic = (buffer == NULL) ? (1) : (0);
+    if (buffer != NULL && size <= 0) {
+        writer->error = 1;
+    }
+}
+
+void dm_utils_json_writer_deinit(_IN_ dm_utils_json_writer_t *writer)
+{
+    if (writer == NULL) {
+        return;
+    }
+
+    if (writer->dynamic && writer->buffer) {
+        DM_free(writer->buffer);
+    }
+    memset(writer, 0, sizeof(dm_utils_json_writer_t));
+}
+
+/* make room for @len more bytes plus '\0' */
+static int _dm_utils_json_writer_reserve(_IN_ dm_utils_json_writer_t *writer, _IN_ int len)
+{
+    int size = 0;
+    char *buffer = NULL;
+
+    if (writer->error) {
+        return FAIL_RETURN;
+    }
+
+    if (writer->buffer != NULL && writer->length + len < writer->size) {
+        return SUCCESS_RETURN;
+    }
+
+    if (!writer->dynamic) {
+        writer->error = 1;
+        return FAIL_RETURN;
+    }
+
+    size = (writer->size > 0) ? (writer->size) : (64);
+    while (writer->length + len >= size) {
+        size <<= 1;
+    }
+
+    buffer = DM_malloc(size);
+    if (buffer == NULL) {
+        writer->error = 1;
+        return DM_MEMORY_NOT_ENOUGH;
+    }
+
+    if (writer->buffer != NULL) {
+        memcpy(buffer, writer->buffer, writer->length);
+        DM_free(writer->buffer);
+    }
+    writer->buffer = buffer;
+    writer->size = size;
+
+    return SUCCESS_RETURN;
+}
+
+static int _dm_utils_json_writer_append(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *data, _IN_ int len)
+{
+    if (_dm_utils_json_writer_reserve(writer, len) != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    memcpy(writer->buffer + writer->length, data, len);
+    writer->length += len;
+    writer->buffer[writer->length] = '\0';
+
+    return SUCCESS_RETURN;
+}
+
+static int _dm_utils_json_writer_escape(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *value,
+                                        _IN_ int value_len)
+{
+    int index = 0, start = 0;
+    unsigned char ch = 0;
+    char escape[7] = {0};
+
+    for (index = 0; index < value_len; index++) {
+        ch = (unsigned char)value[index];
+        if (ch >= 32 && ch != '\"' && ch != '\\') {
+            continue;
+        }
+
+        if (_dm_utils_json_writer_append(writer, value + start, index - start) != SUCCESS_RETURN) {
+            return FAIL_RETURN;
+        }
+        start = index + 1;
+
+        escape[0] = '\\';
+        escape[2] = '\0';
+        switch (ch) {
+            case '\"':
+            case '\\':
+                escape[1] = ch;
+                break;
+            case '\b':
+                escape[1] = 'b';
+                break;
+            case '\f':
+                escape[1] = 'f';
+                break;
+            case '\n':
+                escape[1] = 'n';
+                break;
+            case '\r':
+                escape[1] = 'r';
+                break;
+            case '\t':
+                escape[1] = 't';
+                break;
+            default:
+                HAL_Snprintf(escape, sizeof(escape), "\\u%04x", ch);
+                break;
+        }
+        if (_dm_utils_json_writer_append(writer, escape, strlen(escape)) != SUCCESS_RETURN) {
+            return FAIL_RETURN;
+        }
+    }
+
+    return _dm_utils_json_writer_append(writer, value + start, index - start);
+}
+
+/* write separator and key of next member in current level */
+/* @escaped: @key is JSON string content already, e.g. key taken from lite_cjson_parse() */
+static int _dm_utils_json_writer_key(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ int escaped)
+{
+    unsigned int level = 0;
+
+    if (writer == NULL || writer->error) {
+        return FAIL_RETURN;
+    }
+
+    if (writer->depth == 0) {
+        /* only one top level value */
+        if (key != NULL || writer->length > 0) {
+            writer->error = 1;
+            return FAIL_RETURN;
+        }
+        return SUCCESS_RETURN;
+    }
+
+    level = 1U << (writer->depth - 1);
+    if (((writer->array_mask & level) != 0) != (key == NULL)) {
+        writer->error = 1;
+        return FAIL_RETURN;
+    }
+
+    if ((writer->member_mask & level) && _dm_utils_json_writer_append(writer, ",", 1) != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+    writer->member_mask |= level;
+
+    if (key == NULL) {
+        return SUCCESS_RETURN;
+    }
+
+    if (_dm_utils_json_writer_append(writer, "\"", 1) != SUCCESS_RETURN ||
+        ((escaped) ? (_dm_utils_json_writer_append(writer, key, strlen(key))) :
+         (_dm_utils_json_writer_escape(writer, key, strlen(key)))) != SUCCESS_RETURN ||
+        _dm_utils_json_writer_append(writer, "\":", 2) != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    return SUCCESS_RETURN;
+}
+
+static int _dm_utils_json_writer_member(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key)
+{
+    return _dm_utils_json_writer_key(writer, key, 0);
+}
+
+static int _dm_utils_json_writer_begin(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ int escaped,
+                                       _IN_ int array)
+{
+    unsigned int level = 0;
+
+    if (_dm_utils_json_writer_key(writer, key, escaped) != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    if (writer->depth >= DM_UTILS_JSON_WRITER_DEPTH_MAX) {
+        writer->error = 1;
+        return FAIL_RETURN;
+    }
+
+    level = 1U << writer->depth;
+    writer->depth++;
+    writer->member_mask &= ~level;
+    if (array) {
+        writer->array_mask |= level;
+    } else {
+        writer->array_mask &= ~level;
+    }
+
+    return _dm_utils_json_writer_append(writer, (array) ? ("[") : ("{"), 1);
+}
+
+static int _dm_utils_json_writer_end(_IN_ dm_utils_json_writer_t *writer, _IN_ int array)
+{
+    unsigned int level = 0;
+
+    if (writer == NULL || writer->error) {
+        return FAIL_RETURN;
+    }
+
+    level = (writer->depth > 0) ? (1U << (writer->depth - 1)) : (0);
+    if (level == 0 || ((writer->array_mask & level) != 0) != (array != 0)) {
+        writer->error = 1;
+        return FAIL_RETURN;
+    }
+    writer->depth--;
+
+    return _dm_utils_json_writer_append(writer, (array) ? ("]") : ("}"), 1);
+}
+
+int dm_utils_json_writer_finish(_IN_ dm_utils_json_writer_t *writer, _OU_ char **payload, _OU_ int *payload_len)
+{
+    if (writer == NULL || payload == NULL || *payload != NULL) {
+        return DM_INVALID_PARAMETER;
+    }
+
+    if (writer->error || writer->depth != 0 || writer->length == 0) {
+        return FAIL_RETURN;
+    }
+
+    *payload = writer->buffer;
+    if (payload_len) {
+        *payload_len = writer->length;
+    }
+
+    /* buffer belongs to caller from now on */
+    writer->buffer = NULL;
+    writer->dynamic = 0;
+
+    return SUCCESS_RETURN;
+}
+
+int dm_utils_json_writer_in_array(_IN_ dm_utils_json_writer_t *writer)
+{
+    if (writer == NULL || writer->depth == 0) {
+        return 0;
+    }
+
+    return (writer->array_mask & (1U << (writer->depth - 1))) ? (1) : (0);
+}
+
+int dm_utils_json_writer_object_begin(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key)
+{
+    return _dm_utils_json_writer_begin(writer, key, 0, 0);
+}
+
+int dm_utils_json_writer_escaped_object_begin(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key)
+{
+    return _dm_utils_json_writer_begin(writer, key, 1, 0);
+}
+
+int dm_utils_json_writer_object_end(_IN_ dm_utils_json_writer_t *writer)
+{
+    return _dm_utils_json_writer_end(writer, 0);
+}
+
+int dm_utils_json_writer_array_begin(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key)
+{
+    return _dm_utils_json_writer_begin(writer, key, 0, 1);
+}
+
+int dm_utils_json_writer_array_end(_IN_ dm_utils_json_writer_t *writer)
+{
+    return _dm_utils_json_writer_end(writer, 1);
+}
+
+int dm_utils_json_writer_string(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ const char *value,
+                                _IN_ int value_len)
+{
+    if (value == NULL || value_len < 0) {
+        value = "";
+        value_len = 0;
+    }
+
+    if (_dm_utils_json_writer_member(writer, key) != SUCCESS_RETURN ||
+        _dm_utils_json_writer_append(writer, "\"", 1) != SUCCESS_RETURN ||
+        _dm_utils_json_writer_escape(writer, value, value_len) != SUCCESS_RETURN ||
+        _dm_utils_json_writer_append(writer, "\"", 1) != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    return SUCCESS_RETURN;
+}
+
+int dm_utils_json_writer_escaped_string(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key,
+                                        _IN_ const char *value, _IN_ int value_len)
+{
+    if (value == NULL || value_len < 0) {
+        value = "";
+        value_len = 0;
+    }
+
+    if (_dm_utils_json_writer_member(writer, key) != SUCCESS_RETURN ||
+        _dm_utils_json_writer_append(writer, "\"", 1) != SUCCESS_RETURN ||
+        _dm_utils_json_writer_append(writer, value, value_len) != SUCCESS_RETURN ||
+        _dm_utils_json_writer_append(writer, "\"", 1) != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    return SUCCESS_RETURN;
+}
+
+int dm_utils_json_writer_int(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ int value)
+{
+    char number[DM_UTILS_UINT32_STRLEN + 2] = {0};
+
+    HAL_Snprintf(number, sizeof(number), "%d", value);
+
+    return dm_utils_json_writer_raw(writer, key, number, strlen(number));
+}
+
+int dm_utils_json_writer_double(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ double value)
+{
+    char number[32] = {0};
+    double test = 0;
+
+    /* same text as lite_cjson_print: NaN and Infinity become null, 15 significant digits if round trip is exact */
+    if ((value * 0) != 0) {
+        HAL_Snprintf(number, sizeof(number), "null");
+    } else {
+        HAL_Snprintf(number, sizeof(number), "%1.15g", value);
+        if (sscanf(number, "%lg", &test) != 1 || test != value) {
+            HAL_Snprintf(number, sizeof(number), "%1.17g", value);
+        }
+    }
+
+    return dm_utils_json_writer_raw(writer, key, number, strlen(number));
+}
+
+int dm_utils_json_writer_raw(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ const char *value,
+                             _IN_ int value_len)
+{
+    if (value == NULL || value_len <= 0) {
+        if (writer) {
+            writer->error = 1;
+        }
+        return DM_INVALID_PARAMETER;
+    }
+
+    if (_dm_utils_json_writer_member(writer, key) != SUCCESS_RETURN ||
+        _dm_utils_json_writer_append(writer, value, value_len) != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    return SUCCESS_RETURN;
+}
+
+int dm_utils_json_writer_escaped_raw(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ const char *value,
+                                     _IN_ int value_len)
+{
+    if (value == NULL || value_len <= 0) {
+        if (writer) {
+            writer->error = 1;
+        }
+        return DM_INVALID_PARAMETER;
+    }
+
+    if (_dm_utils_json_writer_key(writer, key, 1) != SUCCESS_RETURN ||
+        _dm_utils_json_writer_append(writer, value, value_len) != SUCCESS_RETURN) {
+        return FAIL_RETURN;
+    }
+
+    return SUCCESS_RETURN;
+}
+
 void *dm_utils_malloc(unsigned int size)
 {
     return LITE_malloc(size, MEM_MAGIC, "lite_cjson");
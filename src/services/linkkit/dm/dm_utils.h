@@ -11,6 +11,24 @@
 #define DM_UTILS_UINT32_STRLEN (10)
 #define DM_UTILS_UINT64_STRLEN (20)
 
+/* nesting depth of dm_utils_json_writer_t, one bit per level */
+#define DM_UTILS_JSON_WRITER_DEPTH_MAX (32)
+
+/*
+ * append-only JSON writer, values are written straight into the buffer without building item tree.
+ * errors are sticky and reported by dm_utils_json_writer_finish().
+ */
+typedef struct {
+    char *buffer;
+    int size;
+    int length;
+    int dynamic;            /* buffer is allocated and grown by writer */
+    int error;
+    int depth;
+    unsigned int array_mask;    /* bit n set: level n is array */
+    unsigned int member_mask;   /* bit n set: level n already has member, next one needs ',' */
+} dm_utils_json_writer_t;
+
 int dm_utils_copy_direct(_IN_ void *input, _IN_ int input_len, _OU_ void **output, _IN_ int output_len);
 
 int dm_utils_copy(_IN_ void *input, _IN_ int input_len, _OU_ void **output, _IN_ int output_len);
@@ -46,6 +64,34 @@ int dm_utils_uri_add_prefix(_IN_ const char *prefix, _IN_ char *uri, _OU_ char *
 int dm_utils_json_parse(_IN_ const char *payload, _IN_ int payload_len, _IN_ int type, _OU_ lite_cjson_t *lite);
 int dm_utils_json_object_item(_IN_ lite_cjson_t *lite, _IN_ const char *key, _IN_ int key_len, _IN_ int type,
                               _OU_ lite_cjson_t *lite_item);
+
+/* @buffer NULL: writer allocates @size bytes on first write and grows as needed */
+void dm_utils_json_writer_init(_IN_ dm_utils_json_writer_t *writer, _IN_ char *buffer, _IN_ int size);
+void dm_utils_json_writer_deinit(_IN_ dm_utils_json_writer_t *writer);
+/* @payload is '\0' terminated, caller takes it over and frees it if the buffer is allocated by writer */
+int dm_utils_json_writer_finish(_IN_ dm_utils_json_writer_t *writer, _OU_ char **payload, _OU_ int *payload_len);
+int dm_utils_json_writer_in_array(_IN_ dm_utils_json_writer_t *writer);
+/* @key is used inside object only and must be NULL inside array or at top level */
+int dm_utils_json_writer_object_begin(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key);
+/* @key is already escaped string content, e.g. key taken from lite_cjson_parse() */
+int dm_utils_json_writer_escaped_object_begin(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key);
+int dm_utils_json_writer_object_end(_IN_ dm_utils_json_writer_t *writer);
+int dm_utils_json_writer_array_begin(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key);
+int dm_utils_json_writer_array_end(_IN_ dm_utils_json_writer_t *writer);
+int dm_utils_json_writer_string(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ const char *value,
+                                _IN_ int value_len);
+/* @value is already escaped string content, e.g. string value taken from lite_cjson_parse() */
+int dm_utils_json_writer_escaped_string(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key,
+                                        _IN_ const char *value, _IN_ int value_len);
+int dm_utils_json_writer_int(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ int value);
+int dm_utils_json_writer_double(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ double value);
+/* @value is complete JSON text of one value, copied as it is */
+int dm_utils_json_writer_raw(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ const char *value,
+                             _IN_ int value_len);
+/* as dm_utils_json_writer_raw(), @key is already escaped string content */
+int dm_utils_json_writer_escaped_raw(_IN_ dm_utils_json_writer_t *writer, _IN_ const char *key, _IN_ const char *value,
+                                     _IN_ int value_len);
+
 void *dm_utils_malloc(unsigned int size);
 void dm_utils_free(void *ptr);
 #endif
@@ -222,9 +222,13 @@ int iotx_dm_get_device_status(_IN_ int devid, _OU_ iotx_dm_dev_status_t *status)
 #endif
 
 #ifdef DEPRECATED_LINKKIT
+struct dm_shw_table_s;
+
 int iotx_dm_deprecated_subdev_register(_IN_ int devid, _IN_ char device_secret[DEVICE_SECRET_MAXLEN]);
 int iotx_dm_deprecated_set_tsl(_IN_ int devid, _IN_ iotx_dm_tsl_source_t source, _IN_ const char *tsl,
                                _IN_ int tsl_len);
+int iotx_dm_set_tsl_table(_IN_ char product_key[PRODUCT_KEY_MAXLEN], _IN_ const struct dm_shw_table_s *table);
+int iotx_dm_deprecated_set_tsl_table(_IN_ int devid, _IN_ const struct dm_shw_table_s *table);
 int iotx_dm_deprecated_set_property_value(_IN_ int devid, _IN_ char *key, _IN_ int key_len, _IN_ void *value,
         _IN_ int value_len);
 int iotx_dm_deprecated_get_property_value(_IN_ int devid, _IN_ char *key, _IN_ int key_len, _IN_ void *value);
@@ -13,4 +13,48 @@
 #define IOTX_DM_CLIENT_REQUEST_TIMEOUT_MS     (2000)
 #define IOTX_DM_CLIENT_KEEPALIVE_INTERVAL_MS  (60000)
 
+/* index every identifier path of TSL shadow for O(1) lookup, costs about 32 bytes per data item */
+#ifndef WITH_DM_SHW_INDEX
+    #define WITH_DM_SHW_INDEX                 (1)
+#endif
+
+/* devices of the same product share one parsed TSL schema and only keep their own values */
+#ifndef WITH_DM_SHW_SCHEMA_SHARE
+    #define WITH_DM_SHW_SCHEMA_SHARE          (1)
+#endif
+
+/*
+ * messages to user no longer than this (including '\0') are stored inside dm_ipc ring slot without malloc.
+ * A slot is this plus its header rounded up to DM_IPC_CACHE_LINE_SIZE, 192 bytes on 64-bit hosts, and the ring
+ * holds CONFIG_DISPATCH_QUEUE_MAXLEN rounded up to power of 2 slots, e.g. 64 slots or 12KB for 50.
+ */
+#ifndef DM_IPC_MSG_INLINE_SIZE
+    #define DM_IPC_MSG_INLINE_SIZE            (112)
+#endif
+
+/* producers and consumer of dm_ipc ring touch separate cache lines, set 8 to save memory on MCUs without cache */
+#ifndef DM_IPC_CACHE_LINE_SIZE
+    #define DM_IPC_CACHE_LINE_SIZE            (64)
+#endif
+
+/* slots are aligned by masking with it */
+#if (DM_IPC_CACHE_LINE_SIZE & (DM_IPC_CACHE_LINE_SIZE - 1)) != 0
+    #error "DM_IPC_CACHE_LINE_SIZE must be power of 2"
+#endif
+
+/* coalesced property reports are sent early once params of pending posts would exceed this length */
+#ifndef DM_COALESCE_PARAMS_MAXLEN
+    #define DM_COALESCE_PARAMS_MAXLEN         (512)
+#endif
+
+/* products whose precompiled TSL table can be registered at the same time */
+#ifndef DM_TSL_TABLE_PRODUCT_MAX
+    #define DM_TSL_TABLE_PRODUCT_MAX          (4)
+#endif
+
+/* subdevices carried by one thing.event.property.pack.post of gateway */
+#ifndef DM_COALESCE_PACK_SUBDEV_MAX
+    #define DM_COALESCE_PACK_SUBDEV_MAX       (20)
+#endif
+
 #endif
\ No newline at end of file
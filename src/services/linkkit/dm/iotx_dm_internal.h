@@ -42,6 +42,7 @@
 #include "dm_shadow.h"
 #include "dm_tsl_alink.h"
 #include "dm_message_cache.h"
+#include "dm_coalesce.h"
 #include "dm_opt.h"
 #include "dm_ota.h"
 #include "dm_cota.h"
@@ -59,8 +60,10 @@
 #define DM_SUPPORT_MEMORY_MAGIC
 #ifdef DM_SUPPORT_MEMORY_MAGIC
     #define DM_malloc(size) LITE_malloc(size, MEM_MAGIC, "dm")
+    #define DM_SHW_malloc(size) LITE_malloc(size, MEM_MAGIC, "dm_shadow")
 #else
     #define DM_malloc(size) LITE_malloc(size)
+    #define DM_SHW_malloc(size) LITE_malloc(size)
 #endif
 #define DM_free(ptr)   {LITE_free(ptr);ptr = NULL;}
 
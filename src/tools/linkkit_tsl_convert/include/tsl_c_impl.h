@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+
+
+#ifndef TSL_C_IMPL_H
+#define TSL_C_IMPL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * generate C source of const dm_shw_table_t named @name##_table from TSL in @src_filename,
+ * which is loaded by dm_shw_create_from_table() without parsing TSL
+ */
+int tsl_format_c_convert(const char *src_filename, const char *dst_filename, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
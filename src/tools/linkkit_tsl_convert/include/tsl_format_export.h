@@ -15,6 +15,8 @@ extern "C" {
 
 int tsl_format_convert(const char *src_filename, const char *dst_filename, int is_slim);
 
+int tsl_format_convert_c(const char *src_filename, const char *dst_filename, const char *name);
+
 int tsl_format_dump(const char *filename);
 
 #ifdef __cplusplus
@@ -13,7 +13,9 @@
 typedef struct {
     char *src;
     char *dst;
+    char *name;
     int is_slim;
+    int is_c;
 } env_t;
 
 void usage()
@@ -22,6 +24,8 @@ void usage()
     printf("\t-i(src_path)\n");
     printf("\t-o[dst_path]\n");
     printf("\t-s slim thing mode\n");
+    printf("\t-c generate C source of precompiled TSL table\n");
+    printf("\t-n(table_name) name of precompiled TSL table, default tsl\n");
 }
 
 void print_env(env_t *env)
@@ -35,6 +39,9 @@ void print_env(env_t *env)
     printf("SRC:%s\n", env->src ? env->src : "NULL");
     printf("DST:%s\n", env->dst ? env->dst : "NULL");
     printf("%s slim TSL mode\n", env->is_slim == 0 ? "not" : "");
+    if (env->is_c) {
+        printf("C table: %s_table\n", env->name);
+    }
     printf("=========================================\n");
 }
 
@@ -45,7 +52,11 @@ void set_default(env_t *env)
     }
 
     if (!env->dst) {
-        env->dst = "conv.txt";
+        env->dst = env->is_c ? "tsl_table.c" : "conv.txt";
+    }
+
+    if (!env->name) {
+        env->name = "tsl";
     }
 }
 
@@ -57,7 +68,7 @@ int main(int argc, char **argv)
 
     memset(&env, 0, sizeof(env_t));
 
-    while ((opt = getopt(argc, argv, "i:o::s")) != -1) {
+    while ((opt = getopt(argc, argv, "i:o::scn:")) != -1) {
         switch (opt) {
             case 'i':
                 env.src = optarg;
@@ -68,6 +79,12 @@ int main(int argc, char **argv)
             case 's':
                 env.is_slim = 1;
                 break;
+            case 'c':
+                env.is_c = 1;
+                break;
+            case 'n':
+                env.name = optarg;
+                break;
             default:
                 usage();
                 return 0;
@@ -82,7 +99,12 @@ int main(int argc, char **argv)
     set_default(&env);
     print_env(&env);
 
-    if (tsl_format_convert(env.src, env.dst, env.is_slim) != 0) {
+    if (env.is_c) {
+        if (tsl_format_convert_c(env.src, env.dst, env.name) != 0) {
+            TFormat_printf("[err] convert fail");
+            goto do_exit;
+        }
+    } else if (tsl_format_convert(env.src, env.dst, env.is_slim) != 0) {
         TFormat_printf("[err] convert fail");
         goto do_exit;
     }
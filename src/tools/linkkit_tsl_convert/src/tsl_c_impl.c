@@ -0,0 +1,617 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "common.h"
+#include "cJSON.h"
+#include "tsl_file.h"
+#include "tsl_c_impl.h"
+#include "iot_import.h"
+
+#define TSL_C_INIT_LEN          (128)
+#define TSL_C_HASH_SEED_MAX     (0x10000)
+#define TSL_C_HASH_SIZE_MAX     (0x4000)
+
+enum {
+    TSL_C_KIND_PROPERTY = 0,
+    TSL_C_KIND_EVENT,
+    TSL_C_KIND_SERVICE,
+    TSL_C_KIND_MAX
+};
+
+typedef struct {
+    FILE *fp;
+    const char *name;
+    int symbol;
+    const char **keys[TSL_C_KIND_MAX];
+    int key_num[TSL_C_KIND_MAX];
+    short *slots[TSL_C_KIND_MAX];
+    uint32_t hash_seed;
+    int hash_size;
+} tsl_c_ctx_t;
+
+/* the same order as dm_shw_data_type_e */
+static const char *tsl_c_type_name[] = {
+    "none", "int", "float", "double", "text", "enum", "date", "bool", "array", "struct"
+};
+
+static const char *tsl_c_type_enum[] = {
+    "DM_SHW_DATA_TYPE_NONE", "DM_SHW_DATA_TYPE_INT", "DM_SHW_DATA_TYPE_FLOAT", "DM_SHW_DATA_TYPE_DOUBLE",
+    "DM_SHW_DATA_TYPE_TEXT", "DM_SHW_DATA_TYPE_ENUM", "DM_SHW_DATA_TYPE_DATE", "DM_SHW_DATA_TYPE_BOOL",
+    "DM_SHW_DATA_TYPE_ARRAY", "DM_SHW_DATA_TYPE_STRUCT"
+};
+
+#define TSL_C_TYPE_ARRAY        (8)
+#define TSL_C_TYPE_STRUCT       (9)
+
+static const char *tsl_c_kind_name[TSL_C_KIND_MAX] = {"property", "event", "service"};
+
+/* must be the same as dm_shw_table_hash() */
+static uint32_t tsl_c_hash(uint32_t seed, const char *key)
+{
+    uint32_t hash = 2166136261u ^ seed;
+
+    while (*key) {
+        hash ^= (uint8_t)(*key++);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static int tsl_c_get_type(cJSON *type)
+{
+    int i = 0;
+
+    if (!type || !cJSON_IsString(type)) {
+        return -1;
+    }
+
+    for (i = 0; i < sizeof(tsl_c_type_name) / sizeof(char *); i++) {
+        if (strcmp(tsl_c_type_name[i], type->valuestring) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int tsl_c_string(tsl_c_ctx_t *ctx, const char *str)
+{
+    int id = ctx->symbol++;
+    const char *p = str;
+
+    fprintf(ctx->fp, "static const char %s_s%d[] = \"", ctx->name, id);
+    for (; *p; p++) {
+        if (*p == '\"' || *p == '\\') {
+            fputc('\\', ctx->fp);
+        }
+        fputc(*p, ctx->fp);
+    }
+    fprintf(ctx->fp, "\";\n");
+
+    return id;
+}
+
+static int tsl_c_datas(tsl_c_ctx_t *ctx, cJSON *datas);
+
+/* emit complex value of struct which members are @specs, return its symbol */
+static int tsl_c_struct(tsl_c_ctx_t *ctx, cJSON *specs)
+{
+    int id = 0;
+    int datas_id = 0;
+
+    if (!specs || !cJSON_IsArray(specs) || cJSON_GetArraySize(specs) == 0) {
+        TFormat_printf("[err] invalid struct specs\n");
+        return -1;
+    }
+
+    datas_id = tsl_c_datas(ctx, specs);
+    if (datas_id < 0) {
+        return -1;
+    }
+
+    id = ctx->symbol++;
+    fprintf(ctx->fp, "static const dm_shw_data_value_complex_t %s_c%d = {DM_SHW_DATA_TYPE_NONE, %d, (void *)%s_d%d};\n",
+            ctx->name, id, cJSON_GetArraySize(specs), ctx->name, datas_id);
+
+    return id;
+}
+
+/* emit complex value of array, struct element is emitted once as template of all elements */
+static int tsl_c_array(tsl_c_ctx_t *ctx, cJSON *specs)
+{
+    int id = 0, type = 0, size = 0, struct_id = 0, item_id = 0;
+    char value[TSL_C_INIT_LEN] = "NULL";
+    cJSON *size_obj = NULL;
+    cJSON *item_obj = NULL;
+
+    size_obj = specs ? cJSON_GetObjectItem(specs, "size") : NULL;
+    item_obj = specs ? cJSON_GetObjectItem(specs, "item") : NULL;
+    if (!size_obj || !item_obj) {
+        TFormat_printf("[err] invalid array specs\n");
+        return -1;
+    }
+
+    if (cJSON_IsString(size_obj)) {
+        size = atoi(size_obj->valuestring);
+    } else if (cJSON_IsNumber(size_obj)) {
+        size = size_obj->valueint;
+    } else {
+        TFormat_printf("[err] invalid array size\n");
+        return -1;
+    }
+
+    type = tsl_c_get_type(cJSON_GetObjectItem(item_obj, "type"));
+    if (type < 0) {
+        TFormat_printf("[err] invalid array item type\n");
+        return -1;
+    }
+
+    if (type == TSL_C_TYPE_STRUCT) {
+        struct_id = tsl_c_struct(ctx, cJSON_GetObjectItem(item_obj, "specs"));
+        if (struct_id < 0) {
+            return -1;
+        }
+        item_id = ctx->symbol++;
+        fprintf(ctx->fp,
+                "static const dm_shw_data_t %s_d%d[1] = {{NULL, {.type = DM_SHW_DATA_TYPE_STRUCT, .value = (void *)&%s_c%d}}};\n",
+                ctx->name, item_id, ctx->name, struct_id);
+        snprintf(value, sizeof(value), "(void *)%s_d%d", ctx->name, item_id);
+    }
+
+    id = ctx->symbol++;
+    fprintf(ctx->fp, "static const dm_shw_data_value_complex_t %s_c%d = {%s, %d, %s};\n",
+            ctx->name, id, tsl_c_type_enum[type], size, value);
+
+    return id;
+}
+
+/* write initializer of dm_shw_data_value_t described by @data_type into @init */
+static int tsl_c_value(tsl_c_ctx_t *ctx, cJSON *data_type, char *init, int init_len)
+{
+    int id = 0;
+    int type = tsl_c_get_type(cJSON_GetObjectItem(data_type, "type"));
+    cJSON *specs = cJSON_GetObjectItem(data_type, "specs");
+
+    if (type < 0) {
+        TFormat_printf("[err] invalid data type\n");
+        return -1;
+    }
+
+    if (type == TSL_C_TYPE_ARRAY) {
+        id = tsl_c_array(ctx, specs);
+    } else if (type == TSL_C_TYPE_STRUCT) {
+        id = tsl_c_struct(ctx, specs);
+    } else {
+        snprintf(init, init_len, "{.type = %s}", tsl_c_type_enum[type]);
+        return 0;
+    }
+
+    if (id < 0) {
+        return -1;
+    }
+    snprintf(init, init_len, "{.type = %s, .value = (void *)&%s_c%d}", tsl_c_type_enum[type], ctx->name, id);
+
+    return 0;
+}
+
+/* emit dm_shw_data_t array of @datas, return its symbol */
+static int tsl_c_datas(tsl_c_ctx_t *ctx, cJSON *datas)
+{
+    int i = 0, id = -1;
+    int num = cJSON_GetArraySize(datas);
+    int *ids = NULL;
+    char *inits = NULL;
+    cJSON *item = NULL;
+    cJSON *identifier = NULL;
+    cJSON *data_type = NULL;
+
+    ids = calloc(num, sizeof(int));
+    inits = calloc(num, TSL_C_INIT_LEN);
+    if (!ids || !inits) {
+        goto do_exit;
+    }
+
+    for (i = 0; i < num; i++) {
+        item = cJSON_GetArrayItem(datas, i);
+        identifier = cJSON_GetObjectItem(item, "identifier");
+        data_type = cJSON_GetObjectItem(item, "dataType");
+        if (!identifier || !cJSON_IsString(identifier) || !data_type || !cJSON_IsObject(data_type)) {
+            TFormat_printf("[err] invalid data item %d\n", i);
+            goto do_exit;
+        }
+        ids[i] = tsl_c_string(ctx, identifier->valuestring);
+        if (tsl_c_value(ctx, data_type, inits + i * TSL_C_INIT_LEN, TSL_C_INIT_LEN) < 0) {
+            TFormat_printf("[err] invalid data type of %s\n", identifier->valuestring);
+            goto do_exit;
+        }
+    }
+
+    id = ctx->symbol++;
+    fprintf(ctx->fp, "static const dm_shw_data_t %s_d%d[] = {\n", ctx->name, id);
+    for (i = 0; i < num; i++) {
+        fprintf(ctx->fp, "    {(char *)%s_s%d, %s},\n", ctx->name, ids[i], inits + i * TSL_C_INIT_LEN);
+    }
+    fprintf(ctx->fp, "};\n");
+
+do_exit:
+    if (ids) {
+        free(ids);
+    }
+    if (inits) {
+        free(inits);
+    }
+    return id;
+}
+
+/* write "number, pointer" of optional data array @name in @obj into @init */
+static int tsl_c_datas_field(tsl_c_ctx_t *ctx, cJSON *obj, const char *name, char *init, int init_len)
+{
+    int id = 0;
+    cJSON *datas = cJSON_GetObjectItem(obj, name);
+
+    snprintf(init, init_len, "0, NULL");
+    if (!datas || !cJSON_IsArray(datas) || cJSON_GetArraySize(datas) == 0) {
+        return 0;
+    }
+
+    id = tsl_c_datas(ctx, datas);
+    if (id < 0) {
+        return -1;
+    }
+    snprintf(init, init_len, "%d, (dm_shw_data_t *)%s_d%d", cJSON_GetArraySize(datas), ctx->name, id);
+
+    return 0;
+}
+
+/* collect identifiers of @items for perfect hash, @items must be array of objects */
+static int tsl_c_collect(tsl_c_ctx_t *ctx, int kind, cJSON *items)
+{
+    int i = 0;
+    cJSON *identifier = NULL;
+
+    ctx->key_num[kind] = items ? cJSON_GetArraySize(items) : 0;
+    if (ctx->key_num[kind] == 0) {
+        return 0;
+    }
+
+    ctx->keys[kind] = calloc(ctx->key_num[kind], sizeof(char *));
+    if (!ctx->keys[kind]) {
+        return -1;
+    }
+    for (i = 0; i < ctx->key_num[kind]; i++) {
+        identifier = cJSON_GetObjectItem(cJSON_GetArrayItem(items, i), "identifier");
+        if (!identifier || !cJSON_IsString(identifier)) {
+            TFormat_printf("[err] %s %d without identifier\n", tsl_c_kind_name[kind], i);
+            return -1;
+        }
+        ctx->keys[kind][i] = identifier->valuestring;
+    }
+
+    return 0;
+}
+
+/* emit identifiers and events, special event which TSL parser ignores has identifier only */
+static int tsl_c_events(tsl_c_ctx_t *ctx, cJSON *events)
+{
+    int i = 0, num = ctx->key_num[TSL_C_KIND_EVENT];
+    int *ids = NULL;
+    char *inits = NULL;
+    cJSON *event = NULL;
+    int ret = -1;
+
+    if (num == 0) {
+        return 0;
+    }
+
+    ids = calloc(num, sizeof(int));
+    inits = calloc(num, TSL_C_INIT_LEN);
+    if (!ids || !inits) {
+        goto do_exit;
+    }
+
+    for (i = 0; i < num; i++) {
+        event = cJSON_GetArrayItem(events, i);
+        ids[i] = tsl_c_string(ctx, ctx->keys[TSL_C_KIND_EVENT][i]);
+        snprintf(inits + i * TSL_C_INIT_LEN, TSL_C_INIT_LEN, "0, NULL");
+        if (strcmp(ctx->keys[TSL_C_KIND_EVENT][i], "post") == 0) {
+            continue;
+        }
+        if (tsl_c_datas_field(ctx, event, "outputData", inits + i * TSL_C_INIT_LEN, TSL_C_INIT_LEN) < 0) {
+            goto do_exit;
+        }
+    }
+
+    fprintf(ctx->fp, "static const dm_shw_event_t %s_events[] = {\n", ctx->name);
+    for (i = 0; i < num; i++) {
+        fprintf(ctx->fp, "    {(char *)%s_s%d, 0, NULL, %s},\n", ctx->name, ids[i], inits + i * TSL_C_INIT_LEN);
+    }
+    fprintf(ctx->fp, "};\n");
+    ret = 0;
+
+do_exit:
+    if (ids) {
+        free(ids);
+    }
+    if (inits) {
+        free(inits);
+    }
+    return ret;
+}
+
+/* emit identifiers and services, special services which TSL parser ignores have identifier only */
+static int tsl_c_services(tsl_c_ctx_t *ctx, cJSON *services)
+{
+    int i = 0, num = ctx->key_num[TSL_C_KIND_SERVICE];
+    int *ids = NULL;
+    char *inits = NULL;
+    char *input = NULL;
+    char *output = NULL;
+    cJSON *service = NULL;
+    int ret = -1;
+
+    if (num == 0) {
+        return 0;
+    }
+
+    ids = calloc(num, sizeof(int));
+    inits = calloc(num, 2 * TSL_C_INIT_LEN);
+    if (!ids || !inits) {
+        goto do_exit;
+    }
+
+    for (i = 0; i < num; i++) {
+        service = cJSON_GetArrayItem(services, i);
+        input = inits + 2 * i * TSL_C_INIT_LEN;
+        output = input + TSL_C_INIT_LEN;
+        ids[i] = tsl_c_string(ctx, ctx->keys[TSL_C_KIND_SERVICE][i]);
+        snprintf(input, TSL_C_INIT_LEN, "0, NULL");
+        snprintf(output, TSL_C_INIT_LEN, "0, NULL");
+        if (strcmp(ctx->keys[TSL_C_KIND_SERVICE][i], "set") == 0 ||
+            strcmp(ctx->keys[TSL_C_KIND_SERVICE][i], "get") == 0) {
+            continue;
+        }
+        if (tsl_c_datas_field(ctx, service, "outputData", output, TSL_C_INIT_LEN) < 0 ||
+            tsl_c_datas_field(ctx, service, "inputData", input, TSL_C_INIT_LEN) < 0) {
+            goto do_exit;
+        }
+    }
+
+    fprintf(ctx->fp, "static const dm_shw_service_t %s_services[] = {\n", ctx->name);
+    for (i = 0; i < num; i++) {
+        input = inits + 2 * i * TSL_C_INIT_LEN;
+        output = input + TSL_C_INIT_LEN;
+        fprintf(ctx->fp, "    {(char *)%s_s%d, %s, %s},\n", ctx->name, ids[i], input, output);
+    }
+    fprintf(ctx->fp, "};\n");
+    ret = 0;
+
+do_exit:
+    if (ids) {
+        free(ids);
+    }
+    if (inits) {
+        free(inits);
+    }
+    return ret;
+}
+
+/* place identifiers of @kind into slots, duplicated identifier keeps the first one like linear search */
+static int tsl_c_hash_place(tsl_c_ctx_t *ctx, int kind, uint32_t seed, int size)
+{
+    int i = 0;
+    short *slots = ctx->slots[kind];
+    uint32_t slot = 0;
+
+    for (i = 0; i < size; i++) {
+        slots[i] = -1;
+    }
+
+    for (i = 0; i < ctx->key_num[kind]; i++) {
+        slot = tsl_c_hash(seed, ctx->keys[kind][i]) & (size - 1);
+        if (slots[slot] >= 0) {
+            if (strcmp(ctx->keys[kind][slots[slot]], ctx->keys[kind][i]) == 0) {
+                continue;
+            }
+            return -1;
+        }
+        slots[slot] = i;
+    }
+
+    return 0;
+}
+
+/* find seed and size with which identifiers of every kind are collision free */
+static int tsl_c_hash_search(tsl_c_ctx_t *ctx)
+{
+    int kind = 0, size = 2, max = 0;
+    uint32_t seed = 0;
+
+    for (kind = 0; kind < TSL_C_KIND_MAX; kind++) {
+        max = (ctx->key_num[kind] > max) ? ctx->key_num[kind] : max;
+        ctx->slots[kind] = calloc(TSL_C_HASH_SIZE_MAX, sizeof(short));
+        if (!ctx->slots[kind]) {
+            return -1;
+        }
+    }
+
+    while (size < 2 * max) {
+        size <<= 1;
+    }
+
+    for (; size <= TSL_C_HASH_SIZE_MAX; size <<= 1) {
+        for (seed = 0; seed < TSL_C_HASH_SEED_MAX; seed++) {
+            for (kind = 0; kind < TSL_C_KIND_MAX; kind++) {
+                if (tsl_c_hash_place(ctx, kind, seed, size) < 0) {
+                    break;
+                }
+            }
+            if (kind == TSL_C_KIND_MAX) {
+                ctx->hash_seed = seed;
+                ctx->hash_size = size;
+                return 0;
+            }
+        }
+    }
+
+    TFormat_printf("[err] no perfect hash found\n");
+    return -1;
+}
+
+static void tsl_c_hash_emit(tsl_c_ctx_t *ctx, int kind)
+{
+    int i = 0;
+
+    if (ctx->key_num[kind] == 0) {
+        return;
+    }
+
+    fprintf(ctx->fp, "static const short %s_%s_index[%d] = {", ctx->name, tsl_c_kind_name[kind], ctx->hash_size);
+    for (i = 0; i < ctx->hash_size; i++) {
+        fprintf(ctx->fp, "%s%d%s", (i % 16 == 0) ? "\n    " : "", ctx->slots[kind][i],
+                (i == ctx->hash_size - 1) ? "\n" : ", ");
+    }
+    fprintf(ctx->fp, "};\n");
+}
+
+static int tsl_c_emit(tsl_c_ctx_t *ctx, const char *src_filename, cJSON *root)
+{
+    int kind = 0;
+    int properties_id = 0;
+    cJSON *properties = cJSON_GetObjectItem(root, "properties");
+    cJSON *events = cJSON_GetObjectItem(root, "events");
+    cJSON *services = cJSON_GetObjectItem(root, "services");
+
+    if ((properties && !cJSON_IsArray(properties)) || (events && !cJSON_IsArray(events)) ||
+        (services && !cJSON_IsArray(services))) {
+        TFormat_printf("[err] invalid tsl\n");
+        return -1;
+    }
+
+    if (tsl_c_collect(ctx, TSL_C_KIND_PROPERTY, properties) < 0 ||
+        tsl_c_collect(ctx, TSL_C_KIND_EVENT, events) < 0 ||
+        tsl_c_collect(ctx, TSL_C_KIND_SERVICE, services) < 0) {
+        return -1;
+    }
+
+    if (tsl_c_hash_search(ctx) < 0) {
+        return -1;
+    }
+
+    fprintf(ctx->fp, "/*\n * Generated by linkkit_tsl_convert from %s, do not edit.\n */\n\n", src_filename);
+    fprintf(ctx->fp, "#ifdef DEPRECATED_LINKKIT\n#include \"iotx_dm_internal.h\"\n\n");
+
+    if (ctx->key_num[TSL_C_KIND_PROPERTY] > 0) {
+        properties_id = tsl_c_datas(ctx, properties);
+        if (properties_id < 0) {
+            return -1;
+        }
+    }
+    if (tsl_c_events(ctx, events) < 0 || tsl_c_services(ctx, services) < 0) {
+        return -1;
+    }
+
+    fprintf(ctx->fp, "\n");
+    tsl_c_hash_emit(ctx, TSL_C_KIND_PROPERTY);
+    tsl_c_hash_emit(ctx, TSL_C_KIND_EVENT);
+    tsl_c_hash_emit(ctx, TSL_C_KIND_SERVICE);
+
+    fprintf(ctx->fp, "\nstatic const dm_shw_t %s_shadow = {\n", ctx->name);
+    if (ctx->key_num[TSL_C_KIND_PROPERTY] > 0) {
+        fprintf(ctx->fp, "    %d, (dm_shw_data_t *)%s_d%d,\n", ctx->key_num[TSL_C_KIND_PROPERTY], ctx->name, properties_id);
+    } else {
+        fprintf(ctx->fp, "    0, NULL,\n");
+    }
+    if (ctx->key_num[TSL_C_KIND_EVENT] > 0) {
+        fprintf(ctx->fp, "    %d, (dm_shw_event_t *)%s_events,\n", ctx->key_num[TSL_C_KIND_EVENT], ctx->name);
+    } else {
+        fprintf(ctx->fp, "    0, NULL,\n");
+    }
+    if (ctx->key_num[TSL_C_KIND_SERVICE] > 0) {
+        fprintf(ctx->fp, "    %d, (dm_shw_service_t *)%s_services,\n", ctx->key_num[TSL_C_KIND_SERVICE], ctx->name);
+    } else {
+        fprintf(ctx->fp, "    0, NULL,\n");
+    }
+    fprintf(ctx->fp, "    NULL\n};\n");
+
+    fprintf(ctx->fp, "\nconst dm_shw_table_t %s_table = {\n", ctx->name);
+    fprintf(ctx->fp, "    &%s_shadow,\n    %uu,\n    %d,\n", ctx->name, (unsigned int)ctx->hash_seed, ctx->hash_size);
+    for (kind = 0; kind < TSL_C_KIND_MAX; kind++) {
+        if (ctx->key_num[kind] > 0) {
+            fprintf(ctx->fp, "    %s_%s_index%s\n", ctx->name, tsl_c_kind_name[kind], (kind == TSL_C_KIND_MAX - 1) ? "" : ",");
+        } else {
+            fprintf(ctx->fp, "    NULL%s\n", (kind == TSL_C_KIND_MAX - 1) ? "" : ",");
+        }
+    }
+    fprintf(ctx->fp, "};\n#endif\n");
+
+    return 0;
+}
+
+int tsl_format_c_convert(const char *src_filename, const char *dst_filename, const char *name)
+{
+    int ret = -1;
+    int kind = 0;
+    int src_buf_len = 0;
+    char *src_buf = NULL;
+    cJSON *cjson = NULL;
+    tsl_c_ctx_t ctx;
+
+    memset(&ctx, 0, sizeof(tsl_c_ctx_t));
+
+    if (!src_filename || !dst_filename || !name) {
+        TFormat_printf("[err] invalid params\n");
+        goto do_exit;
+    }
+
+    src_buf = tsl_read_from_file(src_filename, &src_buf_len);
+    if (!src_buf) {
+        TFormat_printf("[err] read file(%s) failed\n", src_filename);
+        goto do_exit;
+    }
+    cjson = cJSON_Parse(src_buf);
+    if (!cjson) {
+        TFormat_printf("[err] parse json failed\n");
+        goto do_exit;
+    }
+
+    ctx.name = name;
+    ctx.fp = fopen(dst_filename, "w+");
+    if (!ctx.fp) {
+        TFormat_printf("[err] fopen(%s) failed\n", dst_filename);
+        goto do_exit;
+    }
+
+    if (tsl_c_emit(&ctx, src_filename, cjson) < 0) {
+        TFormat_printf("[err] generate %s failed\n", dst_filename);
+        goto do_exit;
+    }
+    ret = 0;
+
+do_exit:
+    if (ctx.fp) {
+        fclose(ctx.fp);
+    }
+    for (kind = 0; kind < TSL_C_KIND_MAX; kind++) {
+        if (ctx.keys[kind]) {
+            free(ctx.keys[kind]);
+        }
+        if (ctx.slots[kind]) {
+            free(ctx.slots[kind]);
+        }
+    }
+    if (cjson) {
+        cJSON_Delete(cjson);
+    }
+    if (src_buf) {
+        HAL_Free(src_buf);
+    }
+    return ret;
+}
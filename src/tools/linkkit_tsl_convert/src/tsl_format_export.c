@@ -9,6 +9,7 @@
 #include <string.h>
 #include "common.h"
 #include "tsl_opt_impl.h"
+#include "tsl_c_impl.h"
 #include "tsl_format_export.h"
 #include "cJSON.h"
 
@@ -17,6 +18,11 @@ int tsl_format_convert(const char *src_filename, const char *dst_filename, int i
     return tsl_format_opt_convert(src_filename, dst_filename, is_slim);
 }
 
+int tsl_format_convert_c(const char *src_filename, const char *dst_filename, const char *name)
+{
+    return tsl_format_c_convert(src_filename, dst_filename, name);
+}
+
 
 int tsl_format_dump(const char *filename)
 {